@@ -0,0 +1,468 @@
+/* Copyright (C) 2011-2026 Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstddef>
+#include <cstring>
+
+#include "FLACEncoder.h"
+
+static const unsigned int BITS_PER_SAMPLE = 16;
+static const unsigned int STREAMINFO_LENGTH = 34;
+
+static const unsigned int SUBFRAME_TYPE_CONSTANT = 0x00;
+static const unsigned int SUBFRAME_TYPE_VERBATIM = 0x01;
+static const unsigned int SUBFRAME_TYPE_FIXED = 0x08;
+
+static const unsigned int CHANNEL_ASSIGNMENT_LEFT_SIDE = 8;
+static const unsigned int CHANNEL_ASSIGNMENT_SIDE_RIGHT = 9;
+static const unsigned int CHANNEL_ASSIGNMENT_MID_SIDE = 10;
+
+static const unsigned int MAX_FIXED_ORDER = 4;
+static const unsigned int MAX_PARTITION_ORDER = 8;
+// Rice parameter 15 is reserved as an escape code in the 4-bit parameter coding method.
+static const unsigned int MAX_RICE_PARAMETER = 14;
+
+namespace {
+
+class CRCTables {
+public:
+	unsigned char crc8[256];
+	unsigned short crc16[256];
+
+	CRCTables() {
+		for (unsigned int i = 0; i < 256; i++) {
+			unsigned int crc = i;
+			for (int bit = 0; bit < 8; bit++) {
+				crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+			}
+			crc8[i] = static_cast<unsigned char>(crc);
+			crc = i << 8;
+			for (int bit = 0; bit < 8; bit++) {
+				crc = (crc & 0x8000) ? (crc << 1) ^ 0x8005 : crc << 1;
+			}
+			crc16[i] = static_cast<unsigned short>(crc);
+		}
+	}
+};
+
+}
+
+// Initialised statically, so that encoders running on different threads don't race.
+static const CRCTables crcTables;
+
+static unsigned int computeCRC8(const unsigned char *data, unsigned int length) {
+	unsigned int crc = 0;
+	while (length-- > 0) {
+		crc = crcTables.crc8[crc ^ *(data++)];
+	}
+	return crc;
+}
+
+static unsigned int computeCRC16(const unsigned char *data, unsigned int length) {
+	unsigned int crc = 0;
+	while (length-- > 0) {
+		crc = ((crc << 8) ^ crcTables.crc16[(crc >> 8) ^ *(data++)]) & 0xFFFF;
+	}
+	return crc;
+}
+
+static unsigned int getSampleRateCode(unsigned int sampleRate) {
+	switch (sampleRate) {
+	case 88200: return 1;
+	case 176400: return 2;
+	case 192000: return 3;
+	case 8000: return 4;
+	case 16000: return 5;
+	case 22050: return 6;
+	case 24000: return 7;
+	case 32000: return 8;
+	case 44100: return 9;
+	case 48000: return 10;
+	case 96000: return 11;
+	}
+	if (sampleRate % 1000 == 0 && sampleRate / 1000 < 256) return 12;
+	if (sampleRate < 65536) return 13;
+	if (sampleRate % 10 == 0 && sampleRate / 10 < 65536) return 14;
+	// Refer to STREAMINFO.
+	return 0;
+}
+
+static inline unsigned int foldSign(int residual) {
+	return residual < 0 ? static_cast<unsigned int>(-(residual + 1)) * 2 + 1 : static_cast<unsigned int>(residual) * 2;
+}
+
+// Estimates the Rice parameter that minimises the coded length of a partition given the sum of the folded residuals.
+static unsigned int getRiceParameter(double residualSum, unsigned int residualCount) {
+	unsigned int parameter = 0;
+	while (parameter < MAX_RICE_PARAMETER && double(residualCount) * double(2u << parameter) < residualSum) {
+		parameter++;
+	}
+	return parameter;
+}
+
+static double estimateRiceBitCount(double residualSum, unsigned int residualCount) {
+	unsigned int parameter = getRiceParameter(residualSum, residualCount);
+	return 4 + double(residualCount) * (parameter + 1) + residualSum / double(1u << parameter);
+}
+
+FLACEncoder::FLACEncoder(unsigned int useSampleRate, unsigned int useChannelCount) :
+	sampleRate(useSampleRate),
+	channelCount(useChannelCount < MAX_CHANNEL_COUNT ? useChannelCount : MAX_CHANNEL_COUNT),
+	blockFrameCount(0),
+	frameNumber(0),
+	totalFrameCount(0),
+	minFrameSize(0),
+	maxFrameSize(0),
+	midSamples(BLOCK_SIZE),
+	sideSamples(BLOCK_SIZE),
+	residual(BLOCK_SIZE),
+	bitBuffer(0),
+	bitBufferLength(0)
+{
+	for (unsigned int channel = 0; channel < channelCount; channel++) {
+		blockSamples[channel].resize(BLOCK_SIZE);
+	}
+}
+
+void FLACEncoder::makeStreamHeader(unsigned char *header) const {
+	memcpy(header, "fLaC", 4);
+	// Last-metadata-block flag set, block type STREAMINFO.
+	header[4] = 0x80;
+	header[5] = 0;
+	header[6] = 0;
+	header[7] = STREAMINFO_LENGTH;
+	header[8] = (BLOCK_SIZE >> 8) & 0xFF;
+	header[9] = BLOCK_SIZE & 0xFF;
+	header[10] = (BLOCK_SIZE >> 8) & 0xFF;
+	header[11] = BLOCK_SIZE & 0xFF;
+	header[12] = (minFrameSize >> 16) & 0xFF;
+	header[13] = (minFrameSize >> 8) & 0xFF;
+	header[14] = minFrameSize & 0xFF;
+	header[15] = (maxFrameSize >> 16) & 0xFF;
+	header[16] = (maxFrameSize >> 8) & 0xFF;
+	header[17] = maxFrameSize & 0xFF;
+	header[18] = (sampleRate >> 12) & 0xFF;
+	header[19] = (sampleRate >> 4) & 0xFF;
+	header[20] = ((sampleRate & 0x0F) << 4) | ((channelCount - 1) << 1) | ((BITS_PER_SAMPLE - 1) >> 4);
+	// The upper 4 bits of the 36-bit total sample count are always zero.
+	header[21] = ((BITS_PER_SAMPLE - 1) & 0x0F) << 4;
+	header[22] = (totalFrameCount >> 24) & 0xFF;
+	header[23] = (totalFrameCount >> 16) & 0xFF;
+	header[24] = (totalFrameCount >> 8) & 0xFF;
+	header[25] = totalFrameCount & 0xFF;
+	// MD5 signature is unknown.
+	memset(header + 26, 0, 16);
+}
+
+void FLACEncoder::addFrames(const short *samples, unsigned int frameCount) {
+	while (frameCount > 0) {
+		unsigned int framesToCopy = BLOCK_SIZE - blockFrameCount;
+		if (framesToCopy > frameCount) framesToCopy = frameCount;
+		for (unsigned int frameIx = blockFrameCount; frameIx < blockFrameCount + framesToCopy; frameIx++) {
+			for (unsigned int channel = 0; channel < channelCount; channel++) {
+				blockSamples[channel][frameIx] = *(samples++);
+			}
+		}
+		blockFrameCount += framesToCopy;
+		frameCount -= framesToCopy;
+		if (blockFrameCount == BLOCK_SIZE) encodeBlock();
+	}
+}
+
+void FLACEncoder::finish() {
+	if (blockFrameCount > 0) encodeBlock();
+}
+
+void FLACEncoder::encodeBlock() {
+	const unsigned int frameStart = getOutputSize();
+	const unsigned int sampleCount = blockFrameCount;
+
+	Subframe subframes[MAX_CHANNEL_COUNT];
+	const int *subframeSamples[MAX_CHANNEL_COUNT];
+	unsigned int subframeBitsPerSample[MAX_CHANNEL_COUNT];
+	unsigned int channelAssignment = channelCount - 1;
+	for (unsigned int channel = 0; channel < channelCount; channel++) {
+		subframeSamples[channel] = &blockSamples[channel][0];
+		subframeBitsPerSample[channel] = BITS_PER_SAMPLE;
+		subframes[channel] = analyseSubframe(subframeSamples[channel], sampleCount, BITS_PER_SAMPLE);
+	}
+
+	if (channelCount == 2) {
+		const int *left = subframeSamples[0];
+		const int *right = subframeSamples[1];
+		for (unsigned int i = 0; i < sampleCount; i++) {
+			midSamples[i] = (left[i] + right[i]) >> 1;
+			sideSamples[i] = left[i] - right[i];
+		}
+		// The side channel needs an extra bit.
+		Subframe mid = analyseSubframe(&midSamples[0], sampleCount, BITS_PER_SAMPLE);
+		Subframe side = analyseSubframe(&sideSamples[0], sampleCount, BITS_PER_SAMPLE + 1);
+		const Subframe leftSubframe = subframes[0];
+		const Subframe rightSubframe = subframes[1];
+		double bestBitCount = leftSubframe.bitCount + rightSubframe.bitCount;
+		if (leftSubframe.bitCount + side.bitCount < bestBitCount) {
+			bestBitCount = leftSubframe.bitCount + side.bitCount;
+			channelAssignment = CHANNEL_ASSIGNMENT_LEFT_SIDE;
+		}
+		if (side.bitCount + rightSubframe.bitCount < bestBitCount) {
+			bestBitCount = side.bitCount + rightSubframe.bitCount;
+			channelAssignment = CHANNEL_ASSIGNMENT_SIDE_RIGHT;
+		}
+		if (mid.bitCount + side.bitCount < bestBitCount) {
+			channelAssignment = CHANNEL_ASSIGNMENT_MID_SIDE;
+		}
+		switch (channelAssignment) {
+		case CHANNEL_ASSIGNMENT_LEFT_SIDE:
+			subframes[1] = side;
+			subframeSamples[1] = &sideSamples[0];
+			subframeBitsPerSample[1] = BITS_PER_SAMPLE + 1;
+			break;
+		case CHANNEL_ASSIGNMENT_SIDE_RIGHT:
+			subframes[0] = side;
+			subframeSamples[0] = &sideSamples[0];
+			subframeBitsPerSample[0] = BITS_PER_SAMPLE + 1;
+			break;
+		case CHANNEL_ASSIGNMENT_MID_SIDE:
+			subframes[0] = mid;
+			subframeSamples[0] = &midSamples[0];
+			subframes[1] = side;
+			subframeSamples[1] = &sideSamples[0];
+			subframeBitsPerSample[1] = BITS_PER_SAMPLE + 1;
+			break;
+		}
+	}
+
+	// Frame header: sync code and fixed-blocksize stream flag.
+	writeBits(0xFFF8, 16);
+	const unsigned int blockSizeCode = sampleCount == BLOCK_SIZE ? 12 : 7;
+	const unsigned int sampleRateCode = getSampleRateCode(sampleRate);
+	writeBits(blockSizeCode, 4);
+	writeBits(sampleRateCode, 4);
+	writeBits(channelAssignment, 4);
+	// Sample size code for 16 bits per sample followed by a reserved bit.
+	writeBits(4, 3);
+	writeBits(0, 1);
+	writeFrameNumber(frameNumber);
+	if (blockSizeCode == 7) writeBits(sampleCount - 1, 16);
+	switch (sampleRateCode) {
+	case 12:
+		writeBits(sampleRate / 1000, 8);
+		break;
+	case 13:
+		writeBits(sampleRate, 16);
+		break;
+	case 14:
+		writeBits(sampleRate / 10, 16);
+		break;
+	}
+	writeBits(computeCRC8(&output[frameStart], getOutputSize() - frameStart), 8);
+
+	for (unsigned int channel = 0; channel < channelCount; channel++) {
+		writeSubframe(subframes[channel], subframeSamples[channel], sampleCount, subframeBitsPerSample[channel]);
+	}
+	alignToByte();
+	writeBits(computeCRC16(&output[frameStart], getOutputSize() - frameStart), 16);
+
+	unsigned int frameSize = getOutputSize() - frameStart;
+	if (minFrameSize == 0 || frameSize < minFrameSize) minFrameSize = frameSize;
+	if (maxFrameSize < frameSize) maxFrameSize = frameSize;
+	frameNumber++;
+	totalFrameCount += sampleCount;
+	blockFrameCount = 0;
+}
+
+FLACEncoder::Subframe FLACEncoder::analyseSubframe(const int *samples, unsigned int sampleCount, unsigned int bitsPerSample) {
+	Subframe best;
+	best.order = 0;
+	best.partitionOrder = 0;
+
+	bool constant = true;
+	for (unsigned int i = 1; i < sampleCount; i++) {
+		if (samples[i] != samples[0]) {
+			constant = false;
+			break;
+		}
+	}
+	if (constant) {
+		best.type = SUBFRAME_TYPE_CONSTANT;
+		best.bitCount = 8 + bitsPerSample;
+		return best;
+	}
+
+	best.type = SUBFRAME_TYPE_VERBATIM;
+	best.bitCount = 8 + double(sampleCount) * bitsPerSample;
+	for (unsigned int order = 0; order <= MAX_FIXED_ORDER && order < sampleCount; order++) {
+		computeResidual(samples, sampleCount, order);
+		unsigned int partitionOrder;
+		double bitCount = 8 + order * bitsPerSample + estimateResidualBitCount(sampleCount, order, partitionOrder);
+		if (bitCount < best.bitCount) {
+			best.type = SUBFRAME_TYPE_FIXED;
+			best.order = order;
+			best.partitionOrder = partitionOrder;
+			best.bitCount = bitCount;
+		}
+	}
+	return best;
+}
+
+void FLACEncoder::writeSubframe(const Subframe &subframe, const int *samples, unsigned int sampleCount, unsigned int bitsPerSample) {
+	const unsigned int sampleMask = (1u << bitsPerSample) - 1;
+	// Zero padding bit, subframe type and no wasted bits.
+	writeBits((subframe.type | subframe.order) << 1, 8);
+	switch (subframe.type) {
+	case SUBFRAME_TYPE_CONSTANT:
+		writeBits(samples[0] & sampleMask, bitsPerSample);
+		break;
+	case SUBFRAME_TYPE_VERBATIM:
+		for (unsigned int i = 0; i < sampleCount; i++) {
+			writeBits(samples[i] & sampleMask, bitsPerSample);
+		}
+		break;
+	default:
+		for (unsigned int i = 0; i < subframe.order; i++) {
+			writeBits(samples[i] & sampleMask, bitsPerSample);
+		}
+		computeResidual(samples, sampleCount, subframe.order);
+		writeResidual(sampleCount, subframe.order, subframe.partitionOrder);
+		break;
+	}
+}
+
+void FLACEncoder::computeResidual(const int *samples, unsigned int sampleCount, unsigned int order) {
+	int *target = &residual[0];
+	unsigned int i = order;
+	switch (order) {
+	case 0:
+		for (; i < sampleCount; i++) target[i] = samples[i];
+		break;
+	case 1:
+		for (; i < sampleCount; i++) target[i] = samples[i] - samples[i - 1];
+		break;
+	case 2:
+		for (; i < sampleCount; i++) target[i] = samples[i] - 2 * samples[i - 1] + samples[i - 2];
+		break;
+	case 3:
+		for (; i < sampleCount; i++) target[i] = samples[i] - 3 * samples[i - 1] + 3 * samples[i - 2] - samples[i - 3];
+		break;
+	default:
+		for (; i < sampleCount; i++) target[i] = samples[i] - 4 * samples[i - 1] + 6 * samples[i - 2] - 4 * samples[i - 3] + samples[i - 4];
+		break;
+	}
+}
+
+double FLACEncoder::estimateResidualBitCount(unsigned int sampleCount, unsigned int order, unsigned int &bestPartitionOrder) {
+	unsigned int maxPartitionOrder = 0;
+	while (maxPartitionOrder < MAX_PARTITION_ORDER && (sampleCount & ((2u << maxPartitionOrder) - 1)) == 0 && (sampleCount >> (maxPartitionOrder + 1)) > order) {
+		maxPartitionOrder++;
+	}
+
+	// Sums of the folded residuals in the partitions of the finest order, merged pairwise for the coarser ones.
+	double sums[1 << MAX_PARTITION_ORDER];
+	unsigned int partitionCount = 1u << maxPartitionOrder;
+	unsigned int partitionSize = sampleCount >> maxPartitionOrder;
+	for (unsigned int partition = 0, i = order; partition < partitionCount; partition++) {
+		double sum = 0;
+		for (unsigned int end = (partition + 1) * partitionSize; i < end; i++) {
+			sum += foldSign(residual[i]);
+		}
+		sums[partition] = sum;
+	}
+
+	double bestBitCount = 0;
+	for (unsigned int partitionOrder = maxPartitionOrder + 1; partitionOrder-- > 0;) {
+		double bitCount = 6;
+		for (unsigned int partition = 0; partition < partitionCount; partition++) {
+			unsigned int residualCount = partition == 0 ? partitionSize - order : partitionSize;
+			bitCount += estimateRiceBitCount(sums[partition], residualCount);
+		}
+		if (partitionOrder == maxPartitionOrder || bitCount < bestBitCount) {
+			bestBitCount = bitCount;
+			bestPartitionOrder = partitionOrder;
+		}
+		partitionCount >>= 1;
+		partitionSize <<= 1;
+		for (unsigned int partition = 0; partition < partitionCount; partition++) {
+			sums[partition] = sums[2 * partition] + sums[2 * partition + 1];
+		}
+	}
+	return bestBitCount;
+}
+
+void FLACEncoder::writeResidual(unsigned int sampleCount, unsigned int order, unsigned int partitionOrder) {
+	// Coding method with 4-bit Rice parameters.
+	writeBits(0, 2);
+	writeBits(partitionOrder, 4);
+	const unsigned int partitionSize = sampleCount >> partitionOrder;
+	unsigned int i = order;
+	for (unsigned int partition = 0; partition < (1u << partitionOrder); partition++) {
+		const unsigned int end = (partition + 1) * partitionSize;
+		double sum = 0;
+		for (unsigned int j = i; j < end; j++) {
+			sum += foldSign(residual[j]);
+		}
+		const unsigned int parameter = getRiceParameter(sum, end - i);
+		const unsigned int lowBitsMask = (1u << parameter) - 1;
+		writeBits(parameter, 4);
+		for (; i < end; i++) {
+			unsigned int value = foldSign(residual[i]);
+			// Unary coded quotient: a run of zeros terminated by a one.
+			unsigned int quotient = value >> parameter;
+			while (quotient >= 16) {
+				writeBits(0, 16);
+				quotient -= 16;
+			}
+			writeBits(1, quotient + 1);
+			if (parameter > 0) writeBits(value & lowBitsMask, parameter);
+		}
+	}
+}
+
+void FLACEncoder::writeBits(unsigned int value, unsigned int bitCount) {
+	while (bitCount > 0) {
+		unsigned int bitsToWrite = 8 - bitBufferLength;
+		if (bitsToWrite > bitCount) bitsToWrite = bitCount;
+		bitCount -= bitsToWrite;
+		bitBuffer = (bitBuffer << bitsToWrite) | ((value >> bitCount) & ((1u << bitsToWrite) - 1));
+		bitBufferLength += bitsToWrite;
+		if (bitBufferLength == 8) {
+			output.push_back(static_cast<unsigned char>(bitBuffer));
+			bitBuffer = 0;
+			bitBufferLength = 0;
+		}
+	}
+}
+
+// The frame number is coded as in UTF-8, with up to 31 bits.
+void FLACEncoder::writeFrameNumber(unsigned long number) {
+	unsigned int value = static_cast<unsigned int>(number & 0x7FFFFFFF);
+	if (value < 0x80) {
+		writeBits(value, 8);
+		return;
+	}
+	unsigned int continuationByteCount = 1;
+	while (continuationByteCount < 5 && value >= (1u << (5 * continuationByteCount + 6))) {
+		continuationByteCount++;
+	}
+	unsigned int firstByteMarker = (0xFF00 >> (continuationByteCount + 1)) & 0xFF;
+	writeBits(firstByteMarker | (value >> (6 * continuationByteCount)), 8);
+	while (continuationByteCount-- > 0) {
+		writeBits(0x80 | ((value >> (6 * continuationByteCount)) & 0x3F), 8);
+	}
+}
+
+void FLACEncoder::alignToByte() {
+	if (bitBufferLength > 0) writeBits(0, 8 - bitBufferLength);
+}
@@ -0,0 +1,88 @@
+/* Copyright (C) 2011-2026 Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FLAC_ENCODER_H
+#define FLAC_ENCODER_H
+
+#include <cstddef>
+#include <vector>
+
+// Self-contained streaming encoder of 16-bit PCM audio into FLAC format.
+// Samples are grouped into fixed-size blocks, each encoded in a separate frame. In every subframe, the encoder picks
+// the best of the fixed linear predictors and Rice-codes the residual. For stereo, the best of the four channel
+// decorrelation modes is selected. Encoded frames are accumulated in the output buffer until the client clears it.
+// Note, the MD5 signature of the audio data is not computed, and the total sample count is limited to 32 bits.
+class FLACEncoder {
+public:
+	static const unsigned int BLOCK_SIZE = 4096;
+	static const unsigned int MAX_CHANNEL_COUNT = 8;
+	// Size of the stream marker followed by the STREAMINFO metadata block.
+	static const unsigned int STREAM_HEADER_SIZE = 42;
+
+	FLACEncoder(unsigned int sampleRate, unsigned int channelCount);
+
+	// Produces the stream marker and the STREAMINFO metadata block that reflects the frames encoded so far.
+	// The header should be written first, and rewritten once the encoding is finished if the output is seekable.
+	void makeStreamHeader(unsigned char *header) const;
+
+	// Consumes interleaved samples in native byte order. Each completed block is encoded to the output buffer.
+	void addFrames(const short *samples, unsigned int frameCount);
+	// Encodes the remaining incomplete block, if any.
+	void finish();
+
+	const unsigned char *getOutput() const { return output.empty() ? NULL : &output[0]; }
+	unsigned int getOutputSize() const { return static_cast<unsigned int>(output.size()); }
+	void clearOutput() { output.clear(); }
+
+private:
+	struct Subframe {
+		unsigned int type;
+		unsigned int order;
+		unsigned int partitionOrder;
+		double bitCount;
+	};
+
+	const unsigned int sampleRate;
+	const unsigned int channelCount;
+
+	std::vector<int> blockSamples[MAX_CHANNEL_COUNT];
+	unsigned int blockFrameCount;
+	unsigned long frameNumber;
+	unsigned long totalFrameCount;
+	unsigned int minFrameSize;
+	unsigned int maxFrameSize;
+
+	std::vector<int> midSamples;
+	std::vector<int> sideSamples;
+	std::vector<int> residual;
+
+	std::vector<unsigned char> output;
+	unsigned int bitBuffer;
+	unsigned int bitBufferLength;
+
+	void encodeBlock();
+	Subframe analyseSubframe(const int *samples, unsigned int sampleCount, unsigned int bitsPerSample);
+	void writeSubframe(const Subframe &subframe, const int *samples, unsigned int sampleCount, unsigned int bitsPerSample);
+	void computeResidual(const int *samples, unsigned int sampleCount, unsigned int order);
+	double estimateResidualBitCount(unsigned int sampleCount, unsigned int order, unsigned int &bestPartitionOrder);
+	void writeResidual(unsigned int sampleCount, unsigned int order, unsigned int partitionOrder);
+
+	void writeBits(unsigned int value, unsigned int bitCount);
+	void writeFrameNumber(unsigned long number);
+	void alignToByte();
+};
+
+#endif
@@ -0,0 +1,370 @@
+/* Copyright (C) 2011-2026 Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Round-trip test of FLACEncoder. The encoded streams are decoded by a minimal decoder that only supports
+// the features the encoder makes use of, and the decoded audio is compared with the source.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "FLACEncoder.h"
+
+namespace {
+
+class BitReader {
+public:
+	BitReader(const std::vector<unsigned char> &useData, size_t position) :
+		data(useData), bytePosition(position), bitPosition(0), failed(false)
+	{}
+
+	unsigned int readBits(unsigned int bitCount) {
+		unsigned int value = 0;
+		while (bitCount-- > 0) {
+			if (bytePosition >= data.size()) {
+				failed = true;
+				return 0;
+			}
+			value = (value << 1) | ((data[bytePosition] >> (7 - bitPosition)) & 1);
+			if (++bitPosition == 8) {
+				bitPosition = 0;
+				bytePosition++;
+			}
+		}
+		return value;
+	}
+
+	int readSignedBits(unsigned int bitCount) {
+		unsigned int value = readBits(bitCount);
+		return (value & (1u << (bitCount - 1))) ? int(value) - int(1u << bitCount) : int(value);
+	}
+
+	unsigned int readUnary() {
+		unsigned int value = 0;
+		while (!failed && readBits(1) == 0) value++;
+		return value;
+	}
+
+	void alignToByte() {
+		if (bitPosition > 0) {
+			bitPosition = 0;
+			bytePosition++;
+		}
+	}
+
+	size_t getBytePosition() const { return bytePosition; }
+	bool isFailed() const { return failed; }
+
+private:
+	const std::vector<unsigned char> &data;
+	size_t bytePosition;
+	unsigned int bitPosition;
+	bool failed;
+};
+
+unsigned int computeCRC(const unsigned char *data, size_t length, unsigned int width, unsigned int polynomial) {
+	const unsigned int topBit = 1u << (width - 1);
+	const unsigned int mask = (topBit << 1) - 1;
+	unsigned int crc = 0;
+	while (length-- > 0) {
+		crc ^= unsigned(*(data++)) << (width - 8);
+		for (int bit = 0; bit < 8; bit++) {
+			crc = ((crc & topBit) ? (crc << 1) ^ polynomial : crc << 1) & mask;
+		}
+	}
+	return crc;
+}
+
+struct DecodedStream {
+	unsigned int sampleRate;
+	unsigned int channelCount;
+	unsigned int totalFrameCount;
+	unsigned int minFrameSize;
+	unsigned int maxFrameSize;
+	std::vector<short> samples;
+};
+
+const char *decodeSubframe(BitReader &reader, unsigned int bitsPerSample, unsigned int sampleCount, int *samples) {
+	if (reader.readBits(1) != 0) return "subframe padding bit set";
+	unsigned int type = reader.readBits(6);
+	if (reader.readBits(1) != 0) return "wasted bits are unexpected";
+	if (type == 0) {
+		int value = reader.readSignedBits(bitsPerSample);
+		for (unsigned int i = 0; i < sampleCount; i++) samples[i] = value;
+		return NULL;
+	}
+	if (type == 1) {
+		for (unsigned int i = 0; i < sampleCount; i++) samples[i] = reader.readSignedBits(bitsPerSample);
+		return NULL;
+	}
+	if (type < 8 || 12 < type) return "unexpected subframe type";
+	const unsigned int order = type - 8;
+	for (unsigned int i = 0; i < order; i++) samples[i] = reader.readSignedBits(bitsPerSample);
+	if (reader.readBits(2) != 0) return "unexpected residual coding method";
+	const unsigned int partitionOrder = reader.readBits(4);
+	const unsigned int partitionSize = sampleCount >> partitionOrder;
+	if ((partitionSize << partitionOrder) != sampleCount || partitionSize < order) return "invalid partition order";
+	unsigned int i = order;
+	for (unsigned int partition = 0; partition < (1u << partitionOrder); partition++) {
+		unsigned int parameter = reader.readBits(4);
+		if (parameter == 15) return "escaped partitions are unexpected";
+		for (unsigned int end = (partition + 1) * partitionSize; i < end; i++) {
+			unsigned int value = (reader.readUnary() << parameter) | reader.readBits(parameter);
+			samples[i] = (value & 1) ? -int(value >> 1) - 1 : int(value >> 1);
+		}
+	}
+	static const int COEFFICIENTS[][4] = {{0, 0, 0, 0}, {1, 0, 0, 0}, {2, -1, 0, 0}, {3, -3, 1, 0}, {4, -6, 4, -1}};
+	for (i = order; i < sampleCount; i++) {
+		int prediction = 0;
+		for (unsigned int j = 0; j < order; j++) prediction += COEFFICIENTS[order][j] * samples[i - 1 - j];
+		samples[i] += prediction;
+	}
+	return NULL;
+}
+
+const char *decodeFrame(const std::vector<unsigned char> &data, size_t &position, DecodedStream &stream, unsigned int expectedFrameNumber) {
+	const size_t frameStart = position;
+	BitReader reader(data, position);
+	if (reader.readBits(16) != 0xFFF8) return "frame sync code or fixed-blocksize flag missing";
+	unsigned int blockSizeCode = reader.readBits(4);
+	unsigned int sampleRateCode = reader.readBits(4);
+	unsigned int channelAssignment = reader.readBits(4);
+	if (reader.readBits(3) != 4) return "sample size is not 16 bits";
+	if (reader.readBits(1) != 0) return "reserved bit set";
+
+	unsigned int frameNumber = reader.readBits(8);
+	unsigned int continuationByteCount = 0;
+	while (continuationByteCount < 6 && (frameNumber & (0x80 >> continuationByteCount))) continuationByteCount++;
+	if (continuationByteCount == 1) return "malformed frame number";
+	if (continuationByteCount > 0) {
+		frameNumber &= 0x7F >> continuationByteCount;
+		while (--continuationByteCount > 0) {
+			unsigned int continuation = reader.readBits(8);
+			if ((continuation & 0xC0) != 0x80) return "malformed frame number";
+			frameNumber = (frameNumber << 6) | (continuation & 0x3F);
+		}
+	}
+	if (frameNumber != expectedFrameNumber) return "unexpected frame number";
+
+	unsigned int blockSize;
+	if (blockSizeCode == 12) {
+		blockSize = FLACEncoder::BLOCK_SIZE;
+	} else if (blockSizeCode == 7) {
+		blockSize = reader.readBits(16) + 1;
+	} else {
+		return "unexpected block size code";
+	}
+	unsigned int sampleRate;
+	static const unsigned int SAMPLE_RATES[] = {0, 88200, 176400, 192000, 8000, 16000, 22050, 24000, 32000, 44100, 48000, 96000};
+	if (sampleRateCode == 0) {
+		sampleRate = stream.sampleRate;
+	} else if (sampleRateCode < 12) {
+		sampleRate = SAMPLE_RATES[sampleRateCode];
+	} else if (sampleRateCode == 12) {
+		sampleRate = reader.readBits(8) * 1000;
+	} else if (sampleRateCode == 13) {
+		sampleRate = reader.readBits(16);
+	} else if (sampleRateCode == 14) {
+		sampleRate = reader.readBits(16) * 10;
+	} else {
+		return "invalid sample rate code";
+	}
+	if (sampleRate != stream.sampleRate) return "frame sample rate mismatches STREAMINFO";
+	size_t headerEnd = reader.getBytePosition();
+	unsigned int crc8 = reader.readBits(8);
+	if (reader.isFailed() || computeCRC(&data[frameStart], headerEnd - frameStart, 8, 0x07) != crc8) return "frame header CRC mismatch";
+
+	unsigned int channelCount = channelAssignment < 8 ? channelAssignment + 1 : 2;
+	if (channelAssignment > 10 || channelCount != stream.channelCount) return "unexpected channel assignment";
+	std::vector<int> channels[FLACEncoder::MAX_CHANNEL_COUNT];
+	for (unsigned int channel = 0; channel < channelCount; channel++) {
+		bool side = (channelAssignment == 8 && channel == 1) || (channelAssignment == 9 && channel == 0) || (channelAssignment == 10 && channel == 1);
+		channels[channel].resize(blockSize);
+		const char *error = decodeSubframe(reader, side ? 17 : 16, blockSize, &channels[channel][0]);
+		if (error != NULL) return error;
+	}
+	reader.alignToByte();
+	size_t footerStart = reader.getBytePosition();
+	unsigned int crc16 = reader.readBits(16);
+	if (reader.isFailed() || computeCRC(&data[frameStart], footerStart - frameStart, 16, 0x8005) != crc16) return "frame CRC mismatch";
+
+	for (unsigned int i = 0; i < blockSize; i++) {
+		int *left = &channels[0][i];
+		int *right = &channels[1 % channelCount][i];
+		switch (channelAssignment) {
+		case 8:
+			*right = *left - *right;
+			break;
+		case 9:
+			*left += *right;
+			break;
+		case 10: {
+			int mid = (*left << 1) | (*right & 1);
+			int side = *right;
+			*left = (mid + side) >> 1;
+			*right = (mid - side) >> 1;
+			break;
+		}
+		}
+		for (unsigned int channel = 0; channel < channelCount; channel++) {
+			stream.samples.push_back(short(channels[channel][i]));
+		}
+	}
+	position = reader.getBytePosition();
+	unsigned int frameSize = unsigned(position - frameStart);
+	if (frameSize < stream.minFrameSize || stream.maxFrameSize < frameSize) return "frame size out of range given in STREAMINFO";
+	return NULL;
+}
+
+const char *decodeStream(const std::vector<unsigned char> &data, DecodedStream &stream) {
+	if (data.size() < FLACEncoder::STREAM_HEADER_SIZE || memcmp(&data[0], "fLaC", 4) != 0) return "stream marker missing";
+	BitReader reader(data, 4);
+	if (reader.readBits(1) != 1 || reader.readBits(7) != 0 || reader.readBits(24) != 34) return "unexpected metadata block";
+	if (reader.readBits(16) != FLACEncoder::BLOCK_SIZE || reader.readBits(16) != FLACEncoder::BLOCK_SIZE) return "unexpected block size in STREAMINFO";
+	stream.minFrameSize = reader.readBits(24);
+	stream.maxFrameSize = reader.readBits(24);
+	stream.sampleRate = reader.readBits(20);
+	stream.channelCount = reader.readBits(3) + 1;
+	if (reader.readBits(5) != 15) return "sample size in STREAMINFO is not 16 bits";
+	if (reader.readBits(4) != 0) return "total sample count exceeds 32 bits";
+	stream.totalFrameCount = reader.readBits(32);
+
+	size_t position = FLACEncoder::STREAM_HEADER_SIZE;
+	for (unsigned int frameNumber = 0; position < data.size(); frameNumber++) {
+		const char *error = decodeFrame(data, position, stream, frameNumber);
+		if (error != NULL) return error;
+	}
+	if (stream.samples.size() != size_t(stream.totalFrameCount) * stream.channelCount) return "sample count mismatches STREAMINFO";
+	return NULL;
+}
+
+// Deterministic, so that failures are reproducible.
+class NoiseGenerator {
+public:
+	NoiseGenerator() : state(12345) {}
+
+	int next(int amplitude) {
+		state = state * 1103515245u + 12345u;
+		return int((state >> 8) % (2u * unsigned(amplitude) + 1u)) - amplitude;
+	}
+
+private:
+	unsigned int state;
+};
+
+enum Signal {
+	SIGNAL_SILENCE,
+	SIGNAL_FULL_SCALE_NOISE,
+	SIGNAL_CORRELATED,
+	SIGNAL_LEFT_ONLY,
+	SIGNAL_EXTREMES
+};
+
+short generateSample(Signal signal, unsigned int frameIx, unsigned int channel, NoiseGenerator &noise) {
+	switch (signal) {
+	case SIGNAL_SILENCE:
+		return 0;
+	case SIGNAL_FULL_SCALE_NOISE:
+		return short(noise.next(32767));
+	case SIGNAL_CORRELATED: {
+		// A slow triangle wave with a little noise on top, nearly the same in all the channels.
+		int phase = int(frameIx % 400);
+		int wave = (phase < 200 ? phase : 400 - phase) * 150 - 15000;
+		return short(wave + noise.next(channel == 0 ? 3 : 5));
+	}
+	case SIGNAL_LEFT_ONLY:
+		return channel == 0 ? short(noise.next(2000)) : short(-7);
+	case SIGNAL_EXTREMES:
+		return short(((frameIx + channel) & 1) ? 32767 : -32768);
+	}
+	return 0;
+}
+
+const char *getSignalName(Signal signal) {
+	static const char * const NAMES[] = {"silence", "full-scale noise", "correlated", "left only", "extremes"};
+	return NAMES[signal];
+}
+
+// Encodes the signal, feeding it in chunks of the given size, and checks the decoded stream matches it.
+bool checkRoundTrip(Signal signal, unsigned int sampleRate, unsigned int channelCount, unsigned int frameCount, unsigned int chunkFrameCount) {
+	NoiseGenerator noise;
+	std::vector<short> source(size_t(frameCount) * channelCount);
+	for (unsigned int frameIx = 0; frameIx < frameCount; frameIx++) {
+		for (unsigned int channel = 0; channel < channelCount; channel++) {
+			source[frameIx * channelCount + channel] = generateSample(signal, frameIx, channel, noise);
+		}
+	}
+
+	FLACEncoder encoder(sampleRate, channelCount);
+	std::vector<unsigned char> encoded(FLACEncoder::STREAM_HEADER_SIZE);
+	for (unsigned int frameIx = 0; frameIx < frameCount; frameIx += chunkFrameCount) {
+		unsigned int chunkLength = frameCount - frameIx < chunkFrameCount ? frameCount - frameIx : chunkFrameCount;
+		encoder.addFrames(&source[frameIx * channelCount], chunkLength);
+		encoded.insert(encoded.end(), encoder.getOutput(), encoder.getOutput() + encoder.getOutputSize());
+		encoder.clearOutput();
+	}
+	encoder.finish();
+	if (encoder.getOutputSize() > 0) encoded.insert(encoded.end(), encoder.getOutput(), encoder.getOutput() + encoder.getOutputSize());
+	encoder.makeStreamHeader(&encoded[0]);
+
+	DecodedStream stream;
+	const char *error = decodeStream(encoded, stream);
+	if (error == NULL && (stream.sampleRate != sampleRate || stream.channelCount != channelCount || stream.totalFrameCount != frameCount)) {
+		error = "STREAMINFO mismatches the source";
+	}
+	if (error == NULL && (stream.samples.size() != source.size() || (frameCount > 0 && memcmp(&stream.samples[0], &source[0], source.size() * sizeof(short)) != 0))) {
+		error = "decoded samples differ from the source";
+	}
+	if (error != NULL) {
+		fprintf(stderr, "FAILED: %s signal, %u Hz, %u channels, %u frames in chunks of %u: %s\n", getSignalName(signal), sampleRate, channelCount, frameCount, chunkFrameCount, error);
+		return false;
+	}
+	return true;
+}
+
+} // namespace
+
+int main() {
+	static const Signal SIGNALS[] = {SIGNAL_SILENCE, SIGNAL_FULL_SCALE_NOISE, SIGNAL_CORRELATED, SIGNAL_LEFT_ONLY, SIGNAL_EXTREMES};
+	// Standard rates along with those coded in the frame header in kHz, Hz and tens of Hz.
+	static const unsigned int SAMPLE_RATES[] = {44100, 32000, 12000, 32123, 100000};
+	static const unsigned int CHANNEL_COUNTS[] = {1, 2, 3};
+	const unsigned int blockSize = FLACEncoder::BLOCK_SIZE;
+	// Empty, shorter than a block, several whole blocks and an incomplete trailing block.
+	const unsigned int frameCounts[] = {0, 1, 5, 1000, 3 * blockSize, 2 * blockSize + 77};
+
+	unsigned int failureCount = 0;
+	for (size_t signalIx = 0; signalIx < sizeof SIGNALS / sizeof SIGNALS[0]; signalIx++) {
+		for (size_t channelCountIx = 0; channelCountIx < sizeof CHANNEL_COUNTS / sizeof CHANNEL_COUNTS[0]; channelCountIx++) {
+			for (size_t frameCountIx = 0; frameCountIx < sizeof frameCounts / sizeof frameCounts[0]; frameCountIx++) {
+				if (!checkRoundTrip(SIGNALS[signalIx], 44100, CHANNEL_COUNTS[channelCountIx], frameCounts[frameCountIx], 1000)) failureCount++;
+			}
+		}
+	}
+	for (size_t sampleRateIx = 0; sampleRateIx < sizeof SAMPLE_RATES / sizeof SAMPLE_RATES[0]; sampleRateIx++) {
+		if (!checkRoundTrip(SIGNAL_CORRELATED, SAMPLE_RATES[sampleRateIx], 2, blockSize + 1, blockSize)) failureCount++;
+	}
+	// Frame numbers of 128 and beyond take more than one byte.
+	if (!checkRoundTrip(SIGNAL_CORRELATED, 48000, 2, 130 * blockSize, 7 * blockSize + 3)) failureCount++;
+
+	if (failureCount > 0) {
+		fprintf(stderr, "%u round-trip checks failed\n", failureCount);
+		return EXIT_FAILURE;
+	}
+	printf("All round-trip checks passed\n");
+	return EXIT_SUCCESS;
+}
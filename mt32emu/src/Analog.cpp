@@ -16,10 +16,13 @@
  */
 
 #include <cstring>
+#include <new>
 
 #include "internals.h"
 
 #include "Analog.h"
+#include "MemoryArena.h"
+#include "StateStream.h"
 #include "Synth.h"
 
 namespace MT32Emu {
@@ -101,31 +104,38 @@ static const unsigned int ACCURATE_LPF_PHASE_INCREMENT_OVERSAMPLED = 1; // No do
 static const Bit32u ACCURATE_LPF_DELTAS_REGULAR[][ACCURATE_LPF_NUMBER_OF_PHASES] = { { 0, 0, 0 }, { 1, 1, 0 }, { 1, 2, 1 } };
 static const Bit32u ACCURATE_LPF_DELTAS_OVERSAMPLED[][ACCURATE_LPF_NUMBER_OF_PHASES] = { { 0, 0, 0 }, { 1, 0, 0 }, { 1, 0, 1 } };
 
-template <class SampleEx>
-class AbstractLowPassFilter {
-public:
-	static AbstractLowPassFilter<SampleEx> &createLowPassFilter(const AnalogOutputMode mode, const bool oldMT32AnalogLPF);
-
-	virtual ~AbstractLowPassFilter() {}
-	virtual SampleEx process(const SampleEx sample) = 0;
+/* The low-pass filters below are not polymorphic. Instead, AnalogImpl is instantiated for each particular filter type,
+ * so that the filter is invoked directly and can be inlined in the per-sample processing loop.
+ */
 
-	virtual bool hasNextSample() const {
+// Defines default behaviour of a low-pass filter that outputs exactly one sample per input sample.
+class NativeRateLowPassFilter {
+public:
+	bool hasNextSample() const {
 		return false;
 	}
 
-	virtual unsigned int getOutputSampleRate() const {
+	unsigned int getOutputSampleRate() const {
 		return SAMPLE_RATE;
 	}
 
-	virtual unsigned int estimateInSampleCount(const unsigned int outSamples) const {
+	unsigned int estimateInSampleCount(const unsigned int outSamples) const {
 		return outSamples;
 	}
 
-	virtual void addPositionIncrement(const unsigned int) {}
+	void addPositionIncrement(const unsigned int) {}
+
+	void saveState(StateWriter &writer) const {
+		writer.write(Bit32u(0));
+	}
+
+	void loadState(StateReader &reader) {
+		reader.expect(Bit32u(0));
+	}
 };
 
 template <class SampleEx>
-class NullLowPassFilter : public AbstractLowPassFilter<SampleEx> {
+class NullLowPassFilter : public NativeRateLowPassFilter {
 public:
 	SampleEx process(const SampleEx sample) {
 		return sample;
@@ -133,7 +143,7 @@ public:
 };
 
 template <class SampleEx>
-class CoarseLowPassFilter : public AbstractLowPassFilter<SampleEx> {
+class CoarseLowPassFilter : public NativeRateLowPassFilter {
 private:
 	const SampleEx * const lpfTaps;
 	SampleEx ringBuffer[COARSE_LPF_DELAY_LINE_LENGTH];
@@ -164,9 +174,23 @@ public:
 
 		return normaliseSample(sample);
 	}
+
+	void saveState(StateWriter &writer) const {
+		writer.write(COARSE_LPF_DELAY_LINE_LENGTH);
+		writer.write(ringBuffer);
+		writer.write(ringBufferPosition);
+	}
+
+	void loadState(StateReader &reader) {
+		reader.expect(COARSE_LPF_DELAY_LINE_LENGTH);
+		reader.read(ringBuffer);
+		reader.read(ringBufferPosition);
+		ringBufferPosition &= COARSE_LPF_DELAY_LINE_LENGTH - 1;
+		if (reader.isFailed()) Synth::muteSampleBuffer(ringBuffer, COARSE_LPF_DELAY_LINE_LENGTH);
+	}
 };
 
-class AccurateLowPassFilter : public AbstractLowPassFilter<IntSampleEx>, public AbstractLowPassFilter<FloatSample> {
+class AccurateLowPassFilter {
 private:
 	const FloatSample * const LPF_TAPS;
 	const Bit32u (* const deltas)[ACCURATE_LPF_NUMBER_OF_PHASES];
@@ -185,6 +209,8 @@ public:
 	unsigned int getOutputSampleRate() const;
 	unsigned int estimateInSampleCount(const unsigned int outSamples) const;
 	void addPositionIncrement(const unsigned int positionIncrement);
+	void saveState(StateWriter &writer) const;
+	void loadState(StateReader &reader);
 };
 
 static inline IntSampleEx normaliseSample(const IntSampleEx sample) {
@@ -203,26 +229,45 @@ static inline IntSampleEx getIntOutputGain(const float outputGain) {
 	return IntSampleEx(((OUTPUT_GAIN_MULTIPLIER < outputGain) ? OUTPUT_GAIN_MULTIPLIER : outputGain) * OUTPUT_GAIN_MULTIPLIER);
 }
 
+static inline void setOutputGain(IntSampleEx &targetGain, const float gain) {
+	targetGain = getIntOutputGain(gain);
+}
+
+static inline void setOutputGain(FloatSample &targetGain, const float gain) {
+	targetGain = gain;
+}
+
+// Maps the type of samples used in computations to the type of samples in the DAC streams and the output stream.
 template <class SampleEx>
+struct StreamSample;
+
+template <>
+struct StreamSample<IntSampleEx> {
+	typedef IntSample Type;
+};
+
+template <>
+struct StreamSample<FloatSample> {
+	typedef FloatSample Type;
+};
+
+template <class SampleEx, class LowPassFilter>
 class AnalogImpl : public Analog {
 public:
-	AbstractLowPassFilter<SampleEx> &leftChannelLPF;
-	AbstractLowPassFilter<SampleEx> &rightChannelLPF;
+	typedef typename StreamSample<SampleEx>::Type Sample;
+
+	LowPassFilter leftChannelLPF;
+	LowPassFilter rightChannelLPF;
 	SampleEx synthGain;
 	SampleEx reverbGain;
 
-	AnalogImpl(const AnalogOutputMode mode, const bool oldMT32AnalogLPF) :
-		leftChannelLPF(AbstractLowPassFilter<SampleEx>::createLowPassFilter(mode, oldMT32AnalogLPF)),
-		rightChannelLPF(AbstractLowPassFilter<SampleEx>::createLowPassFilter(mode, oldMT32AnalogLPF)),
+	explicit AnalogImpl(const LowPassFilter &lpf) :
+		leftChannelLPF(lpf),
+		rightChannelLPF(lpf),
 		synthGain(0),
 		reverbGain(0)
 	{}
 
-	~AnalogImpl() {
-		delete &leftChannelLPF;
-		delete &rightChannelLPF;
-	}
-
 	unsigned int getOutputSampleRate() const {
 		return leftChannelLPF.getOutputSampleRate();
 	}
@@ -231,27 +276,55 @@ public:
 		return leftChannelLPF.estimateInSampleCount(outputLength);
 	}
 
-	void setSynthOutputGain(const float synthGain);
-	void setReverbOutputGain(const float reverbGain, const bool mt32ReverbCompatibilityMode);
+	void setSynthOutputGain(const float useSynthGain) {
+		setOutputGain(synthGain, useSynthGain);
+	}
+
+	void setReverbOutputGain(const float useReverbGain, const bool mt32ReverbCompatibilityMode) {
+		setOutputGain(reverbGain, getActualReverbOutputGain(useReverbGain, mt32ReverbCompatibilityMode));
+	}
+
+	void saveState(StateWriter &writer) const {
+		leftChannelLPF.saveState(writer);
+		rightChannelLPF.saveState(writer);
+	}
+
+	void loadState(StateReader &reader) {
+		leftChannelLPF.loadState(reader);
+		rightChannelLPF.loadState(reader);
+	}
+
+	bool process(const OutputChannels<IntSample> &out, const IntSample *nonReverbLeft, const IntSample *nonReverbRight, const IntSample *reverbDryLeft, const IntSample *reverbDryRight, const IntSample *reverbWetLeft, const IntSample *reverbWetRight, Bit32u outLength) {
+		return produceOutput(out, nonReverbLeft, nonReverbRight, reverbDryLeft, reverbDryRight, reverbWetLeft, reverbWetRight, outLength);
+	}
+
+	bool process(const OutputChannels<FloatSample> &out, const FloatSample *nonReverbLeft, const FloatSample *nonReverbRight, const FloatSample *reverbDryLeft, const FloatSample *reverbDryRight, const FloatSample *reverbWetLeft, const FloatSample *reverbWetRight, Bit32u outLength) {
+		return produceOutput(out, nonReverbLeft, nonReverbRight, reverbDryLeft, reverbDryRight, reverbWetLeft, reverbWetRight, outLength);
+	}
 
-	bool process(IntSample *outStream, const IntSample *nonReverbLeft, const IntSample *nonReverbRight, const IntSample *reverbDryLeft, const IntSample *reverbDryRight, const IntSample *reverbWetLeft, const IntSample *reverbWetRight, Bit32u outLength);
-	bool process(FloatSample *outStream, const FloatSample *nonReverbLeft, const FloatSample *nonReverbRight, const FloatSample *reverbDryLeft, const FloatSample *reverbDryRight, const FloatSample *reverbWetLeft, const FloatSample *reverbWetRight, Bit32u outLength);
+	// Streams of samples that do not match the renderer type are refused.
+	template <class OtherSample>
+	bool produceOutput(const OutputChannels<OtherSample> &, const OtherSample *, const OtherSample *, const OtherSample *, const OtherSample *, const OtherSample *, const OtherSample *, Bit32u) {
+		return false;
+	}
 
-	template <class Sample>
-	void produceOutput(Sample *outStream, const Sample *nonReverbLeft, const Sample *nonReverbRight, const Sample *reverbDryLeft, const Sample *reverbDryRight, const Sample *reverbWetLeft, const Sample *reverbWetRight, Bit32u outLength) {
-		if (outStream == NULL) {
+	bool produceOutput(const OutputChannels<Sample> &out, const Sample *nonReverbLeft, const Sample *nonReverbRight, const Sample *reverbDryLeft, const Sample *reverbDryRight, const Sample *reverbWetLeft, const Sample *reverbWetRight, Bit32u outLength) {
+		if (out.left == NULL) {
 			leftChannelLPF.addPositionIncrement(outLength);
 			rightChannelLPF.addPositionIncrement(outLength);
-			return;
+			return true;
 		}
 
+		Sample *outLeft = out.left;
+		Sample *outRight = out.right;
+		const Bit32u stride = out.stride;
 		while (0 < (outLength--)) {
 			SampleEx outSampleL;
 			SampleEx outSampleR;
 
 			if (leftChannelLPF.hasNextSample()) {
-				outSampleL = leftChannelLPF.process(0);
-				outSampleR = rightChannelLPF.process(0);
+				outSampleL = leftChannelLPF.process(SampleEx(0));
+				outSampleR = rightChannelLPF.process(SampleEx(0));
 			} else {
 				SampleEx inSampleL = (SampleEx(*(nonReverbLeft++)) + SampleEx(*(reverbDryLeft++))) * synthGain + SampleEx(*(reverbWetLeft++)) * reverbGain;
 				SampleEx inSampleR = (SampleEx(*(nonReverbRight++)) + SampleEx(*(reverbDryRight++))) * synthGain + SampleEx(*(reverbWetRight++)) * reverbGain;
@@ -260,93 +333,75 @@ public:
 				outSampleR = rightChannelLPF.process(normaliseSample(inSampleR));
 			}
 
-			*(outStream++) = Synth::clipSampleEx(outSampleL);
-			*(outStream++) = Synth::clipSampleEx(outSampleR);
+			*outLeft = Synth::clipSampleEx(outSampleL);
+			*outRight = Synth::clipSampleEx(outSampleR);
+			outLeft += stride;
+			outRight += stride;
 		}
+		return true;
 	}
 };
 
-Analog *Analog::createAnalog(const AnalogOutputMode mode, const bool oldMT32AnalogLPF, const RendererType rendererType) {
+// Allocates the object on the heap when the arena is NULL.
+template <class SampleEx, class LowPassFilter>
+static Analog *newAnalogImpl(const LowPassFilter &lpf, MemoryArena *arena) {
+	typedef AnalogImpl<SampleEx, LowPassFilter> Impl;
+	if (arena == NULL) return new Impl(lpf);
+	void *memory = arena->allocate(sizeof(Impl));
+	return memory == NULL ? NULL : new(memory) Impl(lpf);
+}
+
+template <class SampleEx>
+static Analog *createAnalogImpl(const AnalogOutputMode mode, const bool oldMT32AnalogLPF, MemoryArena *arena) {
+	switch (mode) {
+	case AnalogOutputMode_COARSE:
+		return newAnalogImpl<SampleEx>(CoarseLowPassFilter<SampleEx>(oldMT32AnalogLPF), arena);
+	case AnalogOutputMode_ACCURATE:
+		return newAnalogImpl<SampleEx>(AccurateLowPassFilter(oldMT32AnalogLPF, false), arena);
+	case AnalogOutputMode_OVERSAMPLED:
+		return newAnalogImpl<SampleEx>(AccurateLowPassFilter(oldMT32AnalogLPF, true), arena);
+	default:
+		return newAnalogImpl<SampleEx>(NullLowPassFilter<SampleEx>(), arena);
+	}
+}
+
+template <class SampleEx>
+static size_t getAnalogImplSize(const AnalogOutputMode mode) {
+	switch (mode) {
+	case AnalogOutputMode_COARSE:
+		return sizeof(AnalogImpl<SampleEx, CoarseLowPassFilter<SampleEx> >);
+	case AnalogOutputMode_ACCURATE:
+	case AnalogOutputMode_OVERSAMPLED:
+		return sizeof(AnalogImpl<SampleEx, AccurateLowPassFilter>);
+	default:
+		return sizeof(AnalogImpl<SampleEx, NullLowPassFilter<SampleEx> >);
+	}
+}
+
+static Analog *createAnalogForRenderer(const AnalogOutputMode mode, const bool oldMT32AnalogLPF, const RendererType rendererType, MemoryArena *arena) {
 	switch (rendererType)
 	{
 	case RendererType_BIT16S:
-		return new AnalogImpl<IntSampleEx>(mode, oldMT32AnalogLPF);
+		return createAnalogImpl<IntSampleEx>(mode, oldMT32AnalogLPF, arena);
 	case RendererType_FLOAT:
-		return new AnalogImpl<FloatSample>(mode, oldMT32AnalogLPF);
+		return createAnalogImpl<FloatSample>(mode, oldMT32AnalogLPF, arena);
 	default:
 		break;
 	}
 	return NULL;
 }
 
-template<>
-bool AnalogImpl<IntSampleEx>::process(IntSample *outStream, const IntSample *nonReverbLeft, const IntSample *nonReverbRight, const IntSample *reverbDryLeft, const IntSample *reverbDryRight, const IntSample *reverbWetLeft, const IntSample *reverbWetRight, Bit32u outLength) {
-	produceOutput(outStream, nonReverbLeft, nonReverbRight, reverbDryLeft, reverbDryRight, reverbWetLeft, reverbWetRight, outLength);
-	return true;
-}
-
-template<>
-bool AnalogImpl<FloatSample>::process(IntSample *, const IntSample *, const IntSample *, const IntSample *, const IntSample *, const IntSample *, const IntSample *, Bit32u) {
-	return false;
-}
-
-template<>
-bool AnalogImpl<IntSampleEx>::process(FloatSample *, const FloatSample *, const FloatSample *, const FloatSample *, const FloatSample *, const FloatSample *, const FloatSample *, Bit32u) {
-	return false;
-}
-
-template<>
-bool AnalogImpl<FloatSample>::process(FloatSample *outStream, const FloatSample *nonReverbLeft, const FloatSample *nonReverbRight, const FloatSample *reverbDryLeft, const FloatSample *reverbDryRight, const FloatSample *reverbWetLeft, const FloatSample *reverbWetRight, Bit32u outLength) {
-	produceOutput(outStream, nonReverbLeft, nonReverbRight, reverbDryLeft, reverbDryRight, reverbWetLeft, reverbWetRight, outLength);
-	return true;
-}
-
-template<>
-void AnalogImpl<IntSampleEx>::setSynthOutputGain(const float useSynthGain) {
-	synthGain = getIntOutputGain(useSynthGain);
-}
-
-template<>
-void AnalogImpl<IntSampleEx>::setReverbOutputGain(const float useReverbGain, const bool mt32ReverbCompatibilityMode) {
-	reverbGain = getIntOutputGain(getActualReverbOutputGain(useReverbGain, mt32ReverbCompatibilityMode));
-}
-
-template<>
-void AnalogImpl<FloatSample>::setSynthOutputGain(const float useSynthGain) {
-	synthGain = useSynthGain;
-}
-
-template<>
-void AnalogImpl<FloatSample>::setReverbOutputGain(const float useReverbGain, const bool mt32ReverbCompatibilityMode) {
-	reverbGain = getActualReverbOutputGain(useReverbGain, mt32ReverbCompatibilityMode);
+Analog *Analog::createAnalog(const AnalogOutputMode mode, const bool oldMT32AnalogLPF, const RendererType rendererType) {
+	return createAnalogForRenderer(mode, oldMT32AnalogLPF, rendererType, NULL);
 }
 
-template<>
-AbstractLowPassFilter<IntSampleEx> &AbstractLowPassFilter<IntSampleEx>::createLowPassFilter(AnalogOutputMode mode, bool oldMT32AnalogLPF) {
-	switch (mode) {
-	case AnalogOutputMode_COARSE:
-		return *new CoarseLowPassFilter<IntSampleEx>(oldMT32AnalogLPF);
-	case AnalogOutputMode_ACCURATE:
-		return *new AccurateLowPassFilter(oldMT32AnalogLPF, false);
-	case AnalogOutputMode_OVERSAMPLED:
-		return *new AccurateLowPassFilter(oldMT32AnalogLPF, true);
-	default:
-		return *new NullLowPassFilter<IntSampleEx>;
-	}
+Analog *Analog::createAnalog(const AnalogOutputMode mode, const bool oldMT32AnalogLPF, const RendererType rendererType, MemoryArena &arena) {
+	return createAnalogForRenderer(mode, oldMT32AnalogLPF, rendererType, &arena);
 }
 
-template<>
-AbstractLowPassFilter<FloatSample> &AbstractLowPassFilter<FloatSample>::createLowPassFilter(AnalogOutputMode mode, bool oldMT32AnalogLPF) {
-	switch (mode) {
-		case AnalogOutputMode_COARSE:
-			return *new CoarseLowPassFilter<FloatSample>(oldMT32AnalogLPF);
-		case AnalogOutputMode_ACCURATE:
-			return *new AccurateLowPassFilter(oldMT32AnalogLPF, false);
-		case AnalogOutputMode_OVERSAMPLED:
-			return *new AccurateLowPassFilter(oldMT32AnalogLPF, true);
-		default:
-			return *new NullLowPassFilter<FloatSample>;
-	}
+size_t Analog::getArenaSize(const AnalogOutputMode mode, const RendererType rendererType) {
+	size_t size = rendererType == RendererType_FLOAT ? getAnalogImplSize<FloatSample>(mode) : getAnalogImplSize<IntSampleEx>(mode);
+	return MemoryArena::getChunkSize(size);
 }
 
 template<>
@@ -423,4 +478,23 @@ void AccurateLowPassFilter::addPositionIncrement(const unsigned int positionIncr
 	phase = (phase + positionIncrement * phaseIncrement) % ACCURATE_LPF_NUMBER_OF_PHASES;
 }
 
+void AccurateLowPassFilter::saveState(StateWriter &writer) const {
+	writer.write(ACCURATE_LPF_DELAY_LINE_LENGTH);
+	writer.write(phaseIncrement);
+	writer.write(ringBuffer);
+	writer.write(ringBufferPosition);
+	writer.write(phase);
+}
+
+void AccurateLowPassFilter::loadState(StateReader &reader) {
+	reader.expect(ACCURATE_LPF_DELAY_LINE_LENGTH);
+	reader.expect(phaseIncrement);
+	reader.read(ringBuffer);
+	reader.read(ringBufferPosition);
+	reader.read(phase);
+	ringBufferPosition &= ACCURATE_LPF_DELAY_LINE_LENGTH - 1;
+	phase %= ACCURATE_LPF_NUMBER_OF_PHASES;
+	if (reader.isFailed()) Synth::muteSampleBuffer(ringBuffer, ACCURATE_LPF_DELAY_LINE_LENGTH);
+}
+
 } // namespace MT32Emu
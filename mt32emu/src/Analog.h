@@ -18,6 +18,8 @@
 #ifndef MT32EMU_ANALOG_H
 #define MT32EMU_ANALOG_H
 
+#include <cstddef>
+
 #include "globals.h"
 #include "internals.h"
 #include "Enumerations.h"
@@ -25,6 +27,20 @@
 
 namespace MT32Emu {
 
+class MemoryArena;
+class StateReader;
+class StateWriter;
+
+// Locations of the left and right channels in the output. The successive samples of a channel are placed stride samples apart,
+// so that the stereo output can be produced either interleaved (stride 2) or planar (stride 1) without an intermediate buffer.
+// When left is NULL, no output is produced.
+template <class Sample>
+struct OutputChannels {
+	Sample *left;
+	Sample *right;
+	Bit32u stride;
+};
+
 /* Analog class is dedicated to perform fair emulation of analogue circuitry of hardware units that is responsible
  * for processing output signal after the DAC. It appears that the analogue circuit labeled "LPF" on the schematic
  * also applies audible changes to the signal spectra. There is a significant boost of higher frequencies observed
@@ -37,6 +53,10 @@ namespace MT32Emu {
 class Analog {
 public:
 	static Analog *createAnalog(const AnalogOutputMode mode, const bool oldMT32AnalogLPF, const RendererType rendererType);
+	// Same as above but the object along with the LPF state is placed in the arena, so it must be destroyed explicitly.
+	static Analog *createAnalog(const AnalogOutputMode mode, const bool oldMT32AnalogLPF, const RendererType rendererType, MemoryArena &arena);
+	// Returns the amount of arena memory needed to create an object with the specified configuration.
+	static size_t getArenaSize(const AnalogOutputMode mode, const RendererType rendererType);
 
 	virtual ~Analog() {}
 	virtual unsigned int getOutputSampleRate() const = 0;
@@ -44,8 +64,23 @@ public:
 	virtual void setSynthOutputGain(const float synthGain) = 0;
 	virtual void setReverbOutputGain(const float reverbGain, const bool mt32ReverbCompatibilityMode) = 0;
 
-	virtual bool process(IntSample *outStream, const IntSample *nonReverbLeft, const IntSample *nonReverbRight, const IntSample *reverbDryLeft, const IntSample *reverbDryRight, const IntSample *reverbWetLeft, const IntSample *reverbWetRight, Bit32u outLength) = 0;
-	virtual bool process(FloatSample *outStream, const FloatSample *nonReverbLeft, const FloatSample *nonReverbRight, const FloatSample *reverbDryLeft, const FloatSample *reverbDryRight, const FloatSample *reverbWetLeft, const FloatSample *reverbWetRight, Bit32u outLength) = 0;
+	virtual bool process(const OutputChannels<IntSample> &out, const IntSample *nonReverbLeft, const IntSample *nonReverbRight, const IntSample *reverbDryLeft, const IntSample *reverbDryRight, const IntSample *reverbWetLeft, const IntSample *reverbWetRight, Bit32u outLength) = 0;
+	virtual bool process(const OutputChannels<FloatSample> &out, const FloatSample *nonReverbLeft, const FloatSample *nonReverbRight, const FloatSample *reverbDryLeft, const FloatSample *reverbDryRight, const FloatSample *reverbWetLeft, const FloatSample *reverbWetRight, Bit32u outLength) = 0;
+
+	// Same as above but produce interleaved stereo output.
+	bool process(IntSample *outStream, const IntSample *nonReverbLeft, const IntSample *nonReverbRight, const IntSample *reverbDryLeft, const IntSample *reverbDryRight, const IntSample *reverbWetLeft, const IntSample *reverbWetRight, Bit32u outLength) {
+		const OutputChannels<IntSample> out = { outStream, outStream + 1, 2 };
+		return process(out, nonReverbLeft, nonReverbRight, reverbDryLeft, reverbDryRight, reverbWetLeft, reverbWetRight, outLength);
+	}
+
+	bool process(FloatSample *outStream, const FloatSample *nonReverbLeft, const FloatSample *nonReverbRight, const FloatSample *reverbDryLeft, const FloatSample *reverbDryRight, const FloatSample *reverbWetLeft, const FloatSample *reverbWetRight, Bit32u outLength) {
+		const OutputChannels<FloatSample> out = { outStream, outStream + 1, 2 };
+		return process(out, nonReverbLeft, nonReverbRight, reverbDryLeft, reverbDryRight, reverbWetLeft, reverbWetRight, outLength);
+	}
+	// Store and restore the history of the LPF. The output gains are client settings and thus aren't included.
+	// If the state cannot be read, the history is cleared.
+	virtual void saveState(StateWriter &writer) const = 0;
+	virtual void loadState(StateReader &reader) = 0;
 };
 
 } // namespace MT32Emu
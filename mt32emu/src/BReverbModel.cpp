@@ -20,6 +20,7 @@
 #include "internals.h"
 
 #include "BReverbModel.h"
+#include "StateStream.h"
 #include "Synth.h"
 
 // Analysing of state of reverb RAM address lines gives exact sizes of the buffers of filters used. This also indicates that
@@ -283,13 +284,18 @@ protected:
 	Bit32u index;
 
 public:
-	RingBuffer(const Bit32u newsize) : size(newsize), index(0) {
-		buffer = new Sample[size];
+	RingBuffer(const Bit32u newsize) : buffer(NULL), size(newsize), index(0) {}
+
+	virtual ~RingBuffer() {}
+
+	Bit32u getSize() const {
+		return size;
 	}
 
-	virtual ~RingBuffer() {
-		delete[] buffer;
-		buffer = NULL;
+	// The buffer memory is owned by the reverb model.
+	void setBuffer(Sample *newBuffer) {
+		buffer = newBuffer;
+		index = 0;
 	}
 
 	Sample next() {
@@ -313,6 +319,22 @@ public:
 	void mute() {
 		Synth::muteSampleBuffer(buffer, size);
 	}
+
+	virtual void saveState(StateWriter &writer) const {
+		writer.write(size);
+		writer.write(index);
+		writer.writeBytes(buffer, size * sizeof(Sample));
+	}
+
+	virtual void loadState(StateReader &reader) {
+		reader.expect(size);
+		Bit32u newIndex;
+		reader.read(newIndex);
+		if (size <= newIndex) reader.fail();
+		if (reader.isFailed()) return;
+		index = newIndex;
+		reader.readBytes(buffer, size * sizeof(Sample));
+	}
 };
 
 template<>
@@ -372,6 +394,16 @@ public:
 	void setFeedbackFactor(const Bit8u useFeedbackFactor) {
 		feedbackFactor = useFeedbackFactor;
 	}
+
+	void saveState(StateWriter &writer) const {
+		RingBuffer<Sample>::saveState(writer);
+		writer.write(feedbackFactor);
+	}
+
+	void loadState(StateReader &reader) {
+		RingBuffer<Sample>::loadState(reader);
+		reader.read(feedbackFactor);
+	}
 };
 
 template <class Sample>
@@ -432,6 +464,18 @@ public:
 		outL = useOutL;
 		outR = useOutR;
 	}
+
+	void saveState(StateWriter &writer) const {
+		CombFilter<Sample>::saveState(writer);
+		writer.write(outL);
+		writer.write(outR);
+	}
+
+	void loadState(StateReader &reader) {
+		CombFilter<Sample>::loadState(reader);
+		reader.read(outL);
+		reader.read(outR);
+	}
 };
 
 template <class Sample>
@@ -445,22 +489,15 @@ public:
 	Bit8u dryAmp;
 	Bit8u wetLevel;
 
+	// The filters are created up front, their delay lines are bound to the memory provided in open().
+	Sample *delayLineMemory;
+
 	BReverbModelImpl(const ReverbMode mode, const bool mt32CompatibleModel) :
 		allpasses(NULL), combs(NULL),
 		currentSettings(mt32CompatibleModel ? getMT32Settings(mode) : getCM32L_LAPCSettings(mode)),
-		tapDelayMode(mode == REVERB_MODE_TAP_DELAY)
-	{}
-
-	~BReverbModelImpl() {
-		close();
-	}
-
-	bool isOpen() const {
-		return combs != NULL;
-	}
-
-	void open() {
-		if (isOpen()) return;
+		tapDelayMode(mode == REVERB_MODE_TAP_DELAY),
+		delayLineMemory(NULL)
+	{
 		if (currentSettings.numberOfAllpasses > 0) {
 			allpasses = new AllpassFilter<Sample>*[currentSettings.numberOfAllpasses];
 			for (Bit32u i = 0; i < currentSettings.numberOfAllpasses; i++) {
@@ -476,42 +513,69 @@ public:
 				combs[i] = new CombFilter<Sample>(currentSettings.combSizes[i], currentSettings.filterFactors[i]);
 			}
 		}
-		mute();
 	}
 
-	void close() {
+	~BReverbModelImpl() {
 		if (allpasses != NULL) {
 			for (Bit32u i = 0; i < currentSettings.numberOfAllpasses; i++) {
-				if (allpasses[i] != NULL) {
-					delete allpasses[i];
-					allpasses[i] = NULL;
-				}
+				delete allpasses[i];
 			}
 			delete[] allpasses;
-			allpasses = NULL;
 		}
-		if (combs != NULL) {
-			for (Bit32u i = 0; i < currentSettings.numberOfCombs; i++) {
-				if (combs[i] != NULL) {
-					delete combs[i];
-					combs[i] = NULL;
-				}
-			}
-			delete[] combs;
-			combs = NULL;
+		for (Bit32u i = 0; i < currentSettings.numberOfCombs; i++) {
+			delete combs[i];
 		}
+		delete[] combs;
+	}
+
+	bool isOpen() const {
+		return delayLineMemory != NULL;
+	}
+
+	size_t getDelayLineMemorySize() const {
+		Bit32u sampleCount = 0;
+		for (Bit32u i = 0; i < currentSettings.numberOfAllpasses; i++) {
+			sampleCount += allpasses[i]->getSize();
+		}
+		for (Bit32u i = 0; i < currentSettings.numberOfCombs; i++) {
+			sampleCount += combs[i]->getSize();
+		}
+		return sampleCount * sizeof(Sample);
+	}
+
+	void open(void *useDelayLineMemory) {
+		if (isOpen()) return;
+		delayLineMemory = static_cast<Sample *>(useDelayLineMemory);
+		Sample *nextBuffer = delayLineMemory;
+		for (Bit32u i = 0; i < currentSettings.numberOfAllpasses; i++) {
+			allpasses[i]->setBuffer(nextBuffer);
+			nextBuffer += allpasses[i]->getSize();
+		}
+		for (Bit32u i = 0; i < currentSettings.numberOfCombs; i++) {
+			combs[i]->setBuffer(nextBuffer);
+			nextBuffer += combs[i]->getSize();
+		}
+		mute();
+	}
+
+	void close() {
+		if (!isOpen()) return;
+		for (Bit32u i = 0; i < currentSettings.numberOfAllpasses; i++) {
+			allpasses[i]->setBuffer(NULL);
+		}
+		for (Bit32u i = 0; i < currentSettings.numberOfCombs; i++) {
+			combs[i]->setBuffer(NULL);
+		}
+		delayLineMemory = NULL;
 	}
 
 	void mute() {
-		if (allpasses != NULL) {
-			for (Bit32u i = 0; i < currentSettings.numberOfAllpasses; i++) {
-				allpasses[i]->mute();
-			}
+		if (!isOpen()) return;
+		for (Bit32u i = 0; i < currentSettings.numberOfAllpasses; i++) {
+			allpasses[i]->mute();
 		}
-		if (combs != NULL) {
-			for (Bit32u i = 0; i < currentSettings.numberOfCombs; i++) {
-				combs[i]->mute();
-			}
+		for (Bit32u i = 0; i < currentSettings.numberOfCombs; i++) {
+			combs[i]->mute();
 		}
 	}
 
@@ -557,6 +621,29 @@ public:
 		return &currentSettings == &getMT32Settings(mode);
 	}
 
+	void saveState(StateWriter &writer) const {
+		writer.write(dryAmp);
+		writer.write(wetLevel);
+		for (Bit32u i = 0; i < currentSettings.numberOfAllpasses; i++) {
+			allpasses[i]->saveState(writer);
+		}
+		for (Bit32u i = 0; i < currentSettings.numberOfCombs; i++) {
+			combs[i]->saveState(writer);
+		}
+	}
+
+	void loadState(StateReader &reader) {
+		reader.read(dryAmp);
+		reader.read(wetLevel);
+		for (Bit32u i = 0; i < currentSettings.numberOfAllpasses; i++) {
+			allpasses[i]->loadState(reader);
+		}
+		for (Bit32u i = 0; i < currentSettings.numberOfCombs; i++) {
+			combs[i]->loadState(reader);
+		}
+		if (reader.isFailed()) mute();
+	}
+
 	template <class SampleEx>
 	void produceOutput(const Sample *inLeft, const Sample *inRight, Sample *outLeft, Sample *outRight, Bit32u numSamples) {
 		if (!isOpen()) {
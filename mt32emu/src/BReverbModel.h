@@ -18,6 +18,8 @@
 #ifndef MT32EMU_B_REVERB_MODEL_H
 #define MT32EMU_B_REVERB_MODEL_H
 
+#include <cstddef>
+
 #include "globals.h"
 #include "internals.h"
 #include "Enumerations.h"
@@ -25,14 +27,22 @@
 
 namespace MT32Emu {
 
+class StateReader;
+class StateWriter;
+
 class BReverbModel {
 public:
 	static BReverbModel *createBReverbModel(const ReverbMode mode, const bool mt32CompatibleModel, const RendererType rendererType);
 
 	virtual ~BReverbModel() {}
 	virtual bool isOpen() const = 0;
+	// Returns the size in bytes of the memory required to accommodate the delay lines of the model.
+	virtual size_t getDelayLineMemorySize() const = 0;
 	// After construction or a close(), open() must be called at least once before any other call (with the exception of close()).
-	virtual void open() = 0;
+	// The delay lines are placed into the provided memory block, which must be at least getDelayLineMemorySize() bytes long
+	// and suitably aligned for the sample type. The block is owned by the caller and must remain valid until close().
+	// No memory is allocated, so the model may be safely opened in the rendering thread.
+	virtual void open(void *delayLineMemory) = 0;
 	// May be called multiple times without an open() in between.
 	virtual void close() = 0;
 	virtual void mute() = 0;
@@ -41,6 +51,10 @@ public:
 	virtual bool isMT32Compatible(const ReverbMode mode) const = 0;
 	virtual bool process(const IntSample *inLeft, const IntSample *inRight, IntSample *outLeft, IntSample *outRight, Bit32u numSamples) = 0;
 	virtual bool process(const FloatSample *inLeft, const FloatSample *inRight, FloatSample *outLeft, FloatSample *outRight, Bit32u numSamples) = 0;
+	// Store and restore the parameters and the contents of the delay lines. The model must be open.
+	// If the state cannot be read, the model is muted.
+	virtual void saveState(StateWriter &writer) const = 0;
+	virtual void loadState(StateReader &reader) = 0;
 };
 
 } // namespace MT32Emu
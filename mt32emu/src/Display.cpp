@@ -22,6 +22,7 @@
 
 #include "Display.h"
 #include "Part.h"
+#include "StateStream.h"
 #include "Structures.h"
 #include "Synth.h"
 
@@ -144,8 +145,13 @@ Display::Display(Synth &useSynth) :
 	lcdDirty(),
 	lcdUpdateSignalled(),
 	lastRhythmPartState(),
+	lastProgramChangePartIndex(),
+	lastProgramChangeSoundGroupName(),
+	lastProgramChangeTimbreName(),
 	mode(Mode_STARTUP_MESSAGE),
+	midiMessageLEDResetTimestamp(),
 	midiMessagePlayedSinceLastReset(),
+	rhythmStateResetTimestamp(),
 	rhythmNotePlayedSinceLastReset()
 {
 	scheduleDisplayReset();
@@ -351,4 +357,58 @@ void Display::maybeResetTimer(bool &timerState, Bit32u scheduledResetTimestamp)
 	if (timerState && shouldResetTimer(scheduledResetTimestamp)) timerState = false;
 }
 
+void Display::saveState(StateWriter &writer) const {
+	writer.write(lastLEDState);
+	writer.write(lastRhythmPartState);
+	writer.write(voicePartStates);
+	writer.write(lastProgramChangePartIndex);
+	Bit32u soundGroupIndex = 0xFFFFFFFF;
+	if (lastProgramChangeSoundGroupName != NULL) {
+		soundGroupIndex = Bit32u(lastProgramChangeSoundGroupName - synth.soundGroupNames[0]) / sizeof(synth.soundGroupNames[0]);
+	}
+	writer.write(soundGroupIndex);
+	writer.write(lastProgramChangeTimbreName);
+	writer.write(mode);
+	writer.write(displayResetTimestamp);
+	writer.write(displayResetScheduled);
+	writer.write(midiMessageLEDResetTimestamp);
+	writer.write(midiMessagePlayedSinceLastReset);
+	writer.write(rhythmStateResetTimestamp);
+	writer.write(rhythmNotePlayedSinceLastReset);
+	writer.write(displayBuffer);
+	writer.write(customMessageBuffer);
+}
+
+void Display::loadState(StateReader &reader) {
+	reader.read(lastLEDState);
+	reader.read(lastRhythmPartState);
+	reader.read(voicePartStates);
+	reader.read(lastProgramChangePartIndex);
+	Bit32u soundGroupIndex;
+	reader.read(soundGroupIndex);
+	lastProgramChangeSoundGroupName = NULL;
+	if (soundGroupIndex < synth.controlROMMap->soundGroupsCount) {
+		lastProgramChangeSoundGroupName = synth.soundGroupNames[soundGroupIndex];
+	}
+	reader.read(lastProgramChangeTimbreName);
+	reader.read(mode);
+	reader.read(displayResetTimestamp);
+	reader.read(displayResetScheduled);
+	reader.read(midiMessageLEDResetTimestamp);
+	reader.read(midiMessagePlayedSinceLastReset);
+	reader.read(rhythmStateResetTimestamp);
+	reader.read(rhythmNotePlayedSinceLastReset);
+	reader.read(displayBuffer);
+	reader.read(customMessageBuffer);
+	if (8 <= lastProgramChangePartIndex || (mode == Mode_PROGRAM_CHANGE && lastProgramChangeSoundGroupName == NULL)) {
+		reader.fail();
+	}
+	if (reader.isFailed()) {
+		lastProgramChangePartIndex = 0;
+		setMainDisplayMode();
+	}
+	lcdDirty = true;
+	lcdUpdateSignalled = false;
+}
+
 } // namespace MT32Emu
@@ -23,6 +23,8 @@
 
 namespace MT32Emu {
 
+class StateReader;
+class StateWriter;
 class Synth;
 
 /** Facilitates emulation of internal state of the MIDI MESSAGE LED and the MT-32 LCD. */
@@ -53,6 +55,10 @@ public:
 	bool customDisplayMessageReceived(const Bit8u *message, Bit32u startIndex, Bit32u length);
 	void displayControlMessageReceived(const Bit8u *messageBytes, Bit32u length);
 
+	void saveState(StateWriter &writer) const;
+	/** Restores the display state and makes the LCD appear updated, so that the client refreshes it. */
+	void loadState(StateReader &reader);
+
 private:
 	typedef Bit8u DisplayBuffer[LCD_TEXT_SIZE];
 
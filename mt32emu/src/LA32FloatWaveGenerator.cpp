@@ -21,6 +21,7 @@
 
 #include "LA32FloatWaveGenerator.h"
 #include "mmath.h"
+#include "StateStream.h"
 #include "Tables.h"
 
 namespace MT32Emu {
@@ -28,6 +29,8 @@ namespace MT32Emu {
 static const float MIDDLE_CUTOFF_VALUE = 128.0f;
 static const float RESONANCE_DECAY_THRESHOLD_CUTOFF_VALUE = 144.0f;
 static const float MAX_CUTOFF_VALUE = 240.0f;
+// The maximum pitch corresponds to the frequency of SAMPLE_RATE, at which the PCM position advances by 2048 samples per step.
+static const float MAX_PCM_POSITION_DELTA = 2048.0f;
 
 static const Bit8u *resAmpDecayFactors;
 
@@ -283,6 +286,42 @@ bool LA32FloatWaveGenerator::isPCMWave() const {
 	return pcmWaveAddress != NULL;
 }
 
+void LA32FloatWaveGenerator::saveState(StateWriter &writer) const {
+	writer.write(active);
+	writer.write(sawtoothWaveform);
+	writer.write(resonance);
+	writer.write(pulseWidth);
+	writer.writePCMWave(pcmWaveAddress, pcmWaveLength);
+	writer.write(pcmWaveLooped);
+	writer.write(pcmWaveInterpolated);
+	writer.write(wavePos);
+	writer.write(lastFreq);
+	writer.write(pcmPosition);
+}
+
+void LA32FloatWaveGenerator::loadState(StateReader &reader) {
+	reader.read(active);
+	reader.read(sawtoothWaveform);
+	reader.read(resonance);
+	reader.read(pulseWidth);
+	pcmWaveAddress = reader.readPCMWave(pcmWaveLength);
+	reader.read(pcmWaveLooped);
+	reader.read(pcmWaveInterpolated);
+	reader.read(wavePos);
+	reader.read(lastFreq);
+	reader.read(pcmPosition);
+	if (active && isPCMWave()) {
+		// The position of a non-looped PCM wave may overrun its end by a single step, which never exceeds
+		// MAX_PCM_POSITION_DELTA, before the generator deactivates. The comparison fails for NaN as well.
+		float positionLimit = float(pcmWaveLength) + (pcmWaveLooped ? 0.0f : MAX_PCM_POSITION_DELTA);
+		if (pcmWaveLength == 0 || !(0.0f <= pcmPosition && pcmPosition < positionLimit)) reader.fail();
+	}
+	if (reader.isFailed()) {
+		active = false;
+		pcmWaveAddress = NULL;
+	}
+}
+
 void LA32FloatPartialPair::initTables(const Tables &tables) {
 	resAmpDecayFactors = tables.resAmpDecayFactors;
 }
@@ -362,4 +401,22 @@ bool LA32FloatPartialPair::isActive(const PairType useMaster) const {
 	return useMaster == MASTER ? master.isActive() : slave.isActive();
 }
 
+void LA32FloatPartialPair::saveState(StateWriter &writer) const {
+	master.saveState(writer);
+	slave.saveState(writer);
+	writer.write(ringModulated);
+	writer.write(mixed);
+	writer.write(masterOutputSample);
+	writer.write(slaveOutputSample);
+}
+
+void LA32FloatPartialPair::loadState(StateReader &reader) {
+	master.loadState(reader);
+	slave.loadState(reader);
+	reader.read(ringModulated);
+	reader.read(mixed);
+	reader.read(masterOutputSample);
+	reader.read(slaveOutputSample);
+}
+
 } // namespace MT32Emu
@@ -92,6 +92,10 @@ public:
 
 	// Return true if the WG engine generates PCM wave samples
 	bool isPCMWave() const;
+
+	// Store and restore the complete state of the WG engine, the PCM wave address is kept relative to the PCM ROM
+	void saveState(StateWriter &writer) const;
+	void loadState(StateReader &reader);
 }; // class LA32FloatWaveGenerator
 
 class LA32FloatPartialPair : public LA32PartialPair {
@@ -127,6 +131,9 @@ public:
 
 	// Return active state of the WG engine
 	bool isActive(const PairType master) const;
+
+	void saveState(StateWriter &writer) const;
+	void loadState(StateReader &reader);
 }; // class LA32FloatPartialPair
 
 } // namespace MT32Emu
@@ -51,6 +51,7 @@ We haven't fully explored:
 #include "internals.h"
 
 #include "LA32Ramp.h"
+#include "StateStream.h"
 #include "Tables.h"
 
 namespace MT32Emu {
@@ -167,4 +168,22 @@ bool LA32Ramp::isBelowCurrent(Bit8u target) const {
 	return Bit32u(target << TARGET_SHIFTS) < current;
 }
 
+void LA32Ramp::saveState(StateWriter &writer) const {
+	writer.write(current);
+	writer.write(largeTarget);
+	writer.write(largeIncrement);
+	writer.write(descending);
+	writer.write(interruptCountdown);
+	writer.write(interruptRaised);
+}
+
+void LA32Ramp::loadState(StateReader &reader) {
+	reader.read(current);
+	reader.read(largeTarget);
+	reader.read(largeIncrement);
+	reader.read(descending);
+	reader.read(interruptCountdown);
+	reader.read(interruptRaised);
+}
+
 } // namespace MT32Emu
@@ -23,6 +23,8 @@
 
 namespace MT32Emu {
 
+class StateReader;
+class StateWriter;
 struct Tables;
 
 class LA32Ramp {
@@ -44,6 +46,8 @@ public:
 	bool checkInterrupt();
 	void reset();
 	bool isBelowCurrent(Bit8u target) const;
+	void saveState(StateWriter &writer) const;
+	void loadState(StateReader &reader);
 };
 
 } // namespace MT32Emu
@@ -20,6 +20,7 @@
 #include "internals.h"
 
 #include "LA32WaveGenerator.h"
+#include "StateStream.h"
 #include "Tables.h"
 
 namespace MT32Emu {
@@ -436,4 +437,76 @@ bool LA32IntPartialPair::isActive(const PairType useMaster) const {
 	return useMaster == MASTER ? master.isActive() : slave.isActive();
 }
 
+void LA32IntPartialPair::saveState(StateWriter &writer) const {
+	master.saveState(writer);
+	slave.saveState(writer);
+	writer.write(ringModulated);
+	writer.write(mixed);
+}
+
+void LA32IntPartialPair::loadState(StateReader &reader) {
+	master.loadState(reader);
+	slave.loadState(reader);
+	reader.read(ringModulated);
+	reader.read(mixed);
+}
+
+void LA32WaveGenerator::saveState(StateWriter &writer) const {
+	writer.write(active);
+	writer.write(sawtoothWaveform);
+	writer.write(amp);
+	writer.write(pitch);
+	writer.write(resonance);
+	writer.write(pulseWidth);
+	writer.write(cutoffVal);
+	writer.writePCMWave(pcmWaveAddress, pcmWaveLength);
+	writer.write(pcmWaveLooped);
+	writer.write(pcmWaveInterpolated);
+	writer.write(wavePosition);
+	writer.write(squareWavePosition);
+	writer.write(resonanceSinePosition);
+	writer.write(resonanceAmpSubtraction);
+	writer.write(resAmpDecayFactor);
+	writer.write(pcmInterpolationFactor);
+	writer.write(phase);
+	writer.write(resonancePhase);
+	writer.write(squareLogSample);
+	writer.write(resonanceLogSample);
+	writer.write(firstPCMLogSample);
+	writer.write(secondPCMLogSample);
+}
+
+void LA32WaveGenerator::loadState(StateReader &reader) {
+	reader.read(active);
+	reader.read(sawtoothWaveform);
+	reader.read(amp);
+	reader.read(pitch);
+	reader.read(resonance);
+	reader.read(pulseWidth);
+	reader.read(cutoffVal);
+	pcmWaveAddress = reader.readPCMWave(pcmWaveLength);
+	reader.read(pcmWaveLooped);
+	reader.read(pcmWaveInterpolated);
+	reader.read(wavePosition);
+	reader.read(squareWavePosition);
+	reader.read(resonanceSinePosition);
+	reader.read(resonanceAmpSubtraction);
+	reader.read(resAmpDecayFactor);
+	reader.read(pcmInterpolationFactor);
+	reader.read(phase);
+	reader.read(resonancePhase);
+	reader.read(squareLogSample);
+	reader.read(resonanceLogSample);
+	reader.read(firstPCMLogSample);
+	reader.read(secondPCMLogSample);
+	// An active generator deactivates as soon as it reaches the end of a non-looped PCM wave.
+	if (active && isPCMWave() && (pcmWaveLength == 0 || (pcmWaveLength << 8) <= wavePosition)) {
+		reader.fail();
+	}
+	if (reader.isFailed()) {
+		active = false;
+		pcmWaveAddress = NULL;
+	}
+}
+
 } // namespace MT32Emu
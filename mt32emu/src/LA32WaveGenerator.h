@@ -24,6 +24,8 @@
 
 namespace MT32Emu {
 
+class StateReader;
+class StateWriter;
 struct Tables;
 
 /**
@@ -128,7 +130,7 @@ class LA32WaveGenerator {
 	Bit32u pcmInterpolationFactor;
 
 	// Current phase of the square wave
-	enum {
+	enum SquareWavePhase {
 		POSITIVE_RISING_SINE_SEGMENT,
 		POSITIVE_LINEAR_SEGMENT,
 		POSITIVE_FALLING_SINE_SEGMENT,
@@ -195,6 +197,10 @@ public:
 
 	// Return current PCM interpolation factor
 	Bit32u getPCMInterpolationFactor() const;
+
+	// Store and restore the complete state of the WG engine, the PCM wave address is kept relative to the PCM ROM
+	void saveState(StateWriter &writer) const;
+	void loadState(StateReader &reader);
 }; // class LA32WaveGenerator
 
 // LA32PartialPair contains a structure of two partials being mixed / ring modulated
@@ -220,6 +226,10 @@ public:
 
 	// Deactivate the WG engine
 	virtual void deactivate(const PairType master) = 0;
+
+	// Store and restore the complete state of both WG engines
+	virtual void saveState(StateWriter &writer) const = 0;
+	virtual void loadState(StateReader &reader) = 0;
 }; // class LA32PartialPair
 
 class LA32IntPartialPair : public LA32PartialPair {
@@ -256,6 +266,9 @@ public:
 
 	// Return active state of the WG engine
 	bool isActive(const PairType master) const;
+
+	void saveState(StateWriter &writer) const;
+	void loadState(StateReader &reader);
 }; // class LA32IntPartialPair
 
 } // namespace MT32Emu
@@ -0,0 +1,240 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <fstream>
+
+#if defined _WIN32
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#  define MT32EMU_MAPPED_FILE_WIN32
+#elif defined __unix__ || defined __APPLE__ || defined __HAIKU__
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  define MT32EMU_MAPPED_FILE_POSIX
+#endif
+
+#include "internals.h"
+
+#include "MappedFile.h"
+
+namespace MT32Emu {
+
+static const char SHA1_SIDECAR_SUFFIX[] = ".sha1";
+
+enum MapResult {
+	MapResult_MAPPED,
+	MapResult_UNSUPPORTED,
+	MapResult_FAILED
+};
+
+static MapResult mapFile(const char *filename, const Bit8u *&data, size_t &size, Bit32u *modificationTime) {
+#if defined MT32EMU_MAPPED_FILE_WIN32
+	HANDLE fileHandle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE) return MapResult_FAILED;
+	LARGE_INTEGER fileSize;
+	MapResult result = MapResult_FAILED;
+	FILETIME lastWriteTime;
+	if (GetFileSizeEx(fileHandle, &fileSize) && LONGLONG(size_t(fileSize.QuadPart)) == fileSize.QuadPart && GetFileTime(fileHandle, NULL, NULL, &lastWriteTime)) {
+		size = size_t(fileSize.QuadPart);
+		modificationTime[0] = lastWriteTime.dwHighDateTime;
+		modificationTime[1] = lastWriteTime.dwLowDateTime;
+		if (size == 0) {
+			data = NULL;
+			result = MapResult_MAPPED;
+		} else {
+			// The view keeps the mapping object alive after the handles are closed.
+			HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mappingHandle != NULL) {
+				data = static_cast<const Bit8u *>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+				if (data != NULL) result = MapResult_MAPPED;
+				CloseHandle(mappingHandle);
+			}
+		}
+	}
+	CloseHandle(fileHandle);
+	return result;
+#elif defined MT32EMU_MAPPED_FILE_POSIX
+	int fd = ::open(filename, O_RDONLY);
+	if (fd == -1) return MapResult_FAILED;
+	struct stat fileStat;
+	MapResult result = MapResult_FAILED;
+	if (fstat(fd, &fileStat) == 0 && S_ISREG(fileStat.st_mode) && off_t(size_t(fileStat.st_size)) == fileStat.st_size) {
+		size = size_t(fileStat.st_size);
+		// Whole seconds alone would miss changes made within the same second, so the nanoseconds are kept as well.
+		// The seconds are truncated to 32 bits, which is harmless since the time is only compared for equality.
+		modificationTime[0] = Bit32u(fileStat.st_mtime);
+#if defined __APPLE__
+		modificationTime[1] = Bit32u(fileStat.st_mtimespec.tv_nsec);
+#else
+		modificationTime[1] = Bit32u(fileStat.st_mtim.tv_nsec);
+#endif
+		if (size == 0) {
+			data = NULL;
+			result = MapResult_MAPPED;
+		} else {
+			// The mapping stays valid after the descriptor is closed.
+			void *mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+			if (mapping != MAP_FAILED) {
+				data = static_cast<const Bit8u *>(mapping);
+				result = MapResult_MAPPED;
+			}
+		}
+	}
+	::close(fd);
+	return result;
+#else
+	(void)filename;
+	(void)data;
+	(void)size;
+	(void)modificationTime;
+	return MapResult_UNSUPPORTED;
+#endif
+}
+
+static bool readFile(const char *filename, const Bit8u *&data, size_t &size) {
+	std::ifstream ifs(filename, std::ios_base::in | std::ios_base::binary);
+	if (ifs.fail()) return false;
+	ifs.seekg(0, std::ios_base::end);
+	std::streamoff fileSize = ifs.tellg();
+	if (fileSize < 0) return false;
+	size = size_t(fileSize);
+	if (size == 0) {
+		data = NULL;
+		return true;
+	}
+	Bit8u *fileData = new Bit8u[size];
+	ifs.seekg(0);
+	ifs.read(reinterpret_cast<char *>(fileData), std::streamsize(size));
+	if (size_t(ifs.gcount()) != size) {
+		delete[] fileData;
+		return false;
+	}
+	data = fileData;
+	return true;
+}
+
+static bool isHexDigit(char c) {
+	return ('0' <= c && c <= '9') || ('a' <= c && c <= 'f') || ('A' <= c && c <= 'F');
+}
+
+MappedFile::MappedFile() : data(NULL), size(0), mapped(false), modificationTimeKnown(false), knownSHA1DigestSet(false) {
+	modificationTime[0] = 0;
+	modificationTime[1] = 0;
+	knownSHA1Digest[0] = 0;
+}
+
+MappedFile::~MappedFile() {
+	unmap();
+}
+
+size_t MappedFile::getSize() {
+	return size;
+}
+
+const Bit8u *MappedFile::getData() {
+	return data;
+}
+
+const File::SHA1Digest &MappedFile::getSHA1() {
+	if (knownSHA1DigestSet) return knownSHA1Digest;
+	return AbstractFile::getSHA1();
+}
+
+bool MappedFile::open(const char *filename) {
+	unmap();
+	knownSHA1DigestSet = false;
+	switch (mapFile(filename, data, size, modificationTime)) {
+	case MapResult_MAPPED:
+		mapped = data != NULL;
+		modificationTimeKnown = true;
+		return true;
+	case MapResult_UNSUPPORTED:
+		return readFile(filename, data, size);
+	default:
+		return false;
+	}
+}
+
+bool MappedFile::loadSHA1Sidecar(const char *filename) {
+	size_t filenameLength = strlen(filename);
+	char *sidecarFilename = new char[filenameLength + sizeof(SHA1_SIDECAR_SUFFIX)];
+	memcpy(sidecarFilename, filename, filenameLength);
+	memcpy(sidecarFilename + filenameLength, SHA1_SIDECAR_SUFFIX, sizeof(SHA1_SIDECAR_SUFFIX));
+	std::ifstream ifs(sidecarFilename, std::ios_base::in | std::ios_base::binary);
+	delete[] sidecarFilename;
+	if (ifs.fail()) return false;
+
+	const size_t digestLength = sizeof(SHA1Digest) - 1;
+	char digest[sizeof(SHA1Digest)];
+	ifs.read(digest, std::streamsize(digestLength + 1));
+	size_t bytesRead = size_t(ifs.gcount());
+	if (bytesRead < digestLength) return false;
+	// The digest must not be immediately followed by more hex digits.
+	if (bytesRead > digestLength && isHexDigit(digest[digestLength])) return false;
+	for (size_t i = 0; i < digestLength; i++) {
+		if (!isHexDigit(digest[i])) return false;
+		// Known ROM digests are stored in lower case.
+		if ('A' <= digest[i] && digest[i] <= 'F') digest[i] += 'a' - 'A';
+	}
+	digest[digestLength] = 0;
+	setSHA1(digest);
+	return true;
+}
+
+void MappedFile::setSHA1(const SHA1Digest &useSHA1Digest) {
+	memcpy(knownSHA1Digest, useSHA1Digest, sizeof(SHA1Digest));
+	knownSHA1DigestSet = true;
+}
+
+bool MappedFile::isSHA1Provided() const {
+	return knownSHA1DigestSet;
+}
+
+bool MappedFile::getModificationTime(Bit32u &timeHigh, Bit32u &timeLow) const {
+	if (!modificationTimeKnown) return false;
+	timeHigh = modificationTime[0];
+	timeLow = modificationTime[1];
+	return true;
+}
+
+void MappedFile::close() {}
+
+void MappedFile::unmap() {
+	if (mapped) {
+#if defined MT32EMU_MAPPED_FILE_WIN32
+		UnmapViewOfFile(data);
+#elif defined MT32EMU_MAPPED_FILE_POSIX
+		munmap(const_cast<Bit8u *>(data), size);
+#endif
+	} else {
+		delete[] data;
+	}
+	data = NULL;
+	size = 0;
+	mapped = false;
+	modificationTimeKnown = false;
+}
+
+} // namespace MT32Emu
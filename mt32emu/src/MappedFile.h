@@ -0,0 +1,69 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_MAPPED_FILE_H
+#define MT32EMU_MAPPED_FILE_H
+
+#include "globals.h"
+#include "Types.h"
+#include "File.h"
+
+namespace MT32Emu {
+
+// File implementation that maps the file contents into memory rather than reading them, so that only the pages
+// actually accessed are loaded. Falls back to reading the whole file on platforms that lack memory-mapping support.
+// Optionally, the SHA1 digest of the file contents can be read from a sidecar file, which avoids hashing the file
+// altogether when it is identified.
+class MappedFile : public AbstractFile {
+public:
+	MT32EMU_EXPORT_V(2.8) MappedFile();
+	MT32EMU_EXPORT_V(2.8) ~MappedFile();
+	MT32EMU_EXPORT_V(2.8) size_t getSize();
+	MT32EMU_EXPORT_V(2.8) const Bit8u *getData();
+	MT32EMU_EXPORT_V(2.8) const SHA1Digest &getSHA1();
+	MT32EMU_EXPORT_V(2.8) bool open(const char *filename);
+	// Reads the SHA1 digest from a sidecar file, named as the opened file with ".sha1" appended. The sidecar must begin
+	// with the digest as 40 hexadecimal digits, e.g. as produced by the sha1sum utility. The digest is trusted and never
+	// verified against the file contents. Returns false if the sidecar is missing or malformed, in which case the digest
+	// is computed as usual.
+	MT32EMU_EXPORT_V(2.8) bool loadSHA1Sidecar(const char *filename);
+	// Provides the SHA1 digest of the file contents known beforehand, so that it is not computed. Reset by open().
+	MT32EMU_EXPORT_V(2.8) void setSHA1(const SHA1Digest &useSHA1Digest);
+	// Returns true if the SHA1 digest has been provided by setSHA1() or loadSHA1Sidecar() rather than computed.
+	MT32EMU_EXPORT_V(2.8) bool isSHA1Provided() const;
+	// Retrieves the time of the last modification of the opened file in a platform-specific representation, which is
+	// only suitable for comparing for equality.
+	// Returns false if the time is unknown, e.g. when the file contents could not be mapped.
+	MT32EMU_EXPORT_V(2.8) bool getModificationTime(Bit32u &timeHigh, Bit32u &timeLow) const;
+	// The file data remains accessible until the object is destroyed.
+	MT32EMU_EXPORT_V(2.8) void close();
+
+private:
+	const Bit8u *data;
+	size_t size;
+	bool mapped;
+	bool modificationTimeKnown;
+	Bit32u modificationTime[2];
+	bool knownSHA1DigestSet;
+	SHA1Digest knownSHA1Digest;
+
+	void unmap();
+};
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_MAPPED_FILE_H
@@ -0,0 +1,184 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#if defined _WIN32
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#  define MT32EMU_MEMORY_ARENA_WIN32
+#elif defined __unix__ || defined __APPLE__ || defined __HAIKU__
+#  include <sys/mman.h>
+#  define MT32EMU_MEMORY_ARENA_POSIX
+#endif
+
+#include "internals.h"
+
+#include "MemoryArena.h"
+
+namespace MT32Emu {
+
+static Bit8u *alignToCacheLine(Bit8u *address) {
+	const size_t misalignment = reinterpret_cast<size_t>(address) & (MemoryArena::CACHE_LINE_SIZE - 1);
+	return misalignment == 0 ? address : address + (MemoryArena::CACHE_LINE_SIZE - misalignment);
+}
+
+static size_t roundUp(size_t size, size_t granularity) {
+	return (size + granularity - 1) / granularity * granularity;
+}
+
+// Maps anonymous memory pages, so that they can be backed by large pages and locked individually. The mapping is
+// page-aligned and hence also cache-line-aligned. Returns NULL if the platform doesn't support that.
+static Bit8u *mapBlock(size_t size, bool useLargePages, size_t &mappedSize, bool &largePages) {
+#if defined MT32EMU_MEMORY_ARENA_WIN32
+	if (useLargePages) {
+		// This requires the SeLockMemoryPrivilege, the allocation simply fails without it.
+		SIZE_T largePageSize = GetLargePageMinimum();
+		if (largePageSize > 0) {
+			mappedSize = roundUp(size, largePageSize);
+			void *mapping = VirtualAlloc(NULL, mappedSize, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+			if (mapping != NULL) {
+				largePages = true;
+				return static_cast<Bit8u *>(mapping);
+			}
+		}
+	}
+	mappedSize = size;
+	return static_cast<Bit8u *>(VirtualAlloc(NULL, mappedSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#elif defined MT32EMU_MEMORY_ARENA_POSIX
+#  if defined MAP_HUGETLB
+	if (useLargePages) {
+		// Only succeeds when the system has huge pages reserved. The length must be a multiple of the huge page size,
+		// which is assumed the most common default.
+		static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+		mappedSize = roundUp(size, HUGE_PAGE_SIZE);
+		void *mapping = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON | MAP_HUGETLB, -1, 0);
+		if (mapping != MAP_FAILED) {
+			largePages = true;
+			return static_cast<Bit8u *>(mapping);
+		}
+	}
+#  endif
+	mappedSize = size;
+	void *mapping = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+	if (mapping == MAP_FAILED) return NULL;
+#  if defined MADV_HUGEPAGE
+	// Transparent huge pages are merely a hint to the kernel, so this doesn't count as large page backing.
+	if (useLargePages) madvise(mapping, mappedSize, MADV_HUGEPAGE);
+#  endif
+	return static_cast<Bit8u *>(mapping);
+#else
+	(void)size;
+	(void)useLargePages;
+	(void)mappedSize;
+	(void)largePages;
+	return NULL;
+#endif
+}
+
+static void unmapBlock(Bit8u *mapping, size_t mappedSize) {
+#if defined MT32EMU_MEMORY_ARENA_WIN32
+	(void)mappedSize;
+	VirtualFree(mapping, 0, MEM_RELEASE);
+#elif defined MT32EMU_MEMORY_ARENA_POSIX
+	munmap(mapping, mappedSize);
+#else
+	(void)mapping;
+	(void)mappedSize;
+#endif
+}
+
+// The pages are unlocked implicitly when unmapped or the process terminates.
+static bool lockBlock(Bit8u *block, size_t size) {
+#if defined MT32EMU_MEMORY_ARENA_WIN32
+	return VirtualLock(block, size) != 0;
+#elif defined MT32EMU_MEMORY_ARENA_POSIX
+	return mlock(block, size) == 0;
+#else
+	(void)block;
+	(void)size;
+	return false;
+#endif
+}
+
+static void unlockBlock(Bit8u *block, size_t size) {
+#if defined MT32EMU_MEMORY_ARENA_WIN32
+	VirtualUnlock(block, size);
+#elif defined MT32EMU_MEMORY_ARENA_POSIX
+	munlock(block, size);
+#else
+	(void)block;
+	(void)size;
+#endif
+}
+
+MemoryArena::MemoryArena(size_t useCapacity, bool useLargePages, bool lockMemory) :
+	capacity(getChunkSize(useCapacity)),
+	rawBlock(),
+	mappedSize(),
+	block(),
+	usedSize(0),
+	largePages(false),
+	locked(false)
+{
+	if (useLargePages || lockMemory) rawBlock = mapBlock(capacity, useLargePages, mappedSize, largePages);
+	if (rawBlock == NULL) {
+		mappedSize = 0;
+		rawBlock = new Bit8u[capacity + CACHE_LINE_SIZE - 1];
+	}
+	block = alignToCacheLine(rawBlock);
+	if (lockMemory) locked = lockBlock(block, capacity);
+	// Touch the entire block right away, so that page faults don't occur later during rendering.
+	memset(block, 0, capacity);
+}
+
+MemoryArena::MemoryArena(void *chunk, size_t useCapacity) :
+	capacity(getChunkSize(useCapacity)),
+	rawBlock(),
+	mappedSize(),
+	block(static_cast<Bit8u *>(chunk)),
+	usedSize(0),
+	largePages(false),
+	locked(false)
+{
+	memset(block, 0, capacity);
+}
+
+MemoryArena::~MemoryArena() {
+	if (rawBlock == NULL) return;
+	if (mappedSize > 0) {
+		unmapBlock(rawBlock, mappedSize);
+		return;
+	}
+	if (locked) unlockBlock(block, capacity);
+	delete[] rawBlock;
+}
+
+void *MemoryArena::allocate(size_t size) {
+	const size_t chunkSize = getChunkSize(size);
+	if (capacity - usedSize < chunkSize) return NULL;
+	void *chunk = block + usedSize;
+	usedSize += chunkSize;
+	return chunk;
+}
+
+} // namespace MT32Emu
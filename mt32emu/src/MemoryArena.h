@@ -0,0 +1,93 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_MEMORY_ARENA_H
+#define MT32EMU_MEMORY_ARENA_H
+
+#include <cstddef>
+
+#include "globals.h"
+#include "Types.h"
+
+namespace MT32Emu {
+
+/**
+ * A trivial bump allocator that hands out chunks of a single contiguous block of memory allocated up front.
+ * Each chunk starts at a cache line boundary, so that unrelated objects never share a cache line.
+ * The chunks are never freed individually, the entire block is released when the arena is destroyed.
+ * Objects created in the arena via placement new must be destroyed explicitly, if their destructors are non-trivial.
+ * Since the required capacity is known beforehand, running out of space indicates a programming error.
+ * Optionally, the block can be backed by large pages and locked in physical memory, where the platform supports that.
+ * Both are best effort, the block is allocated anyway and the outcome can be queried afterwards.
+ */
+class MemoryArena {
+public:
+	static const size_t CACHE_LINE_SIZE = 64;
+
+	// Returns the amount of arena memory consumed by an allocation of the specified size.
+	static size_t getChunkSize(size_t size) {
+		return (size + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1);
+	}
+
+	explicit MemoryArena(size_t capacity, bool useLargePages = false, bool lockMemory = false);
+	// Creates an arena within a chunk allocated from another arena, so that it can be refilled from scratch.
+	// The chunk must be aligned to a cache line and is zeroed again, it remains owned by the other arena.
+	MemoryArena(void *chunk, size_t capacity);
+	~MemoryArena();
+
+	// Returns a pointer to a cache-line-aligned chunk of the specified size or NULL if the arena is exhausted.
+	void *allocate(size_t size);
+
+	template <class T>
+	T *allocateArray(size_t count) {
+		return static_cast<T *>(allocate(count * sizeof(T)));
+	}
+
+	size_t getCapacity() const {
+		return capacity;
+	}
+
+	size_t getUsedSize() const {
+		return usedSize;
+	}
+
+	bool isBackedByLargePages() const {
+		return largePages;
+	}
+
+	bool isLocked() const {
+		return locked;
+	}
+
+private:
+	const size_t capacity;
+	// Either allocated on the heap or mapped, NULL if the block is owned by another arena.
+	Bit8u *rawBlock;
+	size_t mappedSize;
+	Bit8u *block;
+	size_t usedSize;
+	bool largePages;
+	bool locked;
+
+	// Copying is not supported.
+	MemoryArena(const MemoryArena &);
+	MemoryArena &operator=(const MemoryArena &);
+};
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_MEMORY_ARENA_H
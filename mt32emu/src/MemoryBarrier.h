@@ -0,0 +1,56 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_MEMORY_BARRIER_H
+#define MT32EMU_MEMORY_BARRIER_H
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#include "Types.h"
+
+namespace MT32Emu {
+
+// Prevents both the compiler and the CPU from reordering memory accesses across this point.
+static inline void memoryBarrier() {
+#if defined(__GNUC__) || defined(__clang__)
+	__sync_synchronize();
+#elif defined(_MSC_VER)
+#if defined(_M_ARM) || defined(_M_ARM64)
+	__dmb(0xB); // ISH
+#else
+	// On x86, neither stores nor loads are reordered with accesses of the same kind, which is all we need here.
+	_ReadWriteBarrier();
+#endif
+#endif
+}
+
+// Increments the value so that concurrent increments from several threads are never lost.
+static inline void atomicIncrement(volatile Bit32u &value) {
+#if defined(__GNUC__) || defined(__clang__)
+	__sync_fetch_and_add(&value, 1);
+#elif defined(_MSC_VER)
+	_InterlockedIncrement(reinterpret_cast<volatile long *>(&value));
+#else
+	value++;
+#endif
+}
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_MEMORY_BARRIER_H
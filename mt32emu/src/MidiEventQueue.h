@@ -18,11 +18,17 @@
 #ifndef MT32EMU_MIDI_EVENT_QUEUE_H
 #define MT32EMU_MIDI_EVENT_QUEUE_H
 
+#include <cstddef>
+
 #include "globals.h"
 #include "Types.h"
 
 namespace MT32Emu {
 
+class MemoryArena;
+class StateReader;
+class StateWriter;
+
 /**
  * Simple queue implementation using a ring buffer to store incoming MIDI event before the synth actually processes it.
  * It is intended to:
@@ -44,28 +50,50 @@ public:
 			Bit32u shortMessageData;
 		};
 		Bit32u timestamp;
+		// Indicates that sysexData is owned by the client rather than by the SysEx storage.
+		bool sysexDataReferenced;
 	};
 
+	// Returns the amount of arena memory needed to create a queue with the specified parameters.
+	static size_t getArenaSize(Bit32u ringBufferSize, Bit32u storageBufferSize);
+
 	explicit MidiEventQueue(
 		// Must be a power of 2
 		Bit32u ringBufferSize,
-		Bit32u storageBufferSize
+		Bit32u storageBufferSize,
+		// When provided, the ring buffer and the SysEx storage are allocated in the arena rather than on the heap.
+		MemoryArena *arena = NULL
 	);
 	~MidiEventQueue();
 	void reset();
 	bool pushShortMessage(Bit32u shortMessageData, Bit32u timestamp);
 	bool pushSysex(const Bit8u *sysexData, Bit32u sysexLength, Bit32u timestamp);
+	// Same as pushSysex() but the data is referenced instead of being copied to the SysEx storage.
+	bool pushReferencedSysex(const Bit8u *sysexData, Bit32u sysexLength, Bit32u timestamp);
 	const volatile MidiEvent *peekMidiEvent();
 	void dropMidiEvent();
 	inline bool isEmpty() const;
+	Bit32u getPendingEventCount() const;
+	// Returns the number of SysEx events pushed with pushReferencedSysex() that are still in the queue.
+	Bit32u getReferencedSysexCount() const;
+	void saveState(StateWriter &writer) const;
+	// Replaces the pending events with the ones read. Returns false if the events didn't fit into the queue.
+	bool loadState(StateReader &reader);
 
 private:
+	const bool allocatedInArena;
 	SysexDataStorage &sysexDataStorage;
 
 	MidiEvent * const ringBuffer;
 	const Bit32u ringBufferMask;
 	volatile Bit32u startPosition;
 	volatile Bit32u endPosition;
+
+	// Each counter is only modified by either the writing or the reading thread.
+	volatile Bit32u pushedReferencedSysexCount;
+	volatile Bit32u droppedReferencedSysexCount;
+
+	void disposeSysexData(volatile MidiEvent &event);
 };
 
 } // namespace MT32Emu
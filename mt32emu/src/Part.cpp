@@ -24,6 +24,8 @@
 #include "Partial.h"
 #include "PartialManager.h"
 #include "Poly.h"
+#include "StateStream.h"
+#include "StatisticsCollector.h"
 #include "Synth.h"
 
 namespace MT32Emu {
@@ -80,11 +82,8 @@ Part::Part(Synth *useSynth, unsigned int usePartNum) {
 	memset(patchCache, 0, sizeof(patchCache));
 }
 
-Part::~Part() {
-	while (!activePolys.isEmpty()) {
-		delete activePolys.takeFirst();
-	}
-}
+// Polys are owned by PartialManager.
+Part::~Part() {}
 
 void Part::setDataEntryMSB(unsigned char midiDataEntryMSB) {
 	if (nrpn) {
@@ -510,10 +509,12 @@ void Part::playPoly(const PatchCache cache[4], const MemParams::RhythmTemp *rhyt
 		synth->printDebug("%s (%s): Insufficient free partials to play key %d (velocity %d); needed=%d, free=%d, assignMode=%d", name, currentInstr, midiKey, velocity, needPartials, synth->partialManager->getFreePartialCount(), patchTemp->patch.assignMode);
 		synth->printPartialUsage();
 #endif
+		if (synth->getStatisticsCollector() != NULL) synth->getStatisticsCollector()->noteOnIgnored();
 		synth->getReportHandler3()->onNoteOnIgnored(needPartials, synth->partialManager->getFreePartialCount());
 		return;
 	}
 	if (synth->isAbortingPoly()) {
+		if (synth->getStatisticsCollector() != NULL) synth->getStatisticsCollector()->polySilenced();
 		synth->getReportHandler3()->onPlayingPolySilenced(needPartials, synth->partialManager->getFreePartialCount());
 		return;
 	}
@@ -663,6 +664,59 @@ void Part::polyStateChanged(PolyState oldState, PolyState newState) {
 #endif
 }
 
+void Part::saveState(StateWriter &writer) const {
+	writer.write(holdpedal);
+	writer.write(activePartialCount);
+	writer.write(activeNonReleasingPolyCount);
+	for (int t = 0; t < 4; t++) {
+		writer.writePatchCache(patchCache[t]);
+	}
+	activePolys.saveState(writer);
+	writer.write(currentInstr);
+	writer.write(modulation);
+	writer.write(expression);
+	writer.write(pitchBend);
+	writer.write(nrpn);
+	writer.write(rpn);
+	writer.write(pitchBenderRange);
+}
+
+void Part::loadState(StateReader &reader) {
+	reader.read(holdpedal);
+	reader.read(activePartialCount);
+	reader.read(activeNonReleasingPolyCount);
+	for (int t = 0; t < 4; t++) {
+		reader.readPatchCache(patchCache[t]);
+	}
+	activePolys.loadState(reader);
+	reader.read(currentInstr);
+	currentInstr[10] = 0;
+	reader.read(modulation);
+	reader.read(expression);
+	reader.read(pitchBend);
+	reader.read(nrpn);
+	reader.read(rpn);
+	reader.read(pitchBenderRange);
+}
+
+void RhythmPart::saveState(StateWriter &writer) const {
+	Part::saveState(writer);
+	for (int drumNum = 0; drumNum < 85; drumNum++) {
+		for (int t = 0; t < 4; t++) {
+			writer.writePatchCache(drumCache[drumNum][t]);
+		}
+	}
+}
+
+void RhythmPart::loadState(StateReader &reader) {
+	Part::loadState(reader);
+	for (int drumNum = 0; drumNum < 85; drumNum++) {
+		for (int t = 0; t < 4; t++) {
+			reader.readPatchCache(drumCache[drumNum][t]);
+		}
+	}
+}
+
 PolyList::PolyList() : firstPoly(NULL), lastPoly(NULL) {}
 
 bool PolyList::isEmpty() const {
@@ -753,4 +807,14 @@ void PolyList::remove(Poly * const polyToRemove) {
 	}
 }
 
+void PolyList::saveState(StateWriter &writer) const {
+	writer.writePoly(firstPoly);
+	writer.writePoly(lastPoly);
+}
+
+void PolyList::loadState(StateReader &reader) {
+	firstPoly = reader.readPoly();
+	lastPoly = reader.readPoly();
+}
+
 } // namespace MT32Emu
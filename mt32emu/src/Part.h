@@ -26,6 +26,8 @@
 namespace MT32Emu {
 
 class Poly;
+class StateReader;
+class StateWriter;
 class Synth;
 
 class PolyList {
@@ -42,6 +44,8 @@ public:
 	void append(Poly *poly);
 	Poly *takeFirst();
 	void remove(Poly * const poly);
+	void saveState(StateWriter &writer) const;
+	void loadState(StateReader &reader);
 };
 
 class Part {
@@ -136,6 +140,10 @@ public:
 	// Abort the first poly in PolyState_HELD, or if none exists, the first active poly in any state.
 	bool abortFirstPolyPreferHeld();
 	bool abortFirstPoly();
+
+	// The volume override is a client setting, so it isn't included in the state.
+	virtual void saveState(StateWriter &writer) const;
+	virtual void loadState(StateReader &reader);
 }; // class Part
 
 class RhythmPart: public Part {
@@ -155,6 +163,8 @@ public:
 	void setPan(unsigned int midiPan);
 	void setProgram(unsigned int patchNum);
 	void polyStateChanged(PolyState oldState, PolyState newState);
+	void saveState(StateWriter &writer) const;
+	void loadState(StateReader &reader);
 };
 
 } // namespace MT32Emu
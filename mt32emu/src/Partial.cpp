@@ -16,13 +16,16 @@
  */
 
 #include <cstddef>
+#include <new>
 
 #include "internals.h"
 
 #include "Partial.h"
+#include "MemoryArena.h"
 #include "Part.h"
 #include "PartialManager.h"
 #include "Poly.h"
+#include "StateStream.h"
 #include "Synth.h"
 #include "Tables.h"
 #include "TVA.h"
@@ -69,24 +72,33 @@ static void ensureTables() {
 	(void)initialised;
 }
 
-Partial::Partial(Synth *useSynth, int usePartialIndex) :
+size_t Partial::getArenaSize(RendererType rendererType) {
+	size_t la32PairSize = rendererType == RendererType_FLOAT ? sizeof(LA32FloatPartialPair) : sizeof(LA32IntPartialPair);
+	return MemoryArena::getChunkSize(sizeof(Partial)) + MemoryArena::getChunkSize(sizeof(TVA))
+		+ MemoryArena::getChunkSize(sizeof(TVP)) + MemoryArena::getChunkSize(sizeof(TVF))
+		+ MemoryArena::getChunkSize(la32PairSize);
+}
+
+Partial::Partial(Synth *useSynth, int usePartialIndex, MemoryArena &arena) :
 	synth(useSynth), partialIndex(usePartialIndex), sampleNum(0),
 	floatMode(useSynth->getSelectedRendererType() == RendererType_FLOAT) {
 	ensureTables();
 	// Initialisation of tva, tvp and tvf uses 'this' pointer
 	// and thus should not be in the initializer list to avoid a compiler warning
-	tva = new TVA(this, &ampRamp);
-	tvp = new TVP(this);
-	tvf = new TVF(this, &cutoffModifierRamp);
+	tva = new(arena.allocate(sizeof(TVA))) TVA(this, &ampRamp);
+	tvp = new(arena.allocate(sizeof(TVP))) TVP(this);
+	tvf = new(arena.allocate(sizeof(TVF))) TVF(this, &cutoffModifierRamp);
 	ownerPart = -1;
+	pcmWave = NULL;
 	poly = NULL;
 	pair = NULL;
+	patchCache = NULL;
 	switch (synth->getSelectedRendererType()) {
 	case RendererType_BIT16S:
-		la32Pair = new LA32IntPartialPair;
+		la32Pair = new(arena.allocate(sizeof(LA32IntPartialPair))) LA32IntPartialPair;
 		break;
 	case RendererType_FLOAT:
-		la32Pair = new LA32FloatPartialPair;
+		la32Pair = new(arena.allocate(sizeof(LA32FloatPartialPair))) LA32FloatPartialPair;
 		break;
 	default:
 		la32Pair = NULL;
@@ -94,10 +106,11 @@ Partial::Partial(Synth *useSynth, int usePartialIndex) :
 }
 
 Partial::~Partial() {
-	delete la32Pair;
-	delete tva;
-	delete tvp;
-	delete tvf;
+	// The memory is owned by the arena, so only the destructors need to be invoked.
+	if (la32Pair != NULL) la32Pair->~LA32PartialPair();
+	tva->~TVA();
+	tvp->~TVP();
+	tvf->~TVF();
 }
 
 // Only used for debugging purposes
@@ -351,6 +364,33 @@ bool Partial::generateNextSample(LA32PairImpl *la32PairImpl) {
 	return true;
 }
 
+template <class LA32PairImpl>
+bool Partial::skipNextSample(LA32PairImpl *la32PairImpl) {
+	if (!tva->isPlaying() || !la32PairImpl->isActive(LA32PartialPair::MASTER)) {
+		deactivate();
+		return false;
+	}
+	Bit32u amp = getAmpValue();
+	Bit16u pitch = tvp->nextPitch();
+	Bit32u cutoff = getCutoffValue();
+	// PCM waves still have to proceed, as the partial ends when a non-looped wave does.
+	if (isPCM()) la32PairImpl->generateNextSample(LA32PartialPair::MASTER, amp, pitch, cutoff);
+	if (hasRingModulatingSlave()) {
+		amp = pair->getAmpValue();
+		pitch = pair->tvp->nextPitch();
+		cutoff = pair->getCutoffValue();
+		if (pair->isPCM()) la32PairImpl->generateNextSample(LA32PartialPair::SLAVE, amp, pitch, cutoff);
+		if (!pair->tva->isPlaying() || !la32PairImpl->isActive(LA32PartialPair::SLAVE)) {
+			pair->deactivate();
+			if (mixType == 2) {
+				deactivate();
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
 void Partial::produceAndMixSample(IntSample *&leftBuf, IntSample *&rightBuf, LA32IntPartialPair *la32IntPair) {
 	IntSampleEx sample = la32IntPair->nextOutSample();
 
@@ -381,7 +421,10 @@ bool Partial::doProduceOutput(Sample *leftBuf, Sample *rightBuf, Bit32u length,
 	alreadyOutputed = true;
 
 	for (sampleNum = 0; sampleNum < length; sampleNum++) {
-		if (!generateNextSample(la32PairImpl)) break;
+		if (!generateNextSample(la32PairImpl)) {
+			synth->partialManager->partialOutputEnded(sampleNum);
+			break;
+		}
 		produceAndMixSample(leftBuf, rightBuf, la32PairImpl);
 	}
 	sampleNum = 0;
@@ -404,6 +447,28 @@ bool Partial::produceOutput(FloatSample *leftBuf, FloatSample *rightBuf, Bit32u
 	return doProduceOutput(leftBuf, rightBuf, length, static_cast<LA32FloatPartialPair *>(la32Pair));
 }
 
+template <class LA32PairImpl>
+bool Partial::doFastForward(Bit32u length, LA32PairImpl *la32PairImpl) {
+	if (!canProduceOutput()) return false;
+	alreadyOutputed = true;
+
+	for (sampleNum = 0; sampleNum < length; sampleNum++) {
+		if (!skipNextSample(la32PairImpl)) {
+			synth->partialManager->partialOutputEnded(sampleNum);
+			break;
+		}
+	}
+	sampleNum = 0;
+	return true;
+}
+
+bool Partial::fastForward(Bit32u length) {
+	if (floatMode) {
+		return doFastForward(length, static_cast<LA32FloatPartialPair *>(la32Pair));
+	}
+	return doFastForward(length, static_cast<LA32IntPartialPair *>(la32Pair));
+}
+
 bool Partial::shouldReverb() {
 	if (!isActive()) {
 		return false;
@@ -422,4 +487,64 @@ void Partial::startDecayAll() {
 	tvf->startDecay();
 }
 
+void Partial::saveState(StateWriter &writer) const {
+	writer.write(sampleNum);
+	writer.write(leftPanValue);
+	writer.write(rightPanValue);
+	writer.write(ownerPart);
+	writer.write(mixType);
+	writer.write(structurePosition);
+	writer.write(pcmNum);
+	writer.write(pcmWave != NULL);
+	writer.write(pulseWidthVal);
+	writer.writePoly(poly);
+	writer.writePartial(pair);
+	tva->saveState(writer);
+	tvp->saveState(writer);
+	tvf->saveState(writer);
+	ampRamp.saveState(writer);
+	cutoffModifierRamp.saveState(writer);
+	la32Pair->saveState(writer);
+	if (isActive()) {
+		writer.writePatchCache(*patchCache);
+	}
+}
+
+void Partial::loadState(StateReader &reader) {
+	reader.read(sampleNum);
+	reader.read(leftPanValue);
+	reader.read(rightPanValue);
+	reader.read(ownerPart);
+	reader.read(mixType);
+	reader.read(structurePosition);
+	reader.read(pcmNum);
+	bool hasPCMWave;
+	reader.read(hasPCMWave);
+	reader.read(pulseWidthVal);
+	poly = reader.readPoly();
+	pair = reader.readPartial();
+	tva->loadState(reader, isActive());
+	tvp->loadState(reader, isActive());
+	tvf->loadState(reader, isActive());
+	ampRamp.loadState(reader);
+	cutoffModifierRamp.loadState(reader);
+	la32Pair->loadState(reader);
+	if (ownerPart < -1 || 8 < ownerPart || (isActive() && poly == NULL) || (hasPCMWave && (pcmNum < 0 || synth->controlROMMap->pcmCount <= pcmNum))) {
+		reader.fail();
+	}
+	if (reader.isFailed()) {
+		ownerPart = -1;
+		pcmWave = NULL;
+		return;
+	}
+	pcmWave = hasPCMWave ? &synth->pcmWaves[pcmNum] : NULL;
+	if (isActive()) {
+		// An active partial normally shares the patch cache of its part until the part is about to alter the cache.
+		// Owning a copy right away makes no audible difference.
+		reader.readPatchCache(cachebackup);
+		patchCache = &cachebackup;
+	}
+	alreadyOutputed = false;
+}
+
 } // namespace MT32Emu
@@ -18,9 +18,12 @@
 #ifndef MT32EMU_PARTIAL_H
 #define MT32EMU_PARTIAL_H
 
+#include <cstddef>
+
 #include "globals.h"
 #include "internals.h"
 #include "Types.h"
+#include "Enumerations.h"
 #include "Structures.h"
 #include "LA32Ramp.h"
 #include "LA32WaveGenerator.h"
@@ -28,8 +31,11 @@
 
 namespace MT32Emu {
 
+class MemoryArena;
 class Part;
 class Poly;
+class StateReader;
+class StateWriter;
 class Synth;
 class TVA;
 class TVF;
@@ -88,13 +94,20 @@ private:
 	bool canProduceOutput();
 	template <class LA32PairImpl>
 	bool generateNextSample(LA32PairImpl *la32PairImpl);
+	template <class LA32PairImpl>
+	bool skipNextSample(LA32PairImpl *la32PairImpl);
+	template <class LA32PairImpl>
+	bool doFastForward(Bit32u length, LA32PairImpl *la32PairImpl);
 	void produceAndMixSample(IntSample *&leftBuf, IntSample *&rightBuf, LA32IntPartialPair *la32IntPair);
 	void produceAndMixSample(FloatSample *&leftBuf, FloatSample *&rightBuf, LA32FloatPartialPair *la32FloatPair);
 
 public:
 	bool alreadyOutputed;
 
-	Partial(Synth *synth, int debugPartialNum);
+	// Returns the amount of arena memory needed to accommodate a Partial along with the objects it owns.
+	static size_t getArenaSize(RendererType rendererType);
+
+	Partial(Synth *synth, int debugPartialNum, MemoryArena &arena);
 	~Partial();
 
 	int debugGetPartialNum() const;
@@ -119,11 +132,18 @@ public:
 
 	void backupCache(const PatchCache &cache);
 
+	void saveState(StateWriter &writer) const;
+	void loadState(StateReader &reader);
+
 	// Returns true only if data written to buffer
 	// These functions produce processed stereo samples
 	// made from combining this single partial with its pair, if it has one.
 	bool produceOutput(IntSample *leftBuf, IntSample *rightBuf, Bit32u length);
 	bool produceOutput(FloatSample *leftBuf, FloatSample *rightBuf, Bit32u length);
+
+	// Advances the envelopes of this partial and its pair in the same way as produceOutput() but without producing
+	// any samples. Synth waves are not generated at all, so their phase isn't advanced.
+	bool fastForward(Bit32u length);
 }; // class Partial
 
 } // namespace MT32Emu
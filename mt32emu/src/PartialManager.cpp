@@ -17,13 +17,16 @@
 
 #include <cstddef>
 #include <cstring>
+#include <new>
 
 #include "internals.h"
 
 #include "PartialManager.h"
+#include "MemoryArena.h"
 #include "Part.h"
 #include "Partial.h"
 #include "Poly.h"
+#include "StateStream.h"
 #include "Synth.h"
 
 namespace MT32Emu {
@@ -32,35 +35,52 @@ PartialManager *PartialManager::getPartialManager(Synth &synth) {
 	return synth.partialManager;
 }
 
-PartialManager::PartialManager(Synth *useSynth) {
+size_t PartialManager::getArenaSize(Bit32u partialCount, RendererType rendererType) {
+	return MemoryArena::getChunkSize(partialCount * sizeof(Partial *))
+		+ MemoryArena::getChunkSize(partialCount * sizeof(int))
+		+ MemoryArena::getChunkSize(partialCount * sizeof(Poly))
+		+ MemoryArena::getChunkSize(partialCount * sizeof(Poly *))
+		+ partialCount * Partial::getArenaSize(rendererType);
+}
+
+PartialManager::PartialManager(Synth *useSynth, MemoryArena &arena) {
 	synth = useSynth;
 	parts = useSynth->parts;
 	inactivePartialCount = synth->getPartialCount();
-	partialTable = new Partial *[inactivePartialCount];
-	inactivePartials = new int[inactivePartialCount];
-	freePolys = new Poly *[synth->getPartialCount()];
+	partialTable = arena.allocateArray<Partial *>(inactivePartialCount);
+	inactivePartials = arena.allocateArray<int>(inactivePartialCount);
+	polys = arena.allocateArray<Poly>(inactivePartialCount);
+	freePolys = arena.allocateArray<Poly *>(inactivePartialCount);
 	firstFreePolyIndex = 0;
+	partialOutputEnd = 0;
 	for (unsigned int i = 0; i < synth->getPartialCount(); i++) {
-		partialTable[i] = new Partial(synth, i);
+		partialTable[i] = new(arena.allocate(sizeof(Partial))) Partial(synth, i, arena);
 		inactivePartials[i] = inactivePartialCount - i - 1;
-		freePolys[i] = new Poly();
+		freePolys[i] = new(&polys[i]) Poly();
 	}
 }
 
 PartialManager::~PartialManager(void) {
+	// The polys may be still owned by parts at this point. Anyway, the memory is owned by the synth arena.
 	for (unsigned int i = 0; i < synth->getPartialCount(); i++) {
-		delete partialTable[i];
-		if (freePolys[i] != NULL) delete freePolys[i];
+		partialTable[i]->~Partial();
+		polys[i].~Poly();
 	}
-	delete[] partialTable;
-	delete[] inactivePartials;
-	delete[] freePolys;
 }
 
 void PartialManager::clearAlreadyOutputed() {
 	for (unsigned int i = 0; i < synth->getPartialCount(); i++) {
 		partialTable[i]->alreadyOutputed = false;
 	}
+	partialOutputEnd = 0;
+}
+
+void PartialManager::partialOutputEnded(Bit32u sampleCount) {
+	if (partialOutputEnd < sampleCount) partialOutputEnd = sampleCount;
+}
+
+Bit32u PartialManager::getPartialOutputEnd() const {
+	return partialOutputEnd;
 }
 
 bool PartialManager::shouldReverb(int i) {
@@ -75,6 +95,10 @@ bool PartialManager::produceOutput(int i, FloatSample *leftBuf, FloatSample *rig
 	return partialTable[i]->produceOutput(leftBuf, rightBuf, bufferLength);
 }
 
+bool PartialManager::fastForward(int i, Bit32u length) {
+	return partialTable[i]->fastForward(length);
+}
+
 void PartialManager::deactivateAll() {
 	for (unsigned int i = 0; i < synth->getPartialCount(); i++) {
 		partialTable[i]->deactivate();
@@ -359,4 +383,41 @@ void PartialManager::partialDeactivated(int partialIndex) {
 	}
 }
 
+void PartialManager::saveState(StateWriter &writer) const {
+	writer.write(numReservedPartialsForPart);
+	writer.write(firstFreePolyIndex);
+	writer.write(inactivePartialCount);
+	for (Bit32u i = 0; i < synth->getPartialCount(); i++) {
+		writer.writePoly(freePolys[i]);
+		writer.writePartial(i < inactivePartialCount ? partialTable[inactivePartials[i]] : NULL);
+	}
+	for (Bit32u i = 0; i < synth->getPartialCount(); i++) {
+		polys[i].saveState(writer);
+		partialTable[i]->saveState(writer);
+	}
+}
+
+void PartialManager::loadState(StateReader &reader) {
+	reader.read(numReservedPartialsForPart);
+	reader.read(firstFreePolyIndex);
+	reader.read(inactivePartialCount);
+	if (synth->getPartialCount() < firstFreePolyIndex || synth->getPartialCount() < inactivePartialCount) {
+		reader.fail();
+	}
+	for (Bit32u i = 0; i < synth->getPartialCount(); i++) {
+		freePolys[i] = reader.readPoly();
+		const Partial *inactivePartial = reader.readPartial();
+		if (inactivePartial == NULL) {
+			if (i < inactivePartialCount) reader.fail();
+			inactivePartials[i] = -1;
+		} else {
+			inactivePartials[i] = inactivePartial->debugGetPartialNum();
+		}
+	}
+	for (Bit32u i = 0; i < synth->getPartialCount(); i++) {
+		polys[i].loadState(reader);
+		partialTable[i]->loadState(reader);
+	}
+}
+
 } // namespace MT32Emu
@@ -18,27 +18,39 @@
 #ifndef MT32EMU_PARTIALMANAGER_H
 #define MT32EMU_PARTIALMANAGER_H
 
+#include <cstddef>
+
 #include "globals.h"
 #include "internals.h"
 #include "Types.h"
+#include "Enumerations.h"
 
 namespace MT32Emu {
 
+class MemoryArena;
 class Part;
 class Partial;
 class Poly;
+class StateReader;
+class StateWriter;
 class Synth;
 
 class PartialManager {
+friend class StateReader;
+friend class StateWriter;
+
 private:
 	Synth *synth;
 	Part **parts;
+	Poly *polys;
 	Poly **freePolys;
 	Partial **partialTable;
 	Bit8u numReservedPartialsForPart[9];
 	Bit32u firstFreePolyIndex;
 	int *inactivePartials; // Holds indices of inactive Partials in the Partial table
 	Bit32u inactivePartialCount;
+	// Number of samples produced in the current rendering pass by the partial that was deactivated last within the pass.
+	Bit32u partialOutputEnd;
 
 	bool abortFirstReleasingPolyWhereReserveExceeded(int minPart);
 	bool abortFirstPolyPreferHeldWhereReserveExceeded(int minPart);
@@ -48,8 +60,10 @@ private:
 
 public:
 	static PartialManager *getPartialManager(Synth &synth);
+	// Returns the amount of arena memory the constructor allocates for the partials, polys and the bookkeeping tables.
+	static size_t getArenaSize(Bit32u partialCount, RendererType rendererType);
 
-	PartialManager(Synth *useSynth);
+	PartialManager(Synth *useSynth, MemoryArena &arena);
 	~PartialManager();
 	Partial *allocPartial(int partNum);
 	unsigned int getFreePartialCount();
@@ -60,12 +74,17 @@ public:
 	void deactivateAll();
 	bool produceOutput(int i, IntSample *leftBuf, IntSample *rightBuf, Bit32u bufferLength);
 	bool produceOutput(int i, FloatSample *leftBuf, FloatSample *rightBuf, Bit32u bufferLength);
+	bool fastForward(int i, Bit32u length);
 	bool shouldReverb(int i);
 	void clearAlreadyOutputed();
+	void partialOutputEnded(Bit32u sampleCount);
+	Bit32u getPartialOutputEnd() const;
 	const Partial *getPartial(unsigned int partialNum) const;
 	Poly *assignPolyToPart(Part *part);
 	void polyFreed(Poly *poly);
 	void partialDeactivated(int partialIndex);
+	void saveState(StateWriter &writer) const;
+	void loadState(StateReader &reader);
 }; // class PartialManager
 
 } // namespace MT32Emu
@@ -22,6 +22,7 @@
 #include "Poly.h"
 #include "Part.h"
 #include "Partial.h"
+#include "StateStream.h"
 #include "Synth.h"
 
 namespace MT32Emu {
@@ -194,4 +195,36 @@ void Poly::setNext(Poly *poly) {
 	next = poly;
 }
 
+void Poly::saveState(StateWriter &writer) const {
+	writer.writePart(part);
+	writer.write(key);
+	writer.write(velocity);
+	writer.write(activePartialCount);
+	writer.write(sustain);
+	writer.write(Bit32u(state));
+	for (int i = 0; i < 4; i++) {
+		writer.writePartial(partials[i]);
+	}
+	writer.writePoly(next);
+}
+
+void Poly::loadState(StateReader &reader) {
+	part = reader.readPart();
+	reader.read(key);
+	reader.read(velocity);
+	reader.read(activePartialCount);
+	reader.read(sustain);
+	// Read as a plain integer, an out-of-range value of the enum itself would be undefined behaviour.
+	Bit32u stateValue;
+	reader.read(stateValue);
+	state = Bit32u(POLY_Inactive) < stateValue ? POLY_Inactive : PolyState(stateValue);
+	for (int i = 0; i < 4; i++) {
+		partials[i] = reader.readPartial();
+	}
+	next = reader.readPoly();
+	if (Bit32u(POLY_Inactive) < stateValue || 4 < activePartialCount || (state != POLY_Inactive && part == NULL)) {
+		reader.fail();
+	}
+}
+
 } // namespace MT32Emu
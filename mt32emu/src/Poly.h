@@ -25,6 +25,8 @@ namespace MT32Emu {
 
 class Part;
 class Partial;
+class StateReader;
+class StateWriter;
 struct PatchCache;
 
 class Poly {
@@ -65,6 +67,9 @@ public:
 
 	Poly *getNext() const;
 	void setNext(Poly *poly);
+
+	void saveState(StateWriter &writer) const;
+	void loadState(StateReader &reader);
 }; // class Poly
 
 } // namespace MT32Emu
@@ -0,0 +1,190 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#if defined _WIN32
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#elif defined __unix__ || defined __APPLE__ || defined __HAIKU__
+#  include <unistd.h>
+#endif
+
+#include "internals.h"
+
+#include "ROMIndex.h"
+#include "MappedFile.h"
+#include "ROMInfo.h"
+
+namespace MT32Emu {
+
+static const char INDEX_FILE_SIGNATURE[] = "mt32emu-rom-index 1";
+
+static bool isKnownROMSize(size_t fileSize) {
+	const ROMInfo * const *romInfos = ROMInfo::getAllROMInfos();
+	for (Bit32u i = 0; romInfos[i] != NULL; i++) {
+		if (romInfos[i]->fileSize == fileSize) return true;
+	}
+	return false;
+}
+
+static unsigned long getProcessID() {
+#if defined _WIN32
+	return GetCurrentProcessId();
+#elif defined __unix__ || defined __APPLE__ || defined __HAIKU__
+	return static_cast<unsigned long>(getpid());
+#else
+	return 0;
+#endif
+}
+
+static bool replaceFile(const char *filename, const char *newFilename) {
+#if defined _WIN32
+	return MoveFileExA(newFilename, filename, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(newFilename, filename) == 0;
+#endif
+}
+
+ROMIndex::ROMIndex() : entries(NULL), entryCount(0), entryCapacity(0), modified(false) {}
+
+ROMIndex::~ROMIndex() {
+	clear();
+	delete[] entries;
+}
+
+bool ROMIndex::load(const char *indexFilename) {
+	clear();
+	modified = false;
+	std::ifstream ifs(indexFilename, std::ios_base::in | std::ios_base::binary);
+	if (ifs.fail()) return false;
+	std::string line;
+	if (!std::getline(ifs, line) || line != INDEX_FILE_SIGNATURE) return false;
+	while (std::getline(ifs, line)) {
+		char sha1Digest[sizeof(File::SHA1Digest)];
+		unsigned long fileSize, timeHigh, timeLow;
+		int filenameOffset = 0;
+		int fieldCount = sscanf(line.c_str(), "%40[0-9a-f] %lu %lu %lu%n", sha1Digest, &fileSize, &timeHigh, &timeLow, &filenameOffset);
+		if (fieldCount != 4 || strlen(sha1Digest) != sizeof(File::SHA1Digest) - 1
+			|| line.size() <= size_t(filenameOffset) + 1 || line[filenameOffset] != ' ') {
+			clear();
+			return false;
+		}
+		const char *filename = line.c_str() + filenameOffset + 1;
+		Entry *entry = findEntry(filename);
+		if (entry == NULL) entry = addEntry(filename);
+		entry->fileSize = size_t(fileSize);
+		entry->modificationTime[0] = Bit32u(timeHigh);
+		entry->modificationTime[1] = Bit32u(timeLow);
+		memcpy(entry->sha1Digest, sha1Digest, sizeof(File::SHA1Digest));
+	}
+	return true;
+}
+
+bool ROMIndex::save(const char *indexFilename) {
+	if (!modified) return true;
+
+	// Write to a temporary file first, then replace the index, so that processes sharing the index never read
+	// a partially written file. The process ID makes the temporary file name unique among concurrent writers.
+	char suffix[32];
+	sprintf(suffix, ".%lu.tmp", getProcessID());
+	std::string tempFilename = std::string(indexFilename) + suffix;
+	{
+		std::ofstream ofs(tempFilename.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+		if (ofs.fail()) return false;
+		ofs << INDEX_FILE_SIGNATURE << '\n';
+		for (size_t i = 0; i < entryCount; i++) {
+			const Entry &entry = entries[i];
+			ofs << entry.sha1Digest << ' ' << static_cast<unsigned long>(entry.fileSize) << ' ' << static_cast<unsigned long>(entry.modificationTime[0])
+				<< ' ' << static_cast<unsigned long>(entry.modificationTime[1]) << ' ' << entry.filename << '\n';
+		}
+		ofs.close();
+		if (ofs.fail()) {
+			remove(tempFilename.c_str());
+			return false;
+		}
+	}
+	if (!replaceFile(indexFilename, tempFilename.c_str())) {
+		remove(tempFilename.c_str());
+		return false;
+	}
+	modified = false;
+	return true;
+}
+
+bool ROMIndex::isModified() const {
+	return modified;
+}
+
+void ROMIndex::indexFile(MappedFile &file, const char *filename) {
+	Bit32u modificationTime[2];
+	// Without the modification time, changes to the file cannot be detected, and line breaks would corrupt the index.
+	if (!file.getModificationTime(modificationTime[0], modificationTime[1]) || strpbrk(filename, "\r\n") != NULL) return;
+	size_t fileSize = file.getSize();
+	Entry *entry = findEntry(filename);
+	if (entry != NULL && entry->fileSize == fileSize && entry->modificationTime[0] == modificationTime[0] && entry->modificationTime[1] == modificationTime[1]) {
+		file.setSHA1(entry->sha1Digest);
+		return;
+	}
+	// A digest read from a sidecar is trusted by the caller, yet it hasn't been verified, so it isn't worth recording.
+	if (!isKnownROMSize(fileSize) || file.isSHA1Provided()) return;
+	if (entry == NULL) entry = addEntry(filename);
+	entry->fileSize = fileSize;
+	entry->modificationTime[0] = modificationTime[0];
+	entry->modificationTime[1] = modificationTime[1];
+	memcpy(entry->sha1Digest, file.getSHA1(), sizeof(File::SHA1Digest));
+	modified = true;
+}
+
+ROMIndex::Entry *ROMIndex::findEntry(const char *filename) const {
+	for (size_t i = 0; i < entryCount; i++) {
+		if (strcmp(entries[i].filename, filename) == 0) return &entries[i];
+	}
+	return NULL;
+}
+
+ROMIndex::Entry *ROMIndex::addEntry(const char *filename) {
+	if (entryCount == entryCapacity) {
+		entryCapacity = entryCapacity == 0 ? 16 : 2 * entryCapacity;
+		Entry *newEntries = new Entry[entryCapacity];
+		if (entryCount > 0) memcpy(newEntries, entries, entryCount * sizeof(Entry));
+		delete[] entries;
+		entries = newEntries;
+	}
+	Entry &entry = entries[entryCount++];
+	size_t filenameSize = strlen(filename) + 1;
+	entry.filename = new char[filenameSize];
+	memcpy(entry.filename, filename, filenameSize);
+	return &entry;
+}
+
+void ROMIndex::clear() {
+	for (size_t i = 0; i < entryCount; i++) {
+		delete[] entries[i].filename;
+	}
+	entryCount = 0;
+}
+
+} // namespace MT32Emu
@@ -0,0 +1,76 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_ROM_INDEX_H
+#define MT32EMU_ROM_INDEX_H
+
+#include <cstddef>
+
+#include "globals.h"
+#include "Types.h"
+#include "File.h"
+
+namespace MT32Emu {
+
+class MappedFile;
+
+// Remembers SHA1 digests of ROM files along with their sizes and modification times, so that identifying
+// the same ROM files again only requires hashing those that have changed since. The index can be persisted
+// in a small text file shared by many application runs. Only files that have the size of a known ROM image
+// are hashed and recorded, the rest cannot be identified anyway.
+// The index is not thread-safe.
+class ROMIndex {
+public:
+	MT32EMU_EXPORT_V(2.8) ROMIndex();
+	MT32EMU_EXPORT_V(2.8) ~ROMIndex();
+
+	// Replaces the contents of the index with the entries read from the index file. Returns false if the file
+	// cannot be read or is malformed, in which case the index remains empty.
+	MT32EMU_EXPORT_V(2.8) bool load(const char *indexFilename);
+	// Writes the index to the given file unless it is unchanged since the last load or save. The file is replaced
+	// atomically where possible, so that concurrent readers never see a partially written index.
+	// Returns false if writing fails.
+	MT32EMU_EXPORT_V(2.8) bool save(const char *indexFilename);
+	// Returns true if entries have been added or updated since the last load or save.
+	MT32EMU_EXPORT_V(2.8) bool isModified() const;
+
+	// Supplies the file opened from the given path with the SHA1 digest recorded in the index if the size and
+	// the modification time of the file still match the entry. Otherwise, when the file size matches a known ROM image,
+	// the digest is computed and recorded. A digest already provided to the file, e.g. by a sidecar, is never recorded.
+	MT32EMU_EXPORT_V(2.8) void indexFile(MappedFile &file, const char *filename);
+
+private:
+	struct Entry {
+		char *filename;
+		size_t fileSize;
+		Bit32u modificationTime[2];
+		File::SHA1Digest sha1Digest;
+	};
+
+	Entry *entries;
+	size_t entryCount;
+	size_t entryCapacity;
+	bool modified;
+
+	Entry *findEntry(const char *filename) const;
+	Entry *addEntry(const char *filename);
+	void clear();
+};
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_ROM_INDEX_H
@@ -117,6 +117,28 @@ void SampleRateConverter::getOutputSamples(Bit16s *outBuffer, unsigned int lengt
 	}
 }
 
+void SampleRateConverter::getOutputSamples(float *leftBuffer, float *rightBuffer, unsigned int length) {
+	static const unsigned int CHANNEL_COUNT = 2;
+
+	if (useSynthDelegate) {
+		static_cast<Synth *>(srcDelegate)->renderPlanar(leftBuffer, rightBuffer, length);
+		return;
+	}
+
+	float floatBuffer[CHANNEL_COUNT * MAX_SAMPLES_PER_RUN];
+	while (length > 0) {
+		const unsigned int size = MAX_SAMPLES_PER_RUN < length ? MAX_SAMPLES_PER_RUN : length;
+		getOutputSamples(floatBuffer, size);
+		const float *ins = floatBuffer;
+		const float *ends = floatBuffer + CHANNEL_COUNT * size;
+		while (ins < ends) {
+			*(leftBuffer++) = *(ins++);
+			*(rightBuffer++) = *(ins++);
+		}
+		length -= size;
+	}
+}
+
 double SampleRateConverter::convertOutputToSynthTimestamp(double outputTimestamp) const {
 	return outputTimestamp * synthInternalToTargetSampleRateRatio;
 }
@@ -54,6 +54,10 @@ public:
 	// The input samples are automatically retrieved from the synth as necessary.
 	void getOutputSamples(float *buffer, unsigned int length);
 
+	// Fills the provided output buffers with the results of the sample rate conversion, the left and right channels separately.
+	// The input samples are automatically retrieved from the synth as necessary.
+	void getOutputSamples(float *leftBuffer, float *rightBuffer, unsigned int length);
+
 	// Returns the number of samples produced at the internal synth sample rate (32000 Hz)
 	// that correspond to the number of samples at the target sample rate.
 	// Intended to facilitate audio time synchronisation.
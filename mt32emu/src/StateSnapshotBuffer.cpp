@@ -0,0 +1,120 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "internals.h"
+
+#include "StateSnapshotBuffer.h"
+#include "MemoryBarrier.h"
+#include "Synth.h"
+
+namespace MT32Emu {
+
+// Number of attempts to read a consistent snapshot before giving up. A retry is only necessary
+// when the rendering thread manages to publish two snapshots while the reader is still copying the data.
+static const unsigned int MAX_READ_ATTEMPTS = 8;
+
+StateSnapshotBuffer::StateSnapshotBuffer(Bit32u usePartialCount) : partialCount(usePartialCount), sequence(0) {
+	for (int slotIx = 0; slotIx < 2; slotIx++) {
+		Slot &slot = slots[slotIx];
+		slot.renderedSampleCount = 0;
+		slot.partStates = 0;
+		slot.midiMessageLEDState = false;
+		memset(slot.lcdState, 0, sizeof slot.lcdState);
+		memset(slot.playingNoteCounts, 0, sizeof slot.playingNoteCounts);
+		slot.partialStates = new PartialState[partialCount];
+		slot.keys = new Bit8u[partialCount];
+		slot.velocities = new Bit8u[partialCount];
+		for (Bit32u partialNum = 0; partialNum < partialCount; partialNum++) {
+			slot.partialStates[partialNum] = PartialState_INACTIVE;
+		}
+	}
+}
+
+StateSnapshotBuffer::~StateSnapshotBuffer() {
+	for (int slotIx = 0; slotIx < 2; slotIx++) {
+		delete[] slots[slotIx].partialStates;
+		delete[] slots[slotIx].keys;
+		delete[] slots[slotIx].velocities;
+	}
+}
+
+void StateSnapshotBuffer::publish(const Synth &synth) {
+	// The front buffer index is derived from the sequence counter, so we fill in the other one.
+	Bit32u nextSequence = sequence + 1;
+	Slot &slot = slots[((nextSequence >> 1) & 1) ^ 1];
+	sequence = nextSequence;
+	memoryBarrier();
+
+	slot.renderedSampleCount = synth.getInternalRenderedSampleCount();
+	slot.partStates = synth.getPartStates();
+	slot.midiMessageLEDState = synth.getDisplayState(slot.lcdState);
+	Bit32u noteOffset = 0;
+	for (Bit8u partNumber = 0; partNumber < 9; partNumber++) {
+		Bit32u playingNoteCount = synth.getPlayingNotes(partNumber, slot.keys + noteOffset, slot.velocities + noteOffset);
+		slot.playingNoteCounts[partNumber] = playingNoteCount;
+		noteOffset += playingNoteCount;
+	}
+	synth.getPartialStates(slot.partialStates);
+
+	memoryBarrier();
+	sequence = nextSequence + 1;
+}
+
+bool StateSnapshotBuffer::read(StateSnapshot &snapshot) const {
+	for (unsigned int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+		Bit32u startSequence = sequence;
+		memoryBarrier();
+		copySlot(slots[(startSequence >> 1) & 1], snapshot);
+		memoryBarrier();
+		// The slot we've just copied is only overwritten after the writer completes the publication to the other slot.
+		// Counting from the last even sequence value, that takes at least three increments of the counter.
+		if (Bit32u(sequence - (startSequence & ~1U)) <= 2) return true;
+	}
+	return false;
+}
+
+void StateSnapshotBuffer::copySlot(const Slot &slot, StateSnapshot &snapshot) const {
+	snapshot.renderedSampleCount = slot.renderedSampleCount;
+	snapshot.partStates = slot.partStates;
+	snapshot.midiMessageLEDState = slot.midiMessageLEDState;
+	memcpy(snapshot.lcdState, slot.lcdState, sizeof slot.lcdState);
+	memcpy(snapshot.playingNoteCounts, slot.playingNoteCounts, sizeof slot.playingNoteCounts);
+	Bit32u totalNoteCount = 0;
+	for (int partNumber = 0; partNumber < 9; partNumber++) {
+		totalNoteCount += slot.playingNoteCounts[partNumber];
+	}
+	// The counters may be garbage if the writer is racing with us, the sequence check discards the result then.
+	if (partialCount < totalNoteCount) totalNoteCount = partialCount;
+	if (snapshot.keys != NULL) memcpy(snapshot.keys, slot.keys, totalNoteCount);
+	if (snapshot.velocities != NULL) memcpy(snapshot.velocities, slot.velocities, totalNoteCount);
+	if (snapshot.partialStates != NULL) memcpy(snapshot.partialStates, slot.partialStates, partialCount * sizeof(PartialState));
+	if (snapshot.packedPartialStates != NULL) {
+		for (Bit32u quartNum = 0; (4 * quartNum) < partialCount; quartNum++) {
+			Bit8u packedStates = 0;
+			for (Bit32u i = 0; i < 4; i++) {
+				Bit32u partialNum = (4 * quartNum) + i;
+				if (partialCount <= partialNum) break;
+				packedStates |= (slot.partialStates[partialNum] & 3) << (2 * i);
+			}
+			snapshot.packedPartialStates[quartNum] = packedStates;
+		}
+	}
+}
+
+} // namespace MT32Emu
@@ -0,0 +1,68 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_STATE_SNAPSHOT_BUFFER_H
+#define MT32EMU_STATE_SNAPSHOT_BUFFER_H
+
+#include "globals.h"
+#include "Types.h"
+#include "Enumerations.h"
+
+namespace MT32Emu {
+
+class Synth;
+struct StateSnapshot;
+
+/**
+ * Double-buffered storage of the synth state snapshots. The rendering thread publishes a new snapshot at the end
+ * of each rendering pass while the previously published one remains available for reading.
+ * THREAD SAFETY:
+ * Only a single thread may publish snapshots, normally that is the rendering thread. Any number of threads may read
+ * the snapshots concurrently without locking. The consistency of the data being read is ensured by a sequence counter
+ * (seqlock): the counter is odd while the writer fills in the back buffer and becomes even when the buffers are swapped.
+ * A reader retries the copy if the buffer it was reading from could have been overwritten meanwhile.
+ */
+class StateSnapshotBuffer {
+public:
+	StateSnapshotBuffer(Bit32u partialCount);
+	~StateSnapshotBuffer();
+
+	void publish(const Synth &synth);
+	bool read(StateSnapshot &snapshot) const;
+
+private:
+	struct Slot {
+		Bit32u renderedSampleCount;
+		Bit32u partStates;
+		bool midiMessageLEDState;
+		char lcdState[21];
+		Bit32u playingNoteCounts[9];
+		PartialState *partialStates;
+		Bit8u *keys;
+		Bit8u *velocities;
+	};
+
+	const Bit32u partialCount;
+	volatile Bit32u sequence;
+	Slot slots[2];
+
+	void copySlot(const Slot &slot, StateSnapshot &snapshot) const;
+};
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_STATE_SNAPSHOT_BUFFER_H
@@ -0,0 +1,204 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "internals.h"
+
+#include "StateStream.h"
+#include "Partial.h"
+#include "PartialManager.h"
+#include "Poly.h"
+#include "Structures.h"
+#include "Synth.h"
+
+namespace MT32Emu {
+
+// Denotes a NULL pointer in place of an index or an offset.
+static const Bit32u NO_INDEX = 0xFFFFFFFF;
+
+StateWriter::StateWriter(const Synth &useSynth, Bit8u *useBuffer, Bit32u useBufferSize) :
+	synth(useSynth), buffer(useBuffer), bufferSize(useBuffer == NULL ? 0 : useBufferSize), position(0)
+{}
+
+Bit32u StateWriter::getSize() const {
+	return position;
+}
+
+bool StateWriter::isComplete() const {
+	return position <= bufferSize;
+}
+
+void StateWriter::writeBytes(const void *data, Bit32u length) {
+	if (position <= bufferSize && length <= bufferSize - position) {
+		memcpy(buffer + position, data, length);
+	}
+	position += length;
+}
+
+void StateWriter::writePart(const Part *part) {
+	Bit32u partIndex = NO_INDEX;
+	for (Bit32u i = 0; i < 9; i++) {
+		if (synth.parts[i] == part) partIndex = i;
+	}
+	write(partIndex);
+}
+
+void StateWriter::writePoly(const Poly *poly) {
+	write(poly == NULL ? NO_INDEX : Bit32u(poly - synth.partialManager->polys));
+}
+
+void StateWriter::writePartial(const Partial *partial) {
+	write(partial == NULL ? NO_INDEX : Bit32u(partial->debugGetPartialNum()));
+}
+
+void StateWriter::writeRAMPointer(const void *pointer) {
+	const Bit8u *ramStart = reinterpret_cast<const Bit8u *>(&synth.mt32ram);
+	const Bit8u *bytePointer = static_cast<const Bit8u *>(pointer);
+	if (bytePointer < ramStart || ramStart + sizeof(MemParams) <= bytePointer) {
+		write(NO_INDEX);
+	} else {
+		write(Bit32u(bytePointer - ramStart));
+	}
+}
+
+void StateWriter::writePCMPointer(const Bit16s *pointer) {
+	if (pointer < synth.pcmROMData || synth.pcmROMData + synth.pcmROMSize <= pointer) {
+		write(NO_INDEX);
+	} else {
+		write(Bit32u(pointer - synth.pcmROMData));
+	}
+}
+
+void StateWriter::writePCMWave(const Bit16s *address, Bit32u length) {
+	writePCMPointer(address);
+	write(length);
+}
+
+void StateWriter::writePatchCache(const PatchCache &cache) {
+	write(cache.playPartial);
+	write(cache.PCMPartial);
+	write(cache.pcm);
+	write(cache.waveform);
+	write(cache.structureMix);
+	write(cache.structurePosition);
+	write(cache.structurePair);
+	write(cache.dirty);
+	write(cache.partialCount);
+	write(cache.sustain);
+	write(cache.reverb);
+	write(cache.srcPartial);
+	writeRAMPointer(cache.partialParam);
+}
+
+StateReader::StateReader(Synth &useSynth, const Bit8u *useBuffer, Bit32u useBufferSize) :
+	synth(useSynth), buffer(useBuffer), bufferSize(useBuffer == NULL ? 0 : useBufferSize), position(0), failed(false)
+{}
+
+bool StateReader::isFailed() const {
+	return failed;
+}
+
+bool StateReader::isAtEnd() const {
+	return position == bufferSize;
+}
+
+void StateReader::fail() {
+	failed = true;
+}
+
+void StateReader::readBytes(void *data, Bit32u length) {
+	if (failed || bufferSize - position < length) {
+		failed = true;
+		memset(data, 0, length);
+		return;
+	}
+	memcpy(data, buffer + position, length);
+	position += length;
+}
+
+const Bit8u *StateReader::readByteArray(Bit32u length) {
+	if (failed || bufferSize - position < length) {
+		failed = true;
+		return NULL;
+	}
+	const Bit8u *data = buffer + position;
+	position += length;
+	return data;
+}
+
+Bit32u StateReader::readIndex(Bit32u limit) {
+	Bit32u index;
+	read(index);
+	if (index == NO_INDEX) return NO_INDEX;
+	if (index < limit) return index;
+	failed = true;
+	return NO_INDEX;
+}
+
+Part *StateReader::readPart() {
+	Bit32u partIndex = readIndex(9);
+	return partIndex == NO_INDEX || failed ? NULL : synth.parts[partIndex];
+}
+
+Poly *StateReader::readPoly() {
+	Bit32u polyIndex = readIndex(synth.partialCount);
+	return polyIndex == NO_INDEX || failed ? NULL : &synth.partialManager->polys[polyIndex];
+}
+
+Partial *StateReader::readPartial() {
+	Bit32u partialIndex = readIndex(synth.partialCount);
+	return partialIndex == NO_INDEX || failed ? NULL : synth.partialManager->partialTable[partialIndex];
+}
+
+const void *StateReader::readRAMPointer(Bit32u objectSize) {
+	Bit32u offset = readIndex(sizeof(MemParams) - objectSize + 1);
+	return offset == NO_INDEX || failed ? NULL : reinterpret_cast<const Bit8u *>(&synth.mt32ram) + offset;
+}
+
+const Bit16s *StateReader::readPCMPointer() {
+	Bit32u offset = readIndex(Bit32u(synth.pcmROMSize));
+	return offset == NO_INDEX || failed ? NULL : synth.pcmROMData + offset;
+}
+
+const Bit16s *StateReader::readPCMWave(Bit32u &length) {
+	const Bit16s *address = readPCMPointer();
+	read(length);
+	if (address != NULL && Bit32u(synth.pcmROMSize) - Bit32u(address - synth.pcmROMData) < length) {
+		failed = true;
+		return NULL;
+	}
+	return address;
+}
+
+void StateReader::readPatchCache(PatchCache &cache) {
+	read(cache.playPartial);
+	read(cache.PCMPartial);
+	read(cache.pcm);
+	read(cache.waveform);
+	read(cache.structureMix);
+	read(cache.structurePosition);
+	read(cache.structurePair);
+	read(cache.dirty);
+	read(cache.partialCount);
+	read(cache.sustain);
+	read(cache.reverb);
+	read(cache.srcPartial);
+	cache.partialParam = readRAMPointer<TimbreParam::PartialParam>();
+}
+
+} // namespace MT32Emu
@@ -0,0 +1,129 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_STATE_STREAM_H
+#define MT32EMU_STATE_STREAM_H
+
+#include "globals.h"
+#include "Types.h"
+
+namespace MT32Emu {
+
+class Part;
+class Partial;
+class Poly;
+class Synth;
+struct PatchCache;
+
+/**
+ * Serialises the internal state of an open synth into a flat byte array. The values are stored in the native byte order
+ * and layout, so the resulting state can only be loaded by the same build of the library. Pointers between the objects
+ * of the synth are stored as indices of the objects or offsets into the emulated memory and the PCM ROM.
+ * When no buffer is provided, or once the buffer is exhausted, the writer merely counts the bytes it would have written.
+ */
+class StateWriter {
+public:
+	StateWriter(const Synth &synth, Bit8u *buffer, Bit32u bufferSize);
+
+	// Returns the number of bytes required to fit the entire written state.
+	Bit32u getSize() const;
+	// Returns false if the state didn't fit into the buffer.
+	bool isComplete() const;
+
+	void writeBytes(const void *data, Bit32u length);
+
+	template <class T>
+	void write(const T &value) {
+		writeBytes(&value, sizeof(T));
+	}
+
+	void writePart(const Part *part);
+	void writePoly(const Poly *poly);
+	void writePartial(const Partial *partial);
+	// Stores a pointer into the sysex-addressable memory of the synth.
+	void writeRAMPointer(const void *pointer);
+	void writePCMPointer(const Bit16s *pointer);
+	// Stores a pointer to a PCM wave along with its length.
+	void writePCMWave(const Bit16s *address, Bit32u length);
+	void writePatchCache(const PatchCache &cache);
+
+private:
+	const Synth &synth;
+	Bit8u * const buffer;
+	const Bit32u bufferSize;
+	Bit32u position;
+};
+
+/**
+ * Counterpart of StateWriter. The reader never accesses data beyond the end of the buffer, and the indices and offsets
+ * it converts to pointers are validated against the synth. Upon encountering malformed data, the reader enters failed state
+ * and yields zero values and NULL pointers from then on, so the objects being restored always remain in a safe state.
+ */
+class StateReader {
+public:
+	StateReader(Synth &synth, const Bit8u *buffer, Bit32u bufferSize);
+
+	bool isFailed() const;
+	// Returns true if the entire buffer has been consumed.
+	bool isAtEnd() const;
+	void fail();
+
+	void readBytes(void *data, Bit32u length);
+	// Returns a pointer to the next length bytes within the buffer, or NULL if the buffer is too short.
+	const Bit8u *readByteArray(Bit32u length);
+
+	template <class T>
+	void read(T &value) {
+		readBytes(&value, sizeof(T));
+	}
+
+	// Reads a value and enters failed state unless it matches the expected one.
+	template <class T>
+	void expect(const T &expectedValue) {
+		T value;
+		read(value);
+		if (value != expectedValue) fail();
+	}
+
+	Part *readPart();
+	Poly *readPoly();
+	Partial *readPartial();
+	const void *readRAMPointer(Bit32u objectSize);
+
+	template <class T>
+	const T *readRAMPointer() {
+		return static_cast<const T *>(readRAMPointer(sizeof(T)));
+	}
+
+	const Bit16s *readPCMPointer();
+	// Reads a pointer to a PCM wave along with its length, a wave that doesn't fit within the PCM ROM is malformed data.
+	const Bit16s *readPCMWave(Bit32u &length);
+	void readPatchCache(PatchCache &cache);
+
+private:
+	Synth &synth;
+	const Bit8u * const buffer;
+	const Bit32u bufferSize;
+	Bit32u position;
+	bool failed;
+
+	Bit32u readIndex(Bit32u limit);
+};
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_STATE_STREAM_H
@@ -0,0 +1,158 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <ctime>
+
+#if defined _WIN32
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#elif defined __unix__ || defined __APPLE__ || defined __HAIKU__
+#  include <time.h>
+#  define MT32EMU_STATISTICS_CLOCK_GETTIME
+#endif
+
+#include "internals.h"
+
+#include "StatisticsCollector.h"
+#include "Part.h"
+#include "Synth.h"
+
+namespace MT32Emu {
+
+// See StateSnapshotBuffer.
+static const unsigned int MAX_READ_ATTEMPTS = 8;
+
+double StatisticsCollector::getTime() {
+#if defined _WIN32
+	static LARGE_INTEGER frequency;
+	if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return double(counter.QuadPart) / double(frequency.QuadPart);
+#elif defined MT32EMU_STATISTICS_CLOCK_GETTIME
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return double(time.tv_sec) + 1e-9 * double(time.tv_nsec);
+#else
+	// Measures processor time rather than wall-clock time, yet it is good enough as a fallback.
+	return double(std::clock()) / double(CLOCKS_PER_SEC);
+#endif
+}
+
+StatisticsCollector::StatisticsCollector() : renderPassStartTime(0), renderPassStageDuration(0), silencedPolyCount(0), ignoredNoteOnCount(0), resetRequested(false), sequence(0) {
+	reset();
+	memset(slots, 0, sizeof slots);
+}
+
+void StatisticsCollector::reset() {
+	memset(&current, 0, sizeof current);
+	for (int partNumber = 0; partNumber < 9; partNumber++) {
+		activePartialSampleSums[partNumber] = 0;
+	}
+	totalSampleCount = 0;
+	silencedPolyCountAtReset = silencedPolyCount;
+	ignoredNoteOnCountAtReset = ignoredNoteOnCount;
+}
+
+void StatisticsCollector::beginRenderPass(Bit32u pendingMidiEventCount) {
+	if (resetRequested) {
+		resetRequested = false;
+		reset();
+	}
+	if (current.midiQueueHighWaterMark < pendingMidiEventCount) current.midiQueueHighWaterMark = pendingMidiEventCount;
+	renderPassStageDuration = 0;
+	renderPassStartTime = getTime();
+}
+
+void StatisticsCollector::endRenderPass() {
+	double duration = getTime() - renderPassStartTime;
+	current.renderPassCount++;
+	current.totalRenderPassDuration += duration;
+	if (current.maxRenderPassDuration < duration) current.maxRenderPassDuration = duration;
+	// The clock resolution may cause the stages to appear longer than the whole pass.
+	if (renderPassStageDuration < duration) current.totalPartialRenderingDuration += duration - renderPassStageDuration;
+
+	Bit32u nextSequence = sequence + 1;
+	Slot &slot = slots[((nextSequence >> 1) & 1) ^ 1];
+	sequence = nextSequence;
+	memoryBarrier();
+
+	slot.counters = current;
+	slot.silencedPolyCount = silencedPolyCount - silencedPolyCountAtReset;
+	slot.ignoredNoteOnCount = ignoredNoteOnCount - ignoredNoteOnCountAtReset;
+	for (int partNumber = 0; partNumber < 9; partNumber++) {
+		double average = totalSampleCount > 0 ? activePartialSampleSums[partNumber] / totalSampleCount : 0;
+		slot.averageActivePartialCounts[partNumber] = float(average);
+	}
+
+	memoryBarrier();
+	sequence = nextSequence + 1;
+}
+
+void StatisticsCollector::endStage(RenderingStage stage, double stageStartTime) {
+	double duration = getTime() - stageStartTime;
+	current.totalStageDurations[stage] += duration;
+	renderPassStageDuration += duration;
+}
+
+void StatisticsCollector::samplesRendered(Part * const parts[], Bit32u count) {
+	Bit32u totalActivePartialCount = 0;
+	for (int partNumber = 0; partNumber < 9; partNumber++) {
+		Bit32u activePartialCount = parts[partNumber]->getActivePartialCount();
+		if (current.peakActivePartialCounts[partNumber] < activePartialCount) {
+			current.peakActivePartialCounts[partNumber] = activePartialCount;
+		}
+		activePartialSampleSums[partNumber] += double(activePartialCount) * count;
+		totalActivePartialCount += activePartialCount;
+	}
+	if (current.peakActivePartialCount < totalActivePartialCount) current.peakActivePartialCount = totalActivePartialCount;
+	current.renderedSampleCount += count;
+	totalSampleCount += count;
+}
+
+bool StatisticsCollector::read(Statistics &statistics) const {
+	for (unsigned int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+		Bit32u startSequence = sequence;
+		memoryBarrier();
+		const Slot &slot = slots[(startSequence >> 1) & 1];
+		statistics.renderedSampleCount = slot.counters.renderedSampleCount;
+		memcpy(statistics.peakActivePartialCounts, slot.counters.peakActivePartialCounts, sizeof statistics.peakActivePartialCounts);
+		memcpy(statistics.averageActivePartialCounts, slot.averageActivePartialCounts, sizeof statistics.averageActivePartialCounts);
+		statistics.peakActivePartialCount = slot.counters.peakActivePartialCount;
+		statistics.silencedPolyCount = slot.silencedPolyCount;
+		statistics.ignoredNoteOnCount = slot.ignoredNoteOnCount;
+		statistics.midiQueueHighWaterMark = slot.counters.midiQueueHighWaterMark;
+		statistics.renderPassCount = slot.counters.renderPassCount;
+		statistics.totalRenderPassDuration = slot.counters.totalRenderPassDuration;
+		statistics.maxRenderPassDuration = slot.counters.maxRenderPassDuration;
+		statistics.totalMidiProcessingDuration = slot.counters.totalStageDurations[RenderingStage_MIDI_PROCESSING];
+		statistics.totalPartialRenderingDuration = slot.counters.totalPartialRenderingDuration;
+		statistics.totalReverbDuration = slot.counters.totalStageDurations[RenderingStage_REVERB];
+		statistics.totalAnalogDuration = slot.counters.totalStageDurations[RenderingStage_ANALOG];
+		memoryBarrier();
+		if (Bit32u(sequence - (startSequence & ~1U)) <= 2) return true;
+	}
+	return false;
+}
+
+} // namespace MT32Emu
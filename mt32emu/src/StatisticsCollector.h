@@ -0,0 +1,112 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_STATISTICS_COLLECTOR_H
+#define MT32EMU_STATISTICS_COLLECTOR_H
+
+#include "globals.h"
+#include "Types.h"
+#include "MemoryBarrier.h"
+
+namespace MT32Emu {
+
+class Part;
+struct Statistics;
+
+/**
+ * Accumulates the usage statistics of the synth in the rendering thread and publishes them at the end of each rendering pass.
+ * THREAD SAFETY:
+ * The counters are only updated by the thread that renders the output and processes the MIDI events, normally that is
+ * the rendering thread. The published statistics may be read by any number of threads without locking, the consistency
+ * is ensured by a sequence counter in the same manner as in StateSnapshotBuffer. A reset may be requested from any thread,
+ * it is applied by the rendering thread at the beginning of the next pass.
+ * Silenced polys and ignored notes are counted when a MIDI event is played immediately, which may happen in a thread other
+ * than the rendering thread, so these two counters are incremented atomically and never written by the rendering thread.
+ * A reset only records their values at that point, to be subtracted when the statistics are published.
+ */
+class StatisticsCollector {
+public:
+	// Stages of a rendering pass timed separately. The time not attributed to any of these is accounted for producing
+	// the output of partials.
+	enum RenderingStage {
+		RenderingStage_MIDI_PROCESSING,
+		RenderingStage_REVERB,
+		RenderingStage_ANALOG,
+		RenderingStage_COUNT
+	};
+
+	// Returns the current value of a monotonic clock in seconds. Only the differences between the values are meaningful.
+	static double getTime();
+
+	StatisticsCollector();
+
+	void beginRenderPass(Bit32u pendingMidiEventCount);
+	void endRenderPass();
+	void samplesRendered(Part * const parts[], Bit32u count);
+	// May be called from any thread, see above.
+	void polySilenced() { atomicIncrement(silencedPolyCount); }
+	void noteOnIgnored() { atomicIncrement(ignoredNoteOnCount); }
+	// Adds the time elapsed since stageStartTime obtained from getTime() to the total duration of the stage.
+	void endStage(RenderingStage stage, double stageStartTime);
+
+	void requestReset() { resetRequested = true; }
+	bool read(Statistics &statistics) const;
+
+private:
+	struct Counters {
+		Bit32u renderedSampleCount;
+		Bit32u peakActivePartialCounts[9];
+		Bit32u peakActivePartialCount;
+		Bit32u midiQueueHighWaterMark;
+		Bit32u renderPassCount;
+		double totalRenderPassDuration;
+		double maxRenderPassDuration;
+		double totalStageDurations[RenderingStage_COUNT];
+		double totalPartialRenderingDuration;
+	};
+
+	struct Slot {
+		Counters counters;
+		Bit32u silencedPolyCount;
+		Bit32u ignoredNoteOnCount;
+		float averageActivePartialCounts[9];
+	};
+
+	Counters current;
+	// Sums of the active partial counts of each part over all the rendered samples, and the number of those samples.
+	// Unlike the counters, these don't wrap around.
+	double activePartialSampleSums[9];
+	double totalSampleCount;
+	double renderPassStartTime;
+	// Sum of the stage durations within the current rendering pass.
+	double renderPassStageDuration;
+	// Running totals since the collector was created, and their values at the last reset.
+	volatile Bit32u silencedPolyCount;
+	volatile Bit32u ignoredNoteOnCount;
+	Bit32u silencedPolyCountAtReset;
+	Bit32u ignoredNoteOnCountAtReset;
+
+	volatile bool resetRequested;
+	volatile Bit32u sequence;
+	Slot slots[2];
+
+	void reset();
+};
+
+} // namespace MT32Emu
+
+#endif // #ifndef MT32EMU_STATISTICS_COLLECTOR_H
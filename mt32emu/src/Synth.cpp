@@ -16,6 +16,7 @@
  */
 
 #include <cstdio>
+#include <new>
 
 #include "internals.h"
 
@@ -24,6 +25,7 @@
 #include "BReverbModel.h"
 #include "Display.h"
 #include "File.h"
+#include "MemoryArena.h"
 #include "MemoryRegion.h"
 #include "MidiEventQueue.h"
 #include "Part.h"
@@ -31,6 +33,9 @@
 #include "PartialManager.h"
 #include "Poly.h"
 #include "ROMInfo.h"
+#include "StateStream.h"
+#include "StateSnapshotBuffer.h"
+#include "StatisticsCollector.h"
 #include "SysexBuilder.h"
 #include "TVA.h"
 
@@ -45,6 +50,13 @@ static const double MIDI_DATA_TRANSFER_RATE = double(SAMPLE_RATE) / 31250.0 * 8.
 
 static const Bit8u DEFAULT_MASTER_VOLUME = 100; // Confirmed
 
+// Length of the fade-out of the previous reverb model output when the reverb mode changes, in samples.
+static const Bit32u REVERB_FADE_LENGTH = 512;
+
+// Number of frames rendered between checks of the synth activity in Synth::renderWhileActive().
+// Detecting the reverb activity involves scanning the delay lines, so it isn't worth doing too often.
+static const Bit32u ACTIVITY_CHECK_PERIOD = 1024;
+
 static const ControlROMFeatureSet OLD_MT32_ELDER = {
 	true,  // quirkBasePitchOverflow
 	true,  // quirkPitchEnvelopeOverflow
@@ -152,10 +164,69 @@ static inline void convertSampleFormat(const I *inBuffer, O *outBuffer, const Bi
 	}
 }
 
+template <class Sample>
+static inline OutputChannels<Sample> interleavedChannels(Sample *stereoStream) {
+	OutputChannels<Sample> channels = { stereoStream, stereoStream == NULL ? NULL : stereoStream + 1, 2 };
+	return channels;
+}
+
+template <class Sample>
+static inline OutputChannels<Sample> planarChannels(Sample *leftStream, Sample *rightStream) {
+	OutputChannels<Sample> channels = { leftStream, rightStream, 1 };
+	return channels;
+}
+
+template <class Sample>
+static inline void advanceChannels(OutputChannels<Sample> &channels, Bit32u len) {
+	if (channels.left == NULL) return;
+	channels.left += len * channels.stride;
+	channels.right += len * channels.stride;
+}
+
+template <class Sample>
+static inline void muteChannels(const OutputChannels<Sample> &channels, Bit32u len) {
+	if (channels.left == NULL) return;
+	if (channels.stride == 1) {
+		Synth::muteSampleBuffer(channels.left, len);
+		Synth::muteSampleBuffer(channels.right, len);
+	} else {
+		Sample *left = channels.left;
+		Sample *right = channels.right;
+		while (len--) {
+			*left = 0;
+			*right = 0;
+			left += channels.stride;
+			right += channels.stride;
+		}
+	}
+}
+
+template <class I, class O>
+static inline void convertChannelsFormat(const OutputChannels<I> &inChannels, const OutputChannels<O> &outChannels, Bit32u len) {
+	if (inChannels.left == NULL || outChannels.left == NULL) return;
+
+	const I *inLeft = inChannels.left;
+	const I *inRight = inChannels.right;
+	O *outLeft = outChannels.left;
+	O *outRight = outChannels.right;
+	while (len--) {
+		*outLeft = Synth::convertSample(*inLeft);
+		*outRight = Synth::convertSample(*inRight);
+		inLeft += inChannels.stride;
+		inRight += inChannels.stride;
+		outLeft += outChannels.stride;
+		outRight += outChannels.stride;
+	}
+}
+
 class Renderer {
 protected:
 	Synth &synth;
 
+	// When set, rendering stops right after the sample where the last active partial has ended, i.e. the first one it didn't produce.
+	bool stopOnPartialsInactive;
+	bool stoppedOnPartialsInactive;
+
 	void printDebug(const char *msg) const {
 		synth.printDebug("%s", msg);
 	}
@@ -184,25 +255,42 @@ protected:
 		return *synth.reverbModel;
 	}
 
+	inline BReverbModel *getFadingReverbModel();
+	inline Bit32u &getReverbFadeSamplesLeft();
+	inline void finishReverbFade();
+
 	Bit32u getRenderedSampleCount() {
 		return synth.renderedSampleCount;
 	}
 
-	void incRenderedSampleCount(const Bit32u count) {
-		synth.renderedSampleCount += count;
-	}
+	inline void incRenderedSampleCount(const Bit32u count);
+
+	// Return the start time of a rendering stage and account for its duration in the usage statistics, when collected.
+	inline double beginStage() const;
+	inline void endStage(StatisticsCollector::RenderingStage stage, double stageStartTime) const;
 
 	void updateDisplayState();
+	Bit32u playDueMidiEvent(Bit32u len);
 
 public:
-	Renderer(Synth &useSynth) : synth(useSynth) {}
+	Renderer(Synth &useSynth) : synth(useSynth), stopOnPartialsInactive(false), stoppedOnPartialsInactive(false) {}
 
 	virtual ~Renderer() {}
 
-	virtual void render(IntSample *stereoStream, Bit32u len) = 0;
-	virtual void render(FloatSample *stereoStream, Bit32u len) = 0;
-	virtual void renderStreams(const DACOutputStreams<IntSample> &streams, Bit32u len) = 0;
-	virtual void renderStreams(const DACOutputStreams<FloatSample> &streams, Bit32u len) = 0;
+	void setStopOnPartialsInactive(bool enabled) {
+		stopOnPartialsInactive = enabled;
+		stoppedOnPartialsInactive = false;
+	}
+
+	// These return the number of frames actually rendered, which may only be less than len when rendering
+	// has stopped because all the partials became inactive.
+	virtual Bit32u render(const OutputChannels<IntSample> &channels, Bit32u len) = 0;
+	virtual Bit32u render(const OutputChannels<FloatSample> &channels, Bit32u len) = 0;
+	virtual Bit32u renderStreams(const DACOutputStreams<IntSample> &streams, Bit32u len) = 0;
+	virtual Bit32u renderStreams(const DACOutputStreams<FloatSample> &streams, Bit32u len) = 0;
+
+	// Processes the MIDI events and advances the partials as rendering would, but produces no output at all.
+	void fastForward(Bit32u len);
 };
 
 template <class Sample>
@@ -212,6 +300,8 @@ class RendererImpl : public Renderer {
 	Sample tmpNonReverbLeft[MAX_SAMPLES_PER_RUN], tmpNonReverbRight[MAX_SAMPLES_PER_RUN];
 	Sample tmpReverbDryLeft[MAX_SAMPLES_PER_RUN], tmpReverbDryRight[MAX_SAMPLES_PER_RUN];
 	Sample tmpReverbWetLeft[MAX_SAMPLES_PER_RUN], tmpReverbWetRight[MAX_SAMPLES_PER_RUN];
+	// Receive the output of the previous reverb model while it is being faded out.
+	Sample tmpFadingReverbWetLeft[MAX_SAMPLES_PER_RUN], tmpFadingReverbWetRight[MAX_SAMPLES_PER_RUN];
 
 	const DACOutputStreams<Sample> tmpBuffers;
 	DACOutputStreams<Sample> createTmpBuffers() {
@@ -229,21 +319,22 @@ public:
 		tmpBuffers(createTmpBuffers())
 	{}
 
-	void render(IntSample *stereoStream, Bit32u len);
-	void render(FloatSample *stereoStream, Bit32u len);
-	void renderStreams(const DACOutputStreams<IntSample> &streams, Bit32u len);
-	void renderStreams(const DACOutputStreams<FloatSample> &streams, Bit32u len);
+	Bit32u render(const OutputChannels<IntSample> &channels, Bit32u len);
+	Bit32u render(const OutputChannels<FloatSample> &channels, Bit32u len);
+	Bit32u renderStreams(const DACOutputStreams<IntSample> &streams, Bit32u len);
+	Bit32u renderStreams(const DACOutputStreams<FloatSample> &streams, Bit32u len);
 
 	template <class O>
-	void doRenderAndConvert(O *stereoStream, Bit32u len);
-	void doRender(Sample *stereoStream, Bit32u len);
+	Bit32u doRenderAndConvert(const OutputChannels<O> &channels, Bit32u len);
+	Bit32u doRender(const OutputChannels<Sample> &channels, Bit32u len);
 
 	template <class O>
-	void doRenderAndConvertStreams(const DACOutputStreams<O> &streams, Bit32u len);
-	void doRenderStreams(const DACOutputStreams<Sample> &streams, Bit32u len);
+	Bit32u doRenderAndConvertStreams(const DACOutputStreams<O> &streams, Bit32u len);
+	Bit32u doRenderStreams(const DACOutputStreams<Sample> &streams, Bit32u len);
 	void produceLA32Output(Sample *buffer, Bit32u len);
 	void convertSamplesToOutput(Sample *buffer, Bit32u len);
-	void produceStreams(const DACOutputStreams<Sample> &streams, Bit32u len);
+	void mixFadingReverbOutput(const Sample *reverbDryLeft, const Sample *reverbDryRight, Sample *reverbWetLeft, Sample *reverbWetRight, Bit32u len);
+	Bit32u produceStreams(const DACOutputStreams<Sample> &streams, Bit32u len);
 };
 
 class Extensions {
@@ -262,19 +353,70 @@ public:
 	// This stores the index of Part in chantable that failed to play and required partial abortion.
 	Bit32u abortingPartIx;
 
-	bool preallocatedReverbMemory;
+	// Delay lines of all reverb models are placed into this memory pool, which is split into two equal slots.
+	// Each slot is large enough to accommodate the delay lines of any reverb mode. When the reverb mode changes,
+	// the new model occupies the vacant slot while the output of the previous one is being faded out.
+	Bit8u *reverbMemoryPool;
+	size_t reverbMemorySlotSize;
+	Bit32u currentReverbMemorySlot;
+	BReverbModel *fadingReverbModel;
+	Bit32u reverbFadeSamplesLeft;
 
 	Bit32u midiEventQueueSize;
 	Bit32u midiEventQueueSysexStorageBufferSize;
+	// Set unless the queue has been reallocated on the heap after opening the synth.
+	bool midiQueueInArena;
+
+	// Holds the working set of the synth involved in rendering. The objects placed there are destroyed explicitly.
+	MemoryArena *memoryArena;
+	// Region of the arena dedicated to the partial manager, so that it can be recreated in place.
+	void *partialManagerMemory;
+	size_t partialManagerMemorySize;
+	bool largePagesEnabled;
+	bool memoryLockingEnabled;
 
 	Display *display;
 	bool oldMT32DisplayFeatures;
 
+	bool stateSnapshotsEnabled;
+	StateSnapshotBuffer *stateSnapshotBuffer;
+
+	StatisticsCollector *statisticsCollector;
+
 	ReportHandler3 defaultReportHandler;
 	ReportHandler2 *reportHandler2;
 	ReportHandler3 *reportHandler3;
 };
 
+BReverbModel *Renderer::getFadingReverbModel() {
+	return synth.extensions.fadingReverbModel;
+}
+
+Bit32u &Renderer::getReverbFadeSamplesLeft() {
+	return synth.extensions.reverbFadeSamplesLeft;
+}
+
+void Renderer::incRenderedSampleCount(const Bit32u count) {
+	synth.renderedSampleCount += count;
+	StatisticsCollector *statisticsCollector = synth.extensions.statisticsCollector;
+	if (statisticsCollector != NULL) statisticsCollector->samplesRendered(synth.parts, count);
+}
+
+double Renderer::beginStage() const {
+	return synth.extensions.statisticsCollector != NULL ? StatisticsCollector::getTime() : 0;
+}
+
+void Renderer::endStage(StatisticsCollector::RenderingStage stage, double stageStartTime) const {
+	StatisticsCollector *statisticsCollector = synth.extensions.statisticsCollector;
+	if (statisticsCollector != NULL) statisticsCollector->endStage(stage, stageStartTime);
+}
+
+void Renderer::finishReverbFade() {
+	// Closing the model merely releases its memory slot.
+	synth.extensions.fadingReverbModel->close();
+	synth.extensions.fadingReverbModel = NULL;
+}
+
 Bit32u Synth::getLibraryVersionInt() {
 	return MT32EMU_CURRENT_VERSION_INT;
 }
@@ -312,7 +454,8 @@ Synth::Synth(ReportHandler *useReportHandler) :
 	extensions.reportHandler2 = &extensions.defaultReportHandler;
 	extensions.reportHandler3 = &extensions.defaultReportHandler;
 
-	extensions.preallocatedReverbMemory = false;
+	extensions.reverbMemoryPool = NULL;
+	extensions.fadingReverbModel = NULL;
 	for (int i = REVERB_MODE_ROOM; i <= REVERB_MODE_TAP_DELAY; i++) {
 		reverbModels[i] = NULL;
 	}
@@ -347,11 +490,20 @@ Synth::Synth(ReportHandler *useReportHandler) :
 	midiQueue = NULL;
 	extensions.midiEventQueueSize = DEFAULT_MIDI_EVENT_QUEUE_SIZE;
 	extensions.midiEventQueueSysexStorageBufferSize = 0;
+	extensions.midiQueueInArena = false;
+	extensions.memoryArena = NULL;
+	extensions.partialManagerMemory = NULL;
+	extensions.partialManagerMemorySize = 0;
+	extensions.largePagesEnabled = false;
+	extensions.memoryLockingEnabled = false;
 	lastReceivedMIDIEventTimestamp = 0;
 	memset(parts, 0, sizeof(parts));
 	renderedSampleCount = 0;
 	extensions.display = NULL;
 	extensions.oldMT32DisplayFeatures = false;
+	extensions.stateSnapshotsEnabled = false;
+	extensions.stateSnapshotBuffer = NULL;
+	extensions.statisticsCollector = NULL;
 }
 
 Synth::~Synth() {
@@ -461,10 +613,7 @@ void Synth::setReverbEnabled(bool newReverbEnabled) {
 		refreshSystemReverbParameters();
 		reverbOverridden = oldReverbOverridden;
 	} else {
-		if (!extensions.preallocatedReverbMemory) {
-			reverbModel->close();
-		}
-		reverbModel = NULL;
+		closeReverbModels();
 	}
 }
 
@@ -484,9 +633,7 @@ void Synth::setReverbCompatibilityMode(bool mt32CompatibleMode) {
 	if (!opened || (isMT32ReverbCompatibilityMode() == mt32CompatibleMode)) return;
 	bool oldReverbEnabled = isReverbEnabled();
 	setReverbEnabled(false);
-	for (int i = REVERB_MODE_ROOM; i <= REVERB_MODE_TAP_DELAY; i++) {
-		delete reverbModels[i];
-	}
+	deleteReverbModels();
 	initReverbModels(mt32CompatibleMode);
 	setReverbEnabled(oldReverbEnabled);
 	setReverbOutputGain(reverbOutputGain);
@@ -500,17 +647,8 @@ bool Synth::isDefaultReverbMT32Compatible() const {
 	return opened && controlROMFeatures->defaultReverbMT32Compatible;
 }
 
-void Synth::preallocateReverbMemory(bool enabled) {
-	if (extensions.preallocatedReverbMemory == enabled) return;
-	extensions.preallocatedReverbMemory = enabled;
-	if (!opened) return;
-	for (int i = REVERB_MODE_ROOM; i <= REVERB_MODE_TAP_DELAY; i++) {
-		if (enabled) {
-			reverbModels[i]->open();
-		} else if (reverbModel != reverbModels[i]) {
-			reverbModels[i]->close();
-		}
-	}
+void Synth::preallocateReverbMemory(bool) {
+	// Reverb models always use the memory pool allocated in open(), so there is nothing to do.
 }
 
 void Synth::setDACInputMode(DACInputMode mode) {
@@ -742,15 +880,90 @@ bool Synth::initTimbres(Bit16u mapAddress, Bit16u offset, Bit16u count, Bit16u s
 }
 
 void Synth::initReverbModels(bool mt32CompatibleMode) {
+	size_t slotSize = 0;
 	for (int mode = REVERB_MODE_ROOM; mode <= REVERB_MODE_TAP_DELAY; mode++) {
 		reverbModels[mode] = BReverbModel::createBReverbModel(ReverbMode(mode), mt32CompatibleMode, getSelectedRendererType());
+		size_t modelMemorySize = reverbModels[mode]->getDelayLineMemorySize();
+		if (slotSize < modelMemorySize) slotSize = modelMemorySize;
+	}
+	// Keep the slots aligned suitably for samples of any type.
+	slotSize = (slotSize + sizeof(FloatSample) - 1) & ~(sizeof(FloatSample) - 1);
+	// The memory pool itself is allocated in the arena.
+	extensions.reverbMemorySlotSize = slotSize;
+	extensions.currentReverbMemorySlot = 0;
+	extensions.fadingReverbModel = NULL;
+}
 
-		if (extensions.preallocatedReverbMemory) {
-			reverbModels[mode]->open();
-		}
+void Synth::deleteReverbModels() {
+	for (int i = REVERB_MODE_ROOM; i <= REVERB_MODE_TAP_DELAY; i++) {
+		delete reverbModels[i];
+		reverbModels[i] = NULL;
+	}
+	extensions.reverbMemoryPool = NULL;
+	extensions.fadingReverbModel = NULL;
+}
+
+void Synth::closeReverbModels() {
+	if (extensions.fadingReverbModel != NULL) {
+		extensions.fadingReverbModel->close();
+		extensions.fadingReverbModel = NULL;
+	}
+	if (reverbModel != NULL) {
+		reverbModel->close();
+		reverbModel = NULL;
+	}
+}
+
+static size_t getRendererArenaSize(RendererType rendererType) {
+	switch (rendererType) {
+	case RendererType_BIT16S:
+		return MemoryArena::getChunkSize(sizeof(RendererImpl<IntSample>));
+	case RendererType_FLOAT:
+		return MemoryArena::getChunkSize(sizeof(RendererImpl<FloatSample>));
+	default:
+		return 0;
 	}
 }
 
+static Part *newPart(Synth *synth, unsigned int partNum, void *memory) {
+	if (partNum < 8) return new(memory) Part(synth, partNum);
+	return new(memory) RhythmPart(synth, partNum);
+}
+
+// Destroys the MIDI event queue wherever it was allocated.
+static void deleteMidiQueue(MidiEventQueue *midiQueue, bool inArena) {
+	if (inArena) {
+		midiQueue->~MidiEventQueue();
+	} else {
+		delete midiQueue;
+	}
+}
+
+// Sizes the arena to accommodate the entire working set exactly, the reverb models must be created beforehand.
+void Synth::initMemoryArena(AnalogOutputMode analogOutputMode) {
+	const RendererType rendererType = getSelectedRendererType();
+	extensions.partialManagerMemorySize = MemoryArena::getChunkSize(sizeof(PartialManager)) + PartialManager::getArenaSize(partialCount, rendererType);
+	const size_t arenaSize = MemoryArena::getChunkSize(2 * extensions.reverbMemorySlotSize)
+		+ 8 * MemoryArena::getChunkSize(sizeof(Part)) + MemoryArena::getChunkSize(sizeof(RhythmPart))
+		+ extensions.partialManagerMemorySize
+		+ MemoryArena::getChunkSize(sizeof(MidiEventQueue))
+		+ MidiEventQueue::getArenaSize(extensions.midiEventQueueSize, extensions.midiEventQueueSysexStorageBufferSize)
+		+ Analog::getArenaSize(analogOutputMode, rendererType)
+		+ getRendererArenaSize(rendererType);
+	MemoryArena *arena = new MemoryArena(arenaSize, extensions.largePagesEnabled, extensions.memoryLockingEnabled);
+	if (extensions.largePagesEnabled && !arena->isBackedByLargePages()) printDebug("Large pages unavailable, using regular pages for synth memory");
+	if (extensions.memoryLockingEnabled && !arena->isLocked()) printDebug("Failed to lock synth memory");
+	extensions.memoryArena = arena;
+	extensions.reverbMemoryPool = arena->allocateArray<Bit8u>(2 * extensions.reverbMemorySlotSize);
+	extensions.partialManagerMemory = arena->allocate(extensions.partialManagerMemorySize);
+}
+
+// Creates the partial manager anew in the dedicated region of the arena.
+void Synth::createPartialManager() {
+	MemoryArena partialManagerArena(extensions.partialManagerMemory, extensions.partialManagerMemorySize);
+	partialManager = new(partialManagerArena.allocate(sizeof(PartialManager))) PartialManager(this, partialManagerArena);
+}
+
 void Synth::initSoundGroups(char newSoundGroupNames[][9]) {
 	memcpy(soundGroupIx, &controlROMData[controlROMMap->soundGroupsTable - sizeof(soundGroupIx)], sizeof(soundGroupIx));
 	const SoundGroup *table = reinterpret_cast<SoundGroup *>(&controlROMData[controlROMMap->soundGroupsTable]);
@@ -810,6 +1023,7 @@ bool Synth::open(const ROMImage &controlROMImage, const ROMImage &pcmROMImage, B
 	printDebug("Using %s Compatible Reverb Models", mt32CompatibleReverb ? "MT-32" : "CM-32L");
 #endif
 	initReverbModels(mt32CompatibleReverb);
+	initMemoryArena(analogOutputMode);
 
 #if MT32EMU_MONITOR_INIT
 	printDebug("Initialising Timbre Bank A");
@@ -851,7 +1065,7 @@ bool Synth::open(const ROMImage &controlROMImage, const ROMImage &pcmROMImage, B
 	// CM-64 seems to initialise all bytes in this bank to 0.
 	memset(&mt32ram.timbres[128], 0, sizeof(mt32ram.timbres[128]) * 64);
 
-	partialManager = new PartialManager(this);
+	createPartialManager();
 
 	pcmWaves = new PCMWaveEntry[controlROMMap->pcmCount];
 
@@ -926,20 +1140,18 @@ bool Synth::open(const ROMImage &controlROMImage, const ROMImage &pcmROMImage, B
 		memset(patchTemp->dummyv, 0, sizeof(patchTemp->dummyv));
 		patchTemp->dummyv[1] = 127;
 
-		if (i < 8) {
-			parts[i] = new Part(this, i);
-			parts[i]->setProgram(controlROMData[controlROMMap->programSettings + i]);
-		} else {
-			parts[i] = new RhythmPart(this, i);
-		}
+		parts[i] = newPart(this, i, extensions.memoryArena->allocate(i < 8 ? sizeof(Part) : sizeof(RhythmPart)));
+		if (i < 8) parts[i]->setProgram(controlROMData[controlROMMap->programSettings + i]);
 	}
 
 	// For resetting mt32 mid-execution
 	mt32default = mt32ram;
 
-	midiQueue = new MidiEventQueue(extensions.midiEventQueueSize, extensions.midiEventQueueSysexStorageBufferSize);
+	void *midiQueueMemory = extensions.memoryArena->allocate(sizeof(MidiEventQueue));
+	midiQueue = new(midiQueueMemory) MidiEventQueue(extensions.midiEventQueueSize, extensions.midiEventQueueSysexStorageBufferSize, extensions.memoryArena);
+	extensions.midiQueueInArena = true;
 
-	analog = Analog::createAnalog(analogOutputMode, controlROMFeatures->oldMT32AnalogLPF, getSelectedRendererType());
+	analog = Analog::createAnalog(analogOutputMode, controlROMFeatures->oldMT32AnalogLPF, getSelectedRendererType(), *extensions.memoryArena);
 #if MT32EMU_MONITOR_INIT
 	static const char *ANALOG_OUTPUT_MODES[] = { "Digital only", "Coarse", "Accurate", "Oversampled2x" };
 	printDebug("Using Analog output mode %s", ANALOG_OUTPUT_MODES[analogOutputMode]);
@@ -954,13 +1166,13 @@ bool Synth::open(const ROMImage &controlROMImage, const ROMImage &pcmROMImage, B
 
 	switch (getSelectedRendererType()) {
 		case RendererType_BIT16S:
-			renderer = new RendererImpl<IntSample>(*this);
+			renderer = new(extensions.memoryArena->allocate(sizeof(RendererImpl<IntSample>))) RendererImpl<IntSample>(*this);
 #if MT32EMU_MONITOR_INIT
 			printDebug("Using integer 16-bit samples in renderer and wave generator");
 #endif
 			break;
 		case RendererType_FLOAT:
-			renderer = new RendererImpl<FloatSample>(*this);
+			renderer = new(extensions.memoryArena->allocate(sizeof(RendererImpl<FloatSample>))) RendererImpl<FloatSample>(*this);
 #if MT32EMU_MONITOR_INIT
 			printDebug("Using float 32-bit samples in renderer and wave generator");
 #endif
@@ -974,6 +1186,11 @@ bool Synth::open(const ROMImage &controlROMImage, const ROMImage &pcmROMImage, B
 	extensions.display = new Display(*this);
 	extensions.oldMT32DisplayFeatures = controlROMFeatures->oldMT32DisplayFeatures;
 
+	if (extensions.stateSnapshotsEnabled) {
+		extensions.stateSnapshotBuffer = new StateSnapshotBuffer(partialCount);
+	}
+	extensions.statisticsCollector = new StatisticsCollector;
+
 	opened = true;
 	activated = false;
 
@@ -986,23 +1203,30 @@ bool Synth::open(const ROMImage &controlROMImage, const ROMImage &pcmROMImage, B
 void Synth::dispose() {
 	opened = false;
 
+	delete extensions.stateSnapshotBuffer;
+	extensions.stateSnapshotBuffer = NULL;
+
+	delete extensions.statisticsCollector;
+	extensions.statisticsCollector = NULL;
+
 	delete extensions.display;
 	extensions.display = NULL;
 
-	delete midiQueue;
+	// The objects below reside in the arena, so only the destructors need to be invoked.
+	if (midiQueue != NULL) deleteMidiQueue(midiQueue, extensions.midiQueueInArena);
 	midiQueue = NULL;
 
-	delete renderer;
+	if (renderer != NULL) renderer->~Renderer();
 	renderer = NULL;
 
-	delete analog;
+	if (analog != NULL) analog->~Analog();
 	analog = NULL;
 
-	delete partialManager;
+	if (partialManager != NULL) partialManager->~PartialManager();
 	partialManager = NULL;
 
 	for (int i = 0; i < 9; i++) {
-		delete parts[i];
+		if (parts[i] != NULL) parts[i]->~Part();
 		parts[i] = NULL;
 	}
 
@@ -1017,11 +1241,13 @@ void Synth::dispose() {
 
 	deleteMemoryRegions();
 
-	for (int i = REVERB_MODE_ROOM; i <= REVERB_MODE_TAP_DELAY; i++) {
-		delete reverbModels[i];
-		reverbModels[i] = NULL;
-	}
+	deleteReverbModels();
 	reverbModel = NULL;
+
+	delete extensions.memoryArena;
+	extensions.memoryArena = NULL;
+	extensions.partialManagerMemory = NULL;
+
 	controlROMFeatures = NULL;
 	controlROMMap = NULL;
 }
@@ -1067,7 +1293,9 @@ Bit32u Synth::setMIDIEventQueueSize(Bit32u useSize) {
 	extensions.midiEventQueueSize = binarySize;
 	if (midiQueue != NULL) {
 		flushMIDIQueue();
-		delete midiQueue;
+		// The arena has no room for a different queue, so it goes to the heap till the synth is reopened.
+		deleteMidiQueue(midiQueue, extensions.midiQueueInArena);
+		extensions.midiQueueInArena = false;
 		midiQueue = new MidiEventQueue(binarySize, extensions.midiEventQueueSysexStorageBufferSize);
 	}
 	return binarySize;
@@ -1079,7 +1307,8 @@ void Synth::configureMIDIEventQueueSysexStorage(Bit32u storageBufferSize) {
 	extensions.midiEventQueueSysexStorageBufferSize = storageBufferSize;
 	if (midiQueue != NULL) {
 		flushMIDIQueue();
-		delete midiQueue;
+		deleteMidiQueue(midiQueue, extensions.midiQueueInArena);
+		extensions.midiQueueInArena = false;
 		midiQueue = new MidiEventQueue(extensions.midiEventQueueSize, storageBufferSize);
 	}
 }
@@ -1152,6 +1381,22 @@ bool Synth::playSysex(const Bit8u *sysex, Bit32u len, Bit32u timestamp) {
 	return false;
 }
 
+bool Synth::playReferencedSysex(const Bit8u *sysex, Bit32u len, Bit32u timestamp) {
+	if (midiQueue == NULL) return false;
+	if (midiDelayMode == MIDIDelayMode_DELAY_ALL) {
+		timestamp = addMIDIInterfaceDelay(len, timestamp);
+	}
+	if (!activated) activated = true;
+	do {
+		if (midiQueue->pushReferencedSysex(sysex, len, timestamp)) return true;
+	} while (reportHandler->onMIDIQueueOverflow());
+	return false;
+}
+
+Bit32u Synth::getPendingReferencedSysexCount() const {
+	return midiQueue == NULL ? 0 : midiQueue->getReferencedSysexCount();
+}
+
 void Synth::playMsgNow(Bit32u msg) {
 	if (!opened) return;
 
@@ -1498,6 +1743,147 @@ Bit32u Synth::applySysexBank(const Bit8u *sysexBank, Bit32u size) {
 	return sysexesPlayed;
 }
 
+static const Bit32u STATE_MAGIC = 0x3233544D; // "MT32" in little-endian byte order
+static const Bit32u STATE_VERSION = 1;
+
+Bit32u Synth::saveState(Bit8u *stateBuffer, Bit32u size) const {
+	if (!opened) return 0;
+
+	StateWriter writer(*this, stateBuffer, size);
+
+	// Header, contains the parameters the restoring synth must match.
+	writer.write(STATE_MAGIC);
+	writer.write(STATE_VERSION);
+	writer.write(partialCount);
+	writer.write(Bit32u(getSelectedRendererType()));
+	writer.write(Bit32u(analog->getOutputSampleRate()));
+	writer.write(isMT32ReverbCompatibilityMode());
+	Bit32u romNameLength = Bit32u(strlen(controlROMMap->shortName));
+	writer.write(romNameLength);
+	writer.writeBytes(controlROMMap->shortName, romNameLength);
+	writer.write(Bit32u(pcmROMSize));
+
+	writer.write(mt32ram);
+	writer.write(Bit32u(renderedSampleCount));
+	writer.write(Bit32u(lastReceivedMIDIEventTimestamp));
+	writer.write(activated);
+	writer.writePoly(abortingPoly);
+	writer.write(extensions.masterTunePitchDelta);
+	writer.write(extensions.chantable);
+	writer.write(extensions.abortingPartIx);
+
+	for (int i = 0; i < 9; i++) {
+		parts[i]->saveState(writer);
+	}
+	partialManager->saveState(writer);
+
+	Bit32u reverbModelIndex = 0xFFFFFFFF;
+	Bit32u fadingReverbModelIndex = 0xFFFFFFFF;
+	for (Bit32u i = REVERB_MODE_ROOM; i <= REVERB_MODE_TAP_DELAY; i++) {
+		if (reverbModels[i] == reverbModel) reverbModelIndex = i;
+		if (reverbModels[i] == extensions.fadingReverbModel) fadingReverbModelIndex = i;
+	}
+	writer.write(reverbModelIndex);
+	writer.write(fadingReverbModelIndex);
+	writer.write(extensions.currentReverbMemorySlot);
+	writer.write(extensions.reverbFadeSamplesLeft);
+	if (reverbModel != NULL) reverbModel->saveState(writer);
+	if (extensions.fadingReverbModel != NULL) extensions.fadingReverbModel->saveState(writer);
+
+	analog->saveState(writer);
+	extensions.display->saveState(writer);
+	midiQueue->saveState(writer);
+
+	return writer.getSize();
+}
+
+bool Synth::loadState(const Bit8u *stateBuffer, Bit32u size) {
+	if (!opened) return false;
+
+	StateReader reader(*this, stateBuffer, size);
+
+	reader.expect(STATE_MAGIC);
+	reader.expect(STATE_VERSION);
+	reader.expect(partialCount);
+	reader.expect(Bit32u(getSelectedRendererType()));
+	reader.expect(Bit32u(analog->getOutputSampleRate()));
+	reader.expect(isMT32ReverbCompatibilityMode());
+	Bit32u romNameLength = Bit32u(strlen(controlROMMap->shortName));
+	reader.expect(romNameLength);
+	const Bit8u *romName = reader.readByteArray(romNameLength);
+	if (romName == NULL || memcmp(romName, controlROMMap->shortName, romNameLength) != 0) return false;
+	reader.expect(Bit32u(pcmROMSize));
+	if (reader.isFailed()) return false;
+
+	reader.read(mt32ram);
+	Bit32u timestamp;
+	reader.read(timestamp);
+	renderedSampleCount = timestamp;
+	reader.read(timestamp);
+	lastReceivedMIDIEventTimestamp = timestamp;
+	reader.read(activated);
+	abortingPoly = reader.readPoly();
+	reader.read(extensions.masterTunePitchDelta);
+	reader.read(extensions.chantable);
+	reader.read(extensions.abortingPartIx);
+	if (extensions.abortingPartIx > 8) reader.fail();
+
+	for (int i = 0; i < 9; i++) {
+		parts[i]->loadState(reader);
+	}
+	partialManager->loadState(reader);
+
+	closeReverbModels();
+	Bit32u reverbModelIndex, fadingReverbModelIndex;
+	reader.read(reverbModelIndex);
+	reader.read(fadingReverbModelIndex);
+	reader.read(extensions.currentReverbMemorySlot);
+	reader.read(extensions.reverbFadeSamplesLeft);
+	extensions.currentReverbMemorySlot &= 1;
+	if (reverbModelIndex <= REVERB_MODE_TAP_DELAY) {
+		reverbModel = reverbModels[reverbModelIndex];
+		reverbModel->open(extensions.reverbMemoryPool + extensions.currentReverbMemorySlot * extensions.reverbMemorySlotSize);
+		reverbModel->loadState(reader);
+	} else if (reverbModelIndex != 0xFFFFFFFF) {
+		reader.fail();
+	}
+	if (fadingReverbModelIndex <= REVERB_MODE_TAP_DELAY && reverbModels[fadingReverbModelIndex] != reverbModel) {
+		extensions.fadingReverbModel = reverbModels[fadingReverbModelIndex];
+		Bit32u fadingSlot = extensions.currentReverbMemorySlot ^ 1;
+		extensions.fadingReverbModel->open(extensions.reverbMemoryPool + fadingSlot * extensions.reverbMemorySlotSize);
+		extensions.fadingReverbModel->loadState(reader);
+	} else if (fadingReverbModelIndex != 0xFFFFFFFF) {
+		reader.fail();
+	}
+
+	analog->loadState(reader);
+	extensions.display->loadState(reader);
+	if (!midiQueue->loadState(reader)) reader.fail();
+
+	if (!reader.isFailed() && reader.isAtEnd()) return true;
+
+	// The state is corrupted, so the objects may refer to each other inconsistently. Recreate them from scratch.
+	bool oldReverbEnabled = isReverbEnabled();
+	setReverbEnabled(false);
+	// The objects are recreated in place within the arena.
+	partialManager->~PartialManager();
+	mt32ram = mt32default;
+	for (int i = 0; i < 9; i++) {
+		Bit8u volumeOverride = parts[i]->getVolumeOverride();
+		void *partMemory = parts[i];
+		parts[i]->~Part();
+		parts[i] = newPart(this, i, partMemory);
+		parts[i]->setVolumeOverride(volumeOverride);
+	}
+	createPartialManager();
+	abortingPoly = NULL;
+	extensions.abortingPartIx = 0;
+	while (midiQueue->peekMidiEvent() != NULL) midiQueue->dropMidiEvent();
+	reset();
+	setReverbEnabled(oldReverbEnabled);
+	return false;
+}
+
 void Synth::readSysex(Bit8u /*device*/, const Bit8u * /*sysex*/, Bit32u /*len*/) const {
 	// NYI
 }
@@ -1991,17 +2377,25 @@ void Synth::refreshSystemReverbParameters() {
 		reverbModel = reverbModels[mt32ram.system.reverbMode];
 	}
 	if (reverbModel != oldReverbModel) {
-		if (extensions.preallocatedReverbMemory) {
+		// Switching reverb models never allocates memory, so this is safe to do in the rendering thread.
+		if (extensions.fadingReverbModel != NULL) {
+			// Cut short the fade-out still in progress to free its memory slot.
+			extensions.fadingReverbModel->close();
+			extensions.fadingReverbModel = NULL;
+		}
+		if (oldReverbModel != NULL) {
 			if (isReverbEnabled()) {
-				reverbModel->mute();
-			}
-		} else {
-			if (oldReverbModel != NULL) {
+				// Let the output of the previous model fade out gradually rather than cut it off abruptly.
+				// Its memory slot stays occupied until then, so the new model takes the other slot.
+				extensions.fadingReverbModel = oldReverbModel;
+				extensions.reverbFadeSamplesLeft = REVERB_FADE_LENGTH;
+				extensions.currentReverbMemorySlot ^= 1;
+			} else {
 				oldReverbModel->close();
 			}
-			if (isReverbEnabled()) {
-				reverbModel->open();
-			}
+		}
+		if (isReverbEnabled()) {
+			reverbModel->open(extensions.reverbMemoryPool + extensions.currentReverbMemorySlot * extensions.reverbMemorySlotSize);
 		}
 	}
 	if (isReverbEnabled()) {
@@ -2128,10 +2522,53 @@ bool Synth::isDefaultDisplayOldMT32Compatible() const {
 	return opened && controlROMFeatures->oldMT32DisplayFeatures;
 }
 
+void Synth::setStateSnapshotsEnabled(bool enabled) {
+	extensions.stateSnapshotsEnabled = enabled;
+}
+
+bool Synth::isStateSnapshotsEnabled() const {
+	return extensions.stateSnapshotsEnabled;
+}
+
+void Synth::setLargePagesEnabled(bool enabled) {
+	extensions.largePagesEnabled = enabled;
+}
+
+bool Synth::isLargePagesEnabled() const {
+	return extensions.largePagesEnabled;
+}
+
+void Synth::setMemoryLockingEnabled(bool enabled) {
+	extensions.memoryLockingEnabled = enabled;
+}
+
+bool Synth::isMemoryLockingEnabled() const {
+	return extensions.memoryLockingEnabled;
+}
+
+bool Synth::getStateSnapshot(StateSnapshot &snapshot) const {
+	if (!opened || extensions.stateSnapshotBuffer == NULL) return false;
+	return extensions.stateSnapshotBuffer->read(snapshot);
+}
+
+bool Synth::getStatistics(Statistics &statistics) const {
+	if (!opened || extensions.statisticsCollector == NULL) return false;
+	return extensions.statisticsCollector->read(statistics);
+}
+
+void Synth::resetStatistics() {
+	if (extensions.statisticsCollector != NULL) extensions.statisticsCollector->requestReset();
+}
+
+StatisticsCollector *Synth::getStatisticsCollector() const {
+	return extensions.statisticsCollector;
+}
+
 /** Defines an interface of a class that maintains storage of variable-sized data of SysEx messages. */
 class MidiEventQueue::SysexDataStorage {
 public:
-	static MidiEventQueue::SysexDataStorage *create(Bit32u storageBufferSize);
+	static size_t getArenaSize(Bit32u storageBufferSize);
+	static MidiEventQueue::SysexDataStorage *create(Bit32u storageBufferSize, MemoryArena *arena);
 
 	virtual ~SysexDataStorage() {}
 	virtual Bit8u *allocate(Bit32u sysexLength) = 0;
@@ -2160,15 +2597,17 @@ public:
  */
 class BufferedSysexDataStorage : public MidiEventQueue::SysexDataStorage {
 public:
-	explicit BufferedSysexDataStorage(Bit32u useStorageBufferSize) :
-		storageBuffer(new Bit8u[useStorageBufferSize]),
+	// The storage buffer is allocated on the heap unless provided.
+	BufferedSysexDataStorage(Bit32u useStorageBufferSize, Bit8u *useStorageBuffer) :
+		storageBuffer(useStorageBuffer != NULL ? useStorageBuffer : new Bit8u[useStorageBufferSize]),
+		storageBufferOwned(useStorageBuffer == NULL),
 		storageBufferSize(useStorageBufferSize),
 		startPosition(),
 		endPosition()
 	{}
 
 	~BufferedSysexDataStorage() {
-		delete[] storageBuffer;
+		if (storageBufferOwned) delete[] storageBuffer;
 	}
 
 	Bit8u *allocate(Bit32u sysexLength) {
@@ -2212,34 +2651,63 @@ public:
 
 private:
 	Bit8u * const storageBuffer;
+	const bool storageBufferOwned;
 	const Bit32u storageBufferSize;
 
 	volatile Bit32u startPosition;
 	volatile Bit32u endPosition;
 };
 
-MidiEventQueue::SysexDataStorage *MidiEventQueue::SysexDataStorage::create(Bit32u storageBufferSize) {
+size_t MidiEventQueue::SysexDataStorage::getArenaSize(Bit32u storageBufferSize) {
 	if (storageBufferSize > 0) {
-		return new BufferedSysexDataStorage(storageBufferSize);
+		return MemoryArena::getChunkSize(sizeof(BufferedSysexDataStorage)) + MemoryArena::getChunkSize(storageBufferSize);
 	} else {
-		return new DynamicSysexDataStorage;
+		return MemoryArena::getChunkSize(sizeof(DynamicSysexDataStorage));
 	}
 }
 
-MidiEventQueue::MidiEventQueue(Bit32u useRingBufferSize, Bit32u storageBufferSize) :
-	sysexDataStorage(*SysexDataStorage::create(storageBufferSize)),
-	ringBuffer(new MidiEvent[useRingBufferSize]), ringBufferMask(useRingBufferSize - 1)
+MidiEventQueue::SysexDataStorage *MidiEventQueue::SysexDataStorage::create(Bit32u storageBufferSize, MemoryArena *arena) {
+	if (arena == NULL) {
+		if (storageBufferSize > 0) {
+			return new BufferedSysexDataStorage(storageBufferSize, NULL);
+		} else {
+			return new DynamicSysexDataStorage;
+		}
+	}
+	if (storageBufferSize > 0) {
+		void *storage = arena->allocate(sizeof(BufferedSysexDataStorage));
+		return new(storage) BufferedSysexDataStorage(storageBufferSize, arena->allocateArray<Bit8u>(storageBufferSize));
+	} else {
+		// The SysEx data itself still goes to the heap as it arrives.
+		return new(arena->allocate(sizeof(DynamicSysexDataStorage))) DynamicSysexDataStorage;
+	}
+}
+
+size_t MidiEventQueue::getArenaSize(Bit32u ringBufferSize, Bit32u storageBufferSize) {
+	return MemoryArena::getChunkSize(ringBufferSize * sizeof(MidiEvent)) + SysexDataStorage::getArenaSize(storageBufferSize);
+}
+
+MidiEventQueue::MidiEventQueue(Bit32u useRingBufferSize, Bit32u storageBufferSize, MemoryArena *arena) :
+	allocatedInArena(arena != NULL),
+	sysexDataStorage(*SysexDataStorage::create(storageBufferSize, arena)),
+	ringBuffer(arena != NULL ? arena->allocateArray<MidiEvent>(useRingBufferSize) : new MidiEvent[useRingBufferSize]),
+	ringBufferMask(useRingBufferSize - 1),
+	pushedReferencedSysexCount(), droppedReferencedSysexCount()
 {
 	for (Bit32u i = 0; i <= ringBufferMask; i++) {
 		ringBuffer[i].sysexData = NULL;
+		ringBuffer[i].sysexDataReferenced = false;
 	}
 	reset();
 }
 
 MidiEventQueue::~MidiEventQueue() {
 	for (Bit32u i = 0; i <= ringBufferMask; i++) {
-		volatile MidiEvent &currentEvent = ringBuffer[i];
-		sysexDataStorage.dispose(currentEvent.sysexData, currentEvent.sysexLength);
+		disposeSysexData(ringBuffer[i]);
+	}
+	if (allocatedInArena) {
+		sysexDataStorage.~SysexDataStorage();
+		return;
 	}
 	delete &sysexDataStorage;
 	delete[] ringBuffer;
@@ -2248,6 +2716,12 @@ MidiEventQueue::~MidiEventQueue() {
 void MidiEventQueue::reset() {
 	startPosition = 0;
 	endPosition = 0;
+	droppedReferencedSysexCount = pushedReferencedSysexCount;
+}
+
+void MidiEventQueue::disposeSysexData(volatile MidiEvent &event) {
+	if (!event.sysexDataReferenced) sysexDataStorage.dispose(event.sysexData, event.sysexLength);
+	event.sysexDataReferenced = false;
 }
 
 bool MidiEventQueue::pushShortMessage(Bit32u shortMessageData, Bit32u timestamp) {
@@ -2255,7 +2729,7 @@ bool MidiEventQueue::pushShortMessage(Bit32u shortMessageData, Bit32u timestamp)
 	// If ring buffer is full, bail out.
 	if (startPosition == newEndPosition) return false;
 	volatile MidiEvent &newEvent = ringBuffer[endPosition];
-	sysexDataStorage.dispose(newEvent.sysexData, newEvent.sysexLength);
+	disposeSysexData(newEvent);
 	newEvent.sysexData = NULL;
 	newEvent.shortMessageData = shortMessageData;
 	newEvent.timestamp = timestamp;
@@ -2268,7 +2742,7 @@ bool MidiEventQueue::pushSysex(const Bit8u *sysexData, Bit32u sysexLength, Bit32
 	// If ring buffer is full, bail out.
 	if (startPosition == newEndPosition) return false;
 	volatile MidiEvent &newEvent = ringBuffer[endPosition];
-	sysexDataStorage.dispose(newEvent.sysexData, newEvent.sysexLength);
+	disposeSysexData(newEvent);
 	Bit8u *dstSysexData = sysexDataStorage.allocate(sysexLength);
 	if (dstSysexData == NULL) return false;
 	memcpy(dstSysexData, sysexData, sysexLength);
@@ -2279,6 +2753,21 @@ bool MidiEventQueue::pushSysex(const Bit8u *sysexData, Bit32u sysexLength, Bit32
 	return true;
 }
 
+bool MidiEventQueue::pushReferencedSysex(const Bit8u *sysexData, Bit32u sysexLength, Bit32u timestamp) {
+	Bit32u newEndPosition = (endPosition + 1) & ringBufferMask;
+	// If ring buffer is full, bail out.
+	if (startPosition == newEndPosition) return false;
+	volatile MidiEvent &newEvent = ringBuffer[endPosition];
+	disposeSysexData(newEvent);
+	newEvent.sysexData = sysexData;
+	newEvent.sysexLength = sysexLength;
+	newEvent.timestamp = timestamp;
+	newEvent.sysexDataReferenced = true;
+	pushedReferencedSysexCount = pushedReferencedSysexCount + 1;
+	endPosition = newEndPosition;
+	return true;
+}
+
 const volatile MidiEventQueue::MidiEvent *MidiEventQueue::peekMidiEvent() {
 	return isEmpty() ? NULL : &ringBuffer[startPosition];
 }
@@ -2286,6 +2775,12 @@ const volatile MidiEventQueue::MidiEvent *MidiEventQueue::peekMidiEvent() {
 void MidiEventQueue::dropMidiEvent() {
 	if (isEmpty()) return;
 	volatile MidiEvent &unusedEvent = ringBuffer[startPosition];
+	if (unusedEvent.sysexDataReferenced) {
+		startPosition = (startPosition + 1) & ringBufferMask;
+		// The client may reuse the referenced data as soon as the event is out of the queue.
+		droppedReferencedSysexCount = droppedReferencedSysexCount + 1;
+		return;
+	}
 	sysexDataStorage.reclaimUnused(unusedEvent.sysexData, unusedEvent.sysexLength);
 	startPosition = (startPosition + 1) & ringBufferMask;
 }
@@ -2294,6 +2789,53 @@ bool MidiEventQueue::isEmpty() const {
 	return startPosition == endPosition;
 }
 
+Bit32u MidiEventQueue::getPendingEventCount() const {
+	return (endPosition - startPosition) & ringBufferMask;
+}
+
+Bit32u MidiEventQueue::getReferencedSysexCount() const {
+	return pushedReferencedSysexCount - droppedReferencedSysexCount;
+}
+
+void MidiEventQueue::saveState(StateWriter &writer) const {
+	writer.write(getPendingEventCount());
+	for (Bit32u position = startPosition; position != endPosition; position = (position + 1) & ringBufferMask) {
+		const volatile MidiEvent &event = ringBuffer[position];
+		bool sysex = event.sysexData != NULL;
+		writer.write(sysex);
+		writer.write(Bit32u(event.timestamp));
+		if (sysex) {
+			writer.write(Bit32u(event.sysexLength));
+			writer.writeBytes(const_cast<const Bit8u *>(event.sysexData), event.sysexLength);
+		} else {
+			writer.write(Bit32u(event.shortMessageData));
+		}
+	}
+}
+
+bool MidiEventQueue::loadState(StateReader &reader) {
+	while (!isEmpty()) dropMidiEvent();
+	Bit32u eventCount;
+	reader.read(eventCount);
+	if (eventCount > ringBufferMask) return false;
+	for (Bit32u i = 0; i < eventCount && !reader.isFailed(); i++) {
+		bool sysex;
+		Bit32u timestamp, data;
+		reader.read(sysex);
+		reader.read(timestamp);
+		reader.read(data);
+		bool pushed;
+		if (sysex) {
+			const Bit8u *sysexData = reader.readByteArray(data);
+			pushed = sysexData != NULL && pushSysex(sysexData, data, timestamp);
+		} else {
+			pushed = pushShortMessage(data, timestamp);
+		}
+		if (!pushed) return false;
+	}
+	return true;
+}
+
 void Synth::selectRendererType(RendererType newRendererType) {
 	extensions.selectedRendererType = newRendererType;
 }
@@ -2315,80 +2857,169 @@ void Renderer::updateDisplayState() {
 	if (lcdUpdated) synth.extensions.reportHandler2->onLCDStateUpdated();
 }
 
+// Plays the next MIDI event from the queue if it is due and returns the number of samples to produce before proceeding.
+Bit32u Renderer::playDueMidiEvent(Bit32u len) {
+	// We need to ensure zero-duration notes will play so add minimum 1-sample delay.
+	Bit32u thisLen = 1;
+	if (!isAbortingPoly()) {
+		const volatile MidiEventQueue::MidiEvent *nextEvent = getMidiQueue().peekMidiEvent();
+		Bit32s samplesToNextEvent = (nextEvent != NULL) ? Bit32s(nextEvent->timestamp - getRenderedSampleCount()) : MAX_SAMPLES_PER_RUN;
+		if (samplesToNextEvent > 0) {
+			thisLen = len > MAX_SAMPLES_PER_RUN ? MAX_SAMPLES_PER_RUN : len;
+			if (thisLen > Bit32u(samplesToNextEvent)) {
+				thisLen = samplesToNextEvent;
+			}
+		} else {
+			double stageStartTime = beginStage();
+			if (nextEvent->sysexData == NULL) {
+				synth.playMsgNow(nextEvent->shortMessageData);
+				// If a poly is aborting we don't drop the event from the queue.
+				// Instead, we'll return to it again when the abortion is done.
+				if (!isAbortingPoly()) {
+					getMidiQueue().dropMidiEvent();
+				}
+			} else {
+				synth.playSysexNow(nextEvent->sysexData, nextEvent->sysexLength);
+				getMidiQueue().dropMidiEvent();
+			}
+			endStage(StatisticsCollector::RenderingStage_MIDI_PROCESSING, stageStartTime);
+		}
+	}
+	return thisLen;
+}
+
+void Renderer::fastForward(Bit32u len) {
+	while (len > 0) {
+		Bit32u thisLen = playDueMidiEvent(len);
+		if (isActivated()) {
+			for (unsigned int i = 0; i < synth.getPartialCount(); i++) {
+				getPartialManager().fastForward(i, thisLen);
+			}
+		}
+		getPartialManager().clearAlreadyOutputed();
+		incRenderedSampleCount(thisLen);
+		updateDisplayState();
+		len -= thisLen;
+	}
+}
+
 template <class Sample>
-void RendererImpl<Sample>::doRender(Sample *stereoStream, Bit32u len) {
+Bit32u RendererImpl<Sample>::doRender(const OutputChannels<Sample> &channels, Bit32u len) {
 	if (!isActivated()) {
 		incRenderedSampleCount(getAnalog().getDACStreamsLength(len));
-		if (!getAnalog().process(NULL, NULL, NULL, NULL, NULL, NULL, stereoStream, len)) {
+		const OutputChannels<Sample> noChannels = { NULL, NULL, 0 };
+		double stageStartTime = beginStage();
+		if (!getAnalog().process(noChannels, NULL, NULL, NULL, NULL, NULL, NULL, len)) {
 			printDebug("RendererImpl: Invalid call to Analog::process()!\n");
 		}
-		Synth::muteSampleBuffer(stereoStream, len << 1);
+		endStage(StatisticsCollector::RenderingStage_ANALOG, stageStartTime);
+		muteChannels(channels, len);
 		updateDisplayState();
-		return;
+		return len;
 	}
 
+	OutputChannels<Sample> tmpChannels = channels;
+	const Bit32u requestedLen = len;
 	while (len > 0) {
 		// As in AnalogOutputMode_ACCURATE mode output is upsampled, MAX_SAMPLES_PER_RUN is more than enough for the temp buffers.
 		Bit32u thisPassLen = len > MAX_SAMPLES_PER_RUN ? MAX_SAMPLES_PER_RUN : len;
-		doRenderStreams(tmpBuffers, getAnalog().getDACStreamsLength(thisPassLen));
-		if (!getAnalog().process(stereoStream, tmpNonReverbLeft, tmpNonReverbRight, tmpReverbDryLeft, tmpReverbDryRight, tmpReverbWetLeft, tmpReverbWetRight, thisPassLen)) {
+		Bit32u dacStreamsLength = getAnalog().getDACStreamsLength(thisPassLen);
+		Bit32u renderedDACStreamsLength = doRenderStreams(tmpBuffers, dacStreamsLength);
+		// Rendering only stops early when the analog circuitry emulation retains the native sample rate.
+		if (renderedDACStreamsLength < dacStreamsLength) thisPassLen = renderedDACStreamsLength;
+		double stageStartTime = beginStage();
+		bool analogProcessed = getAnalog().process(tmpChannels, tmpNonReverbLeft, tmpNonReverbRight, tmpReverbDryLeft, tmpReverbDryRight, tmpReverbWetLeft, tmpReverbWetRight, thisPassLen);
+		endStage(StatisticsCollector::RenderingStage_ANALOG, stageStartTime);
+		if (!analogProcessed) {
 			printDebug("RendererImpl: Invalid call to Analog::process()!\n");
-			Synth::muteSampleBuffer(stereoStream, len << 1);
-			return;
+			muteChannels(tmpChannels, len);
+			return requestedLen;
 		}
-		stereoStream += thisPassLen << 1;
+		advanceChannels(tmpChannels, thisPassLen);
 		len -= thisPassLen;
+		if (stoppedOnPartialsInactive) break;
 	}
+	return requestedLen - len;
 }
 
 template <class Sample>
 template <class O>
-void RendererImpl<Sample>::doRenderAndConvert(O *stereoStream, Bit32u len) {
+Bit32u RendererImpl<Sample>::doRenderAndConvert(const OutputChannels<O> &channels, Bit32u len) {
 	Sample renderingBuffer[MAX_SAMPLES_PER_RUN << 1];
+	const OutputChannels<Sample> renderingChannels = planarChannels(renderingBuffer, renderingBuffer + MAX_SAMPLES_PER_RUN);
+	OutputChannels<O> tmpChannels = channels;
+	const Bit32u requestedLen = len;
 	while (len > 0) {
 		Bit32u thisPassLen = len > MAX_SAMPLES_PER_RUN ? MAX_SAMPLES_PER_RUN : len;
-		doRender(renderingBuffer, thisPassLen);
-		convertSampleFormat(renderingBuffer, stereoStream, thisPassLen << 1);
-		stereoStream += thisPassLen << 1;
+		thisPassLen = doRender(renderingChannels, thisPassLen);
+		convertChannelsFormat(renderingChannels, tmpChannels, thisPassLen);
+		advanceChannels(tmpChannels, thisPassLen);
 		len -= thisPassLen;
+		if (stoppedOnPartialsInactive) break;
 	}
+	return requestedLen - len;
 }
 
 template<>
-void RendererImpl<IntSample>::render(IntSample *stereoStream, Bit32u len) {
-	doRender(stereoStream, len);
+Bit32u RendererImpl<IntSample>::render(const OutputChannels<IntSample> &channels, Bit32u len) {
+	return doRender(channels, len);
 }
 
 template<>
-void RendererImpl<IntSample>::render(FloatSample *stereoStream, Bit32u len) {
-	doRenderAndConvert(stereoStream, len);
+Bit32u RendererImpl<IntSample>::render(const OutputChannels<FloatSample> &channels, Bit32u len) {
+	return doRenderAndConvert(channels, len);
 }
 
 template<>
-void RendererImpl<FloatSample>::render(IntSample *stereoStream, Bit32u len) {
-	doRenderAndConvert(stereoStream, len);
+Bit32u RendererImpl<FloatSample>::render(const OutputChannels<IntSample> &channels, Bit32u len) {
+	return doRenderAndConvert(channels, len);
 }
 
 template<>
-void RendererImpl<FloatSample>::render(FloatSample *stereoStream, Bit32u len) {
-	doRender(stereoStream, len);
+Bit32u RendererImpl<FloatSample>::render(const OutputChannels<FloatSample> &channels, Bit32u len) {
+	return doRender(channels, len);
 }
 
 template <class S>
-static inline void renderStereo(bool opened, Renderer *renderer, S *stream, Bit32u len) {
+static inline void renderStereo(bool opened, Renderer *renderer, const OutputChannels<S> &channels, Bit32u len) {
 	if (opened) {
-		renderer->render(stream, len);
+		renderer->render(channels, len);
 	} else {
-		Synth::muteSampleBuffer(stream, len << 1);
+		muteChannels(channels, len);
 	}
 }
 
+void Synth::beginRenderPass() {
+	if (extensions.statisticsCollector != NULL) extensions.statisticsCollector->beginRenderPass(midiQueue->getPendingEventCount());
+}
+
+void Synth::endRenderPass() {
+	if (extensions.statisticsCollector != NULL) extensions.statisticsCollector->endRenderPass();
+	if (extensions.stateSnapshotBuffer != NULL) extensions.stateSnapshotBuffer->publish(*this);
+}
+
 void Synth::render(Bit16s *stream, Bit32u len) {
-	renderStereo(opened, renderer, stream, len);
+	beginRenderPass();
+	renderStereo(opened, renderer, interleavedChannels(stream), len);
+	endRenderPass();
 }
 
 void Synth::render(float *stream, Bit32u len) {
-	renderStereo(opened, renderer, stream, len);
+	beginRenderPass();
+	renderStereo(opened, renderer, interleavedChannels(stream), len);
+	endRenderPass();
+}
+
+void Synth::renderPlanar(Bit16s *leftStream, Bit16s *rightStream, Bit32u len) {
+	beginRenderPass();
+	renderStereo(opened, renderer, planarChannels(leftStream, rightStream), len);
+	endRenderPass();
+}
+
+void Synth::renderPlanar(float *leftStream, float *rightStream, Bit32u len) {
+	beginRenderPass();
+	renderStereo(opened, renderer, planarChannels(leftStream, rightStream), len);
+	endRenderPass();
 }
 
 template <class Sample>
@@ -2429,43 +3060,23 @@ static inline void convertStreamsFormat(const DACOutputStreams<I> &inStreams, co
 }
 
 template <class Sample>
-void RendererImpl<Sample>::doRenderStreams(const DACOutputStreams<Sample> &streams, Bit32u len)
+Bit32u RendererImpl<Sample>::doRenderStreams(const DACOutputStreams<Sample> &streams, Bit32u len)
 {
 	DACOutputStreams<Sample> tmpStreams = streams;
+	const Bit32u requestedLen = len;
 	while (len > 0) {
-		// We need to ensure zero-duration notes will play so add minimum 1-sample delay.
-		Bit32u thisLen = 1;
-		if (!isAbortingPoly()) {
-			const volatile MidiEventQueue::MidiEvent *nextEvent = getMidiQueue().peekMidiEvent();
-			Bit32s samplesToNextEvent = (nextEvent != NULL) ? Bit32s(nextEvent->timestamp - getRenderedSampleCount()) : MAX_SAMPLES_PER_RUN;
-			if (samplesToNextEvent > 0) {
-				thisLen = len > MAX_SAMPLES_PER_RUN ? MAX_SAMPLES_PER_RUN : len;
-				if (thisLen > Bit32u(samplesToNextEvent)) {
-					thisLen = samplesToNextEvent;
-				}
-			} else {
-				if (nextEvent->sysexData == NULL) {
-					synth.playMsgNow(nextEvent->shortMessageData);
-					// If a poly is aborting we don't drop the event from the queue.
-					// Instead, we'll return to it again when the abortion is done.
-					if (!isAbortingPoly()) {
-						getMidiQueue().dropMidiEvent();
-					}
-				} else {
-					synth.playSysexNow(nextEvent->sysexData, nextEvent->sysexLength);
-					getMidiQueue().dropMidiEvent();
-				}
-			}
-		}
-		produceStreams(tmpStreams, thisLen);
+		Bit32u thisLen = playDueMidiEvent(len);
+		thisLen = produceStreams(tmpStreams, thisLen);
 		advanceStreams(tmpStreams, thisLen);
 		len -= thisLen;
+		if (stoppedOnPartialsInactive) break;
 	}
+	return requestedLen - len;
 }
 
 template <class Sample>
 template <class O>
-void RendererImpl<Sample>::doRenderAndConvertStreams(const DACOutputStreams<O> &streams, Bit32u len) {
+Bit32u RendererImpl<Sample>::doRenderAndConvertStreams(const DACOutputStreams<O> &streams, Bit32u len) {
 	Sample cnvNonReverbLeft[MAX_SAMPLES_PER_RUN], cnvNonReverbRight[MAX_SAMPLES_PER_RUN];
 	Sample cnvReverbDryLeft[MAX_SAMPLES_PER_RUN], cnvReverbDryRight[MAX_SAMPLES_PER_RUN];
 	Sample cnvReverbWetLeft[MAX_SAMPLES_PER_RUN], cnvReverbWetRight[MAX_SAMPLES_PER_RUN];
@@ -2477,34 +3088,37 @@ void RendererImpl<Sample>::doRenderAndConvertStreams(const DACOutputStreams<O> &
 	};
 
 	DACOutputStreams<O> tmpStreams = streams;
+	const Bit32u requestedLen = len;
 
 	while (len > 0) {
 		Bit32u thisPassLen = len > MAX_SAMPLES_PER_RUN ? MAX_SAMPLES_PER_RUN : len;
-		doRenderStreams(cnvStreams, thisPassLen);
+		thisPassLen = doRenderStreams(cnvStreams, thisPassLen);
 		convertStreamsFormat(cnvStreams, tmpStreams, thisPassLen);
 		advanceStreams(tmpStreams, thisPassLen);
 		len -= thisPassLen;
+		if (stoppedOnPartialsInactive) break;
 	}
+	return requestedLen - len;
 }
 
 template<>
-void RendererImpl<IntSample>::renderStreams(const DACOutputStreams<IntSample> &streams, Bit32u len) {
-	doRenderStreams(streams, len);
+Bit32u RendererImpl<IntSample>::renderStreams(const DACOutputStreams<IntSample> &streams, Bit32u len) {
+	return doRenderStreams(streams, len);
 }
 
 template<>
-void RendererImpl<IntSample>::renderStreams(const DACOutputStreams<FloatSample> &streams, Bit32u len) {
-	doRenderAndConvertStreams(streams, len);
+Bit32u RendererImpl<IntSample>::renderStreams(const DACOutputStreams<FloatSample> &streams, Bit32u len) {
+	return doRenderAndConvertStreams(streams, len);
 }
 
 template<>
-void RendererImpl<FloatSample>::renderStreams(const DACOutputStreams<IntSample> &streams, Bit32u len) {
-	doRenderAndConvertStreams(streams, len);
+Bit32u RendererImpl<FloatSample>::renderStreams(const DACOutputStreams<IntSample> &streams, Bit32u len) {
+	return doRenderAndConvertStreams(streams, len);
 }
 
 template<>
-void RendererImpl<FloatSample>::renderStreams(const DACOutputStreams<FloatSample> &streams, Bit32u len) {
-	doRenderStreams(streams, len);
+Bit32u RendererImpl<FloatSample>::renderStreams(const DACOutputStreams<FloatSample> &streams, Bit32u len) {
+	return doRenderStreams(streams, len);
 }
 
 template <class S>
@@ -2517,11 +3131,15 @@ static inline void renderStreams(bool opened, Renderer *renderer, const DACOutpu
 }
 
 void Synth::renderStreams(const DACOutputStreams<Bit16s> &streams, Bit32u len) {
+	beginRenderPass();
 	MT32Emu::renderStreams(opened, renderer, streams, len);
+	endRenderPass();
 }
 
 void Synth::renderStreams(const DACOutputStreams<float> &streams, Bit32u len) {
+	beginRenderPass();
 	MT32Emu::renderStreams(opened, renderer, streams, len);
+	endRenderPass();
 }
 
 void Synth::renderStreams(
@@ -2552,6 +3170,139 @@ void Synth::renderStreams(
 	renderStreams(streams, len);
 }
 
+// Keeps track of the position in the stereo output while rendering in several calls.
+template <class S>
+class StereoOutput {
+public:
+	explicit StereoOutput(const OutputChannels<S> &useChannels) : channels(useChannels) {}
+
+	Bit32u render(Renderer &renderer, Bit32u len) {
+		Bit32u renderedLen = renderer.render(channels, len);
+		advanceChannels(channels, renderedLen);
+		return renderedLen;
+	}
+
+	Bit32u renderWhilePartialsActive(const Synth &synth, Renderer &renderer, Bit32u len) {
+		if (synth.getStereoOutputSampleRate() != SAMPLE_RATE) {
+			// When resampled, the output frames don't correspond to the DAC samples, so we have to proceed frame by frame.
+			Bit32u renderedLen = 0;
+			while (renderedLen < len && synth.hasActivePartials()) {
+				renderedLen += render(renderer, 1);
+			}
+			return renderedLen;
+		}
+		renderer.setStopOnPartialsInactive(true);
+		Bit32u renderedLen = render(renderer, len);
+		renderer.setStopOnPartialsInactive(false);
+		return renderedLen;
+	}
+
+private:
+	OutputChannels<S> channels;
+};
+
+// Same as StereoOutput but for the DAC output streams.
+template <class S>
+class StreamsOutput {
+public:
+	explicit StreamsOutput(const DACOutputStreams<S> &useStreams) : streams(useStreams) {}
+
+	Bit32u render(Renderer &renderer, Bit32u len) {
+		Bit32u renderedLen = renderer.renderStreams(streams, len);
+		advanceStreams(streams, renderedLen);
+		return renderedLen;
+	}
+
+	Bit32u renderWhilePartialsActive(const Synth &, Renderer &renderer, Bit32u len) {
+		renderer.setStopOnPartialsInactive(true);
+		Bit32u renderedLen = render(renderer, len);
+		renderer.setStopOnPartialsInactive(false);
+		return renderedLen;
+	}
+
+private:
+	DACOutputStreams<S> streams;
+};
+
+template <class Output>
+static inline Bit32u renderWhilePartialsActive(const Synth &synth, Renderer *renderer, Output output, Bit32u len) {
+	if (!synth.hasActivePartials()) return 0;
+	return output.renderWhilePartialsActive(synth, *renderer, len);
+}
+
+template <class Output>
+static inline Bit32u renderWhileActive(Synth &synth, Renderer *renderer, Output output, Bit32u len) {
+	Bit32u renderedLen = 0;
+	while (renderedLen < len && synth.isActive()) {
+		Bit32u thisLen = len - renderedLen;
+		if (thisLen > ACTIVITY_CHECK_PERIOD) thisLen = ACTIVITY_CHECK_PERIOD;
+		renderedLen += output.render(*renderer, thisLen);
+	}
+	return renderedLen;
+}
+
+Bit32u Synth::renderWhilePartialsActive(Bit16s *stream, Bit32u len) {
+	beginRenderPass();
+	Bit32u renderedLen = MT32Emu::renderWhilePartialsActive(*this, renderer, StereoOutput<Bit16s>(interleavedChannels(stream)), len);
+	endRenderPass();
+	return renderedLen;
+}
+
+Bit32u Synth::renderWhilePartialsActive(float *stream, Bit32u len) {
+	beginRenderPass();
+	Bit32u renderedLen = MT32Emu::renderWhilePartialsActive(*this, renderer, StereoOutput<float>(interleavedChannels(stream)), len);
+	endRenderPass();
+	return renderedLen;
+}
+
+Bit32u Synth::renderStreamsWhilePartialsActive(const DACOutputStreams<Bit16s> &streams, Bit32u len) {
+	beginRenderPass();
+	Bit32u renderedLen = MT32Emu::renderWhilePartialsActive(*this, renderer, StreamsOutput<Bit16s>(streams), len);
+	endRenderPass();
+	return renderedLen;
+}
+
+Bit32u Synth::renderStreamsWhilePartialsActive(const DACOutputStreams<float> &streams, Bit32u len) {
+	beginRenderPass();
+	Bit32u renderedLen = MT32Emu::renderWhilePartialsActive(*this, renderer, StreamsOutput<float>(streams), len);
+	endRenderPass();
+	return renderedLen;
+}
+
+Bit32u Synth::renderWhileActive(Bit16s *stream, Bit32u len) {
+	beginRenderPass();
+	Bit32u renderedLen = MT32Emu::renderWhileActive(*this, renderer, StereoOutput<Bit16s>(interleavedChannels(stream)), len);
+	endRenderPass();
+	return renderedLen;
+}
+
+Bit32u Synth::renderWhileActive(float *stream, Bit32u len) {
+	beginRenderPass();
+	Bit32u renderedLen = MT32Emu::renderWhileActive(*this, renderer, StereoOutput<float>(interleavedChannels(stream)), len);
+	endRenderPass();
+	return renderedLen;
+}
+
+Bit32u Synth::renderStreamsWhileActive(const DACOutputStreams<Bit16s> &streams, Bit32u len) {
+	beginRenderPass();
+	Bit32u renderedLen = MT32Emu::renderWhileActive(*this, renderer, StreamsOutput<Bit16s>(streams), len);
+	endRenderPass();
+	return renderedLen;
+}
+
+Bit32u Synth::renderStreamsWhileActive(const DACOutputStreams<float> &streams, Bit32u len) {
+	beginRenderPass();
+	Bit32u renderedLen = MT32Emu::renderWhileActive(*this, renderer, StreamsOutput<float>(streams), len);
+	endRenderPass();
+	return renderedLen;
+}
+
+void Synth::fastForward(Bit32u len) {
+	beginRenderPass();
+	if (opened) renderer->fastForward(len);
+	endRenderPass();
+}
+
 // In GENERATION2 units, the output from LA32 goes to the Boss chip already bit-shifted.
 // In NICE mode, it's also better to increase volume before the reverb processing to preserve accuracy.
 template <>
@@ -2627,8 +3378,35 @@ void RendererImpl<FloatSample>::convertSamplesToOutput(FloatSample *buffer, Bit3
 	}
 }
 
+static inline IntSample mixFadingSample(const IntSample sample, const IntSample fadingSample, const Bit32u fadeSamplesLeft) {
+	return Synth::clipSampleEx(IntSampleEx(sample) + IntSampleEx(fadingSample) * IntSampleEx(fadeSamplesLeft) / IntSampleEx(REVERB_FADE_LENGTH));
+}
+
+static inline FloatSample mixFadingSample(const FloatSample sample, const FloatSample fadingSample, const Bit32u fadeSamplesLeft) {
+	return sample + fadingSample * (float(fadeSamplesLeft) / float(REVERB_FADE_LENGTH));
+}
+
+template <class Sample>
+void RendererImpl<Sample>::mixFadingReverbOutput(const Sample *reverbDryLeft, const Sample *reverbDryRight, Sample *reverbWetLeft, Sample *reverbWetRight, Bit32u len) {
+	BReverbModel *fadingReverbModel = getFadingReverbModel();
+	Sample *fadingWetLeft = reverbWetLeft == NULL ? NULL : tmpFadingReverbWetLeft;
+	Sample *fadingWetRight = reverbWetRight == NULL ? NULL : tmpFadingReverbWetRight;
+	if (!fadingReverbModel->process(reverbDryLeft, reverbDryRight, fadingWetLeft, fadingWetRight, len)) {
+		printDebug("RendererImpl: Invalid call to BReverbModel::process()!\n");
+	}
+
+	Bit32u &fadeSamplesLeft = getReverbFadeSamplesLeft();
+	for (Bit32u i = 0; i < len && fadeSamplesLeft > 0; i++, fadeSamplesLeft--) {
+		if (reverbWetLeft != NULL) reverbWetLeft[i] = mixFadingSample(reverbWetLeft[i], fadingWetLeft[i], fadeSamplesLeft);
+		if (reverbWetRight != NULL) reverbWetRight[i] = mixFadingSample(reverbWetRight[i], fadingWetRight[i], fadeSamplesLeft);
+	}
+	if (fadeSamplesLeft == 0) {
+		finishReverbFade();
+	}
+}
+
 template <class Sample>
-void RendererImpl<Sample>::produceStreams(const DACOutputStreams<Sample> &streams, Bit32u len) {
+Bit32u RendererImpl<Sample>::produceStreams(const DACOutputStreams<Sample> &streams, Bit32u len) {
 	if (isActivated()) {
 		// Even if LA32 output isn't desired, we proceed anyway with temp buffers
 		Sample *nonReverbLeft = streams.nonReverbLeft == NULL ? tmpNonReverbLeft : streams.nonReverbLeft;
@@ -2649,15 +3427,28 @@ void RendererImpl<Sample>::produceStreams(const DACOutputStreams<Sample> &stream
 			}
 		}
 
+		if (stopOnPartialsInactive && !synth.hasActivePartials()) {
+			// Cut this pass short right after the sample where the partials have ended. That sample is retained, so that
+			// the output matches rendering one frame at a time while hasActivePartials() returns true.
+			Bit32u partialOutputEnd = getPartialManager().getPartialOutputEnd();
+			if (partialOutputEnd < len) len = partialOutputEnd + 1;
+			stoppedOnPartialsInactive = true;
+		}
+
 		produceLA32Output(reverbDryLeft, len);
 		produceLA32Output(reverbDryRight, len);
 
 		if (synth.isReverbEnabled()) {
+			double stageStartTime = beginStage();
 			if (!getReverbModel().process(reverbDryLeft, reverbDryRight, streams.reverbWetLeft, streams.reverbWetRight, len)) {
 				printDebug("RendererImpl: Invalid call to BReverbModel::process()!\n");
 			}
+			if (getFadingReverbModel() != NULL) {
+				mixFadingReverbOutput(reverbDryLeft, reverbDryRight, streams.reverbWetLeft, streams.reverbWetRight, len);
+			}
 			if (streams.reverbWetLeft != NULL) convertSamplesToOutput(streams.reverbWetLeft, len);
 			if (streams.reverbWetRight != NULL) convertSamplesToOutput(streams.reverbWetRight, len);
+			endStage(StatisticsCollector::RenderingStage_REVERB, stageStartTime);
 		} else {
 			Synth::muteSampleBuffer(streams.reverbWetLeft, len);
 			Synth::muteSampleBuffer(streams.reverbWetRight, len);
@@ -2681,6 +3472,7 @@ void RendererImpl<Sample>::produceStreams(const DACOutputStreams<Sample> &stream
 	getPartialManager().clearAlreadyOutputed();
 	incRenderedSampleCount(len);
 	updateDisplayState();
+	return len;
 }
 
 void Synth::printPartialUsage(Bit32u sampleOffset) {
@@ -2712,7 +3504,7 @@ bool Synth::isActive() {
 	if (!midiQueue->isEmpty() || hasActivePartials()) {
 		return true;
 	}
-	if (isReverbEnabled() && reverbModel->isActive()) {
+	if (isReverbEnabled() && (reverbModel->isActive() || extensions.fadingReverbModel != NULL)) {
 		return true;
 	}
 	activated = false;
@@ -39,6 +39,7 @@ class Partial;
 class PartialManager;
 class Renderer;
 class ROMImage;
+class StatisticsCollector;
 
 class PatchTempMemoryRegion;
 class RhythmTempMemoryRegion;
@@ -85,6 +86,58 @@ struct DACOutputStreams {
 	T *reverbWetRight;
 };
 
+// Consistent view of the synth state captured by the rendering thread at the end of a rendering pass.
+// See Synth::getStateSnapshot() for details. The client must set each array pointer either to NULL,
+// in order to skip retrieving the corresponding data, or to an array of sufficient size.
+struct StateSnapshot {
+	// Value of Synth::getInternalRenderedSampleCount() when the snapshot was captured.
+	Bit32u renderedSampleCount;
+	// States of all the parts as a bit set, see Synth::getPartStates().
+	Bit32u partStates;
+	// State of the MIDI MESSAGE LED and null-terminated content of the emulated LCD, see Synth::getDisplayState().
+	bool midiMessageLEDState;
+	char lcdState[21];
+	// Numbers of notes playing on each part. Keys and velocities of the notes are stored in arrays keys and velocities
+	// part by part, starting from part 1. The arrays must have at least getPartialCount() entries.
+	Bit32u playingNoteCounts[9];
+	Bit8u *keys;
+	Bit8u *velocities;
+	// States of all the partials, see Synth::getPartialStates(PartialState *).
+	PartialState *partialStates;
+	// States of all the partials packed in pairs of bits, see Synth::getPartialStates(Bit8u *).
+	Bit8u *packedPartialStates;
+};
+
+// Usage statistics accumulated by the rendering thread since the synth was opened or the statistics were last reset.
+// See Synth::getStatistics() for details.
+struct Statistics {
+	// Number of samples rendered at the internal sample rate. Wraps around.
+	Bit32u renderedSampleCount;
+	// Maximum and average numbers of partials simultaneously active on each part, starting from part 1.
+	// The counts are sampled once per rendered chunk, so very short peaks may be missed.
+	Bit32u peakActivePartialCounts[9];
+	float averageActivePartialCounts[9];
+	// Maximum number of partials simultaneously active on all the parts.
+	Bit32u peakActivePartialCount;
+	// Number of playing polys aborted to free partials for new notes, see ReportHandler3::onPlayingPolySilenced().
+	Bit32u silencedPolyCount;
+	// Number of note-on messages ignored for the lack of free partials, see ReportHandler3::onNoteOnIgnored().
+	Bit32u ignoredNoteOnCount;
+	// Maximum number of MIDI events found pending in the queue at the beginning of a rendering pass.
+	Bit32u midiQueueHighWaterMark;
+	// Number of calls to the rendering methods, along with the total and maximum time spent in them, in seconds.
+	Bit32u renderPassCount;
+	double totalRenderPassDuration;
+	double maxRenderPassDuration;
+	// Parts of the total rendering time spent in processing MIDI events, producing the output of partials,
+	// emulating the reverb and the analogue circuitry, in seconds. The time spent producing the output of partials
+	// also covers whatever overhead is not attributed to the other stages.
+	double totalMidiProcessingDuration;
+	double totalPartialRenderingDuration;
+	double totalReverbDuration;
+	double totalAnalogDuration;
+};
+
 // Class for the client to supply callbacks for reporting various errors and information
 class MT32EMU_EXPORT ReportHandler {
 public:
@@ -151,6 +204,8 @@ friend class Renderer;
 friend class RhythmPart;
 friend class SamplerateAdapter;
 friend class SoxrAdapter;
+friend class StateReader;
+friend class StateWriter;
 friend class TVA;
 friend class TVF;
 friend class TVP;
@@ -241,6 +296,10 @@ private:
 	bool initTimbres(Bit16u mapAddress, Bit16u offset, Bit16u timbreCount, Bit16u startTimbre, bool compressed);
 	bool initCompressedTimbre(Bit16u drumNum, const Bit8u *mem, Bit32u memLen);
 	void initReverbModels(bool mt32CompatibleMode);
+	void deleteReverbModels();
+	void closeReverbModels();
+	void initMemoryArena(AnalogOutputMode analogOutputMode);
+	void createPartialManager();
 	void initSoundGroups(char newSoundGroupNames[][9]);
 
 	void refreshSystemMasterTune();
@@ -268,6 +327,10 @@ private:
 	Bit32s getMasterTunePitchDelta() const;
 
 	ReportHandler3 *getReportHandler3();
+	StatisticsCollector *getStatisticsCollector() const;
+
+	void beginRenderPass();
+	void endRenderPass();
 
 	void playUnpackedShortMessage(Bit8u partNum, Bit8u command, Bit8u data1, Bit8u data2);
 
@@ -389,6 +452,17 @@ public:
 	// Enqueues a single well formed System Exclusive MIDI message to be processed ASAP.
 	MT32EMU_EXPORT bool playSysex(const Bit8u *sysex, Bit32u len);
 
+	// Same as playSysex() above but the SysEx data isn't copied into the MIDI event queue. Instead, the queue merely references
+	// the data provided, which must therefore stay intact until the synth has processed the message. This permits delivering
+	// SysEx messages (e.g. large dumps) straight from a client-side event buffer without copying them once again.
+	// The client may reuse the memory occupied by the referenced data once the message is processed (see
+	// getPendingReferencedSysexCount()) or the MIDI event queue is flushed or reallocated.
+	MT32EMU_EXPORT_V(2.8) bool playReferencedSysex(const Bit8u *sysex, Bit32u len, Bit32u timestamp);
+	// Returns the number of SysEx messages enqueued with playReferencedSysex() and not yet processed. The messages are processed
+	// in the order enqueued, so by counting the messages it enqueued, the client can tell which ones are done with.
+	// Safe to call from the thread that enqueues MIDI events.
+	MT32EMU_EXPORT_V(2.8) Bit32u getPendingReferencedSysexCount() const;
+
 	// WARNING:
 	// The methods below may have no effect while the synth is aborting a poly. They also don't ensure minimum 1-sample delay between
 	// sequential MIDI events, and a sequence of NoteOn and immediately succeeding NoteOff messages is always silent.
@@ -428,6 +502,23 @@ public:
 	// Returns the number of played SysEx messages.
 	MT32EMU_EXPORT_V(2.8) Bit32u applySysexBank(const Bit8u *sysexBank, Bit32u size);
 
+	// Stores the complete internal state of the emulated synth into the provided array, including the memory contents,
+	// the playing partials with their envelopes and wave generators, the reverb delay lines, the analogue LPF history
+	// and the pending MIDI events. Unlike a SysEx bank, the state can be restored to continue rendering bit-exactly,
+	// either by the same synth, e.g. to seek back, or by another synth opened with the same ROMs, partial count,
+	// renderer type, analog output mode and reverb compatibility mode, e.g. to fork a render. Settings that are
+	// controlled by the client, such as output gains, overrides, stereo reversal and nice* emulation flags, are not
+	// included. The state is compact yet only meaningful to the same build of the library.
+	// Returns the full length of the state in bytes. This function can be used to retrieve the required size of the state
+	// by supplying NULL stateBuffer or zero size arguments, in which case it does nothing else.
+	// The synth must be open. Must not be invoked concurrently with rendering or MIDI input.
+	MT32EMU_EXPORT_V(2.8) Bit32u saveState(Bit8u *stateBuffer, Bit32u size) const;
+	// Restores the internal state of the emulated synth previously stored by saveState().
+	// Returns false if the state is incompatible with this synth or appears corrupted. The synth remains unaffected
+	// when the problem is detected by examining the header of the state, otherwise the synth is reset.
+	// The synth must be open. Must not be invoked concurrently with rendering or MIDI input.
+	MT32EMU_EXPORT_V(2.8) bool loadState(const Bit8u *stateBuffer, Bit32u size);
+
 	// Allows to disable wet reverb output altogether.
 	MT32EMU_EXPORT void setReverbEnabled(bool reverbEnabled);
 	// Returns whether wet reverb output is enabled.
@@ -447,9 +538,9 @@ public:
 	MT32EMU_EXPORT bool isMT32ReverbCompatibilityMode() const;
 	// Returns whether default reverb compatibility mode is the old MT-32 compatibility mode.
 	MT32EMU_EXPORT bool isDefaultReverbMT32Compatible() const;
-	// If enabled, reverb buffers for all modes are kept around allocated all the time to avoid memory
-	// allocating/freeing in the rendering thread, which may be required for realtime operation.
-	// Otherwise, reverb buffers that are not in use are deleted to save memory (the default behaviour).
+	// Deprecated since 2.8: has no effect. Reverb buffers are now placed into a memory pool allocated in open(),
+	// which is large enough to accommodate two reverb modes at once. Hence, switching the reverb mode never involves
+	// memory allocating/freeing in the rendering thread, while the buffers for all modes are not kept around.
 	MT32EMU_EXPORT void preallocateReverbMemory(bool enabled);
 	// Sets new DAC input mode. See DACInputMode for details.
 	MT32EMU_EXPORT void setDACInputMode(DACInputMode mode);
@@ -563,6 +654,12 @@ public:
 	MT32EMU_EXPORT void render(Bit16s *stream, Bit32u len);
 	// Same as above but outputs to a float stereo stream.
 	MT32EMU_EXPORT void render(float *stream, Bit32u len);
+	// Same as render() but outputs the left and right channels to separate (planar) streams, as expected by many audio APIs
+	// and plugin hosts. Samples are written directly by the analog circuitry emulation without interleaving. Both streams
+	// must be provided, the length is in samples per channel.
+	MT32EMU_EXPORT_V(2.8) void renderPlanar(Bit16s *leftStream, Bit16s *rightStream, Bit32u len);
+	// Same as above but outputs to float streams.
+	MT32EMU_EXPORT_V(2.8) void renderPlanar(float *leftStream, float *rightStream, Bit32u len);
 
 	// Renders samples to the specified output streams as if they appeared at the DAC entrance.
 	// No further processing performed in analog circuitry emulation is applied to the signal.
@@ -582,6 +679,43 @@ public:
 	// or the reverb is (somewhat unreliably) detected as being active.
 	MT32EMU_EXPORT bool isActive();
 
+	// Same as render() but stops rendering right after the frame where the last active partial has ended.
+	// Returns the number of frames actually rendered, which is less than len only when no partials remain active.
+	// The output is the same as rendering one frame at a time while hasActivePartials() returns true, so the frame
+	// where the partials end is included. Returns 0 and leaves the stream untouched if there are no active partials
+	// when called. Otherwise, the output buffer past the returned number of frames may be overwritten with silence.
+	// This permits finding the exact end of the notes without rendering one frame at a time. When the analog circuitry
+	// emulation resamples the output (i.e. in modes ACCURATE and OVERSAMPLED, or with a custom output sample rate),
+	// the end is determined with a granularity of one output frame.
+	MT32EMU_EXPORT_V(2.8) Bit32u renderWhilePartialsActive(Bit16s *stream, Bit32u len);
+	// Same as above but outputs to a float stereo stream.
+	MT32EMU_EXPORT_V(2.8) Bit32u renderWhilePartialsActive(float *stream, Bit32u len);
+	// Same as renderStreams() but stops rendering right after the last active partial has ended. See above.
+	MT32EMU_EXPORT_V(2.8) Bit32u renderStreamsWhilePartialsActive(const DACOutputStreams<Bit16s> &streams, Bit32u len);
+	// Same as above but outputs to float streams.
+	MT32EMU_EXPORT_V(2.8) Bit32u renderStreamsWhilePartialsActive(const DACOutputStreams<float> &streams, Bit32u len);
+
+	// Same as render() but stops rendering as soon as isActive() returns false, which is useful for rendering the reverb tail.
+	// Since reverb activity detection is costly, the check is only performed once per a block of frames, so the rendered tail
+	// may be somewhat longer than necessary.
+	// Returns the number of frames actually rendered, which is less than len only when the synth became inactive.
+	MT32EMU_EXPORT_V(2.8) Bit32u renderWhileActive(Bit16s *stream, Bit32u len);
+	// Same as above but outputs to a float stereo stream.
+	MT32EMU_EXPORT_V(2.8) Bit32u renderWhileActive(float *stream, Bit32u len);
+	// Same as renderStreams() but stops rendering as soon as isActive() returns false. See above.
+	MT32EMU_EXPORT_V(2.8) Bit32u renderStreamsWhileActive(const DACOutputStreams<Bit16s> &streams, Bit32u len);
+	// Same as above but outputs to float streams.
+	MT32EMU_EXPORT_V(2.8) Bit32u renderStreamsWhileActive(const DACOutputStreams<float> &streams, Bit32u len);
+
+	// Advances the synth by the specified number of samples at the native sample rate 32000 Hz without producing any sound.
+	// The MIDI events are played from the queue at their timestamps, and the partials proceed through their envelopes
+	// and get allocated and freed exactly as they would while rendering. Thus, the report handler callbacks (e.g.
+	// ReportHandler3::onNoteOnIgnored()) and the synth state queries behave as usual, yet the processing is many times faster.
+	// Neither the waveforms of synth partials, nor the reverb, nor the analog circuitry emulation are processed meanwhile,
+	// so when rendering resumes, the reverb and analog filters continue from their state before fast-forwarding.
+	// Useful for collecting statistics or seeking across a MIDI stream.
+	MT32EMU_EXPORT_V(2.8) void fastForward(Bit32u len);
+
 	// Returns the maximum number of partials playing simultaneously.
 	MT32EMU_EXPORT Bit32u getPartialCount() const;
 
@@ -658,6 +792,45 @@ public:
 	// Returns whether the emulated display features configured by default depending on the actual control ROM version
 	// are compatible with the old-gen MT-32 devices.
 	MT32EMU_EXPORT_V(2.6) bool isDefaultDisplayOldMT32Compatible() const;
+
+	// Enables or disables publishing of the synth state snapshots by the rendering thread (disabled by default).
+	// When enabled, the synth captures its state at the end of each call to one of render methods, so that a consistent snapshot
+	// can be retrieved via getStateSnapshot() from any thread without synchronisation with the rendering thread.
+	// This setting takes effect upon the next call to open().
+	MT32EMU_EXPORT_V(2.8) void setStateSnapshotsEnabled(bool enabled);
+	// Returns whether publishing of the synth state snapshots is enabled.
+	MT32EMU_EXPORT_V(2.8) bool isStateSnapshotsEnabled() const;
+
+	// Copies the most recent state snapshot published by the rendering thread into the provided structure. This method is lock-free
+	// and may be invoked from any thread concurrently with rendering, although not concurrently with open() or close().
+	// Returns false when the synth is closed, publishing of the snapshots is disabled, or the rendering thread overtook
+	// the reader too many times. In the latter case, the content of the snapshot is undefined and the call should be retried later.
+	MT32EMU_EXPORT_V(2.8) bool getStateSnapshot(StateSnapshot &snapshot) const;
+
+	// Copies the usage statistics most recently published by the rendering thread into the provided structure. The statistics
+	// are always collected while the synth is open and published at the end of each call to one of render methods or fastForward().
+	// Like getStateSnapshot(), this method is lock-free and may be invoked from any thread concurrently with rendering, although
+	// not concurrently with open() or close(). Returns false when the synth is closed or the rendering thread overtook the reader
+	// too many times. In the latter case, the content of the statistics is undefined and the call should be retried later.
+	MT32EMU_EXPORT_V(2.8) bool getStatistics(Statistics &statistics) const;
+	// Requests the usage statistics to be cleared. May be invoked from any thread, the statistics are actually cleared
+	// by the rendering thread at the beginning of the next rendering pass.
+	MT32EMU_EXPORT_V(2.8) void resetStatistics();
+
+	// The working set of the synth involved in rendering (parts, partials, polys, reverb delay lines, LPF state,
+	// the MIDI event queue and the intermediate sample buffers) is allocated in a single block of memory upon open().
+	// Enables or disables backing that block by large (huge) pages (disabled by default). This may reduce TLB misses
+	// during rendering, yet typically requires the pages to be reserved in the system or special privileges.
+	// When large pages are unavailable, regular pages are used silently. This setting takes effect upon the next call to open().
+	MT32EMU_EXPORT_V(2.8) void setLargePagesEnabled(bool enabled);
+	// Returns whether backing the working set of the synth by large pages is enabled.
+	MT32EMU_EXPORT_V(2.8) bool isLargePagesEnabled() const;
+	// Enables or disables locking the working set of the synth in physical memory (disabled by default), so that
+	// rendering never incurs page faults even under memory pressure. Locking may fail due to the limits imposed
+	// by the system, in which case the memory simply remains unlocked. This setting takes effect upon the next call to open().
+	MT32EMU_EXPORT_V(2.8) void setMemoryLockingEnabled(bool enabled);
+	// Returns whether locking the working set of the synth in physical memory is enabled.
+	MT32EMU_EXPORT_V(2.8) bool isMemoryLockingEnabled() const;
 }; // class Synth
 
 } // namespace MT32Emu
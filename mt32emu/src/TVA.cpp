@@ -26,6 +26,7 @@
 #include "Part.h"
 #include "Partial.h"
 #include "Poly.h"
+#include "StateStream.h"
 #include "Synth.h"
 #include "Tables.h"
 
@@ -382,4 +383,29 @@ void TVA::nextPhase() {
 	startRamp(Bit8u(newTarget), Bit8u(newIncrement), newPhase);
 }
 
+void TVA::saveState(StateWriter &writer) const {
+	writer.writePart(part);
+	writer.writeRAMPointer(partialParam);
+	writer.writeRAMPointer(rhythmTemp);
+	writer.write(playing);
+	writer.write(biasAmpSubtraction);
+	writer.write(veloAmpSubtraction);
+	writer.write(keyTimeSubtraction);
+	writer.write(target);
+	writer.write(phase);
+}
+
+void TVA::loadState(StateReader &reader, bool partialActive) {
+	part = reader.readPart();
+	partialParam = reader.readRAMPointer<TimbreParam::PartialParam>();
+	rhythmTemp = reader.readRAMPointer<MemParams::RhythmTemp>();
+	reader.read(playing);
+	reader.read(biasAmpSubtraction);
+	reader.read(veloAmpSubtraction);
+	reader.read(keyTimeSubtraction);
+	reader.read(target);
+	reader.read(phase);
+	if (partialActive && (part == NULL || partialParam == NULL)) reader.fail();
+}
+
 } // namespace MT32Emu
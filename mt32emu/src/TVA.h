@@ -27,6 +27,8 @@ namespace MT32Emu {
 class LA32Ramp;
 class Part;
 class Partial;
+class StateReader;
+class StateWriter;
 struct Tables;
 
 // Note that when entering nextPhase(), newPhase is set to phase + 1, and the descriptions/names below refer to
@@ -95,6 +97,10 @@ public:
 
 	bool isPlaying() const;
 	int getPhase() const;
+
+	void saveState(StateWriter &writer) const;
+	// The parameters of an active partial must be present in the loaded state, or else the reader enters failed state.
+	void loadState(StateReader &reader, bool partialActive);
 }; // class TVA
 
 } // namespace MT32Emu
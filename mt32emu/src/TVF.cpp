@@ -21,6 +21,7 @@
 #include "LA32Ramp.h"
 #include "Partial.h"
 #include "Poly.h"
+#include "StateStream.h"
 #include "Synth.h"
 #include "Tables.h"
 
@@ -242,4 +243,23 @@ void TVF::nextPhase() {
 	startRamp(newTarget, newIncrement, newPhase);
 }
 
+void TVF::saveState(StateWriter &writer) const {
+	writer.writeRAMPointer(partialParam);
+	writer.write(baseCutoff);
+	writer.write(keyTimeSubtraction);
+	writer.write(levelMult);
+	writer.write(target);
+	writer.write(phase);
+}
+
+void TVF::loadState(StateReader &reader, bool partialActive) {
+	partialParam = reader.readRAMPointer<TimbreParam::PartialParam>();
+	reader.read(baseCutoff);
+	reader.read(keyTimeSubtraction);
+	reader.read(levelMult);
+	reader.read(target);
+	reader.read(phase);
+	if (partialActive && partialParam == NULL) reader.fail();
+}
+
 } // namespace MT32Emu
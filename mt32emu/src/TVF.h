@@ -26,6 +26,8 @@ namespace MT32Emu {
 
 class LA32Ramp;
 class Partial;
+class StateReader;
+class StateWriter;
 struct Tables;
 
 class TVF {
@@ -57,6 +59,10 @@ public:
 	Bit8u getBaseCutoff() const;
 	void handleInterrupt();
 	void startDecay();
+
+	void saveState(StateWriter &writer) const;
+	// The parameters of an active partial must be present in the loaded state, or else the reader enters failed state.
+	void loadState(StateReader &reader, bool partialActive);
 }; // class TVF
 
 } // namespace MT32Emu
@@ -23,6 +23,7 @@
 #include "Part.h"
 #include "Partial.h"
 #include "Poly.h"
+#include "StateStream.h"
 #include "Synth.h"
 #include "TVA.h"
 
@@ -371,4 +372,43 @@ void TVP::process() {
 	updatePitch();
 }
 
+void TVP::saveState(StateWriter &writer) const {
+	writer.writePart(part);
+	writer.writeRAMPointer(partialParam);
+	writer.writeRAMPointer(patchTemp);
+	writer.write(processTimerIncrement);
+	writer.write(counter);
+	writer.write(timeElapsed);
+	writer.write(phase);
+	writer.write(basePitch);
+	writer.write(targetPitchOffsetWithoutLFO);
+	writer.write(currentPitchOffset);
+	writer.write(lfoPitchOffset);
+	writer.write(timeKeyfollowSubtraction);
+	writer.write(pitchOffsetChangePerBigTick);
+	writer.write(targetPitchOffsetReachedBigTick);
+	writer.write(shifts);
+	writer.write(pitch);
+}
+
+void TVP::loadState(StateReader &reader, bool partialActive) {
+	part = reader.readPart();
+	partialParam = reader.readRAMPointer<TimbreParam::PartialParam>();
+	patchTemp = reader.readRAMPointer<MemParams::PatchTemp>();
+	reader.read(processTimerIncrement);
+	reader.read(counter);
+	reader.read(timeElapsed);
+	reader.read(phase);
+	reader.read(basePitch);
+	reader.read(targetPitchOffsetWithoutLFO);
+	reader.read(currentPitchOffset);
+	reader.read(lfoPitchOffset);
+	reader.read(timeKeyfollowSubtraction);
+	reader.read(pitchOffsetChangePerBigTick);
+	reader.read(targetPitchOffsetReachedBigTick);
+	reader.read(shifts);
+	reader.read(pitch);
+	if (partialActive && (part == NULL || partialParam == NULL || patchTemp == NULL)) reader.fail();
+}
+
 } // namespace MT32Emu
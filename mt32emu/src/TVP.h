@@ -26,6 +26,8 @@ namespace MT32Emu {
 
 class Part;
 class Partial;
+class StateReader;
+class StateWriter;
 
 class TVP {
 private:
@@ -67,6 +69,10 @@ public:
 	Bit32u getBasePitch() const;
 	Bit16u nextPitch();
 	void startDecay();
+
+	void saveState(StateWriter &writer) const;
+	// The parameters of an active partial must be present in the loaded state, or else the reader enters failed state.
+	void loadState(StateReader &reader, bool partialActive);
 }; // class TVP
 
 } // namespace MT32Emu
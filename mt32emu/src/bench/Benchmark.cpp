@@ -0,0 +1,541 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Benchmark suite for the rendering pipeline of the emulation engine.
+ * Each benchmark case processes audio in blocks until the specified amount of CPU time elapses, and reports
+ * the throughput in samples (or stereo frames) per second. The results are printed in CSV format to stdout,
+ * so that they can be easily compared between builds to detect performance regressions.
+ * Unless real ROM images are specified in the command line, the fake ROMs used by the unit tests are loaded.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include "../Analog.h"
+#include "../BReverbModel.h"
+#include "../FileStream.h"
+#include "../LA32WaveGenerator.h"
+#include "../LA32FloatWaveGenerator.h"
+#include "../ROMInfo.h"
+#include "../SampleRateConverter.h"
+#include "../Synth.h"
+#include "../Tables.h"
+#include "../srchelper/srctools/include/ResamplerModel.h"
+
+#include "../test/FakeROMs.h"
+
+namespace MT32Emu {
+
+namespace Bench {
+
+static const Bit32u BLOCK_LENGTH = MAX_SAMPLES_PER_RUN;
+
+static const char * const RENDERER_TYPE_NAMES[] = {"int", "float"};
+static const char * const REVERB_MODE_NAMES[] = {"room", "hall", "plate", "tap-delay"};
+static const char * const ANALOG_OUTPUT_MODE_NAMES[] = {"digital-only", "coarse", "accurate", "oversampled"};
+static const char * const SRC_QUALITY_NAMES[] = {"fastest", "fast", "good", "best"};
+
+struct Options {
+	double minCPUSeconds;
+	const char *filter;
+	const char *controlROMFileName;
+	const char *pcmROMFileName;
+};
+
+// A benchmark case processes a single block of audio per call to run() and returns the number of samples processed.
+class BenchmarkCase {
+public:
+	virtual ~BenchmarkCase() {}
+	virtual Bit32u run() = 0;
+};
+
+class Runner {
+public:
+	explicit Runner(const Options &useOptions) : options(useOptions) {
+		printf("suite,case,samples,cpu_seconds,samples_per_second\n");
+	}
+
+	bool isSelected(const char *suite, const char *caseName) const {
+		if (options.filter == NULL) return true;
+		char fullName[128];
+		sprintf(fullName, "%s/%s", suite, caseName);
+		return strstr(fullName, options.filter) != NULL;
+	}
+
+	void run(const char *suite, const char *caseName, BenchmarkCase &benchmarkCase) const {
+		// Warm up caches and let the lazily initialised tables settle before measuring.
+		benchmarkCase.run();
+
+		double sampleCount = 0;
+		const clock_t startTime = clock();
+		clock_t elapsed = 0;
+		const clock_t minElapsed = clock_t(options.minCPUSeconds * CLOCKS_PER_SEC);
+		do {
+			sampleCount += benchmarkCase.run();
+			elapsed = clock() - startTime;
+		} while (elapsed < minElapsed);
+
+		const double seconds = double(elapsed) / CLOCKS_PER_SEC;
+		printf("%s,%s,%.0f,%.6f,%.0f\n", suite, caseName, sampleCount, seconds, sampleCount / seconds);
+		fflush(stdout);
+	}
+
+private:
+	const Options &options;
+};
+
+// Fills the buffer with deterministic pseudo-random noise of moderate amplitude.
+static void fillNoise(IntSample *buffer, Bit32u length) {
+	Bit32u seed = 12345;
+	for (Bit32u i = 0; i < length; i++) {
+		seed = seed * 1103515245 + 12345;
+		buffer[i] = IntSample(Bit32s(seed >> 16 & 0x3FFF) - 0x2000);
+	}
+}
+
+static void fillNoise(FloatSample *buffer, Bit32u length) {
+	Bit32u seed = 12345;
+	for (Bit32u i = 0; i < length; i++) {
+		seed = seed * 1103515245 + 12345;
+		buffer[i] = (Bit32s(seed >> 16 & 0x3FFF) - 0x2000) / 32768.0f;
+	}
+}
+
+// Generates a single sawtooth partial with a slowly sweeping pitch and cutoff, which exercises the LA32 wave generator
+// the same way as an active synth partial does, yet without TVA / TVP / TVF overhead.
+template <class LA32PairImpl, class Sample>
+class LA32PartialCase : public BenchmarkCase {
+public:
+	LA32PartialCase() : pitch(0) {
+		pair.init(false, false);
+		pair.initSynth(LA32PartialPair::MASTER, true, 64, 20);
+		pair.deactivate(LA32PartialPair::SLAVE);
+	}
+
+	Bit32u run() {
+		for (Bit32u i = 0; i < BLOCK_LENGTH; i++) {
+			pitch = (pitch + 1) & 0x7FFF;
+			pair.generateNextSample(LA32PartialPair::MASTER, 0x1000000, Bit16u(0x8000 + (pitch >> 2)), (0x60 + (pitch >> 10)) << 18);
+			buffer[i] = pair.nextOutSample();
+		}
+		return BLOCK_LENGTH;
+	}
+
+private:
+	LA32PairImpl pair;
+	Bit32u pitch;
+	Sample buffer[BLOCK_LENGTH];
+};
+
+template <class Sample>
+class ReverbCase : public BenchmarkCase {
+public:
+	ReverbCase(ReverbMode mode, RendererType rendererType) :
+		reverbModel(BReverbModel::createBReverbModel(mode, false, rendererType)),
+		delayLineMemory(new Bit8u[reverbModel->getDelayLineMemorySize()])
+	{
+		reverbModel->open(delayLineMemory);
+		reverbModel->setParameters(5, 7);
+		fillNoise(inLeft, BLOCK_LENGTH);
+		fillNoise(inRight, BLOCK_LENGTH);
+	}
+
+	~ReverbCase() {
+		reverbModel->close();
+		delete reverbModel;
+		delete[] delayLineMemory;
+	}
+
+	Bit32u run() {
+		reverbModel->process(inLeft, inRight, outLeft, outRight, BLOCK_LENGTH);
+		return BLOCK_LENGTH;
+	}
+
+private:
+	BReverbModel * const reverbModel;
+	Bit8u * const delayLineMemory;
+	Sample inLeft[BLOCK_LENGTH], inRight[BLOCK_LENGTH];
+	Sample outLeft[BLOCK_LENGTH], outRight[BLOCK_LENGTH];
+};
+
+// Counts stereo frames produced at the output sample rate of the analog circuit emulation.
+template <class Sample>
+class AnalogCase : public BenchmarkCase {
+public:
+	AnalogCase(AnalogOutputMode mode, RendererType rendererType) :
+		analog(Analog::createAnalog(mode, false, rendererType))
+	{
+		analog->setSynthOutputGain(1.0f);
+		analog->setReverbOutputGain(1.0f, false);
+		// Oversampling requires less input samples than output samples.
+		outLength = BLOCK_LENGTH;
+		while (analog->getDACStreamsLength(outLength) > BLOCK_LENGTH) outLength >>= 1;
+		for (int i = 0; i < 6; i++) {
+			fillNoise(dacStreams[i], BLOCK_LENGTH);
+		}
+	}
+
+	~AnalogCase() {
+		delete analog;
+	}
+
+	Bit32u run() {
+		analog->process(outStream, dacStreams[0], dacStreams[1], dacStreams[2], dacStreams[3], dacStreams[4], dacStreams[5], outLength);
+		return outLength;
+	}
+
+private:
+	Analog * const analog;
+	Bit32u outLength;
+	Sample dacStreams[6][BLOCK_LENGTH];
+	Sample outStream[2 * BLOCK_LENGTH];
+};
+
+// Holds the ROM images required to open a Synth, either real ones loaded from files or the fake ones.
+class ROMs {
+public:
+	explicit ROMs(const Options &options) :
+		useFakeROMs(options.controlROMFileName == NULL), controlROMImage(NULL), pcmROMImage(NULL)
+	{
+		if (useFakeROMs) {
+			fakeROMSet.initMT32New();
+			return;
+		}
+		if (controlROMFile.open(options.controlROMFileName) && pcmROMFile.open(options.pcmROMFileName)) {
+			controlROMImage = ROMImage::makeROMImage(&controlROMFile);
+			pcmROMImage = ROMImage::makeROMImage(&pcmROMFile);
+		}
+	}
+
+	~ROMs() {
+		if (controlROMImage != NULL) ROMImage::freeROMImage(controlROMImage);
+		if (pcmROMImage != NULL) ROMImage::freeROMImage(pcmROMImage);
+	}
+
+	const ROMImage *getControlROMImage() const {
+		return useFakeROMs ? fakeROMSet.getControlROMImage() : controlROMImage;
+	}
+
+	const ROMImage *getPCMROMImage() const {
+		return useFakeROMs ? fakeROMSet.getPCMROMImage() : pcmROMImage;
+	}
+
+private:
+	const bool useFakeROMs;
+	Test::ROMSet fakeROMSet;
+	FileStream controlROMFile;
+	FileStream pcmROMFile;
+	const ROMImage *controlROMImage;
+	const ROMImage *pcmROMImage;
+};
+
+// Configures the patch & timbre temp area of the part with a timbre that consists of a single sustained synth partial.
+// Unlike the preset timbres, this doesn't rely on the PCM ROM contents, so that the load is the same with any ROMs.
+static void sendSustainedTimbreSysex(Synth &synth, Bit8u channel) {
+	static const Bit8u patchSysex[] = {
+		0x00, 0x00, 0x00,
+		0x00, 0x00, 0x18, 0x19, 0x0c, 0x00, 0x00, 0x00,
+		0x64, 0x00
+	};
+	synth.writeSysex(channel, patchSysex, sizeof patchSysex);
+	static const Bit8u timbreSysex[] = {
+		0x02, 0x00, 0x00,
+		'B', 'e', 'n', 'c', 'h', '-', 's', 'a', 'w', ' ', 0x00, 0x00, 0x01, 0x00,
+		0x18, 0x01, 0x03, 0x00, 0x00, 0x00, 0x00, 0x07,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x32,
+		0x00, 0x0b, 0x00, 0x07, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x00, 0x64, 0x32, 0x00, 0x0c, 0x00, 0x0c, 0x00,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x64, 0x64,
+		0x64, 0x64
+	};
+	synth.writeSysex(channel, timbreSysex, sizeof timbreSysex);
+}
+
+// Renders a stereo stream with the specified number of notes held, spread evenly across the melodic parts.
+// Every so often, one of the notes is released and retriggered, so that partial allocation is exercised as well.
+// When fast-forwarding, the synth advances through the same events without producing any output.
+template <class Sample>
+class SynthRenderCase : public BenchmarkCase {
+public:
+	SynthRenderCase(const ROMs &roms, RendererType rendererType, Bit32u usePolyphony, AnalogOutputMode analogOutputMode, bool useFastForward = false) :
+		polyphony(usePolyphony), fastForward(useFastForward), blockCount(0)
+	{
+		synth.selectRendererType(rendererType);
+		opened = synth.open(*roms.getControlROMImage(), *roms.getPCMROMImage(), polyphony > DEFAULT_MAX_PARTIALS ? polyphony : DEFAULT_MAX_PARTIALS, analogOutputMode);
+		if (!opened) return;
+		for (Bit8u channel = 1; channel < 9; channel++) {
+			sendSustainedTimbreSysex(synth, channel);
+		}
+		for (Bit32u note = 0; note < polyphony; note++) {
+			synth.playMsgNow(getNoteOnMessage(note, 100));
+		}
+	}
+
+	bool isOpen() const {
+		return opened;
+	}
+
+	Bit32u run() {
+		const Bit32u retriggeredNote = blockCount++ % polyphony;
+		synth.playMsgNow(getNoteOnMessage(retriggeredNote, 0));
+		synth.playMsgNow(getNoteOnMessage(retriggeredNote, 100));
+		if (fastForward) {
+			synth.fastForward(BLOCK_LENGTH);
+		} else {
+			synth.render(stereoStream, BLOCK_LENGTH);
+		}
+		return BLOCK_LENGTH;
+	}
+
+private:
+	Synth synth;
+	const Bit32u polyphony;
+	const bool fastForward;
+	Bit32u blockCount;
+	bool opened;
+	Sample stereoStream[2 * BLOCK_LENGTH];
+
+	static Bit32u getNoteOnMessage(Bit32u note, Bit8u velocity) {
+		const Bit32u channel = 1 + note % 8;
+		const Bit32u key = 36 + note / 8 * 5 + note % 8;
+		return 0x90 | channel | key << 8 | Bit32u(velocity) << 16;
+	}
+};
+
+// Replays a stretch of the synth output rendered in advance in a loop, so that only the resampling is timed.
+class PrerenderedSynthSource : public SRCTools::FloatSampleProvider {
+public:
+	static const Bit32u FRAME_COUNT = 8 * BLOCK_LENGTH;
+
+	PrerenderedSynthSource() : stereoStream(new float[2 * FRAME_COUNT]), position(0) {}
+
+	~PrerenderedSynthSource() {
+		delete[] stereoStream;
+	}
+
+	float *getStereoStream() {
+		return stereoStream;
+	}
+
+	void getOutputSamples(SRCTools::FloatSample *outBuffer, unsigned int size) {
+		while (size > 0) {
+			const Bit32u frameCount = size < FRAME_COUNT - position ? size : FRAME_COUNT - position;
+			memcpy(outBuffer, stereoStream + 2 * position, 2 * frameCount * sizeof(float));
+			outBuffer += 2 * frameCount;
+			size -= frameCount;
+			position = (position + frameCount) % FRAME_COUNT;
+		}
+	}
+
+private:
+	float * const stereoStream;
+	Bit32u position;
+};
+
+// Counts stereo frames produced at the target sample rate. The synth output is rendered once in the analog output mode
+// that suits the target sample rate best, the same way as SampleRateConverter does, and the built-in resampler
+// is then fed from that. The conversion ratio must differ from 1, or else the resampler is merely a copy.
+class SampleRateConverterCase : public BenchmarkCase {
+public:
+	SampleRateConverterCase(const ROMs &roms, double sourceSampleRate, double targetSampleRate, SamplerateConversionQuality quality) : model(NULL) {
+		Synth synth;
+		synth.selectRendererType(RendererType_FLOAT);
+		if (!synth.open(*roms.getControlROMImage(), *roms.getPCMROMImage(), SampleRateConverter::getBestAnalogOutputMode(targetSampleRate))) return;
+		if (synth.getStereoOutputSampleRate() != sourceSampleRate) return;
+		sendSustainedTimbreSysex(synth, 1);
+		synth.playMsgNow(0x7F3C91);
+		synth.render(source.getStereoStream(), PrerenderedSynthSource::FRAME_COUNT);
+		synth.close();
+		model = &SRCTools::ResamplerModel::createResamplerModel(source, sourceSampleRate, targetSampleRate, SRCTools::ResamplerModel::Quality(quality));
+	}
+
+	~SampleRateConverterCase() {
+		if (model != NULL) SRCTools::ResamplerModel::freeResamplerModel(*model, source);
+	}
+
+	bool isOpen() const {
+		return model != NULL;
+	}
+
+	Bit32u run() {
+		model->getOutputSamples(stereoStream, BLOCK_LENGTH);
+		return BLOCK_LENGTH;
+	}
+
+private:
+	PrerenderedSynthSource source;
+	SRCTools::FloatSampleProvider *model;
+	float stereoStream[2 * BLOCK_LENGTH];
+};
+
+static void runLA32Benchmarks(const Runner &runner) {
+	const Tables &tables = Tables::getInstance();
+	LA32IntPartialPair::initTables(tables);
+	LA32FloatPartialPair::initTables(tables);
+	if (runner.isSelected("la32-partial", "int")) {
+		LA32PartialCase<LA32IntPartialPair, IntSample> *benchmarkCase = new LA32PartialCase<LA32IntPartialPair, IntSample>;
+		runner.run("la32-partial", "int", *benchmarkCase);
+		delete benchmarkCase;
+	}
+	if (runner.isSelected("la32-partial", "float")) {
+		LA32PartialCase<LA32FloatPartialPair, FloatSample> *benchmarkCase = new LA32PartialCase<LA32FloatPartialPair, FloatSample>;
+		runner.run("la32-partial", "float", *benchmarkCase);
+		delete benchmarkCase;
+	}
+}
+
+template <class Sample>
+static void runReverbBenchmarks(const Runner &runner, RendererType rendererType) {
+	char caseName[64];
+	for (int mode = REVERB_MODE_ROOM; mode <= REVERB_MODE_TAP_DELAY; mode++) {
+		sprintf(caseName, "%s/%s", REVERB_MODE_NAMES[mode], RENDERER_TYPE_NAMES[rendererType]);
+		if (!runner.isSelected("reverb", caseName)) continue;
+		ReverbCase<Sample> *benchmarkCase = new ReverbCase<Sample>(ReverbMode(mode), rendererType);
+		runner.run("reverb", caseName, *benchmarkCase);
+		delete benchmarkCase;
+	}
+}
+
+template <class Sample>
+static void runAnalogBenchmarks(const Runner &runner, RendererType rendererType) {
+	char caseName[64];
+	for (int mode = AnalogOutputMode_DIGITAL_ONLY; mode <= AnalogOutputMode_OVERSAMPLED; mode++) {
+		sprintf(caseName, "%s/%s", ANALOG_OUTPUT_MODE_NAMES[mode], RENDERER_TYPE_NAMES[rendererType]);
+		if (!runner.isSelected("analog", caseName)) continue;
+		AnalogCase<Sample> *benchmarkCase = new AnalogCase<Sample>(AnalogOutputMode(mode), rendererType);
+		runner.run("analog", caseName, *benchmarkCase);
+		delete benchmarkCase;
+	}
+}
+
+static void runSampleRateConverterBenchmarks(const Runner &runner, const ROMs &roms) {
+	static const double TARGET_SAMPLE_RATE = 44100.0;
+	const double sourceSampleRate = Synth::getStereoOutputSampleRate(SampleRateConverter::getBestAnalogOutputMode(TARGET_SAMPLE_RATE));
+	if (sourceSampleRate == TARGET_SAMPLE_RATE) {
+		fprintf(stderr, "Sample rate %.0f needs no conversion, skipping SRC benchmarks\n", TARGET_SAMPLE_RATE);
+		return;
+	}
+	char suite[64];
+	sprintf(suite, "src-%.0f-to-%.0f", sourceSampleRate, TARGET_SAMPLE_RATE);
+	for (int quality = SamplerateConversionQuality_FASTEST; quality <= SamplerateConversionQuality_BEST; quality++) {
+		const char *caseName = SRC_QUALITY_NAMES[quality];
+		if (!runner.isSelected(suite, caseName)) continue;
+		SampleRateConverterCase *benchmarkCase = new SampleRateConverterCase(roms, sourceSampleRate, TARGET_SAMPLE_RATE, SamplerateConversionQuality(quality));
+		if (benchmarkCase->isOpen()) {
+			runner.run(suite, caseName, *benchmarkCase);
+		} else {
+			fprintf(stderr, "Failed to prepare synth output, skipping %s/%s\n", suite, caseName);
+		}
+		delete benchmarkCase;
+	}
+}
+
+template <class Sample>
+static void runSynthRenderBenchmarks(const Runner &runner, const ROMs &roms, RendererType rendererType) {
+	static const Bit32u POLYPHONY_LOADS[] = {1, 8, 32, 64};
+	static const Bit32u POLYPHONY_LOAD_COUNT = sizeof POLYPHONY_LOADS / sizeof POLYPHONY_LOADS[0];
+
+	char caseName[64];
+	for (Bit32u i = 0; i < POLYPHONY_LOAD_COUNT; i++) {
+		sprintf(caseName, "notes-%u/%s", POLYPHONY_LOADS[i], RENDERER_TYPE_NAMES[rendererType]);
+		if (!runner.isSelected("synth-render", caseName)) continue;
+		SynthRenderCase<Sample> *benchmarkCase = new SynthRenderCase<Sample>(roms, rendererType, POLYPHONY_LOADS[i], AnalogOutputMode_COARSE);
+		if (benchmarkCase->isOpen()) {
+			runner.run("synth-render", caseName, *benchmarkCase);
+		} else {
+			fprintf(stderr, "Failed to open synth, skipping synth-render/%s\n", caseName);
+		}
+		delete benchmarkCase;
+	}
+	for (Bit32u i = 0; i < POLYPHONY_LOAD_COUNT; i++) {
+		sprintf(caseName, "notes-%u/%s", POLYPHONY_LOADS[i], RENDERER_TYPE_NAMES[rendererType]);
+		if (!runner.isSelected("synth-fast-forward", caseName)) continue;
+		SynthRenderCase<Sample> *benchmarkCase = new SynthRenderCase<Sample>(roms, rendererType, POLYPHONY_LOADS[i], AnalogOutputMode_COARSE, true);
+		if (benchmarkCase->isOpen()) {
+			runner.run("synth-fast-forward", caseName, *benchmarkCase);
+		} else {
+			fprintf(stderr, "Failed to open synth, skipping synth-fast-forward/%s\n", caseName);
+		}
+		delete benchmarkCase;
+	}
+}
+
+static void printUsage(const char *programName) {
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"  -t <seconds>    minimum CPU time spent in each benchmark case (default: 1.0)\n"
+		"  -f <substring>  only run benchmark cases whose <suite>/<case> name contains the substring\n"
+		"  -r <control ROM file> <PCM ROM file>\n"
+		"                  use real ROM images rather than the fake ones\n",
+		programName);
+}
+
+static bool parseOptions(int argc, char *argv[], Options &options) {
+	options.minCPUSeconds = 1.0;
+	options.filter = NULL;
+	options.controlROMFileName = NULL;
+	options.pcmROMFileName = NULL;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			options.minCPUSeconds = atof(argv[++i]);
+		} else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+			options.filter = argv[++i];
+		} else if (strcmp(argv[i], "-r") == 0 && i + 2 < argc) {
+			options.controlROMFileName = argv[++i];
+			options.pcmROMFileName = argv[++i];
+		} else {
+			return false;
+		}
+	}
+	return options.minCPUSeconds > 0.0;
+}
+
+} // namespace Bench
+
+} // namespace MT32Emu
+
+using namespace MT32Emu;
+using namespace MT32Emu::Bench;
+
+int main(int argc, char *argv[]) {
+	Options options;
+	if (!parseOptions(argc, argv, options)) {
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	const ROMs roms(options);
+	if (roms.getControlROMImage() == NULL || roms.getPCMROMImage() == NULL) {
+		fprintf(stderr, "Failed to load ROM images\n");
+		return 1;
+	}
+
+	const Runner runner(options);
+	runLA32Benchmarks(runner);
+	runReverbBenchmarks<IntSample>(runner, RendererType_BIT16S);
+	runReverbBenchmarks<FloatSample>(runner, RendererType_FLOAT);
+	runAnalogBenchmarks<IntSample>(runner, RendererType_BIT16S);
+	runAnalogBenchmarks<FloatSample>(runner, RendererType_FLOAT);
+	runSampleRateConverterBenchmarks(runner, roms);
+	runSynthRenderBenchmarks<IntSample>(runner, roms, RendererType_BIT16S);
+	runSynthRenderBenchmarks<FloatSample>(runner, roms, RendererType_FLOAT);
+	return 0;
+}
@@ -20,7 +20,8 @@
 #include "../globals.h"
 #include "../Types.h"
 #include "../File.h"
-#include "../FileStream.h"
+#include "../MappedFile.h"
+#include "../ROMIndex.h"
 #include "../ROMInfo.h"
 #include "../Synth.h"
 #include "../MidiStreamParser.h"
@@ -140,7 +141,36 @@ static const mt32emu_service_i_v7 SERVICE_VTABLE = {
 	mt32emu_set_master_volume_override,
 	mt32emu_get_master_volume_override,
 	mt32emu_dump_sysex_bank,
-	mt32emu_apply_sysex_bank
+	mt32emu_apply_sysex_bank,
+	mt32emu_set_state_snapshots_enabled,
+	mt32emu_is_state_snapshots_enabled,
+	mt32emu_get_state_snapshot,
+	mt32emu_render_bit16s_while_partials_active,
+	mt32emu_render_float_while_partials_active,
+	mt32emu_render_bit16s_streams_while_partials_active,
+	mt32emu_render_float_streams_while_partials_active,
+	mt32emu_render_bit16s_while_active,
+	mt32emu_render_float_while_active,
+	mt32emu_render_bit16s_streams_while_active,
+	mt32emu_render_float_streams_while_active,
+	mt32emu_identify_rom_file_using_sha1_sidecar,
+	mt32emu_set_rom_sha1_sidecars_enabled,
+	mt32emu_load_rom_index,
+	mt32emu_save_rom_index,
+	mt32emu_identify_rom_file_using_index,
+	mt32emu_save_state,
+	mt32emu_load_state,
+	mt32emu_fast_forward,
+	mt32emu_get_statistics,
+	mt32emu_reset_statistics,
+	mt32emu_render_bit16s_planar,
+	mt32emu_render_float_planar,
+	mt32emu_play_referenced_sysex_at,
+	mt32emu_get_pending_referenced_sysex_count,
+	mt32emu_set_large_pages_enabled,
+	mt32emu_is_large_pages_enabled,
+	mt32emu_set_memory_locking_enabled,
+	mt32emu_is_memory_locking_enabled
 };
 
 } // namespace MT32Emu
@@ -154,6 +184,9 @@ struct mt32emu_data {
 	Bit32u partialCount;
 	AnalogOutputMode analogOutputMode;
 	SamplerateConversionState *srcState;
+	bool romSHA1SidecarsEnabled;
+	ROMIndex *romIndex;
+	char *romIndexFilename;
 };
 
 // Internal C++ utility stuff
@@ -463,21 +496,47 @@ static mt32emu_return_code addROMFiles(mt32emu_data *data, File *file1, File *fi
 	}
 }
 
-static mt32emu_return_code createFileStream(const char *filename, FileStream *&fileStream) {
+static mt32emu_return_code createROMFile(const char *filename, bool useSHA1Sidecar, ROMIndex *romIndex, MappedFile *&romFile) {
 	mt32emu_return_code rc;
-	fileStream = new FileStream;
-	if (!fileStream->open(filename)) {
+	romFile = new MappedFile;
+	if (!romFile->open(filename)) {
 		rc = MT32EMU_RC_FILE_NOT_FOUND;
-	} else if (fileStream->getSize() == 0) {
+	} else if (romFile->getSize() == 0) {
 		rc = MT32EMU_RC_FILE_NOT_LOADED;
 	} else {
+		if (useSHA1Sidecar) romFile->loadSHA1Sidecar(filename);
+		if (romIndex != NULL) romIndex->indexFile(*romFile, filename);
 		return MT32EMU_RC_OK;
 	}
-	delete fileStream;
-	fileStream = NULL;
+	delete romFile;
+	romFile = NULL;
 	return rc;
 }
 
+static mt32emu_return_code identifyROMFile(mt32emu_rom_info *rom_info, const char *filename, const char *machine_id, bool useSHA1Sidecar, ROMIndex *romIndex) {
+	MappedFile *romFile;
+	mt32emu_return_code rc = createROMFile(filename, useSHA1Sidecar, romIndex, romFile);
+	if (romFile == NULL) return rc;
+	rc = identifyROM(rom_info, romFile, machine_id);
+	delete romFile;
+	return rc;
+}
+
+// The sample rate converter only produces interleaved output, so it is split into the channels chunk by chunk.
+template <class Sample>
+static void renderResampledPlanar(SampleRateConverter &src, Sample *leftStream, Sample *rightStream, Bit32u len) {
+	Sample buffer[MAX_SAMPLES_PER_RUN << 1];
+	while (len > 0) {
+		Bit32u thisPassLen = len > MAX_SAMPLES_PER_RUN ? MAX_SAMPLES_PER_RUN : len;
+		src.getOutputSamples(buffer, thisPassLen);
+		for (const Sample *bufferPtr = buffer, *bufferEnd = buffer + (thisPassLen << 1); bufferPtr < bufferEnd;) {
+			*(leftStream++) = *(bufferPtr++);
+			*(rightStream++) = *(bufferPtr++);
+		}
+		len -= thisPassLen;
+	}
+}
+
 } // namespace MT32Emu
 
 // C-visible implementation
@@ -553,12 +612,7 @@ mt32emu_return_code MT32EMU_C_CALL mt32emu_identify_rom_data(mt32emu_rom_info *r
 }
 
 mt32emu_return_code MT32EMU_C_CALL mt32emu_identify_rom_file(mt32emu_rom_info *rom_info, const char *filename, const char *machine_id) {
-	FileStream *fs;
-	mt32emu_return_code rc = createFileStream(filename, fs);
-	if (fs == NULL) return rc;
-	rc = identifyROM(rom_info, fs, machine_id);
-	delete fs;
-	return rc;
+	return identifyROMFile(rom_info, filename, machine_id, false, NULL);
 }
 
 mt32emu_context MT32EMU_C_CALL mt32emu_create_context(mt32emu_report_handler_i report_handler, void *instance_data) {
@@ -575,6 +629,9 @@ mt32emu_context MT32EMU_C_CALL mt32emu_create_context(mt32emu_report_handler_i r
 	data->pcmROMImage = NULL;
 	data->partialCount = DEFAULT_MAX_PARTIALS;
 	data->analogOutputMode = AnalogOutputMode_COARSE;
+	data->romSHA1SidecarsEnabled = false;
+	data->romIndex = NULL;
+	data->romIndexFilename = NULL;
 
 	data->srcState = new SamplerateConversionState;
 	data->srcState->outputSampleRate = 0.0;
@@ -608,6 +665,10 @@ void MT32EMU_C_CALL mt32emu_free_context(mt32emu_context data) {
 	data->synth = NULL;
 	delete data->reportHandler;
 	data->reportHandler = NULL;
+	delete data->romIndex;
+	data->romIndex = NULL;
+	delete[] data->romIndexFilename;
+	data->romIndexFilename = NULL;
 	delete data;
 }
 
@@ -617,10 +678,10 @@ mt32emu_return_code MT32EMU_C_CALL mt32emu_add_rom_data(mt32emu_context context,
 }
 
 mt32emu_return_code MT32EMU_C_CALL mt32emu_add_rom_file(mt32emu_context context, const char *filename) {
-	FileStream *fs;
-	mt32emu_return_code rc = createFileStream(filename, fs);
-	if (fs != NULL) rc = addROMFiles(context, fs);
-	if (rc <= MT32EMU_RC_OK) delete fs;
+	MappedFile *file;
+	mt32emu_return_code rc = createROMFile(filename, context->romSHA1SidecarsEnabled, context->romIndex, file);
+	if (file != NULL) rc = addROMFiles(context, file);
+	if (rc <= MT32EMU_RC_OK) delete file;
 	return rc;
 }
 
@@ -634,16 +695,16 @@ mt32emu_return_code MT32EMU_C_CALL mt32emu_merge_and_add_rom_data(mt32emu_contex
 }
 
 mt32emu_return_code MT32EMU_C_CALL mt32emu_merge_and_add_rom_files(mt32emu_context context, const char *part1_filename, const char *part2_filename) {
-	FileStream *fs1;
-	mt32emu_return_code rc = createFileStream(part1_filename, fs1);
-	if (fs1 != NULL) {
-		FileStream *fs2;
-		rc = createFileStream(part2_filename, fs2);
-		if (fs2 != NULL) {
-			rc = addROMFiles(context, fs1, fs2);
-			delete fs2;
+	MappedFile *file1;
+	mt32emu_return_code rc = createROMFile(part1_filename, context->romSHA1SidecarsEnabled, context->romIndex, file1);
+	if (file1 != NULL) {
+		MappedFile *file2;
+		rc = createROMFile(part2_filename, context->romSHA1SidecarsEnabled, context->romIndex, file2);
+		if (file2 != NULL) {
+			rc = addROMFiles(context, file1, file2);
+			delete file2;
 		}
-		delete fs1;
+		delete file1;
 	}
 	return rc;
 }
@@ -652,11 +713,11 @@ mt32emu_return_code MT32EMU_C_CALL mt32emu_add_machine_rom_file(mt32emu_context
 	const MachineConfiguration *machineConfiguration = findMachineConfiguration(machine_id);
 	if (machineConfiguration == NULL) return MT32EMU_RC_MACHINE_NOT_IDENTIFIED;
 
-	FileStream *fs;
-	mt32emu_return_code rc = createFileStream(filename, fs);
-	if (fs == NULL) return rc;
-	rc = addROMFiles(context, fs, NULL, machineConfiguration);
-	if (rc <= MT32EMU_RC_OK) delete fs;
+	MappedFile *file;
+	mt32emu_return_code rc = createROMFile(filename, context->romSHA1SidecarsEnabled, context->romIndex, file);
+	if (file == NULL) return rc;
+	rc = addROMFiles(context, file, NULL, machineConfiguration);
+	if (rc <= MT32EMU_RC_OK) delete file;
 	return rc;
 }
 
@@ -820,6 +881,14 @@ mt32emu_bit32u MT32EMU_C_CALL mt32emu_apply_sysex_bank(mt32emu_const_context con
 	return context->synth->applySysexBank(sysex_bank, size);
 }
 
+mt32emu_bit32u MT32EMU_C_CALL mt32emu_save_state(mt32emu_const_context context, mt32emu_bit8u *state_buffer, mt32emu_bit32u size) {
+	return context->synth->saveState(state_buffer, size);
+}
+
+mt32emu_return_code MT32EMU_C_CALL mt32emu_load_state(mt32emu_const_context context, const mt32emu_bit8u *state_buffer, mt32emu_bit32u size) {
+	return context->synth->loadState(state_buffer, size) ? MT32EMU_RC_OK : MT32EMU_RC_FAILED;
+}
+
 void MT32EMU_C_CALL mt32emu_set_reverb_enabled(mt32emu_const_context context, const mt32emu_boolean reverb_enabled) {
 	context->synth->setReverbEnabled(reverb_enabled != MT32EMU_BOOL_FALSE);
 }
@@ -1016,6 +1085,156 @@ mt32emu_boolean MT32EMU_C_CALL mt32emu_is_default_display_old_mt32_compatible(mt
 	return context->synth->isDefaultDisplayOldMT32Compatible() ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE;
 }
 
+void MT32EMU_C_CALL mt32emu_set_state_snapshots_enabled(mt32emu_const_context context, const mt32emu_boolean enabled) {
+	context->synth->setStateSnapshotsEnabled(enabled != MT32EMU_BOOL_FALSE);
+}
+
+mt32emu_boolean MT32EMU_C_CALL mt32emu_is_state_snapshots_enabled(mt32emu_const_context context) {
+	return context->synth->isStateSnapshotsEnabled() ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE;
+}
+
+mt32emu_boolean MT32EMU_C_CALL mt32emu_get_state_snapshot(mt32emu_const_context context, mt32emu_state_snapshot *snapshot) {
+	StateSnapshot cppSnapshot;
+	cppSnapshot.keys = snapshot->keys;
+	cppSnapshot.velocities = snapshot->velocities;
+	cppSnapshot.partialStates = NULL;
+	cppSnapshot.packedPartialStates = snapshot->partial_states;
+	if (!context->synth->getStateSnapshot(cppSnapshot)) return MT32EMU_BOOL_FALSE;
+	snapshot->rendered_sample_count = cppSnapshot.renderedSampleCount;
+	snapshot->part_states = cppSnapshot.partStates;
+	snapshot->midi_message_led_state = cppSnapshot.midiMessageLEDState ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE;
+	memcpy(snapshot->lcd_state, cppSnapshot.lcdState, sizeof snapshot->lcd_state);
+	memcpy(snapshot->playing_note_counts, cppSnapshot.playingNoteCounts, sizeof snapshot->playing_note_counts);
+	return MT32EMU_BOOL_TRUE;
+}
+
+mt32emu_boolean MT32EMU_C_CALL mt32emu_get_statistics(mt32emu_const_context context, mt32emu_statistics *statistics) {
+	Statistics cppStatistics;
+	if (!context->synth->getStatistics(cppStatistics)) return MT32EMU_BOOL_FALSE;
+	statistics->rendered_sample_count = cppStatistics.renderedSampleCount;
+	memcpy(statistics->peak_active_partial_counts, cppStatistics.peakActivePartialCounts, sizeof statistics->peak_active_partial_counts);
+	memcpy(statistics->average_active_partial_counts, cppStatistics.averageActivePartialCounts, sizeof statistics->average_active_partial_counts);
+	statistics->peak_active_partial_count = cppStatistics.peakActivePartialCount;
+	statistics->silenced_poly_count = cppStatistics.silencedPolyCount;
+	statistics->ignored_note_on_count = cppStatistics.ignoredNoteOnCount;
+	statistics->midi_queue_high_water_mark = cppStatistics.midiQueueHighWaterMark;
+	statistics->render_pass_count = cppStatistics.renderPassCount;
+	statistics->total_render_pass_duration = cppStatistics.totalRenderPassDuration;
+	statistics->max_render_pass_duration = cppStatistics.maxRenderPassDuration;
+	statistics->total_midi_processing_duration = cppStatistics.totalMidiProcessingDuration;
+	statistics->total_partial_rendering_duration = cppStatistics.totalPartialRenderingDuration;
+	statistics->total_reverb_duration = cppStatistics.totalReverbDuration;
+	statistics->total_analog_duration = cppStatistics.totalAnalogDuration;
+	return MT32EMU_BOOL_TRUE;
+}
+
+void MT32EMU_C_CALL mt32emu_reset_statistics(mt32emu_const_context context) {
+	context->synth->resetStatistics();
+}
+
+void MT32EMU_C_CALL mt32emu_render_bit16s_planar(mt32emu_const_context context, mt32emu_bit16s *left_stream, mt32emu_bit16s *right_stream, mt32emu_bit32u len) {
+	if (context->srcState->src != NULL) {
+		renderResampledPlanar(*context->srcState->src, left_stream, right_stream, len);
+	} else {
+		context->synth->renderPlanar(left_stream, right_stream, len);
+	}
+}
+
+void MT32EMU_C_CALL mt32emu_render_float_planar(mt32emu_const_context context, float *left_stream, float *right_stream, mt32emu_bit32u len) {
+	if (context->srcState->src != NULL) {
+		renderResampledPlanar(*context->srcState->src, left_stream, right_stream, len);
+	} else {
+		context->synth->renderPlanar(left_stream, right_stream, len);
+	}
+}
+
+mt32emu_return_code MT32EMU_C_CALL mt32emu_play_referenced_sysex_at(mt32emu_const_context context, const mt32emu_bit8u *sysex, mt32emu_bit32u len, mt32emu_bit32u timestamp) {
+	if (!context->synth->isOpen()) return MT32EMU_RC_NOT_OPENED;
+	return (context->synth->playReferencedSysex(sysex, len, timestamp)) ? MT32EMU_RC_OK : MT32EMU_RC_QUEUE_FULL;
+}
+
+mt32emu_bit32u MT32EMU_C_CALL mt32emu_get_pending_referenced_sysex_count(mt32emu_const_context context) {
+	return context->synth->getPendingReferencedSysexCount();
+}
+
+void MT32EMU_C_CALL mt32emu_set_large_pages_enabled(mt32emu_const_context context, const mt32emu_boolean enabled) {
+	context->synth->setLargePagesEnabled(enabled != MT32EMU_BOOL_FALSE);
+}
+
+mt32emu_boolean MT32EMU_C_CALL mt32emu_is_large_pages_enabled(mt32emu_const_context context) {
+	return context->synth->isLargePagesEnabled() ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE;
+}
+
+void MT32EMU_C_CALL mt32emu_set_memory_locking_enabled(mt32emu_const_context context, const mt32emu_boolean enabled) {
+	context->synth->setMemoryLockingEnabled(enabled != MT32EMU_BOOL_FALSE);
+}
+
+mt32emu_boolean MT32EMU_C_CALL mt32emu_is_memory_locking_enabled(mt32emu_const_context context) {
+	return context->synth->isMemoryLockingEnabled() ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE;
+}
+
+mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_bit16s_while_partials_active(mt32emu_const_context context, mt32emu_bit16s *stream, mt32emu_bit32u len) {
+	return context->synth->renderWhilePartialsActive(stream, len);
+}
+
+mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_float_while_partials_active(mt32emu_const_context context, float *stream, mt32emu_bit32u len) {
+	return context->synth->renderWhilePartialsActive(stream, len);
+}
+
+mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_bit16s_streams_while_partials_active(mt32emu_const_context context, const mt32emu_dac_output_bit16s_streams *streams, mt32emu_bit32u len) {
+	return context->synth->renderStreamsWhilePartialsActive(*reinterpret_cast<const DACOutputStreams<Bit16s> *>(streams), len);
+}
+
+mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_float_streams_while_partials_active(mt32emu_const_context context, const mt32emu_dac_output_float_streams *streams, mt32emu_bit32u len) {
+	return context->synth->renderStreamsWhilePartialsActive(*reinterpret_cast<const DACOutputStreams<float> *>(streams), len);
+}
+
+mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_bit16s_while_active(mt32emu_const_context context, mt32emu_bit16s *stream, mt32emu_bit32u len) {
+	return context->synth->renderWhileActive(stream, len);
+}
+
+mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_float_while_active(mt32emu_const_context context, float *stream, mt32emu_bit32u len) {
+	return context->synth->renderWhileActive(stream, len);
+}
+
+mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_bit16s_streams_while_active(mt32emu_const_context context, const mt32emu_dac_output_bit16s_streams *streams, mt32emu_bit32u len) {
+	return context->synth->renderStreamsWhileActive(*reinterpret_cast<const DACOutputStreams<Bit16s> *>(streams), len);
+}
+
+mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_float_streams_while_active(mt32emu_const_context context, const mt32emu_dac_output_float_streams *streams, mt32emu_bit32u len) {
+	return context->synth->renderStreamsWhileActive(*reinterpret_cast<const DACOutputStreams<float> *>(streams), len);
+}
+
+void MT32EMU_C_CALL mt32emu_fast_forward(mt32emu_const_context context, mt32emu_bit32u len) {
+	context->synth->fastForward(len);
+}
+
+mt32emu_return_code MT32EMU_C_CALL mt32emu_identify_rom_file_using_sha1_sidecar(mt32emu_rom_info *rom_info, const char *filename, const char *machine_id) {
+	return identifyROMFile(rom_info, filename, machine_id, true, NULL);
+}
+
+void MT32EMU_C_CALL mt32emu_set_rom_sha1_sidecars_enabled(mt32emu_context context, const mt32emu_boolean enabled) {
+	context->romSHA1SidecarsEnabled = enabled != MT32EMU_BOOL_FALSE;
+}
+
+mt32emu_return_code MT32EMU_C_CALL mt32emu_load_rom_index(mt32emu_context context, const char *index_filename) {
+	if (context->romIndex == NULL) context->romIndex = new ROMIndex;
+	delete[] context->romIndexFilename;
+	size_t filenameSize = strlen(index_filename) + 1;
+	context->romIndexFilename = new char[filenameSize];
+	memcpy(context->romIndexFilename, index_filename, filenameSize);
+	return context->romIndex->load(index_filename) ? MT32EMU_RC_OK : MT32EMU_RC_FILE_NOT_LOADED;
+}
+
+mt32emu_return_code MT32EMU_C_CALL mt32emu_save_rom_index(mt32emu_context context) {
+	if (context->romIndex == NULL || !context->romIndex->save(context->romIndexFilename)) return MT32EMU_RC_FAILED;
+	return MT32EMU_RC_OK;
+}
+
+mt32emu_return_code MT32EMU_C_CALL mt32emu_identify_rom_file_using_index(mt32emu_context context, mt32emu_rom_info *rom_info, const char *filename, const char *machine_id) {
+	return identifyROMFile(rom_info, filename, machine_id, context->romSHA1SidecarsEnabled, context->romIndex);
+}
+
 } // extern "C"
 
 #ifdef MT32EMU_WITH_TESTING
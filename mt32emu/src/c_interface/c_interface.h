@@ -124,6 +124,12 @@ MT32EMU_EXPORT_V(2.5) mt32emu_return_code MT32EMU_C_CALL mt32emu_identify_rom_da
  * Returns MT32EMU_RC_OK upon success or a negative error code otherwise.
  */
 MT32EMU_EXPORT_V(2.5) mt32emu_return_code MT32EMU_C_CALL mt32emu_identify_rom_file(mt32emu_rom_info *rom_info, const char *filename, const char *machine_id);
+/**
+ * Same as mt32emu_identify_rom_file() but if a sidecar file exists, named as the ROM file with ".sha1" appended, the SHA1 digest
+ * is read from it rather than computed from the file contents. The sidecar must begin with the digest as 40 hexadecimal digits,
+ * e.g. as produced by the sha1sum utility. The digest is trusted and never verified against the file contents.
+ */
+MT32EMU_EXPORT_V(2.8) mt32emu_return_code MT32EMU_C_CALL mt32emu_identify_rom_file_using_sha1_sidecar(mt32emu_rom_info *rom_info, const char *filename, const char *machine_id);
 
 /* == Context-dependent functions == */
 
@@ -192,6 +198,35 @@ MT32EMU_EXPORT_V(2.5) mt32emu_return_code MT32EMU_C_CALL mt32emu_merge_and_add_r
  */
 MT32EMU_EXPORT_V(2.5) mt32emu_return_code MT32EMU_C_CALL mt32emu_add_machine_rom_file(mt32emu_context context, const char *machine_id, const char *filename);
 
+/**
+ * Enables or disables use of SHA1 sidecar files when ROM files are loaded into the emulation context. When enabled, the functions
+ * that load ROM files read the SHA1 digest from a sidecar file, named as the ROM file with ".sha1" appended, if it exists, rather
+ * than computing it. See mt32emu_identify_rom_file_using_sha1_sidecar() for details. Disabled by default.
+ */
+MT32EMU_EXPORT_V(2.8) void MT32EMU_C_CALL mt32emu_set_rom_sha1_sidecars_enabled(mt32emu_context context, const mt32emu_boolean enabled);
+
+/**
+ * Enables the ROM identification index and loads its contents from the specified index file. The index remembers SHA1 digests
+ * of ROM files along with their sizes and modification times, so that the functions that load ROM files into the context
+ * and mt32emu_identify_rom_file_using_index() only compute digests of ROM files that are new or have changed since they
+ * were recorded. The index is enabled even if the index file cannot be read, so that it can be created with
+ * mt32emu_save_rom_index().
+ * Returns MT32EMU_RC_OK upon success, MT32EMU_RC_FILE_NOT_LOADED if the index file is missing or malformed.
+ */
+MT32EMU_EXPORT_V(2.8) mt32emu_return_code MT32EMU_C_CALL mt32emu_load_rom_index(mt32emu_context context, const char *index_filename);
+/**
+ * Writes the ROM identification index back to the index file it has been loaded from, provided that new digests have been
+ * recorded meanwhile. The file is replaced atomically where possible, so it can be safely shared by concurrently running
+ * processes.
+ * Returns MT32EMU_RC_OK upon success or if the index is unchanged, MT32EMU_RC_FAILED if the index is not enabled or writing fails.
+ */
+MT32EMU_EXPORT_V(2.8) mt32emu_return_code MT32EMU_C_CALL mt32emu_save_rom_index(mt32emu_context context);
+/**
+ * Same as mt32emu_identify_rom_file() but makes use of the ROM identification index enabled in the context, if any,
+ * and SHA1 sidecar files if enabled with mt32emu_set_rom_sha1_sidecars_enabled().
+ */
+MT32EMU_EXPORT_V(2.8) mt32emu_return_code MT32EMU_C_CALL mt32emu_identify_rom_file_using_index(mt32emu_context context, mt32emu_rom_info *rom_info, const char *filename, const char *machine_id);
+
 /**
  * Fills in mt32emu_rom_info structure with identifiers and descriptions of control and PCM ROM files identified and added to the synth context.
  * If one of the ROM files is not loaded and identified yet, NULL is returned in the corresponding fields of the mt32emu_rom_info structure.
@@ -413,6 +448,24 @@ MT32EMU_EXPORT_V(2.8) mt32emu_bit32u MT32EMU_C_CALL mt32emu_dump_sysex_bank(mt32
  */
 MT32EMU_EXPORT_V(2.8) mt32emu_bit32u MT32EMU_C_CALL mt32emu_apply_sysex_bank(mt32emu_const_context context, const mt32emu_bit8u *sysex_bank, mt32emu_bit32u size);
 
+/**
+ * Stores the complete internal state of the emulated synth into the provided array, so that rendering can be later continued
+ * bit-exactly from this point, either by the same synth or by another synth opened with the same ROMs, partial count,
+ * renderer type, analog output mode and reverb compatibility mode. The state is only meaningful to the same build
+ * of the library. Client settings, such as output gains and overrides, as well as the state of the sample rate converter
+ * aren't included.
+ * Returns the full length of the state in bytes. This function can be used to retrieve the required size of the state
+ * by supplying NULL state_buffer or zero size arguments, in which case it does nothing else. Returns 0 if the synth is closed.
+ * Must not be invoked concurrently with rendering or MIDI input.
+ */
+MT32EMU_EXPORT_V(2.8) mt32emu_bit32u MT32EMU_C_CALL mt32emu_save_state(mt32emu_const_context context, mt32emu_bit8u *state_buffer, mt32emu_bit32u size);
+/**
+ * Restores the internal state of the emulated synth previously stored by mt32emu_save_state().
+ * Returns MT32EMU_RC_FAILED if the synth is closed or the state is incompatible or corrupted. In the latter case, the synth
+ * may be reset. Must not be invoked concurrently with rendering or MIDI input.
+ */
+MT32EMU_EXPORT_V(2.8) mt32emu_return_code MT32EMU_C_CALL mt32emu_load_state(mt32emu_const_context context, const mt32emu_bit8u *state_buffer, mt32emu_bit32u size);
+
 /** Allows to disable wet reverb output altogether. */
 MT32EMU_EXPORT void MT32EMU_C_CALL mt32emu_set_reverb_enabled(mt32emu_const_context context, const mt32emu_boolean reverb_enabled);
 /** Returns whether wet reverb output is enabled. */
@@ -438,9 +491,9 @@ MT32EMU_EXPORT mt32emu_boolean MT32EMU_C_CALL mt32emu_is_mt32_reverb_compatibili
 MT32EMU_EXPORT mt32emu_boolean MT32EMU_C_CALL mt32emu_is_default_reverb_mt32_compatible(mt32emu_const_context context);
 
 /**
- * If enabled, reverb buffers for all modes are kept around allocated all the time to avoid memory
- * allocating/freeing in the rendering thread, which may be required for realtime operation.
- * Otherwise, reverb buffers that are not in use are deleted to save memory (the default behaviour).
+ * Deprecated since 2.8: has no effect. Reverb buffers are now placed into a memory pool allocated when the synth
+ * is opened, which is large enough to accommodate two reverb modes at once. Hence, switching the reverb mode never
+ * involves memory allocating/freeing in the rendering thread, while the buffers for all modes are not kept around.
  */
 MT32EMU_EXPORT void MT32EMU_C_CALL mt32emu_preallocate_reverb_memory(mt32emu_const_context context, const mt32emu_boolean enabled);
 
@@ -671,6 +724,121 @@ MT32EMU_EXPORT_V(2.6) mt32emu_boolean MT32EMU_C_CALL mt32emu_is_display_old_mt32
  */
 MT32EMU_EXPORT_V(2.6) mt32emu_boolean MT32EMU_C_CALL mt32emu_is_default_display_old_mt32_compatible(mt32emu_const_context context);
 
+/**
+ * Enables or disables publishing of the synth state snapshots by the rendering thread (disabled by default).
+ * When enabled, the synth captures its state at the end of each call to one of render functions, so that a consistent snapshot
+ * can be retrieved via mt32emu_get_state_snapshot() from any thread without synchronisation with the rendering thread.
+ * This setting takes effect upon the next call to mt32emu_open_synth().
+ */
+MT32EMU_EXPORT_V(2.8) void MT32EMU_C_CALL mt32emu_set_state_snapshots_enabled(mt32emu_const_context context, const mt32emu_boolean enabled);
+/** Returns whether publishing of the synth state snapshots is enabled. */
+MT32EMU_EXPORT_V(2.8) mt32emu_boolean MT32EMU_C_CALL mt32emu_is_state_snapshots_enabled(mt32emu_const_context context);
+/**
+ * Copies the most recent state snapshot published by the rendering thread into the provided structure. This function is lock-free
+ * and may be invoked from any thread concurrently with rendering, although not concurrently with mt32emu_open_synth()
+ * or mt32emu_close_synth().
+ * Returns MT32EMU_BOOL_FALSE when the synth is closed, publishing of the snapshots is disabled, or the rendering thread overtook
+ * the reader too many times. In the latter case, the content of the snapshot is undefined and the call should be retried later.
+ */
+MT32EMU_EXPORT_V(2.8) mt32emu_boolean MT32EMU_C_CALL mt32emu_get_state_snapshot(mt32emu_const_context context, mt32emu_state_snapshot *snapshot);
+
+/**
+ * Copies the usage statistics most recently published by the rendering thread into the provided structure. The statistics
+ * are always collected while the synth is open and published at the end of each call to one of render functions
+ * or mt32emu_fast_forward(). Like mt32emu_get_state_snapshot(), this function is lock-free and may be invoked from any thread
+ * concurrently with rendering, although not concurrently with mt32emu_open_synth() or mt32emu_close_synth().
+ * Returns MT32EMU_BOOL_FALSE when the synth is closed or the rendering thread overtook the reader too many times.
+ * In the latter case, the content of the statistics is undefined and the call should be retried later.
+ */
+MT32EMU_EXPORT_V(2.8) mt32emu_boolean MT32EMU_C_CALL mt32emu_get_statistics(mt32emu_const_context context, mt32emu_statistics *statistics);
+/**
+ * Requests the usage statistics to be cleared. May be invoked from any thread, the statistics are actually cleared
+ * by the rendering thread at the beginning of the next rendering pass.
+ */
+MT32EMU_EXPORT_V(2.8) void MT32EMU_C_CALL mt32emu_reset_statistics(mt32emu_const_context context);
+
+/**
+ * Same as mt32emu_render_bit16s() but outputs the left and right channels to separate (planar) streams.
+ * Both streams must be provided, the length is in samples per channel. Unless the output is resampled
+ * by the internal sample rate converter, the samples are written directly without interleaving.
+ */
+MT32EMU_EXPORT_V(2.8) void MT32EMU_C_CALL mt32emu_render_bit16s_planar(mt32emu_const_context context, mt32emu_bit16s *left_stream, mt32emu_bit16s *right_stream, mt32emu_bit32u len);
+/** Same as above but outputs to float streams. */
+MT32EMU_EXPORT_V(2.8) void MT32EMU_C_CALL mt32emu_render_float_planar(mt32emu_const_context context, float *left_stream, float *right_stream, mt32emu_bit32u len);
+
+/**
+ * Same as mt32emu_play_sysex_at() but the SysEx data isn't copied into the MIDI event queue. The queue merely references the data,
+ * which must stay intact until the synth has processed the message (see mt32emu_get_pending_referenced_sysex_count()).
+ * The memory may also be reused once the MIDI queue is flushed or the synth is closed.
+ */
+MT32EMU_EXPORT_V(2.8) mt32emu_return_code MT32EMU_C_CALL mt32emu_play_referenced_sysex_at(mt32emu_const_context context, const mt32emu_bit8u *sysex, mt32emu_bit32u len, mt32emu_bit32u timestamp);
+/**
+ * Returns the number of SysEx messages enqueued with mt32emu_play_referenced_sysex_at() and not yet processed.
+ * The messages are processed in the order enqueued.
+ */
+MT32EMU_EXPORT_V(2.8) mt32emu_bit32u MT32EMU_C_CALL mt32emu_get_pending_referenced_sysex_count(mt32emu_const_context context);
+
+/**
+ * The working set of the synth involved in rendering (parts, partials, polys, reverb delay lines, LPF state,
+ * the MIDI event queue and the intermediate sample buffers) is allocated in a single block of memory upon mt32emu_open_synth().
+ * Enables or disables backing that block by large (huge) pages (disabled by default). This may reduce TLB misses
+ * during rendering, yet typically requires the pages to be reserved in the system or special privileges.
+ * When large pages are unavailable, regular pages are used silently. This setting takes effect upon the next call to mt32emu_open_synth().
+ */
+MT32EMU_EXPORT_V(2.8) void MT32EMU_C_CALL mt32emu_set_large_pages_enabled(mt32emu_const_context context, const mt32emu_boolean enabled);
+/** Returns whether backing the working set of the synth by large pages is enabled. */
+MT32EMU_EXPORT_V(2.8) mt32emu_boolean MT32EMU_C_CALL mt32emu_is_large_pages_enabled(mt32emu_const_context context);
+/**
+ * Enables or disables locking the working set of the synth in physical memory (disabled by default), so that
+ * rendering never incurs page faults even under memory pressure. Locking may fail due to the limits imposed
+ * by the system, in which case the memory simply remains unlocked. This setting takes effect upon the next call to mt32emu_open_synth().
+ */
+MT32EMU_EXPORT_V(2.8) void MT32EMU_C_CALL mt32emu_set_memory_locking_enabled(mt32emu_const_context context, const mt32emu_boolean enabled);
+/** Returns whether locking the working set of the synth in physical memory is enabled. */
+MT32EMU_EXPORT_V(2.8) mt32emu_boolean MT32EMU_C_CALL mt32emu_is_memory_locking_enabled(mt32emu_const_context context);
+
+/**
+ * Same as mt32emu_render_bit16s() but stops rendering right after the frame where the last active partial has ended.
+ * Returns the number of frames actually rendered, which is less than len only when no partials remain active.
+ * The output is the same as rendering one frame at a time while mt32emu_has_active_partials() returns true, so the frame
+ * where the partials end is included. Returns 0 and leaves the stream untouched if there are no active partials
+ * when called. Otherwise, the output buffer past the returned number of frames may be overwritten with silence.
+ * This permits finding the exact end of the notes without rendering one frame at a time. When the analog circuitry
+ * emulation resamples the output (i.e. in modes MT32EMU_AOM_ACCURATE and MT32EMU_AOM_OVERSAMPLED, or with a custom
+ * output sample rate), the end is determined with a granularity of one output frame.
+ */
+MT32EMU_EXPORT_V(2.8) mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_bit16s_while_partials_active(mt32emu_const_context context, mt32emu_bit16s *stream, mt32emu_bit32u len);
+/** Same as above but outputs to a float stereo stream. */
+MT32EMU_EXPORT_V(2.8) mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_float_while_partials_active(mt32emu_const_context context, float *stream, mt32emu_bit32u len);
+/** Same as mt32emu_render_bit16s_streams() but stops rendering right after the last active partial has ended. See above. */
+MT32EMU_EXPORT_V(2.8) mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_bit16s_streams_while_partials_active(mt32emu_const_context context, const mt32emu_dac_output_bit16s_streams *streams, mt32emu_bit32u len);
+/** Same as above but outputs to float streams. */
+MT32EMU_EXPORT_V(2.8) mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_float_streams_while_partials_active(mt32emu_const_context context, const mt32emu_dac_output_float_streams *streams, mt32emu_bit32u len);
+
+/**
+ * Same as mt32emu_render_bit16s() but stops rendering as soon as mt32emu_is_active() returns false, which is useful
+ * for rendering the reverb tail. Since reverb activity detection is costly, the check is only performed once per
+ * a block of frames, so the rendered tail may be somewhat longer than necessary.
+ * Returns the number of frames actually rendered, which is less than len only when the synth became inactive.
+ */
+MT32EMU_EXPORT_V(2.8) mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_bit16s_while_active(mt32emu_const_context context, mt32emu_bit16s *stream, mt32emu_bit32u len);
+/** Same as above but outputs to a float stereo stream. */
+MT32EMU_EXPORT_V(2.8) mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_float_while_active(mt32emu_const_context context, float *stream, mt32emu_bit32u len);
+/** Same as mt32emu_render_bit16s_streams() but stops rendering as soon as mt32emu_is_active() returns false. See above. */
+MT32EMU_EXPORT_V(2.8) mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_bit16s_streams_while_active(mt32emu_const_context context, const mt32emu_dac_output_bit16s_streams *streams, mt32emu_bit32u len);
+/** Same as above but outputs to float streams. */
+MT32EMU_EXPORT_V(2.8) mt32emu_bit32u MT32EMU_C_CALL mt32emu_render_float_streams_while_active(mt32emu_const_context context, const mt32emu_dac_output_float_streams *streams, mt32emu_bit32u len);
+
+/**
+ * Advances the synth by the specified number of samples at the native sample rate 32000 Hz without producing any sound.
+ * The MIDI events are played from the queue at their timestamps, and the partials proceed through their envelopes
+ * and get allocated and freed exactly as they would while rendering, so the report handler callbacks and the state
+ * queries behave as usual, yet the processing is many times faster. Neither the waveforms of synth partials,
+ * nor the reverb, nor the analog circuitry emulation are processed meanwhile.
+ * Useful for collecting statistics or seeking across a MIDI stream.
+ */
+MT32EMU_EXPORT_V(2.8) void MT32EMU_C_CALL mt32emu_fast_forward(mt32emu_const_context context, mt32emu_bit32u len);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -112,6 +112,66 @@ typedef struct {
 	float *reverbWetRight;
 } mt32emu_dac_output_float_streams;
 
+/**
+ * Consistent view of the synth state captured by the rendering thread at the end of a rendering pass.
+ * See mt32emu_get_state_snapshot() for details. The client must set each array pointer either to NULL,
+ * in order to skip retrieving the corresponding data, or to an array of sufficient size.
+ */
+typedef struct {
+	/** Value of mt32emu_get_internal_rendered_sample_count() when the snapshot was captured. */
+	mt32emu_bit32u rendered_sample_count;
+	/** States of all the parts as a bit set, see mt32emu_get_part_states(). */
+	mt32emu_bit32u part_states;
+	/** State of the MIDI MESSAGE LED and null-terminated content of the emulated LCD, see mt32emu_get_display_state(). */
+	mt32emu_boolean midi_message_led_state;
+	char lcd_state[21];
+	/**
+	 * Numbers of notes playing on each part. Keys and velocities of the notes are stored in arrays keys and velocities
+	 * part by part, starting from part 1. The arrays must have at least mt32emu_get_partial_count() entries.
+	 */
+	mt32emu_bit32u playing_note_counts[9];
+	mt32emu_bit8u *keys;
+	mt32emu_bit8u *velocities;
+	/** States of all the partials packed in pairs of bits, see mt32emu_get_partial_states(). */
+	mt32emu_bit8u *partial_states;
+} mt32emu_state_snapshot;
+
+/**
+ * Usage statistics accumulated by the rendering thread since the synth was opened or the statistics were last reset.
+ * See mt32emu_get_statistics() for details.
+ */
+typedef struct {
+	/** Number of samples rendered at the internal sample rate. Wraps around. */
+	mt32emu_bit32u rendered_sample_count;
+	/**
+	 * Maximum and average numbers of partials simultaneously active on each part, starting from part 1.
+	 * The counts are sampled once per rendered chunk, so very short peaks may be missed.
+	 */
+	mt32emu_bit32u peak_active_partial_counts[9];
+	float average_active_partial_counts[9];
+	/** Maximum number of partials simultaneously active on all the parts. */
+	mt32emu_bit32u peak_active_partial_count;
+	/** Number of playing polys aborted to free partials for new notes, see mt32emu_report_handler_i_v2.onPlayingPolySilenced. */
+	mt32emu_bit32u silenced_poly_count;
+	/** Number of note-on messages ignored for the lack of free partials, see mt32emu_report_handler_i_v2.onNoteOnIgnored. */
+	mt32emu_bit32u ignored_note_on_count;
+	/** Maximum number of MIDI events found pending in the queue at the beginning of a rendering pass. */
+	mt32emu_bit32u midi_queue_high_water_mark;
+	/** Number of calls to the rendering functions, along with the total and maximum time spent in them, in seconds. */
+	mt32emu_bit32u render_pass_count;
+	double total_render_pass_duration;
+	double max_render_pass_duration;
+	/**
+	 * Parts of the total rendering time spent in processing MIDI events, producing the output of partials,
+	 * emulating the reverb and the analogue circuitry, in seconds. The time spent producing the output of partials
+	 * also covers whatever overhead is not attributed to the other stages.
+	 */
+	double total_midi_processing_duration;
+	double total_partial_rendering_duration;
+	double total_reverb_duration;
+	double total_analog_duration;
+} mt32emu_statistics;
+
 /* === Interface handling === */
 
 /** Report handler interface versions */
@@ -395,7 +455,36 @@ typedef union mt32emu_service_i mt32emu_service_i;
 	void (MT32EMU_C_CALL *setMasterVolumeOverride)(mt32emu_const_context context, mt32emu_bit8u volume_override); \
 	mt32emu_bit8u (MT32EMU_C_CALL *getMasterVolumeOverride)(mt32emu_const_context context); \
 	mt32emu_bit32u (MT32EMU_C_CALL *dumpSysexBank)(mt32emu_const_context context, mt32emu_bit8u *sysex_bank, mt32emu_bit32u size); \
-	mt32emu_bit32u (MT32EMU_C_CALL *applySysexBank)(mt32emu_const_context context, const mt32emu_bit8u *sysex_bank, mt32emu_bit32u size);
+	mt32emu_bit32u (MT32EMU_C_CALL *applySysexBank)(mt32emu_const_context context, const mt32emu_bit8u *sysex_bank, mt32emu_bit32u size); \
+	void (MT32EMU_C_CALL *setStateSnapshotsEnabled)(mt32emu_const_context context, const mt32emu_boolean enabled); \
+	mt32emu_boolean (MT32EMU_C_CALL *isStateSnapshotsEnabled)(mt32emu_const_context context); \
+	mt32emu_boolean (MT32EMU_C_CALL *getStateSnapshot)(mt32emu_const_context context, mt32emu_state_snapshot *snapshot); \
+	mt32emu_bit32u (MT32EMU_C_CALL *renderBit16sWhilePartialsActive)(mt32emu_const_context context, mt32emu_bit16s *stream, mt32emu_bit32u len); \
+	mt32emu_bit32u (MT32EMU_C_CALL *renderFloatWhilePartialsActive)(mt32emu_const_context context, float *stream, mt32emu_bit32u len); \
+	mt32emu_bit32u (MT32EMU_C_CALL *renderBit16sStreamsWhilePartialsActive)(mt32emu_const_context context, const mt32emu_dac_output_bit16s_streams *streams, mt32emu_bit32u len); \
+	mt32emu_bit32u (MT32EMU_C_CALL *renderFloatStreamsWhilePartialsActive)(mt32emu_const_context context, const mt32emu_dac_output_float_streams *streams, mt32emu_bit32u len); \
+	mt32emu_bit32u (MT32EMU_C_CALL *renderBit16sWhileActive)(mt32emu_const_context context, mt32emu_bit16s *stream, mt32emu_bit32u len); \
+	mt32emu_bit32u (MT32EMU_C_CALL *renderFloatWhileActive)(mt32emu_const_context context, float *stream, mt32emu_bit32u len); \
+	mt32emu_bit32u (MT32EMU_C_CALL *renderBit16sStreamsWhileActive)(mt32emu_const_context context, const mt32emu_dac_output_bit16s_streams *streams, mt32emu_bit32u len); \
+	mt32emu_bit32u (MT32EMU_C_CALL *renderFloatStreamsWhileActive)(mt32emu_const_context context, const mt32emu_dac_output_float_streams *streams, mt32emu_bit32u len); \
+	mt32emu_return_code (MT32EMU_C_CALL *identifyROMFileUsingSHA1Sidecar)(mt32emu_rom_info *rom_info, const char *filename, const char *machine_id); \
+	void (MT32EMU_C_CALL *setROMSHA1SidecarsEnabled)(mt32emu_context context, const mt32emu_boolean enabled); \
+	mt32emu_return_code (MT32EMU_C_CALL *loadROMIndex)(mt32emu_context context, const char *index_filename); \
+	mt32emu_return_code (MT32EMU_C_CALL *saveROMIndex)(mt32emu_context context); \
+	mt32emu_return_code (MT32EMU_C_CALL *identifyROMFileUsingIndex)(mt32emu_context context, mt32emu_rom_info *rom_info, const char *filename, const char *machine_id); \
+	mt32emu_bit32u (MT32EMU_C_CALL *saveState)(mt32emu_const_context context, mt32emu_bit8u *state_buffer, mt32emu_bit32u size); \
+	mt32emu_return_code (MT32EMU_C_CALL *loadState)(mt32emu_const_context context, const mt32emu_bit8u *state_buffer, mt32emu_bit32u size); \
+	void (MT32EMU_C_CALL *fastForward)(mt32emu_const_context context, mt32emu_bit32u len); \
+	mt32emu_boolean (MT32EMU_C_CALL *getStatistics)(mt32emu_const_context context, mt32emu_statistics *statistics); \
+	void (MT32EMU_C_CALL *resetStatistics)(mt32emu_const_context context); \
+	void (MT32EMU_C_CALL *renderBit16sPlanar)(mt32emu_const_context context, mt32emu_bit16s *left_stream, mt32emu_bit16s *right_stream, mt32emu_bit32u len); \
+	void (MT32EMU_C_CALL *renderFloatPlanar)(mt32emu_const_context context, float *left_stream, float *right_stream, mt32emu_bit32u len); \
+	mt32emu_return_code (MT32EMU_C_CALL *playReferencedSysexAt)(mt32emu_const_context context, const mt32emu_bit8u *sysex, mt32emu_bit32u len, mt32emu_bit32u timestamp); \
+	mt32emu_bit32u (MT32EMU_C_CALL *getPendingReferencedSysexCount)(mt32emu_const_context context); \
+	void (MT32EMU_C_CALL *setLargePagesEnabled)(mt32emu_const_context context, const mt32emu_boolean enabled); \
+	mt32emu_boolean (MT32EMU_C_CALL *isLargePagesEnabled)(mt32emu_const_context context); \
+	void (MT32EMU_C_CALL *setMemoryLockingEnabled)(mt32emu_const_context context, const mt32emu_boolean enabled); \
+	mt32emu_boolean (MT32EMU_C_CALL *isMemoryLockingEnabled)(mt32emu_const_context context);
 
 typedef struct {
 	MT32EMU_SERVICE_I_V0
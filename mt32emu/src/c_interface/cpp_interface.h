@@ -84,6 +84,8 @@ mt32emu_service_i mt32emu_get_service_i();
 #define mt32emu_write_sysex i.v0->writeSysex
 #define mt32emu_dump_sysex_bank iV7()->dumpSysexBank
 #define mt32emu_apply_sysex_bank iV7()->applySysexBank
+#define mt32emu_save_state iV7()->saveState
+#define mt32emu_load_state iV7()->loadState
 #define mt32emu_set_reverb_enabled i.v0->setReverbEnabled
 #define mt32emu_is_reverb_enabled i.v0->isReverbEnabled
 #define mt32emu_set_reverb_overridden i.v0->setReverbOverridden
@@ -131,6 +133,33 @@ mt32emu_service_i mt32emu_get_service_i();
 #define mt32emu_set_display_compatibility iV5()->setDisplayCompatibility
 #define mt32emu_is_display_old_mt32_compatible iV5()->isDisplayOldMT32Compatible
 #define mt32emu_is_default_display_old_mt32_compatible iV5()->isDefaultDisplayOldMT32Compatible
+#define mt32emu_set_state_snapshots_enabled iV7()->setStateSnapshotsEnabled
+#define mt32emu_is_state_snapshots_enabled iV7()->isStateSnapshotsEnabled
+#define mt32emu_get_state_snapshot iV7()->getStateSnapshot
+#define mt32emu_render_bit16s_while_partials_active iV7()->renderBit16sWhilePartialsActive
+#define mt32emu_render_float_while_partials_active iV7()->renderFloatWhilePartialsActive
+#define mt32emu_render_bit16s_streams_while_partials_active iV7()->renderBit16sStreamsWhilePartialsActive
+#define mt32emu_render_float_streams_while_partials_active iV7()->renderFloatStreamsWhilePartialsActive
+#define mt32emu_render_bit16s_while_active iV7()->renderBit16sWhileActive
+#define mt32emu_render_float_while_active iV7()->renderFloatWhileActive
+#define mt32emu_render_bit16s_streams_while_active iV7()->renderBit16sStreamsWhileActive
+#define mt32emu_render_float_streams_while_active iV7()->renderFloatStreamsWhileActive
+#define mt32emu_fast_forward iV7()->fastForward
+#define mt32emu_get_statistics iV7()->getStatistics
+#define mt32emu_reset_statistics iV7()->resetStatistics
+#define mt32emu_render_bit16s_planar iV7()->renderBit16sPlanar
+#define mt32emu_render_float_planar iV7()->renderFloatPlanar
+#define mt32emu_play_referenced_sysex_at iV7()->playReferencedSysexAt
+#define mt32emu_get_pending_referenced_sysex_count iV7()->getPendingReferencedSysexCount
+#define mt32emu_set_large_pages_enabled iV7()->setLargePagesEnabled
+#define mt32emu_is_large_pages_enabled iV7()->isLargePagesEnabled
+#define mt32emu_set_memory_locking_enabled iV7()->setMemoryLockingEnabled
+#define mt32emu_is_memory_locking_enabled iV7()->isMemoryLockingEnabled
+#define mt32emu_identify_rom_file_using_sha1_sidecar iV7()->identifyROMFileUsingSHA1Sidecar
+#define mt32emu_set_rom_sha1_sidecars_enabled iV7()->setROMSHA1SidecarsEnabled
+#define mt32emu_load_rom_index iV7()->loadROMIndex
+#define mt32emu_save_rom_index iV7()->saveROMIndex
+#define mt32emu_identify_rom_file_using_index iV7()->identifyROMFileUsingIndex
 
 #else // #if MT32EMU_API_TYPE == 2
 
@@ -242,6 +271,7 @@ public:
 	size_t getROMIDs(const char **rom_ids, size_t rom_ids_size, const char *machine_id) { return mt32emu_get_rom_ids(rom_ids, rom_ids_size, machine_id); }
 	mt32emu_return_code identifyROMData(mt32emu_rom_info *rom_info, const Bit8u *data, size_t data_size, const char *machine_id) { return mt32emu_identify_rom_data(rom_info, data, data_size, machine_id); }
 	mt32emu_return_code identifyROMFile(mt32emu_rom_info *rom_info, const char *filename, const char *machine_id) { return mt32emu_identify_rom_file(rom_info, filename, machine_id); }
+	mt32emu_return_code identifyROMFileUsingSHA1Sidecar(mt32emu_rom_info *rom_info, const char *filename, const char *machine_id) { return mt32emu_identify_rom_file_using_sha1_sidecar(rom_info, filename, machine_id); }
 
 	// Context-dependent methods
 
@@ -257,6 +287,10 @@ public:
 	mt32emu_return_code mergeAndAddROMData(const Bit8u *part1_data, size_t part1_data_size, const mt32emu_sha1_digest *part1_sha1_digest, const Bit8u *part2_data, size_t part2_data_size, const mt32emu_sha1_digest *part2_sha1_digest) { return mt32emu_merge_and_add_rom_data(c, part1_data, part1_data_size, part1_sha1_digest, part2_data, part2_data_size, part2_sha1_digest); }
 	mt32emu_return_code mergeAndAddROMFiles(const char *part1_filename, const char *part2_filename) { return mt32emu_merge_and_add_rom_files(c, part1_filename, part2_filename); }
 	mt32emu_return_code addMachineROMFile(const char *machine_id, const char *filename) { return mt32emu_add_machine_rom_file(c, machine_id, filename); }
+	void setROMSHA1SidecarsEnabled(const bool enabled) { mt32emu_set_rom_sha1_sidecars_enabled(c, enabled ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE); }
+	mt32emu_return_code loadROMIndex(const char *index_filename) { return mt32emu_load_rom_index(c, index_filename); }
+	mt32emu_return_code saveROMIndex() { return mt32emu_save_rom_index(c); }
+	mt32emu_return_code identifyROMFileUsingIndex(mt32emu_rom_info *rom_info, const char *filename, const char *machine_id) { return mt32emu_identify_rom_file_using_index(c, rom_info, filename, machine_id); }
 	void getROMInfo(mt32emu_rom_info *rom_info) { mt32emu_get_rom_info(c, rom_info); }
 	void setPartialCount(const Bit32u partial_count) { mt32emu_set_partial_count(c, partial_count); }
 	void setAnalogOutputMode(const AnalogOutputMode analog_output_mode) { mt32emu_set_analog_output_mode(c, static_cast<mt32emu_analog_output_mode>(analog_output_mode)); }
@@ -285,6 +319,8 @@ public:
 	mt32emu_return_code playSysex(const Bit8u *sysex, Bit32u len) { return mt32emu_play_sysex(c, sysex, len); }
 	mt32emu_return_code playMsgAt(Bit32u msg, Bit32u timestamp) { return mt32emu_play_msg_at(c, msg, timestamp); }
 	mt32emu_return_code playSysexAt(const Bit8u *sysex, Bit32u len, Bit32u timestamp) { return mt32emu_play_sysex_at(c, sysex, len, timestamp); }
+	mt32emu_return_code playReferencedSysexAt(const Bit8u *sysex, Bit32u len, Bit32u timestamp) { return mt32emu_play_referenced_sysex_at(c, sysex, len, timestamp); }
+	Bit32u getPendingReferencedSysexCount() { return mt32emu_get_pending_referenced_sysex_count(c); }
 
 	void playMsgNow(Bit32u msg) { mt32emu_play_msg_now(c, msg); }
 	void playMsgOnPart(Bit8u part, Bit8u code, Bit8u note, Bit8u velocity) { mt32emu_play_msg_on_part(c, part, code, note, velocity); }
@@ -293,6 +329,8 @@ public:
 
 	Bit32u dumpSysexBank(Bit8u *sysex_bank, Bit32u size) { return mt32emu_dump_sysex_bank(c, sysex_bank, size); }
 	Bit32u applySysexBank(const Bit8u *sysex_bank, Bit32u size) { return mt32emu_apply_sysex_bank(c, sysex_bank, size); }
+	Bit32u saveState(Bit8u *state_buffer, Bit32u size) { return mt32emu_save_state(c, state_buffer, size); }
+	mt32emu_return_code loadState(const Bit8u *state_buffer, Bit32u size) { return mt32emu_load_state(c, state_buffer, size); }
 
 	void setReverbEnabled(const bool reverb_enabled) { mt32emu_set_reverb_enabled(c, reverb_enabled ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE); }
 	bool isReverbEnabled() { return mt32emu_is_reverb_enabled(c) != MT32EMU_BOOL_FALSE; }
@@ -336,6 +374,17 @@ public:
 	void renderFloat(float *stream, Bit32u len) { mt32emu_render_float(c, stream, len); }
 	void renderBit16sStreams(const mt32emu_dac_output_bit16s_streams *streams, Bit32u len) { mt32emu_render_bit16s_streams(c, streams, len); }
 	void renderFloatStreams(const mt32emu_dac_output_float_streams *streams, Bit32u len) { mt32emu_render_float_streams(c, streams, len); }
+	Bit32u renderBit16sWhilePartialsActive(Bit16s *stream, Bit32u len) { return mt32emu_render_bit16s_while_partials_active(c, stream, len); }
+	Bit32u renderFloatWhilePartialsActive(float *stream, Bit32u len) { return mt32emu_render_float_while_partials_active(c, stream, len); }
+	Bit32u renderBit16sStreamsWhilePartialsActive(const mt32emu_dac_output_bit16s_streams *streams, Bit32u len) { return mt32emu_render_bit16s_streams_while_partials_active(c, streams, len); }
+	Bit32u renderFloatStreamsWhilePartialsActive(const mt32emu_dac_output_float_streams *streams, Bit32u len) { return mt32emu_render_float_streams_while_partials_active(c, streams, len); }
+	Bit32u renderBit16sWhileActive(Bit16s *stream, Bit32u len) { return mt32emu_render_bit16s_while_active(c, stream, len); }
+	Bit32u renderFloatWhileActive(float *stream, Bit32u len) { return mt32emu_render_float_while_active(c, stream, len); }
+	Bit32u renderBit16sStreamsWhileActive(const mt32emu_dac_output_bit16s_streams *streams, Bit32u len) { return mt32emu_render_bit16s_streams_while_active(c, streams, len); }
+	Bit32u renderFloatStreamsWhileActive(const mt32emu_dac_output_float_streams *streams, Bit32u len) { return mt32emu_render_float_streams_while_active(c, streams, len); }
+	void renderBit16sPlanar(Bit16s *leftStream, Bit16s *rightStream, Bit32u len) { mt32emu_render_bit16s_planar(c, leftStream, rightStream, len); }
+	void renderFloatPlanar(float *leftStream, float *rightStream, Bit32u len) { mt32emu_render_float_planar(c, leftStream, rightStream, len); }
+	void fastForward(Bit32u len) { mt32emu_fast_forward(c, len); }
 
 	bool hasActivePartials() { return mt32emu_has_active_partials(c) != MT32EMU_BOOL_FALSE; }
 	bool isActive() { return mt32emu_is_active(c) != MT32EMU_BOOL_FALSE; }
@@ -355,6 +404,17 @@ public:
 	bool isDisplayOldMT32Compatible() { return mt32emu_is_display_old_mt32_compatible(c) != MT32EMU_BOOL_FALSE; }
 	bool isDefaultDisplayOldMT32Compatible() { return mt32emu_is_default_display_old_mt32_compatible(c) != MT32EMU_BOOL_FALSE; }
 
+	void setStateSnapshotsEnabled(const bool enabled) { mt32emu_set_state_snapshots_enabled(c, enabled ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE); }
+	bool isStateSnapshotsEnabled() { return mt32emu_is_state_snapshots_enabled(c) != MT32EMU_BOOL_FALSE; }
+	bool getStateSnapshot(mt32emu_state_snapshot *snapshot) { return mt32emu_get_state_snapshot(c, snapshot) != MT32EMU_BOOL_FALSE; }
+	bool getStatistics(mt32emu_statistics *statistics) { return mt32emu_get_statistics(c, statistics) != MT32EMU_BOOL_FALSE; }
+	void resetStatistics() { mt32emu_reset_statistics(c); }
+
+	void setLargePagesEnabled(const bool enabled) { mt32emu_set_large_pages_enabled(c, enabled ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE); }
+	bool isLargePagesEnabled() { return mt32emu_is_large_pages_enabled(c) != MT32EMU_BOOL_FALSE; }
+	void setMemoryLockingEnabled(const bool enabled) { mt32emu_set_memory_locking_enabled(c, enabled ? MT32EMU_BOOL_TRUE : MT32EMU_BOOL_FALSE); }
+	bool isMemoryLockingEnabled() { return mt32emu_is_memory_locking_enabled(c) != MT32EMU_BOOL_FALSE; }
+
 private:
 #if MT32EMU_API_TYPE == 2
 	const mt32emu_service_i i;
@@ -592,6 +652,8 @@ static mt32emu_midi_receiver_i getMidiReceiverThunk() {
 #undef mt32emu_write_sysex
 #undef mt32emu_dump_sysex_bank
 #undef mt32emu_apply_sysex_bank
+#undef mt32emu_save_state
+#undef mt32emu_load_state
 #undef mt32emu_set_reverb_enabled
 #undef mt32emu_is_reverb_enabled
 #undef mt32emu_set_reverb_overridden
@@ -639,6 +701,33 @@ static mt32emu_midi_receiver_i getMidiReceiverThunk() {
 #undef mt32emu_set_display_compatibility
 #undef mt32emu_is_display_old_mt32_compatible
 #undef mt32emu_is_default_display_old_mt32_compatible
+#undef mt32emu_set_state_snapshots_enabled
+#undef mt32emu_is_state_snapshots_enabled
+#undef mt32emu_get_state_snapshot
+#undef mt32emu_render_bit16s_while_partials_active
+#undef mt32emu_render_float_while_partials_active
+#undef mt32emu_render_bit16s_streams_while_partials_active
+#undef mt32emu_render_float_streams_while_partials_active
+#undef mt32emu_render_bit16s_while_active
+#undef mt32emu_render_float_while_active
+#undef mt32emu_render_bit16s_streams_while_active
+#undef mt32emu_render_float_streams_while_active
+#undef mt32emu_fast_forward
+#undef mt32emu_get_statistics
+#undef mt32emu_reset_statistics
+#undef mt32emu_render_bit16s_planar
+#undef mt32emu_render_float_planar
+#undef mt32emu_play_referenced_sysex_at
+#undef mt32emu_get_pending_referenced_sysex_count
+#undef mt32emu_set_large_pages_enabled
+#undef mt32emu_is_large_pages_enabled
+#undef mt32emu_set_memory_locking_enabled
+#undef mt32emu_is_memory_locking_enabled
+#undef mt32emu_identify_rom_file_using_sha1_sidecar
+#undef mt32emu_set_rom_sha1_sidecars_enabled
+#undef mt32emu_load_rom_index
+#undef mt32emu_save_rom_index
+#undef mt32emu_identify_rom_file_using_index
 
 #endif // #if MT32EMU_API_TYPE == 2
 
@@ -69,6 +69,8 @@
 #include "Types.h"
 #include "File.h"
 #include "FileStream.h"
+#include "MappedFile.h"
+#include "ROMIndex.h"
 #include "ROMInfo.h"
 #include "Synth.h"
 #include "MidiStreamParser.h"
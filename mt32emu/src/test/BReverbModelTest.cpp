@@ -0,0 +1,159 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "../BReverbModel.h"
+#include "../Synth.h"
+
+#include "FakeROMs.h"
+#include "TestUtils.h"
+#include "Testing.h"
+
+// Counts the allocations made via the global operator new while the counting is enabled. Since the operator is replaced
+// for the entire test runner, it only adds bookkeeping to the default behaviour.
+static bool countingAllocations = false;
+static size_t allocationCount = 0;
+
+#if __cplusplus >= 201103L
+#define MT32EMU_TEST_THROWS_BAD_ALLOC
+#define MT32EMU_TEST_THROWS_NOTHING noexcept
+#else
+#define MT32EMU_TEST_THROWS_BAD_ALLOC throw (std::bad_alloc)
+#define MT32EMU_TEST_THROWS_NOTHING throw ()
+#endif
+
+void *operator new(size_t size) MT32EMU_TEST_THROWS_BAD_ALLOC {
+	if (countingAllocations) allocationCount++;
+	void *block = malloc(size == 0 ? 1 : size);
+	if (block == NULL) throw std::bad_alloc();
+	return block;
+}
+
+void operator delete(void *block) MT32EMU_TEST_THROWS_NOTHING {
+	free(block);
+}
+
+namespace MT32Emu {
+
+namespace Test {
+
+namespace {
+
+const Bit32u FRAME_COUNT = 1024;
+const Bit8u GUARD_BYTE = 0xA5;
+const Bit8u GARBAGE_BYTE = 0x5A;
+
+bool isSilent(IntSample sample) {
+	return sample == 0;
+}
+
+// The float models bias their input slightly to avoid denormals.
+bool isSilent(FloatSample sample) {
+	return -1e-10f < sample && sample < 1e-10f;
+}
+
+template <class Sample>
+void checkDelayLinesInProvidedMemory(ReverbMode mode, RendererType rendererType) {
+	BReverbModel *model = BReverbModel::createBReverbModel(mode, false, rendererType);
+	const size_t memorySize = model->getDelayLineMemorySize();
+	REQUIRE(memorySize > 0);
+	// The extra FloatSample keeps the guard area after the block suitably aligned.
+	Bit8u *memory = reinterpret_cast<Bit8u *>(new FloatSample[memorySize / sizeof(FloatSample) + 2]);
+	memset(memory, GARBAGE_BYTE, memorySize);
+	memset(memory + memorySize, GUARD_BYTE, sizeof(FloatSample));
+
+	model->open(memory);
+	model->setParameters(5, 7);
+	Sample silence[FRAME_COUNT] = {};
+	Sample outLeft[FRAME_COUNT], outRight[FRAME_COUNT];
+	REQUIRE(model->process(silence, silence, outLeft, outRight, FRAME_COUNT));
+
+	// The delay lines are cleared when opened, despite the garbage in the memory block.
+	size_t nonSilentSampleCount = 0;
+	for (Bit32u i = 0; i < FRAME_COUNT; i++) {
+		if (!isSilent(outLeft[i]) || !isSilent(outRight[i])) nonSilentSampleCount++;
+	}
+	CHECK(nonSilentSampleCount == 0);
+	size_t garbageByteCount = 0;
+	for (size_t i = 0; i < memorySize; i++) {
+		if (memory[i] == GARBAGE_BYTE) garbageByteCount++;
+	}
+	CHECK(garbageByteCount == 0);
+	for (size_t i = 0; i < sizeof(FloatSample); i++) {
+		CHECK(memory[memorySize + i] == GUARD_BYTE);
+	}
+
+	model->close();
+	CHECK_FALSE(model->isOpen());
+	delete model;
+	delete[] reinterpret_cast<FloatSample *>(memory);
+}
+
+void sendReverbModeSysex(Synth &synth, Bit8u mode) {
+	const Bit8u sysex[] = { 0x10, 0x00, 0x01, mode };
+	synth.writeSysex(16, sysex, sizeof sysex);
+}
+
+} // namespace
+
+TEST_CASE("BReverbModel should place its delay lines into the memory provided") {
+	for (int mode = REVERB_MODE_ROOM; mode <= REVERB_MODE_TAP_DELAY; mode++) {
+		CAPTURE(mode);
+		checkDelayLinesInProvidedMemory<IntSample>(ReverbMode(mode), RendererType_BIT16S);
+		checkDelayLinesInProvidedMemory<FloatSample>(ReverbMode(mode), RendererType_FLOAT);
+	}
+}
+
+TEST_CASE("Synth should switch reverb modes without allocating memory") {
+	Synth synth;
+	ROMSet romSet;
+	romSet.initMT32New();
+	openSynth(synth, romSet);
+	sendSineWaveSysex(synth, 1);
+	sendNoteOn(synth, 1, 60, 100);
+	REQUIRE(synth.isReverbEnabled());
+	Bit16s buffer[2 * FRAME_COUNT];
+	synth.render(buffer, FRAME_COUNT);
+
+	allocationCount = 0;
+	countingAllocations = true;
+	for (Bit8u mode = REVERB_MODE_ROOM; mode <= REVERB_MODE_TAP_DELAY; mode++) {
+		// Let the previous mode fade out completely.
+		sendReverbModeSysex(synth, mode);
+		synth.render(buffer, FRAME_COUNT);
+	}
+	for (Bit8u mode = REVERB_MODE_ROOM; mode <= REVERB_MODE_TAP_DELAY; mode++) {
+		// Cut the fade-out short every time.
+		sendReverbModeSysex(synth, mode);
+		synth.render(buffer, 16);
+	}
+	synth.setReverbEnabled(false);
+	synth.render(buffer, FRAME_COUNT);
+	synth.setReverbEnabled(true);
+	synth.render(buffer, FRAME_COUNT);
+	countingAllocations = false;
+
+	CHECK(allocationCount == 0);
+	CHECK(synth.isReverbEnabled());
+}
+
+} // namespace Test
+
+} // namespace MT32Emu
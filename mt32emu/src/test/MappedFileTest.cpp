@@ -0,0 +1,149 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+
+#include "../File.h"
+#include "../MappedFile.h"
+
+#include "Testing.h"
+
+namespace MT32Emu {
+
+namespace Test {
+
+namespace {
+
+const char TEST_FILENAME[] = "mt32emu-mapped-file-test.bin";
+const char TEST_SIDECAR_FILENAME[] = "mt32emu-mapped-file-test.bin.sha1";
+const char TEST_FILE_CONTENTS[] = "abc";
+const char TEST_FILE_SHA1[] = "a9993e364706816aba3e25717850c26c9cd0d89d";
+const char OTHER_SHA1[] = "0123456789abcdef0123456789abcdef01234567";
+
+void writeFile(const char *filename, const char *contents) {
+	FILE *file = fopen(filename, "wb");
+	REQUIRE(file != NULL_PTR);
+	size_t length = strlen(contents);
+	CHECK(fwrite(contents, 1, length, file) == length);
+	fclose(file);
+}
+
+// Removes the files created by a test case, even if it fails.
+struct TestFiles {
+	TestFiles() {
+		remove(TEST_SIDECAR_FILENAME);
+		writeFile(TEST_FILENAME, TEST_FILE_CONTENTS);
+	}
+
+	~TestFiles() {
+		remove(TEST_FILENAME);
+		remove(TEST_SIDECAR_FILENAME);
+	}
+};
+
+} // namespace
+
+TEST_CASE("MappedFile should provide the contents of the opened file") {
+	TestFiles testFiles;
+	MappedFile file;
+	REQUIRE(file.open(TEST_FILENAME));
+
+	CHECK(file.getSize() == strlen(TEST_FILE_CONTENTS));
+	REQUIRE(file.getData() != NULL_PTR);
+	CHECK(memcmp(file.getData(), TEST_FILE_CONTENTS, file.getSize()) == 0);
+	CHECK(strcmp(file.getSHA1(), TEST_FILE_SHA1) == 0);
+	Bit32u timeHigh, timeLow;
+	CHECK(file.getModificationTime(timeHigh, timeLow));
+}
+
+TEST_CASE("MappedFile should open empty files") {
+	TestFiles testFiles;
+	writeFile(TEST_FILENAME, "");
+	MappedFile file;
+	REQUIRE(file.open(TEST_FILENAME));
+
+	CHECK(file.getSize() == 0);
+	CHECK(file.getData() == NULL_PTR);
+}
+
+TEST_CASE("MappedFile should fail to open missing files") {
+	TestFiles testFiles;
+	remove(TEST_FILENAME);
+	MappedFile file;
+
+	CHECK_FALSE(file.open(TEST_FILENAME));
+	CHECK(file.getSize() == 0);
+	Bit32u timeHigh, timeLow;
+	CHECK_FALSE(file.getModificationTime(timeHigh, timeLow));
+}
+
+TEST_CASE("MappedFile should trust the SHA1 digest in a well-formed sidecar") {
+	TestFiles testFiles;
+	MappedFile file;
+	REQUIRE(file.open(TEST_FILENAME));
+
+	SUBCASE("Digest alone") {
+		writeFile(TEST_SIDECAR_FILENAME, OTHER_SHA1);
+	}
+
+	SUBCASE("Output of sha1sum") {
+		writeFile(TEST_SIDECAR_FILENAME, "0123456789abcdef0123456789abcdef01234567  mt32emu-mapped-file-test.bin\n");
+	}
+
+	SUBCASE("Upper case digest") {
+		writeFile(TEST_SIDECAR_FILENAME, "0123456789ABCDEF0123456789ABCDEF01234567\n");
+	}
+
+	CHECK(file.loadSHA1Sidecar(TEST_FILENAME));
+	CHECK(strcmp(file.getSHA1(), OTHER_SHA1) == 0);
+
+	// Reopening the file forgets the digest.
+	REQUIRE(file.open(TEST_FILENAME));
+	CHECK(strcmp(file.getSHA1(), TEST_FILE_SHA1) == 0);
+}
+
+TEST_CASE("MappedFile should compute the SHA1 digest unless the sidecar is well-formed") {
+	TestFiles testFiles;
+	MappedFile file;
+	REQUIRE(file.open(TEST_FILENAME));
+
+	SUBCASE("Missing sidecar") {}
+
+	SUBCASE("Empty sidecar") {
+		writeFile(TEST_SIDECAR_FILENAME, "");
+	}
+
+	SUBCASE("Digest too short") {
+		writeFile(TEST_SIDECAR_FILENAME, "0123456789abcdef0123456789abcdef0123456\n");
+	}
+
+	SUBCASE("Digest too long") {
+		writeFile(TEST_SIDECAR_FILENAME, "0123456789abcdef0123456789abcdef012345678\n");
+	}
+
+	SUBCASE("Not a hex digit") {
+		writeFile(TEST_SIDECAR_FILENAME, "0123456789abcdef0123456789abcdef0123456g\n");
+	}
+
+	CHECK_FALSE(file.loadSHA1Sidecar(TEST_FILENAME));
+	CHECK(strcmp(file.getSHA1(), TEST_FILE_SHA1) == 0);
+}
+
+} // namespace Test
+
+} // namespace MT32Emu
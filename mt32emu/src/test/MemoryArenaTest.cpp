@@ -0,0 +1,193 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "../MemoryArena.h"
+#include "../Partial.h"
+#include "../PartialManager.h"
+#include "../Synth.h"
+
+#include "FakeROMs.h"
+#include "TestUtils.h"
+#include "Testing.h"
+
+namespace MT32Emu {
+
+namespace Test {
+
+static bool isCacheLineAligned(const void *address) {
+	return (reinterpret_cast<size_t>(address) & (MemoryArena::CACHE_LINE_SIZE - 1)) == 0;
+}
+
+TEST_CASE("MemoryArena should round chunks up to whole cache lines") {
+	CHECK(MemoryArena::getChunkSize(0) == 0);
+	CHECK(MemoryArena::getChunkSize(1) == MemoryArena::CACHE_LINE_SIZE);
+	CHECK(MemoryArena::getChunkSize(MemoryArena::CACHE_LINE_SIZE) == MemoryArena::CACHE_LINE_SIZE);
+	CHECK(MemoryArena::getChunkSize(MemoryArena::CACHE_LINE_SIZE + 1) == 2 * MemoryArena::CACHE_LINE_SIZE);
+
+	MemoryArena arena(3 * MemoryArena::CACHE_LINE_SIZE - 1);
+	CHECK(arena.getCapacity() == 3 * MemoryArena::CACHE_LINE_SIZE);
+	CHECK(arena.getUsedSize() == 0);
+}
+
+TEST_CASE("MemoryArena should allocate zeroed cache-line-aligned chunks that don't overlap") {
+	MemoryArena arena(4 * MemoryArena::CACHE_LINE_SIZE);
+
+	Bit8u *firstChunk = static_cast<Bit8u *>(arena.allocate(1));
+	REQUIRE(firstChunk != NULL_PTR);
+	CHECK(isCacheLineAligned(firstChunk));
+	CHECK(arena.getUsedSize() == MemoryArena::CACHE_LINE_SIZE);
+
+	Bit32u *secondChunk = arena.allocateArray<Bit32u>(MemoryArena::CACHE_LINE_SIZE / sizeof(Bit32u) + 1);
+	REQUIRE(secondChunk != NULL_PTR);
+	CHECK(isCacheLineAligned(secondChunk));
+	CHECK(reinterpret_cast<Bit8u *>(secondChunk) == firstChunk + MemoryArena::CACHE_LINE_SIZE);
+	CHECK(arena.getUsedSize() == 3 * MemoryArena::CACHE_LINE_SIZE);
+
+	size_t nonZeroByteCount = 0;
+	for (size_t i = 0; i < 3 * MemoryArena::CACHE_LINE_SIZE; i++) {
+		if (firstChunk[i] != 0) nonZeroByteCount++;
+	}
+	CHECK(nonZeroByteCount == 0);
+}
+
+TEST_CASE("MemoryArena should refuse allocations exceeding the remaining capacity") {
+	MemoryArena arena(2 * MemoryArena::CACHE_LINE_SIZE);
+	REQUIRE(arena.allocate(MemoryArena::CACHE_LINE_SIZE) != NULL_PTR);
+
+	CHECK(arena.allocate(MemoryArena::CACHE_LINE_SIZE + 1) == NULL_PTR);
+	CHECK(arena.getUsedSize() == MemoryArena::CACHE_LINE_SIZE);
+
+	CHECK(arena.allocate(MemoryArena::CACHE_LINE_SIZE) != NULL_PTR);
+	CHECK(arena.getUsedSize() == arena.getCapacity());
+	CHECK(arena.allocate(1) == NULL_PTR);
+}
+
+TEST_CASE("MemoryArena should carve sub-arenas out of chunks of another arena") {
+	MemoryArena arena(4 * MemoryArena::CACHE_LINE_SIZE);
+	void *chunk = arena.allocate(2 * MemoryArena::CACHE_LINE_SIZE);
+	REQUIRE(chunk != NULL_PTR);
+	memset(chunk, 0xFF, 2 * MemoryArena::CACHE_LINE_SIZE);
+
+	MemoryArena subArena(chunk, 2 * MemoryArena::CACHE_LINE_SIZE);
+	CHECK(subArena.getCapacity() == 2 * MemoryArena::CACHE_LINE_SIZE);
+	CHECK_FALSE(subArena.isBackedByLargePages());
+	CHECK_FALSE(subArena.isLocked());
+
+	Bit8u *subChunk = static_cast<Bit8u *>(subArena.allocate(2 * MemoryArena::CACHE_LINE_SIZE));
+	REQUIRE(subChunk == chunk);
+	CHECK(subChunk[0] == 0);
+	CHECK(subChunk[2 * MemoryArena::CACHE_LINE_SIZE - 1] == 0);
+	CHECK(subArena.allocate(1) == NULL_PTR);
+	CHECK(arena.getUsedSize() == 2 * MemoryArena::CACHE_LINE_SIZE);
+}
+
+TEST_CASE("MemoryArena should provide usable memory whether or not large pages and locking are available") {
+	bool useLargePages = false;
+	bool lockMemory = false;
+
+	SUBCASE("With large pages") {
+		useLargePages = true;
+	}
+
+	SUBCASE("With locked memory") {
+		lockMemory = true;
+	}
+
+	SUBCASE("With large pages and locked memory") {
+		useLargePages = true;
+		lockMemory = true;
+	}
+
+	// Both options are best effort, so only consistency of the reported state is verified.
+	MemoryArena arena(16 * MemoryArena::CACHE_LINE_SIZE, useLargePages, lockMemory);
+	CHECK((useLargePages || !arena.isBackedByLargePages()));
+	CHECK((lockMemory || !arena.isLocked()));
+
+	Bit8u *chunk = static_cast<Bit8u *>(arena.allocate(16 * MemoryArena::CACHE_LINE_SIZE));
+	REQUIRE(chunk != NULL_PTR);
+	CHECK(isCacheLineAligned(chunk));
+	CHECK(chunk[16 * MemoryArena::CACHE_LINE_SIZE - 1] == 0);
+	memset(chunk, 0xFF, 16 * MemoryArena::CACHE_LINE_SIZE);
+}
+
+TEST_CASE("PartialManager arena should be recreated when the synth is reopened") {
+	Synth synth;
+	ROMSet romSet;
+	romSet.initMT32New();
+
+	SUBCASE("With integer renderer") {
+		synth.selectRendererType(RendererType_BIT16S);
+	}
+
+	SUBCASE("With float renderer") {
+		synth.selectRendererType(RendererType_FLOAT);
+	}
+
+	openSynth(synth, romSet, DEFAULT_MAX_PARTIALS / 2);
+	const PartialManager *partialManager = PartialManager::getPartialManager(synth);
+	REQUIRE(partialManager != NULL_PTR);
+	CHECK(partialManager->getPartial(DEFAULT_MAX_PARTIALS / 2 - 1) != NULL_PTR);
+	CHECK(partialManager->getPartial(DEFAULT_MAX_PARTIALS / 2) == NULL_PTR);
+	synth.close();
+
+	openSynth(synth, romSet, 2 * DEFAULT_MAX_PARTIALS);
+	partialManager = PartialManager::getPartialManager(synth);
+	REQUIRE(partialManager != NULL_PTR);
+	for (unsigned int i = 0; i < 2 * DEFAULT_MAX_PARTIALS; i++) {
+		const Partial *partial = partialManager->getPartial(i);
+		REQUIRE(partial != NULL_PTR);
+		CHECK(isCacheLineAligned(partial));
+		CHECK_FALSE(partial->isActive());
+	}
+
+	sendSineWaveSysex(synth, 1);
+	sendNoteOn(synth, 1, 60, 100);
+	CHECK(synth.hasActivePartials());
+	skipRenderedFrames(synth, 256);
+}
+
+TEST_CASE("Synth should render with large pages and memory locking requested") {
+	Synth synth;
+	ROMSet romSet;
+	romSet.initMT32New();
+	synth.setLargePagesEnabled(true);
+	synth.setMemoryLockingEnabled(true);
+	CHECK(synth.isLargePagesEnabled());
+	CHECK(synth.isMemoryLockingEnabled());
+
+	openSynth(synth, romSet);
+	sendSineWaveSysex(synth, 1);
+	sendNoteOn(synth, 1, 60, 100);
+	CHECK(synth.hasActivePartials());
+	skipRenderedFrames(synth, 256);
+	synth.close();
+
+	synth.setLargePagesEnabled(false);
+	synth.setMemoryLockingEnabled(false);
+	openSynth(synth, romSet);
+	sendSineWaveSysex(synth, 1);
+	sendNoteOn(synth, 1, 60, 100);
+	CHECK(synth.hasActivePartials());
+	skipRenderedFrames(synth, 256);
+}
+
+
+} // namespace Test
+
+} // namespace MT32Emu
@@ -0,0 +1,203 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include "../File.h"
+#include "../MappedFile.h"
+#include "../ROMIndex.h"
+
+#include "Testing.h"
+
+namespace MT32Emu {
+
+namespace Test {
+
+namespace {
+
+const char ROM_FILENAME[] = "mt32emu-rom-index-test.rom";
+const char SIDECAR_FILENAME[] = "mt32emu-rom-index-test.rom.sha1";
+const char INDEX_FILENAME[] = "mt32emu-rom-index-test.idx";
+// Matches the size of the MT-32 control ROMs, so that the file is indexed.
+const size_t ROM_FILE_SIZE = 65536;
+const char OTHER_SHA1[] = "0123456789abcdef0123456789abcdef01234567";
+
+void writeTextFile(const char *filename, const std::string &contents) {
+	std::ofstream ofs(filename, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	ofs << contents;
+	ofs.close();
+	REQUIRE_FALSE(ofs.fail());
+}
+
+std::string readTextFile(const char *filename) {
+	std::ifstream ifs(filename, std::ios_base::in | std::ios_base::binary);
+	std::string contents;
+	std::getline(ifs, contents, '\0');
+	return contents;
+}
+
+// Creates a ROM-sized file and removes the files created by a test case, even if it fails.
+struct Context {
+	Bit8u romData[ROM_FILE_SIZE];
+	File::SHA1Digest romSHA1;
+
+	Context() {
+		for (size_t i = 0; i < ROM_FILE_SIZE; i++) {
+			romData[i] = Bit8u(i * 7);
+		}
+		ArrayFile romFile(romData, ROM_FILE_SIZE);
+		memcpy(romSHA1, romFile.getSHA1(), sizeof romSHA1);
+		writeTextFile(ROM_FILENAME, std::string(reinterpret_cast<const char *>(romData), ROM_FILE_SIZE));
+		remove(SIDECAR_FILENAME);
+		remove(INDEX_FILENAME);
+	}
+
+	~Context() {
+		remove(ROM_FILENAME);
+		remove(SIDECAR_FILENAME);
+		remove(INDEX_FILENAME);
+	}
+
+	// Indexes the ROM file and returns the digest it ends up with.
+	std::string indexROMFile(ROMIndex &index, bool useSidecar = false) {
+		MappedFile file;
+		REQUIRE(file.open(ROM_FILENAME));
+		if (useSidecar) REQUIRE(file.loadSHA1Sidecar(ROM_FILENAME));
+		index.indexFile(file, ROM_FILENAME);
+		return file.getSHA1();
+	}
+
+	// Saves the index with the ROM file indexed and returns the entry line.
+	std::string saveIndexEntry() {
+		ROMIndex index;
+		CHECK(indexROMFile(index) == romSHA1);
+		REQUIRE(index.save(INDEX_FILENAME));
+		std::string contents = readTextFile(INDEX_FILENAME);
+		size_t entryStart = contents.find('\n');
+		REQUIRE(entryStart != std::string::npos);
+		return contents.substr(entryStart + 1);
+	}
+};
+
+} // namespace
+
+TEST_CASE("ROMIndex should record the digests of files with the size of a known ROM") {
+	Context ctx;
+	ROMIndex index;
+	CHECK_FALSE(index.isModified());
+
+	SUBCASE("ROM-sized file") {
+		CHECK(ctx.indexROMFile(index) == ctx.romSHA1);
+		CHECK(index.isModified());
+		REQUIRE(index.save(INDEX_FILENAME));
+		CHECK_FALSE(index.isModified());
+		std::string contents = readTextFile(INDEX_FILENAME);
+		CHECK(contents.find(ctx.romSHA1) != std::string::npos);
+		CHECK(contents.find(ROM_FILENAME) != std::string::npos);
+	}
+
+	SUBCASE("File of other size") {
+		writeTextFile(ROM_FILENAME, "Not a ROM");
+		ctx.indexROMFile(index);
+		CHECK_FALSE(index.isModified());
+	}
+}
+
+TEST_CASE("ROMIndex should supply the recorded digest while the file is unchanged") {
+	Context ctx;
+	std::string entry = ctx.saveIndexEntry();
+	// Substitute the digest, so that it is evident where the file gets it from.
+	writeTextFile(INDEX_FILENAME, "mt32emu-rom-index 1\n" + std::string(OTHER_SHA1) + entry.substr(strlen(OTHER_SHA1)));
+
+	ROMIndex index;
+	REQUIRE(index.load(INDEX_FILENAME));
+	CHECK(ctx.indexROMFile(index) == OTHER_SHA1);
+	CHECK_FALSE(index.isModified());
+}
+
+TEST_CASE("ROMIndex should compute the digest again once the file changes") {
+	Context ctx;
+	std::string entry = ctx.saveIndexEntry();
+	std::string changedEntry = std::string(OTHER_SHA1) + entry.substr(strlen(OTHER_SHA1));
+
+	SUBCASE("Modification time within the same second") {
+		// The nanoseconds are the last number before the file name.
+		size_t nanosEnd = changedEntry.find(' ', strlen(OTHER_SHA1) + 1);
+		nanosEnd = changedEntry.find(' ', nanosEnd + 1);
+		nanosEnd = changedEntry.find(' ', nanosEnd + 1);
+		REQUIRE(nanosEnd != std::string::npos);
+		changedEntry[nanosEnd - 1] = changedEntry[nanosEnd - 1] == '1' ? '2' : '1';
+	}
+
+	SUBCASE("File size") {
+		size_t sizeStart = strlen(OTHER_SHA1) + 1;
+		changedEntry.replace(sizeStart, changedEntry.find(' ', sizeStart) - sizeStart, "65535");
+	}
+
+	writeTextFile(INDEX_FILENAME, "mt32emu-rom-index 1\n" + changedEntry);
+	ROMIndex index;
+	REQUIRE(index.load(INDEX_FILENAME));
+	CHECK(ctx.indexROMFile(index) == ctx.romSHA1);
+	CHECK(index.isModified());
+}
+
+TEST_CASE("ROMIndex should not record digests provided by sidecars") {
+	Context ctx;
+	writeTextFile(SIDECAR_FILENAME, OTHER_SHA1);
+	ROMIndex index;
+	CHECK(ctx.indexROMFile(index, true) == OTHER_SHA1);
+	CHECK_FALSE(index.isModified());
+
+	// Once a computed digest is recorded, it takes precedence over the sidecar.
+	CHECK(ctx.indexROMFile(index) == ctx.romSHA1);
+	CHECK(index.isModified());
+	CHECK(ctx.indexROMFile(index, true) == ctx.romSHA1);
+}
+
+TEST_CASE("ROMIndex should refuse malformed index files") {
+	Context ctx;
+	std::string entry = ctx.saveIndexEntry();
+	ROMIndex index;
+
+	SUBCASE("Missing file") {
+		remove(INDEX_FILENAME);
+	}
+
+	SUBCASE("Wrong signature") {
+		writeTextFile(INDEX_FILENAME, "mt32emu-rom-index 0\n" + entry);
+	}
+
+	SUBCASE("Short digest") {
+		writeTextFile(INDEX_FILENAME, "mt32emu-rom-index 1\n" + entry.substr(1));
+	}
+
+	SUBCASE("Missing file name") {
+		writeTextFile(INDEX_FILENAME, "mt32emu-rom-index 1\n" + entry.substr(0, entry.rfind(' ')) + "\n");
+	}
+
+	CHECK_FALSE(index.load(INDEX_FILENAME));
+	// The index remains empty, so the digest is computed and recorded anew.
+	CHECK(ctx.indexROMFile(index) == ctx.romSHA1);
+	CHECK(index.isModified());
+}
+
+} // namespace Test
+
+} // namespace MT32Emu
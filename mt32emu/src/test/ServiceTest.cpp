@@ -207,6 +207,81 @@ TEST_CASE_TEMPLATE("Service should store internal state into SysEx bank and rest
 	CHECK(service.getContext() == NULL_PTR);
 }
 
+TEST_CASE_TEMPLATE("Service should save and load synth state ", ServiceImpl, TestTypes) {
+	TestService<ServiceImpl> service;
+	service.createContext();
+	REQUIRE(service.getContext() != NULL_PTR);
+
+	CHECK(service.saveState(NULL, 0) == 0);
+
+	ROMSet romSet;
+	romSet.initMT32New();
+	service.addROMSet(romSet);
+
+	mt32emu_return_code rc = service.openSynth();
+	CHECK(rc == MT32EMU_RC_OK);
+	CHECK(service.isOpen());
+
+	Bit16s buffer[2 * 16];
+	service.renderBit16s(buffer, 16);
+	Bit32u stateSize = service.saveState(NULL, 0);
+	REQUIRE(stateSize > 0);
+	Bit8u *state = new Bit8u[stateSize];
+	CHECK(service.saveState(state, stateSize) == stateSize);
+
+	service.renderBit16s(buffer, 16);
+	CHECK(service.getInternalRenderedSampleCount() == 32);
+	rc = service.loadState(state, stateSize);
+	CHECK(rc == MT32EMU_RC_OK);
+	CHECK(service.getInternalRenderedSampleCount() == 16);
+	rc = service.loadState(state, stateSize - 1);
+	CHECK(rc == MT32EMU_RC_FAILED);
+
+	delete[] state;
+
+	service.freeContext();
+	CHECK(service.getContext() == NULL_PTR);
+}
+
+TEST_CASE_TEMPLATE("Service should provide state snapshots if enabled ", ServiceImpl, TestTypes) {
+	TestService<ServiceImpl> service;
+	service.createContext();
+	REQUIRE(service.getContext() != NULL_PTR);
+
+	ROMSet romSet;
+	romSet.initMT32New();
+	service.addROMSet(romSet);
+
+	CHECK_FALSE(service.isStateSnapshotsEnabled());
+	service.setStateSnapshotsEnabled(true);
+	CHECK(service.isStateSnapshotsEnabled());
+
+	mt32emu_state_snapshot snapshot;
+	Bit8u partialStates[DEFAULT_MAX_PARTIALS >> 2];
+	snapshot.keys = NULL;
+	snapshot.velocities = NULL;
+	snapshot.partial_states = partialStates;
+	CHECK_FALSE(service.getStateSnapshot(&snapshot));
+
+	mt32emu_return_code rc = service.openSynth();
+	CHECK(rc == MT32EMU_RC_OK);
+	CHECK(service.isOpen());
+
+	Bit16s buffer[2 * 16];
+	service.renderBit16s(buffer, 16);
+	REQUIRE(service.getStateSnapshot(&snapshot));
+	CHECK(snapshot.rendered_sample_count == 16);
+	CHECK(snapshot.part_states == 0);
+	CHECK(snapshot.playing_note_counts[0] == 0);
+	for (Bit32u i = 0; i < (DEFAULT_MAX_PARTIALS >> 2); i++) {
+		CAPTURE(i);
+		CHECK(partialStates[i] == 0);
+	}
+
+	service.freeContext();
+	CHECK(service.getContext() == NULL_PTR);
+}
+
 template <class ReportHandlerImpl>
 static ReportHandler3 *ensureNewContextReportHandler(Service &service, ReportHandlerImpl &rh) {
 	service.createContext(rh);
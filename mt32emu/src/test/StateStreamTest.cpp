@@ -0,0 +1,192 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011-2026 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "../LA32WaveGenerator.h"
+#include "../LA32FloatWaveGenerator.h"
+#include "../PartialManager.h"
+#include "../Poly.h"
+#include "../StateStream.h"
+#include "../Synth.h"
+#include "../TVA.h"
+#include "../TVF.h"
+#include "../TVP.h"
+
+#include "FakeROMs.h"
+#include "TestUtils.h"
+#include "Testing.h"
+
+namespace MT32Emu {
+
+namespace Test {
+
+namespace {
+
+// Large enough to hold the state of any single object tested here.
+const Bit32u STATE_BUFFER_SIZE = 256;
+
+struct Context {
+	Synth synth;
+	ROMSet romSet;
+	// Resembles the state written by a newer build or damaged in transit.
+	Bit8u garbage[STATE_BUFFER_SIZE];
+
+	Context() {
+		romSet.initMT32New();
+		openSynth(synth, romSet);
+		memset(garbage, 0xFF, sizeof garbage);
+	}
+
+	const Bit16s *getPCMROMStart() {
+		Bit8u buffer[sizeof(Bit32u)];
+		StateWriter writer(synth, buffer, sizeof buffer);
+		writer.write(Bit32u(0));
+		StateReader reader(synth, buffer, sizeof buffer);
+		return reader.readPCMPointer();
+	}
+
+	const Partial *getPartial() {
+		return PartialManager::getPartialManager(synth)->getPartial(0);
+	}
+};
+
+template <class WaveGenerator>
+Bit32u saveWaveGeneratorState(Synth &synth, const WaveGenerator &generator, Bit8u *state) {
+	StateWriter writer(synth, state, STATE_BUFFER_SIZE);
+	generator.saveState(writer);
+	REQUIRE(writer.isComplete());
+	return writer.getSize();
+}
+
+template <class WaveGenerator>
+void checkPCMWaveLengthValidated(Context &ctx) {
+	const Bit16s *pcmROMStart = ctx.getPCMROMStart();
+	REQUIRE(pcmROMStart != NULL_PTR);
+
+	WaveGenerator generator = WaveGenerator();
+	Bit8u state[STATE_BUFFER_SIZE];
+	Bit8u otherState[STATE_BUFFER_SIZE];
+	generator.initPCM(pcmROMStart, 8, true, true);
+	Bit32u stateSize = saveWaveGeneratorState(ctx.synth, generator, state);
+	generator.initPCM(pcmROMStart, 9, true, true);
+	REQUIRE(saveWaveGeneratorState(ctx.synth, generator, otherState) == stateSize);
+
+	// The states only differ in the lowest byte of the wave length.
+	Bit32u lengthByteIx = stateSize;
+	for (Bit32u i = 0; i < stateSize; i++) {
+		if (state[i] == otherState[i]) continue;
+		REQUIRE(lengthByteIx == stateSize);
+		lengthByteIx = i;
+	}
+	REQUIRE(lengthByteIx < stateSize);
+
+	WaveGenerator loadedGenerator = WaveGenerator();
+	StateReader reader(ctx.synth, state, stateSize);
+	loadedGenerator.loadState(reader);
+	CHECK_FALSE(reader.isFailed());
+	CHECK(reader.isAtEnd());
+	CHECK(loadedGenerator.isActive());
+	CHECK(loadedGenerator.isPCMWave());
+
+	// An empty wave leaves no valid position.
+	state[lengthByteIx] = 0;
+	StateReader corruptedStateReader(ctx.synth, state, stateSize);
+	loadedGenerator.loadState(corruptedStateReader);
+	CHECK(corruptedStateReader.isFailed());
+	CHECK_FALSE(loadedGenerator.isActive());
+	CHECK_FALSE(loadedGenerator.isPCMWave());
+}
+
+template <class EnvelopeGenerator>
+void checkPartialParametersRequired(Context &ctx, EnvelopeGenerator &generator) {
+	StateReader inactivePartialReader(ctx.synth, ctx.garbage, sizeof ctx.garbage);
+	generator.loadState(inactivePartialReader, false);
+	CHECK_FALSE(inactivePartialReader.isFailed());
+
+	StateReader activePartialReader(ctx.synth, ctx.garbage, sizeof ctx.garbage);
+	generator.loadState(activePartialReader, true);
+	CHECK(activePartialReader.isFailed());
+}
+
+} // namespace
+
+TEST_CASE("StateReader should refuse PCM waves that overrun the PCM ROM") {
+	Context ctx;
+	Bit8u state[2 * sizeof(Bit32u)];
+	StateWriter writer(ctx.synth, state, sizeof state);
+	writer.write(Bit32u(0));
+	Bit32u length = 1;
+
+	SUBCASE("Wave within the ROM") {
+		writer.write(length);
+		StateReader reader(ctx.synth, state, sizeof state);
+		CHECK(reader.readPCMWave(length) == ctx.getPCMROMStart());
+		CHECK(length == 1);
+		CHECK_FALSE(reader.isFailed());
+	}
+
+	SUBCASE("Wave past the end of the ROM") {
+		writer.write(Bit32u(0xFFFFFFFF));
+		StateReader reader(ctx.synth, state, sizeof state);
+		CHECK(reader.readPCMWave(length) == NULL_PTR);
+		CHECK(reader.isFailed());
+	}
+}
+
+TEST_CASE("LA32WaveGenerator should refuse to load PCM wave position past the end of the wave") {
+	Context ctx;
+	checkPCMWaveLengthValidated<LA32WaveGenerator>(ctx);
+}
+
+TEST_CASE("LA32FloatWaveGenerator should refuse to load PCM wave position past the end of the wave") {
+	Context ctx;
+	checkPCMWaveLengthValidated<LA32FloatWaveGenerator>(ctx);
+}
+
+TEST_CASE("Envelope generators should refuse to load state without the parameters of an active partial") {
+	Context ctx;
+	const Partial *partial = ctx.getPartial();
+	REQUIRE(partial != NULL_PTR);
+
+	SUBCASE("TVA") {
+		TVA tva(partial, NULL);
+		checkPartialParametersRequired(ctx, tva);
+	}
+
+	SUBCASE("TVP") {
+		TVP tvp(partial);
+		checkPartialParametersRequired(ctx, tvp);
+	}
+
+	SUBCASE("TVF") {
+		TVF tvf(partial, NULL);
+		checkPartialParametersRequired(ctx, tvf);
+	}
+}
+
+TEST_CASE("Poly should refuse to load invalid state") {
+	Context ctx;
+	Poly poly;
+	StateReader reader(ctx.synth, ctx.garbage, sizeof ctx.garbage);
+	poly.loadState(reader);
+	CHECK(reader.isFailed());
+}
+
+} // namespace Test
+
+} // namespace MT32Emu
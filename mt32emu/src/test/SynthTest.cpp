@@ -523,6 +523,49 @@ TEST_CASE("Synth should set Master Volume via SysEx and override optionally") {
 	}
 }
 
+TEST_CASE("Synth should play referenced SysEx without taking ownership of the data") {
+	Synth synth;
+	ROMSet romSet;
+
+	SUBCASE("Dynamic SysEx storage") {}
+
+	SUBCASE("Buffered SysEx storage") {
+		synth.configureMIDIEventQueueSysexStorage(32768);
+	}
+
+	openSynthWithMT32NewROMSet(synth, romSet);
+	CHECK(synth.getPendingReferencedSysexCount() == 0);
+
+	Bit8u sysex[] = { 0xF0, 0x41, 0x10, 0x16, 0x12, 0x10, 0x00, 0x16, 0x17, 0x43, 0xF7 };
+	Bit8u otherSysex[] = { 0xF0, 0x41, 0x10, 0x16, 0x12, 0x10, 0x00, 0x16, 0x40, 0x1A, 0xF7 };
+	Bit32u timestamp = synth.getInternalRenderedSampleCount() + 100;
+	REQUIRE(synth.playReferencedSysex(sysex, sizeof sysex, timestamp));
+	REQUIRE(synth.playReferencedSysex(otherSysex, sizeof otherSysex, timestamp + 100));
+	CHECK(synth.getPendingReferencedSysexCount() == 2);
+	skipRenderedFrames(synth, 50);
+	CHECK(synth.getPendingReferencedSysexCount() == 2);
+	CHECK(readMasterVolume(synth) == 100);
+
+	// The messages are processed in order, so the data of the first one is no longer used.
+	skipRenderedFrames(synth, 100);
+	CHECK(synth.getPendingReferencedSysexCount() == 1);
+	CHECK(readMasterVolume(synth) == 23);
+
+	skipRenderedFrames(synth, 100);
+	CHECK(synth.getPendingReferencedSysexCount() == 0);
+	CHECK(readMasterVolume(synth) == 64);
+
+	// Once processed, the data can be reused.
+	// Flushing the MIDI queue processes referenced SysEx data as well.
+	sysex[8] = 0x50;
+	sysex[9] = 0x0A;
+	REQUIRE(synth.playReferencedSysex(sysex, sizeof sysex, synth.getInternalRenderedSampleCount() + 100));
+	CHECK(synth.getPendingReferencedSysexCount() == 1);
+	synth.flushMIDIQueue();
+	CHECK(synth.getPendingReferencedSysexCount() == 0);
+	CHECK(readMasterVolume(synth) == 80);
+}
+
 TEST_CASE("Synth should store internal state into SysEx bank and restore it back") {
 	Synth synth;
 	ROMSet romSet;
@@ -559,6 +602,405 @@ TEST_CASE("Synth should store internal state into SysEx bank and restore it back
 	delete[] sysexBank;
 }
 
+TEST_CASE("Synth should publish state snapshots when rendering if enabled") {
+	Synth synth;
+	ROMSet romSet;
+	romSet.initMT32New();
+
+	Bit8u keys[DEFAULT_MAX_PARTIALS];
+	Bit8u velocities[DEFAULT_MAX_PARTIALS];
+	PartialState partialStates[DEFAULT_MAX_PARTIALS];
+	Bit8u packedPartialStates[DEFAULT_MAX_PARTIALS >> 2];
+	StateSnapshot snapshot;
+	snapshot.keys = keys;
+	snapshot.velocities = velocities;
+	snapshot.partialStates = partialStates;
+	snapshot.packedPartialStates = packedPartialStates;
+
+	CHECK_FALSE(synth.isStateSnapshotsEnabled());
+	CHECK_FALSE(synth.getStateSnapshot(snapshot));
+
+	SUBCASE("Snapshots are unavailable when disabled") {
+		openSynth(synth, romSet);
+		skipRenderedFrames(synth, 16);
+		CHECK_FALSE(synth.getStateSnapshot(snapshot));
+	}
+
+	SUBCASE("Snapshots reflect the state at the end of the last rendering pass") {
+		synth.setStateSnapshotsEnabled(true);
+		CHECK(synth.isStateSnapshotsEnabled());
+		openSynth(synth, romSet);
+		sendSineWaveSysex(synth, 1);
+		sendNoteOn(synth, 1, 36, 100);
+
+		REQUIRE(synth.getStateSnapshot(snapshot));
+		CHECK(snapshot.renderedSampleCount == 0);
+		CHECK(snapshot.playingNoteCounts[0] == 0);
+
+		skipRenderedFrames(synth, 16);
+		REQUIRE(synth.getStateSnapshot(snapshot));
+		CHECK(snapshot.renderedSampleCount == 16);
+		CHECK(snapshot.partStates == synth.getPartStates());
+		CHECK(snapshot.partStates == 1);
+		CHECK(snapshot.playingNoteCounts[0] == 1);
+		CHECK(snapshot.keys[0] == 36);
+		CHECK(snapshot.velocities[0] == 100);
+		for (Bit32u i = 1; i < 9; i++) {
+			CAPTURE(i);
+			CHECK(snapshot.playingNoteCounts[i] == 0);
+		}
+
+		PartialState actualPartialStates[DEFAULT_MAX_PARTIALS];
+		synth.getPartialStates(actualPartialStates);
+		MT32EMU_CHECK_MEMORY_EQUAL(snapshot.partialStates, actualPartialStates, sizeof actualPartialStates);
+		Bit8u actualPackedPartialStates[DEFAULT_MAX_PARTIALS >> 2];
+		synth.getPartialStates(actualPackedPartialStates);
+		MT32EMU_CHECK_MEMORY_EQUAL(snapshot.packedPartialStates, actualPackedPartialStates, sizeof actualPackedPartialStates);
+
+		char actualLCDState[21];
+		CHECK(snapshot.midiMessageLEDState == synth.getDisplayState(actualLCDState));
+		CHECK(strcmp(snapshot.lcdState, actualLCDState) == 0);
+
+		synth.close();
+		CHECK_FALSE(synth.getStateSnapshot(snapshot));
+	}
+}
+
+TEST_CASE("Synth should collect usage statistics when rendering") {
+	Synth synth;
+	ROMSet romSet;
+	romSet.initMT32New();
+	Statistics statistics;
+
+	CHECK_FALSE(synth.getStatistics(statistics));
+
+	openSynth(synth, romSet, 4);
+	REQUIRE(synth.getStatistics(statistics));
+	CHECK(statistics.renderedSampleCount == 0);
+	CHECK(statistics.renderPassCount == 0);
+
+	sendSineWaveSysex(synth, 1);
+	sendSineWaveSysex(synth, 2);
+	sendNoteOn(synth, 1, 36, 100);
+	sendNoteOn(synth, 1, 37, 100);
+	skipRenderedFrames(synth, 16);
+	sendNoteOn(synth, 1, 38, 100);
+	sendNoteOn(synth, 1, 39, 100);
+	skipRenderedFrames(synth, 16);
+
+	REQUIRE(synth.getStatistics(statistics));
+	CHECK(statistics.renderedSampleCount == 32);
+	CHECK(statistics.renderPassCount == 2);
+	CHECK(statistics.peakActivePartialCounts[0] == 4);
+	CHECK(statistics.averageActivePartialCounts[0] == 3.0f);
+	CHECK(statistics.peakActivePartialCount == 4);
+	for (Bit32u i = 1; i < 9; i++) {
+		CAPTURE(i);
+		CHECK(statistics.peakActivePartialCounts[i] == 0);
+		CHECK(statistics.averageActivePartialCounts[i] == 0.0f);
+	}
+	CHECK(statistics.silencedPolyCount == 0);
+	CHECK(statistics.ignoredNoteOnCount == 0);
+	CHECK(statistics.totalRenderPassDuration >= statistics.maxRenderPassDuration);
+	CHECK(statistics.totalMidiProcessingDuration >= 0);
+	CHECK(statistics.totalReverbDuration >= 0);
+	CHECK(statistics.totalAnalogDuration > 0);
+	CHECK(statistics.totalPartialRenderingDuration >= 0);
+	CHECK(statistics.totalPartialRenderingDuration <= statistics.totalRenderPassDuration);
+
+	// We don't have a reserve and this part has lower priority than the part all the other notes are playing on.
+	sendNoteOn(synth, 2, 36, 100);
+	sendNoteOn(synth, 1, 40, 100);
+	skipRenderedFrames(synth, 1024);
+	synth.playMsg(0x002581, 0);
+	synth.playMsg(0x002681, 0);
+	synth.playMsg(0x002781, 0);
+	skipRenderedFrames(synth, 16);
+
+	REQUIRE(synth.getStatistics(statistics));
+	CHECK(statistics.silencedPolyCount == 1);
+	CHECK(statistics.ignoredNoteOnCount == 1);
+	CHECK(statistics.midiQueueHighWaterMark == 3);
+
+	synth.resetStatistics();
+	REQUIRE(synth.getStatistics(statistics));
+	CHECK(statistics.renderPassCount == 4);
+
+	skipRenderedFrames(synth, 16);
+	REQUIRE(synth.getStatistics(statistics));
+	CHECK(statistics.renderedSampleCount == 16);
+	CHECK(statistics.renderPassCount == 1);
+	CHECK(statistics.silencedPolyCount == 0);
+	CHECK(statistics.ignoredNoteOnCount == 0);
+	CHECK(statistics.midiQueueHighWaterMark == 0);
+
+	synth.close();
+	CHECK_FALSE(synth.getStatistics(statistics));
+}
+
+TEST_CASE("Synth should attribute rendering time to the stages doing the work") {
+	Synth synth;
+	ROMSet romSet;
+	romSet.initMT32New();
+	openSynth(synth, romSet);
+	synth.setMIDIDelayMode(MIDIDelayMode_IMMEDIATE);
+	Statistics statistics;
+
+	// Without MIDI input and with the reverb disabled, only the analog circuitry emulation is doing the work.
+	synth.setReverbEnabled(false);
+	skipRenderedFrames(synth, 4096);
+	REQUIRE(synth.getStatistics(statistics));
+	CHECK(statistics.totalMidiProcessingDuration == 0);
+	CHECK(statistics.totalReverbDuration == 0);
+	CHECK(statistics.totalAnalogDuration > 0);
+
+	// A burst of program changes handled within a few samples outweighs everything else.
+	synth.resetStatistics();
+	for (Bit32u i = 0; i < 256; i++) {
+		synth.playMsg(0xC1 | ((i & 0x7F) << 8), 0);
+	}
+	skipRenderedFrames(synth, 16);
+	REQUIRE(synth.getStatistics(statistics));
+	CHECK(statistics.totalMidiProcessingDuration > 0);
+	CHECK(statistics.totalMidiProcessingDuration > statistics.totalAnalogDuration);
+	CHECK(statistics.totalReverbDuration == 0);
+
+	// Reverb is only accounted for when enabled and the synth is active.
+	synth.setReverbEnabled(true);
+	synth.resetStatistics();
+	sendNoteOn(synth, 1, 60, 100);
+	skipRenderedFrames(synth, 4096);
+	REQUIRE(synth.getStatistics(statistics));
+	CHECK(statistics.totalReverbDuration > 0);
+	CHECK(statistics.totalPartialRenderingDuration > 0);
+}
+
+static void playReleasedSineWave(Synth &synth, const ROMSet &romSet) {
+	openSynth(synth, romSet);
+	sendSineWaveSysex(synth, 1);
+	sendNoteOn(synth, 1, 36, 100);
+	skipRenderedFrames(synth, 256);
+	sendNoteOn(synth, 1, 36, 0);
+	REQUIRE(synth.hasActivePartials());
+}
+
+TEST_CASE("Synth should stop rendering right after partials become inactive") {
+	Synth synth;
+	Synth referenceSynth;
+	ROMSet romSet;
+	romSet.initMT32New();
+	const Bit32u frameCount = 4096;
+
+	playReleasedSineWave(synth, romSet);
+	playReleasedSineWave(referenceSynth, romSet);
+
+	Bit16s buffer[2 * frameCount];
+	Bit32u renderedFrameCount = synth.renderWhilePartialsActive(buffer, frameCount);
+	CHECK(renderedFrameCount > 0);
+	CHECK(renderedFrameCount < frameCount);
+	CHECK_FALSE(synth.hasActivePartials());
+
+	// The output must match rendering one frame at a time until the partials become inactive, including the frame where they end.
+	Bit16s referenceBuffer[2 * frameCount];
+	Bit32u referenceFrameCount = 0;
+	while (referenceSynth.hasActivePartials() && referenceFrameCount < frameCount) {
+		referenceSynth.render(referenceBuffer + 2 * referenceFrameCount, 1);
+		referenceFrameCount++;
+	}
+	CHECK(renderedFrameCount == referenceFrameCount);
+	MT32EMU_CHECK_MEMORY_EQUAL(buffer, referenceBuffer, 4 * renderedFrameCount);
+
+	CHECK(synth.renderWhilePartialsActive(buffer, frameCount) == 0);
+	CHECK(synth.renderWhileActive(buffer, frameCount) == 0);
+}
+
+static void playSineWaveChord(Synth &synth, const ROMSet &romSet, RendererType rendererType, AnalogOutputMode analogOutputMode) {
+	synth.selectRendererType(rendererType);
+	REQUIRE(synth.open(*romSet.getControlROMImage(), *romSet.getPCMROMImage(), analogOutputMode));
+	sendSineWaveSysex(synth, 1);
+	sendNoteOn(synth, 1, 36, 100);
+	sendNoteOn(synth, 1, 48, 100);
+	skipRenderedFrames(synth, 300);
+	// Leave a pending event in the MIDI queue, so that it is stored with the state.
+	REQUIRE(synth.playMsg(0x3090 | 1, synth.getInternalRenderedSampleCount() + 200));
+}
+
+template <class Sample>
+static void checkStateRestoredBitExactly(const ROMSet &romSet, RendererType rendererType, AnalogOutputMode analogOutputMode) {
+	Synth synth;
+	playSineWaveChord(synth, romSet, rendererType, analogOutputMode);
+
+	Bit32u stateSize = synth.saveState(NULL, 0);
+	REQUIRE(stateSize > 0);
+	Bit8u *state = new Bit8u[stateSize];
+	CHECK(synth.saveState(state, stateSize) == stateSize);
+	Bit32u savedSampleCount = synth.getInternalRenderedSampleCount();
+
+	const Bit32u frameCount = 1024;
+	Sample buffer[2 * frameCount];
+	synth.render(buffer, frameCount);
+
+	SUBCASE("Same synth after seeking back") {
+		REQUIRE(synth.loadState(state, stateSize));
+		Sample restoredBuffer[2 * frameCount];
+		synth.render(restoredBuffer, frameCount);
+		MT32EMU_CHECK_MEMORY_EQUAL(buffer, restoredBuffer, sizeof buffer);
+	}
+
+	SUBCASE("Forked synth") {
+		Synth forkedSynth;
+		forkedSynth.selectRendererType(rendererType);
+		REQUIRE(forkedSynth.open(*romSet.getControlROMImage(), *romSet.getPCMROMImage(), analogOutputMode));
+		REQUIRE(forkedSynth.loadState(state, stateSize));
+		CHECK(forkedSynth.getInternalRenderedSampleCount() == savedSampleCount);
+		Sample restoredBuffer[2 * frameCount];
+		forkedSynth.render(restoredBuffer, frameCount);
+		MT32EMU_CHECK_MEMORY_EQUAL(buffer, restoredBuffer, sizeof buffer);
+	}
+
+	delete[] state;
+}
+
+TEST_CASE("Synth should restore saved internal state and continue rendering bit-exactly") {
+	ROMSet romSet;
+	romSet.initMT32New();
+
+	SUBCASE("16-bit integer samples") {
+		checkStateRestoredBitExactly<Bit16s>(romSet, RendererType_BIT16S, AnalogOutputMode_COARSE);
+	}
+
+	SUBCASE("Float samples") {
+		checkStateRestoredBitExactly<float>(romSet, RendererType_FLOAT, AnalogOutputMode_ACCURATE);
+	}
+}
+
+template <class Sample>
+static void checkPlanarOutputMatchesInterleaved(const ROMSet &romSet, RendererType rendererType, AnalogOutputMode analogOutputMode) {
+	Synth synth;
+	Synth referenceSynth;
+	playSineWaveChord(synth, romSet, rendererType, analogOutputMode);
+	playSineWaveChord(referenceSynth, romSet, rendererType, analogOutputMode);
+
+	const Bit32u frameCount = 1024;
+	Sample leftBuffer[frameCount];
+	Sample rightBuffer[frameCount];
+	synth.renderPlanar(leftBuffer, rightBuffer, frameCount);
+
+	Sample referenceBuffer[2 * frameCount];
+	referenceSynth.render(referenceBuffer, frameCount);
+	Sample referenceLeftBuffer[frameCount];
+	Sample referenceRightBuffer[frameCount];
+	for (Bit32u i = 0; i < frameCount; i++) {
+		referenceLeftBuffer[i] = referenceBuffer[2 * i];
+		referenceRightBuffer[i] = referenceBuffer[2 * i + 1];
+	}
+	MT32EMU_CHECK_MEMORY_EQUAL(leftBuffer, referenceLeftBuffer, sizeof leftBuffer);
+	MT32EMU_CHECK_MEMORY_EQUAL(rightBuffer, referenceRightBuffer, sizeof rightBuffer);
+}
+
+TEST_CASE("Synth should render planar output identical to interleaved") {
+	ROMSet romSet;
+	romSet.initMT32New();
+
+	SUBCASE("16-bit integer samples") {
+		checkPlanarOutputMatchesInterleaved<Bit16s>(romSet, RendererType_BIT16S, AnalogOutputMode_COARSE);
+	}
+
+	SUBCASE("Float samples") {
+		checkPlanarOutputMatchesInterleaved<float>(romSet, RendererType_FLOAT, AnalogOutputMode_ACCURATE);
+	}
+
+	SUBCASE("Float samples converted from 16-bit integer renderer") {
+		checkPlanarOutputMatchesInterleaved<float>(romSet, RendererType_BIT16S, AnalogOutputMode_OVERSAMPLED);
+	}
+}
+
+TEST_CASE("Synth should refuse to load incompatible or corrupted state") {
+	Synth synth;
+	ROMSet romSet;
+	romSet.initMT32New();
+
+	CHECK(synth.saveState(NULL, 0) == 0);
+	CHECK_FALSE(synth.loadState(NULL, 0));
+
+	playSineWaveChord(synth, romSet, RendererType_BIT16S, AnalogOutputMode_DIGITAL_ONLY);
+	Bit32u stateSize = synth.saveState(NULL, 0);
+	Bit8u *state = new Bit8u[stateSize];
+	REQUIRE(synth.saveState(state, stateSize) == stateSize);
+
+	SUBCASE("Incompatible synth remains unaffected") {
+		Synth otherSynth;
+		openSynth(otherSynth, romSet, DEFAULT_MAX_PARTIALS / 2);
+		sendSineWaveSysex(otherSynth, 1);
+		sendNoteOn(otherSynth, 1, 60, 100);
+		CHECK_FALSE(otherSynth.loadState(state, stateSize));
+		CHECK(otherSynth.getPartStates() == 1);
+	}
+
+	SUBCASE("Synth is reset upon loading truncated state") {
+		CHECK_FALSE(synth.loadState(state, stateSize - 1));
+		CHECK_FALSE(synth.hasActivePartials());
+		CHECK(synth.getPartStates() == 0);
+		skipRenderedFrames(synth, 256);
+		CHECK_FALSE(synth.hasActivePartials());
+	}
+
+	delete[] state;
+}
+
+TEST_CASE("Synth should fast-forward through MIDI events with the same timing as when rendering") {
+	Synth synth;
+	Synth referenceSynth;
+	ROMSet romSet;
+	romSet.initMT32New();
+	const Bit32u frameCount = 4096;
+	Bit16s buffer[2];
+
+	playReleasedSineWave(synth, romSet);
+	playReleasedSineWave(referenceSynth, romSet);
+
+	SUBCASE("Partials become inactive at the same sample") {
+		Bit32u fastForwardedFrameCount = 0;
+		while (synth.hasActivePartials() && fastForwardedFrameCount < frameCount) {
+			synth.fastForward(1);
+			fastForwardedFrameCount++;
+		}
+		Bit32u referenceFrameCount = 0;
+		while (referenceSynth.hasActivePartials() && referenceFrameCount < frameCount) {
+			referenceSynth.render(buffer, 1);
+			referenceFrameCount++;
+		}
+		CHECK(fastForwardedFrameCount < frameCount);
+		CHECK(fastForwardedFrameCount == referenceFrameCount);
+		CHECK(synth.getInternalRenderedSampleCount() == referenceSynth.getInternalRenderedSampleCount());
+	}
+
+	SUBCASE("Queued events play at the same sample") {
+		REQUIRE(synth.playMsg(0x7F3090 | 1, synth.getInternalRenderedSampleCount() + frameCount));
+		REQUIRE(referenceSynth.playMsg(0x7F3090 | 1, referenceSynth.getInternalRenderedSampleCount() + frameCount));
+		Bit32u fastForwardedFrameCount = 0;
+		while (synth.getPartStates() == 0 && fastForwardedFrameCount < 2 * frameCount) {
+			synth.fastForward(1);
+			fastForwardedFrameCount++;
+		}
+		Bit32u referenceFrameCount = 0;
+		while (referenceSynth.getPartStates() == 0 && referenceFrameCount < 2 * frameCount) {
+			referenceSynth.render(buffer, 1);
+			referenceFrameCount++;
+		}
+		CHECK(fastForwardedFrameCount >= frameCount);
+		CHECK(fastForwardedFrameCount == referenceFrameCount);
+
+		PartialState partialStates[DEFAULT_MAX_PARTIALS];
+		PartialState referencePartialStates[DEFAULT_MAX_PARTIALS];
+		synth.fastForward(frameCount);
+		skipRenderedFrames(referenceSynth, frameCount);
+		synth.getPartialStates(partialStates);
+		referenceSynth.getPartialStates(referencePartialStates);
+		MT32EMU_CHECK_MEMORY_EQUAL(partialStates, referencePartialStates, sizeof partialStates);
+	}
+}
+
 } // namespace Test
 
 } // namespace MT32Emu
@@ -18,9 +18,12 @@
 
 #include "AudioFileWriter.h"
 
+#include "FLACEncoder.h"
 #include "MasterClock.h"
 #include "Master.h"
 #include "MidiParser.h"
+#include "QAtomicHelper.h"
+#include "QRingBuffer.h"
 #include "QSynth.h"
 #include "audiodrv/AudioFileWriterDriver.h"
 
@@ -36,6 +39,118 @@ static const unsigned int WAVE_SAMPLE_RATE_OFFSET = 24;
 static const unsigned int WAVE_BYTE_RATE_OFFSET = 28;
 static const unsigned int WAVE_DATA_SIZE_OFFSET = 40;
 static const unsigned int WAVE_HEADER_LENGTH = 44;
+static const quint32 FLAC_RING_BUFFER_SIZE = 1 << 20;
+// Number of buffers cycled between the rendering and the writer threads.
+static const uint RENDER_PIPELINE_BUFFER_COUNT = 3;
+
+// Encodes the audio data to FLAC on a separate thread, so that compression overlaps rendering.
+// The frames are passed from the producer thread through a lock-free ring buffer. Either thread sleeps on the wait
+// condition while the ring buffer is full or empty respectively, the mutex only guards against missed wake-ups.
+class AudioFileWriter::FLACEncoderThread : public QThread {
+public:
+	FLACEncoderThread(uint sampleRate, QFile &file) :
+		encoder(sampleRate, 2), file(file), ringBuffer(FLAC_RING_BUFFER_SIZE), finishRequested(false), failed(false)
+	{}
+
+	// Copies the frames in native byte order to the ring buffer, waiting for free space when necessary.
+	// Returns false if the encoder thread failed to write the output.
+	bool push(const qint16 *frames, uint frameCount) {
+		while (frameCount > 0) {
+			quint32 bytesFree;
+			bool freeSpaceContiguous;
+			void *writePointer = ringBuffer.writePointer(bytesFree, freeSpaceContiguous);
+			uint framesToWrite = qMin(frameCount, uint(bytesFree / FRAME_SIZE));
+			if (framesToWrite == 0) {
+				QMutexLocker locker(&mutex);
+				if (failed) return false;
+				ringBuffer.writePointer(bytesFree, freeSpaceContiguous);
+				if (bytesFree < FRAME_SIZE) ringBufferChanged.wait(&mutex);
+				continue;
+			}
+			memcpy(writePointer, frames, framesToWrite * FRAME_SIZE);
+			ringBuffer.advanceWritePointer(framesToWrite * FRAME_SIZE);
+			frames += framesToWrite << 1;
+			frameCount -= framesToWrite;
+			QMutexLocker locker(&mutex);
+			ringBufferChanged.wakeAll();
+			if (failed) return false;
+		}
+		return true;
+	}
+
+	// Lets the encoder thread drain the ring buffer and waits for it to complete.
+	bool finish() {
+		{
+			QMutexLocker locker(&mutex);
+			finishRequested = true;
+			ringBufferChanged.wakeAll();
+		}
+		wait();
+		return !failed;
+	}
+
+	bool writeStreamHeader() {
+		uchar header[FLACEncoder::STREAM_HEADER_SIZE];
+		encoder.makeStreamHeader(header);
+		file.seek(0);
+		return file.write((const char *)header, FLACEncoder::STREAM_HEADER_SIZE) == FLACEncoder::STREAM_HEADER_SIZE;
+	}
+
+private:
+	FLACEncoder encoder;
+	QFile &file;
+	Utility::QRingBuffer ringBuffer;
+	QMutex mutex;
+	// Woken whenever frames are pushed to or consumed from the ring buffer, or the state of the encoding changes otherwise.
+	QWaitCondition ringBufferChanged;
+	bool finishRequested;
+	bool failed;
+
+	void run() {
+		for (;;) {
+			quint32 bytesReady;
+			const qint16 *readPointer = static_cast<const qint16 *>(ringBuffer.readPointer(bytesReady));
+			if (bytesReady == 0) {
+				QMutexLocker locker(&mutex);
+				readPointer = static_cast<const qint16 *>(ringBuffer.readPointer(bytesReady));
+				if (bytesReady == 0) {
+					// All the frames are pushed before the finish request, so the ring buffer is drained by now.
+					if (finishRequested) break;
+					ringBufferChanged.wait(&mutex);
+					continue;
+				}
+			}
+			encoder.addFrames(readPointer, bytesReady / FRAME_SIZE);
+			ringBuffer.advanceReadPointer(bytesReady);
+			{
+				QMutexLocker locker(&mutex);
+				ringBufferChanged.wakeAll();
+			}
+			if (!writeEncoderOutput()) return;
+		}
+		encoder.finish();
+		writeEncoderOutput();
+	}
+
+	bool writeEncoderOutput() {
+		const char *outputPos = (const char *)encoder.getOutput();
+		qint64 bytesToWrite = encoder.getOutputSize();
+		while (bytesToWrite > 0) {
+			qint64 bytesWritten = file.write(outputPos, bytesToWrite);
+			if (bytesWritten == -1) {
+				qDebug() << "AudioFileWriter: error writing into the audio file:" << file.errorString();
+				QMutexLocker locker(&mutex);
+				failed = true;
+				ringBufferChanged.wakeAll();
+				return false;
+			}
+			bytesToWrite -= bytesWritten;
+			outputPos += bytesWritten;
+		}
+		encoder.clearOutput();
+		return true;
+	}
+};
 
 bool AudioFileWriter::convertSamplesFromNativeEndian(const qint16 *sourceBuffer, qint16 *targetBuffer, uint sampleCount, QSysInfo::Endian targetByteOrder) {
 	if (QSysInfo::ByteOrder == targetByteOrder) return false;
@@ -46,7 +161,8 @@ bool AudioFileWriter::convertSamplesFromNativeEndian(const qint16 *sourceBuffer,
 }
 
 AudioFileWriter::AudioFileWriter(uint sampleRate, const QString &fileName) :
-	sampleRate(sampleRate), fileName(fileName), waveMode(fileName.endsWith(".wav")), file(fileName)
+	sampleRate(sampleRate), fileName(fileName), waveMode(fileName.endsWith(".wav")),
+	flacMode(fileName.endsWith(".flac")), file(fileName), flacEncoderThread(NULL)
 {}
 
 AudioFileWriter::~AudioFileWriter() {
@@ -59,6 +175,11 @@ bool AudioFileWriter::open(bool skipInitialSilence) {
 		return false;
 	}
 	if (waveMode) file.seek(WAVE_HEADER_LENGTH);
+	if (flacMode) {
+		file.seek(FLACEncoder::STREAM_HEADER_SIZE);
+		flacEncoderThread = new FLACEncoderThread(sampleRate, file);
+		flacEncoderThread->start();
+	}
 	skipSilence = skipInitialSilence;
 	return true;
 }
@@ -83,6 +204,12 @@ bool AudioFileWriter::write(const qint16 *buffer, uint totalFrames) {
 		}
 	}
 
+	if (flacMode) {
+		if (flacEncoderThread->push(buffer, totalFrames)) return true;
+		close();
+		return false;
+	}
+
 	qint16 cnvBuffer[MAX_FRAMES_PER_RUN << 1];
 	while (totalFrames > 0) {
 		uint framesToWrite = qMin(MAX_FRAMES_PER_RUN, totalFrames);
@@ -119,26 +246,110 @@ void AudioFileWriter::close() {
 		file.seek(0);
 		file.write((char *)headerBuffer, WAVE_HEADER_LENGTH);
 	}
+	if (flacEncoderThread != NULL) {
+		// Rewrite the stream header as the frame sizes and the sample count are known now.
+		if (flacEncoderThread->finish()) flacEncoderThread->writeStreamHeader();
+		delete flacEncoderThread;
+		flacEncoderThread = NULL;
+	}
 	file.close();
 }
 
-AudioFileRenderer::AudioFileRenderer() : buffer(NULL), parsers(NULL) {
+// Writes the rendered buffers to the audio file, so that rendering doesn't stall while waiting for I/O.
+// The rendering thread blocks when all the buffers are queued for writing.
+class AudioFileRenderer::WriterThread : public QThread {
+public:
+	WriterThread(AudioFileWriter &writer, qint16 *buffers, uint bufferSize) :
+		writer(writer), buffers(buffers), bufferSize(bufferSize), freeBuffers(RENDER_PIPELINE_BUFFER_COUNT), failed(0),
+		producerBufferIx(0)
+	{}
+
+	// Returns the next free buffer, waiting until the writer releases one if necessary.
+	qint16 *acquireBuffer() {
+		freeBuffers.acquire();
+		return getBuffer(producerBufferIx);
+	}
+
+	// Queues the buffer last acquired for writing. Returns false if writing of a previous buffer has failed.
+	bool queueBuffer(uint frameCount) {
+		frameCounts[producerBufferIx] = frameCount;
+		producerBufferIx = (producerBufferIx + 1) % RENDER_PIPELINE_BUFFER_COUNT;
+		queuedBuffers.release();
+		return QAtomicHelper::loadAcquire(failed) == 0;
+	}
+
+	// Waits for the queued buffers to be written. Returns false if writing has failed.
+	bool finish() {
+		acquireBuffer();
+		// An empty buffer terminates the writer.
+		queueBuffer(0);
+		wait();
+		return QAtomicHelper::loadAcquire(failed) == 0;
+	}
+
+private:
+	AudioFileWriter &writer;
+	qint16 * const buffers;
+	const uint bufferSize;
+	uint frameCounts[RENDER_PIPELINE_BUFFER_COUNT];
+	QSemaphore freeBuffers;
+	QSemaphore queuedBuffers;
+	QAtomicInt failed;
+	uint producerBufferIx;
+
+	qint16 *getBuffer(uint bufferIx) const {
+		return buffers + 2 * bufferSize * bufferIx;
+	}
+
+	void run() {
+		for (uint bufferIx = 0;; bufferIx = (bufferIx + 1) % RENDER_PIPELINE_BUFFER_COUNT) {
+			queuedBuffers.acquire();
+			uint frameCount = frameCounts[bufferIx];
+			if (frameCount == 0) break;
+			// Once failed, keep releasing the buffers, so that the rendering thread never gets stuck.
+			if (QAtomicHelper::loadRelaxed(failed) == 0 && !writer.write(getBuffer(bufferIx), frameCount)) {
+				QAtomicHelper::storeRelease(failed, 1);
+			}
+			freeBuffers.release();
+		}
+	}
+};
+
+AudioFileRenderer::AudioFileRenderer() : buffer(NULL), parsers(NULL), realtimeMode(false), renderingGeneration(0) {
 	audioRenderer.synth = NULL;
 	connect(this, SIGNAL(parsingFailed(const QString &, const QString &)), Master::getInstance(), SLOT(showBalloon(const QString &, const QString &)));
+	connect(this, SIGNAL(renderingFinished(uint)), SLOT(handleRenderingFinished(uint)));
 }
 
 AudioFileRenderer::~AudioFileRenderer() {
 	stop();
-	if (!realtimeMode && audioRenderer.synth != NULL) {
-		audioRenderer.synth->close();
-		delete audioRenderer.synth;
-	}
+	if (!realtimeMode) closeSynth();
 	delete[] parsers;
 	delete[] buffer;
 }
 
+// Several converters may run at once sharing the ROM images, so their synths are only opened and closed
+// in the application thread, as the other synths are.
+void AudioFileRenderer::closeSynth() {
+	if (audioRenderer.synth == NULL) return;
+	audioRenderer.synth->close();
+	Master::getInstance()->removeAudioFileWriterSynth(audioRenderer.synth);
+	delete audioRenderer.synth;
+	audioRenderer.synth = NULL;
+}
+
+void AudioFileRenderer::handleRenderingFinished(uint finishedRenderingGeneration) {
+	// Unless the next conversion has already been started.
+	if (realtimeMode || finishedRenderingGeneration != renderingGeneration) return;
+	// The notification is sent right before the thread exits.
+	wait();
+	closeSynth();
+}
+
 bool AudioFileRenderer::convertMIDIFiles(QString useOutFileName, QStringList midiFileNameList, QString synthProfileName, quint32 useBufferSize) {
 	if (useOutFileName.isEmpty() || midiFileNameList.isEmpty()) return false;
+	// The previous conversion may still be finishing after it has been reported.
+	wait();
 	delete[] parsers;
 	parsersCount = midiFileNameList.size();
 	parsers = new MidiParser[parsersCount];
@@ -156,29 +367,25 @@ bool AudioFileRenderer::convertMIDIFiles(QString useOutFileName, QStringList mid
 		}
 	}
 	parsers[parsersCount - 1].addChannelsReset();
-	if (audioRenderer.synth != NULL) {
-		audioRenderer.synth->close();
-		delete audioRenderer.synth;
-	}
+	closeSynth();
 	audioRenderer.synth = new QSynth(this);
 	sampleRate = 0;
 	if (!audioRenderer.synth->open(sampleRate, MT32Emu::SamplerateConversionQuality_BEST, synthProfileName)) {
-		audioRenderer.synth->close();
-		delete audioRenderer.synth;
-		audioRenderer.synth = NULL;
+		closeSynth();
 		delete[] parsers;
 		parsers = NULL;
 		qDebug() << "AudioFileRenderer: Can't open synth";
 		QMessageBox::critical(NULL, "Error", "Failed to open synth");
 		return false;
 	}
-	Master::getInstance()->setAudioFileWriterSynth(audioRenderer.synth);
+	Master::getInstance()->addAudioFileWriterSynth(audioRenderer.synth);
 	bufferSize = useBufferSize;
 	outFileName = useOutFileName;
 	realtimeMode = false;
 	stopProcessing = false;
 	delete[] buffer;
-	buffer = new qint16[2 * bufferSize];
+	buffer = new qint16[RENDER_PIPELINE_BUFFER_COUNT * 2 * bufferSize];
+	renderingGeneration++;
 	QThread::start();
 	return true;
 }
@@ -190,9 +397,10 @@ void AudioFileRenderer::startRealtimeProcessing(AudioFileWriterStream *audioStre
 	bufferSize = useBufferSize;
 	outFileName = useOutFileName;
 	delete[] buffer;
-	buffer = new qint16[2 * bufferSize];
+	buffer = new qint16[RENDER_PIPELINE_BUFFER_COUNT * 2 * bufferSize];
 	realtimeMode = true;
 	stopProcessing = false;
+	renderingGeneration++;
 	QThread::start();
 }
 
@@ -202,11 +410,8 @@ void AudioFileRenderer::stop() {
 }
 
 inline void AudioFileRenderer::audioFileWriteFailed() {
-	if (realtimeMode) {
-		audioRenderer.audioStream->audioStreamFailed();
-	} else {
-		audioRenderer.synth->close();
-	}
+	// In the conversion mode, the synth is closed in the application thread once rendering finishes.
+	if (realtimeMode) audioRenderer.audioStream->audioStreamFailed();
 }
 
 inline void AudioFileRenderer::render(qint16 *buffer, uint length) {
@@ -218,13 +423,20 @@ inline void AudioFileRenderer::render(qint16 *buffer, uint length) {
 }
 
 void AudioFileRenderer::run() {
+	const uint runRenderingGeneration = renderingGeneration;
+	renderAudioFile();
+	emit renderingFinished(runRenderingGeneration);
+}
+
+void AudioFileRenderer::renderAudioFile() {
 	AudioFileWriter writer(sampleRate, outFileName);
 	if (!writer.open(!realtimeMode)) {
 		audioFileWriteFailed();
-		if (!realtimeMode) Master::getInstance()->setAudioFileWriterSynth(NULL);
 		emit conversionFinished();
 		return;
 	}
+	WriterThread writerThread(writer, buffer, bufferSize);
+	writerThread.start();
 	MasterClockNanos startNanos = MasterClock::getClockNanos();
 	MasterClockNanos firstSampleNanos = 0;
 	MasterClockNanos midiTick = 0;
@@ -232,11 +444,17 @@ void AudioFileRenderer::run() {
 	QMidiEventList midiEvents;
 	int midiEventIx = 0;
 	uint parserIx = 0;
+	// The progress is reported across all the MIDI files being concatenated.
+	int midiEventsTotal = 0;
+	int midiEventsInPreviousFiles = 0;
 	if (realtimeMode) {
 		firstSampleNanos = startNanos;
 	} else {
 		midiEvents = parsers[parserIx].getMIDIEvents();
 		midiTick = parsers[parserIx].getMidiTick();
+		for (uint i = 0; i < parsersCount; i++) {
+			midiEventsTotal += parsers[i].getMIDIEvents().count();
+		}
 	}
 	qDebug() << "AudioFileRenderer: Rendering started";
 	while (!stopProcessing) {
@@ -279,11 +497,12 @@ void AudioFileRenderer::run() {
 				}
 				midiNanos = nextEventNanos;
 				midiEventIx++;
-				emit midiEventProcessed(midiEventIx, midiEvents.count());
+				emit midiEventProcessed(midiEventsInPreviousFiles + midiEventIx, midiEventsTotal);
 			}
 			if (midiEvents.count() <= midiEventIx) {
 				if (parserIx < parsersCount - 1) {
 					++parserIx;
+					midiEventsInPreviousFiles += midiEvents.count();
 					midiEventIx = 0;
 					midiEvents = parsers[parserIx].getMIDIEvents();
 					midiTick = parsers[parserIx].getMidiTick();
@@ -296,10 +515,10 @@ void AudioFileRenderer::run() {
 		}
 		while (frameCount > 0) {
 			uint framesToRender = qMin(bufferSize, frameCount);
-			render(buffer, framesToRender);
-			if (!writer.write(buffer, framesToRender)) {
+			render(writerThread.acquireBuffer(), framesToRender);
+			if (!writerThread.queueBuffer(framesToRender)) {
+				writerThread.finish();
 				audioFileWriteFailed();
-				if (!realtimeMode) Master::getInstance()->setAudioFileWriterSynth(NULL);
 				emit conversionFinished();
 				return;
 			}
@@ -308,12 +527,13 @@ void AudioFileRenderer::run() {
 			if (!realtimeMode) qDebug() << "AudioFileWriter: Rendering time:" << (double)firstSampleNanos / MasterClock::NANOS_PER_SECOND;
 		}
 	}
-	qDebug() << "AudioFileRenderer: Rendering finished";
-	if (!realtimeMode) {
-		qDebug() << "AudioFileRenderer: Elapsed seconds: " << 1e-9 * (MasterClock::getClockNanos() - startNanos);
-		audioRenderer.synth->close();
-		Master::getInstance()->setAudioFileWriterSynth(NULL);
+	if (!writerThread.finish()) {
+		audioFileWriteFailed();
+		emit conversionFinished();
+		return;
 	}
+	qDebug() << "AudioFileRenderer: Rendering finished";
+	if (!realtimeMode) qDebug() << "AudioFileRenderer: Elapsed seconds: " << 1e-9 * (MasterClock::getClockNanos() - startNanos);
 	writer.close();
 	if (!stopProcessing) emit conversionFinished();
 }
@@ -15,11 +15,15 @@ public:
 	void close();
 
 private:
+	class FLACEncoderThread;
+
 	const uint sampleRate;
 	const QString fileName;
 	const bool waveMode;
+	const bool flacMode;
 	QFile file;
 	bool skipSilence;
+	FLACEncoderThread *flacEncoderThread;
 };
 
 class AudioFileWriterStream;
@@ -38,6 +42,8 @@ public:
 	void stop();
 
 private:
+	class WriterThread;
+
 	union {
 		QSynth *synth;
 		AudioFileWriterStream *audioStream;
@@ -50,12 +56,20 @@ private:
 	uint parsersCount;
 	bool realtimeMode;
 	volatile bool stopProcessing;
+	// Incremented each time rendering is started, so that a late notification of a previous run can be told apart.
+	uint renderingGeneration;
 
+	void closeSynth();
 	inline void audioFileWriteFailed();
 	inline void render(qint16 *buffer, uint length);
 	void run();
+	void renderAudioFile();
+
+private slots:
+	void handleRenderingFinished(uint finishedRenderingGeneration);
 
 signals:
+	void renderingFinished(uint renderingGeneration);
 	void parsingFailed(const QString &, const QString &);
 	void midiEventProcessed(int midiEventsProcessed, int midiEventsTotal);
 	void conversionFinished();
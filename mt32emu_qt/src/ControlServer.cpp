@@ -0,0 +1,354 @@
+/* Copyright (C) 2011-2026 Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <csignal>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "ControlServer.h"
+#include "Master.h"
+#include "MidiSession.h"
+#include "audiodrv/AudioDriver.h"
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+#define SOCKET_NOTIFIER_ACTIVATED_SIGNAL SIGNAL(activated(int))
+#else
+#define SOCKET_NOTIFIER_ACTIVATED_SIGNAL SIGNAL(activated(QSocketDescriptor, QSocketNotifier::Type))
+#endif
+
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int SEND_FLAGS = 0;
+#endif
+
+static const int READ_BUFFER_SIZE = 1024;
+static const int MAX_COMMAND_LINE_LENGTH = 4096;
+// A client that doesn't read the responses is disconnected rather than let the queued output grow indefinitely.
+static const int MAX_PENDING_OUTPUT_SIZE = 65536;
+
+static const char * const HELP_TEXT =
+	"list - show synth instances, their states and MIDI ports\n"
+	"connect_midi <MIDI port name> - create a MIDI port connected to a new synth instance\n"
+	"disconnect_midi <MIDI port name> - delete the MIDI port, along with the synth instance unless it is in use\n"
+	"reset <synth instance index> - reset the synth instance\n"
+	"load <synth instance index> - show the DSP load, xruns, time spent in each rendering stage and audio timing of the synth instance\n"
+	"quit - shut down the application\n";
+
+static const char *getSynthRouteStateName(SynthRouteState state) {
+	switch (state) {
+	case SynthRouteState_CLOSED:
+		return "CLOSED";
+	case SynthRouteState_OPENING:
+		return "OPENING";
+	case SynthRouteState_OPEN:
+		return "OPEN";
+	case SynthRouteState_CLOSING:
+		return "CLOSING";
+	}
+	return "UNKNOWN";
+}
+
+static MidiSession *findMidiSession(const QList<SynthRoute *> &synthRoutes, const QString &portName) {
+	foreach (SynthRoute *synthRoute, synthRoutes) {
+		foreach (MidiSession *midiSession, synthRoute->getMidiSessions()) {
+			if (midiSession->getName() == portName) return midiSession;
+		}
+	}
+	return NULL;
+}
+
+ControlServer::ControlServer(Master &useMaster) : QObject(&useMaster), master(useMaster), serverSocket(-1), serverNotifier() {}
+
+ControlServer::~ControlServer() {
+	foreach (int clientSocket, clients.keys()) {
+		close(clientSocket);
+	}
+	if (serverSocket != -1) {
+		close(serverSocket);
+		unlink(socketPathName.constData());
+	}
+}
+
+bool ControlServer::listen(const QString &socketPath) {
+	socketPathName = QFile::encodeName(socketPath);
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	if (size_t(socketPathName.size()) >= sizeof(address.sun_path)) {
+		qWarning() << "ControlServer: Socket path is too long:" << socketPath;
+		return false;
+	}
+	address.sun_family = AF_UNIX;
+	memcpy(address.sun_path, socketPathName.constData(), socketPathName.size());
+
+	serverSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (serverSocket == -1) {
+		qWarning() << "ControlServer: Failed to create socket, errno:" << errno;
+		return false;
+	}
+
+	// Remove a stale socket possibly left behind by a previous run, but never anything else,
+	// nor the socket of another instance that is still running.
+	struct stat fileStat;
+	if (stat(socketPathName.constData(), &fileStat) == 0 && S_ISSOCK(fileStat.st_mode)) {
+		if (::connect(serverSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0) {
+			qWarning() << "ControlServer: Socket" << socketPath << "is in use by another process";
+			close(serverSocket);
+			serverSocket = -1;
+			return false;
+		}
+		if (errno == ECONNREFUSED) unlink(socketPathName.constData());
+		// The failed connection attempt leaves the socket in an unspecified state.
+		close(serverSocket);
+		serverSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (serverSocket == -1) {
+			qWarning() << "ControlServer: Failed to create socket, errno:" << errno;
+			return false;
+		}
+	}
+
+	// The commands allow for controlling the application, so only the owner is permitted to connect.
+	mode_t oldUmask = umask(S_IRWXG | S_IRWXO | S_IXUSR);
+	bool bound = bind(serverSocket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+	umask(oldUmask);
+	if (!bound || chmod(socketPathName.constData(), S_IRUSR | S_IWUSR) != 0 || ::listen(serverSocket, 4) != 0) {
+		qWarning() << "ControlServer: Failed to listen on socket" << socketPath << "errno:" << errno;
+		if (bound) unlink(socketPathName.constData());
+		close(serverSocket);
+		serverSocket = -1;
+		return false;
+	}
+	fcntl(serverSocket, F_SETFL, fcntl(serverSocket, F_GETFL) | O_NONBLOCK);
+#if !defined MSG_NOSIGNAL && !defined SO_NOSIGPIPE
+	// Otherwise, writing to a socket closed by the client would terminate the application.
+	signal(SIGPIPE, SIG_IGN);
+#endif
+	serverNotifier = new QSocketNotifier(serverSocket, QSocketNotifier::Read, this);
+	connect(serverNotifier, SOCKET_NOTIFIER_ACTIVATED_SIGNAL, SLOT(handleNewConnection()));
+	qDebug() << "ControlServer: Listening on socket" << socketPath;
+	return true;
+}
+
+void ControlServer::handleNewConnection() {
+	for (;;) {
+		int clientSocket = accept(serverSocket, NULL, NULL);
+		if (clientSocket == -1) {
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+				qWarning() << "ControlServer: Failed to accept connection, errno:" << errno;
+			}
+			if (errno != EINTR) return;
+			continue;
+		}
+		fcntl(clientSocket, F_SETFL, fcntl(clientSocket, F_GETFL) | O_NONBLOCK);
+#if !defined MSG_NOSIGNAL && defined SO_NOSIGPIPE
+		int noSigPipe = 1;
+		setsockopt(clientSocket, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+		Client &client = clients[clientSocket];
+		client.readNotifier = new QSocketNotifier(clientSocket, QSocketNotifier::Read, this);
+		connect(client.readNotifier, SOCKET_NOTIFIER_ACTIVATED_SIGNAL, SLOT(handleClientInput()));
+		client.writeNotifier = new QSocketNotifier(clientSocket, QSocketNotifier::Write, this);
+		client.writeNotifier->setEnabled(false);
+		connect(client.writeNotifier, SOCKET_NOTIFIER_ACTIVATED_SIGNAL, SLOT(handleClientOutput()));
+		client.closing = false;
+	}
+}
+
+void ControlServer::handleClientInput() {
+	QSocketNotifier *clientNotifier = qobject_cast<QSocketNotifier *>(sender());
+	if (clientNotifier == NULL) return;
+	int clientSocket = int(clientNotifier->socket());
+	if (!clients.contains(clientSocket)) return;
+	char buffer[READ_BUFFER_SIZE];
+	ssize_t bytesRead = read(clientSocket, buffer, READ_BUFFER_SIZE);
+	if (bytesRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return;
+	if (bytesRead <= 0) {
+		closeClient(clientSocket);
+		return;
+	}
+	clients[clientSocket].input.append(buffer, int(bytesRead));
+	int lineEndIx;
+	// The client may get closed while processing a command.
+	while (clients.contains(clientSocket) && !clients[clientSocket].closing && (lineEndIx = clients[clientSocket].input.indexOf('\n')) != -1) {
+		QByteArray &input = clients[clientSocket].input;
+		QString commandLine = QString::fromLocal8Bit(input.constData(), lineEndIx).trimmed();
+		input.remove(0, lineEndIx + 1);
+		if (!commandLine.isEmpty()) processCommand(clientSocket, commandLine);
+	}
+	if (clients.contains(clientSocket) && !clients[clientSocket].closing && clients[clientSocket].input.size() > MAX_COMMAND_LINE_LENGTH) {
+		sendResponse(clientSocket, "ERROR Command line too long");
+		if (!clients.contains(clientSocket)) return;
+		Client &client = clients[clientSocket];
+		client.closing = true;
+		client.readNotifier->setEnabled(false);
+		if (client.output.isEmpty()) closeClient(clientSocket);
+	}
+}
+
+void ControlServer::handleClientOutput() {
+	QSocketNotifier *clientNotifier = qobject_cast<QSocketNotifier *>(sender());
+	if (clientNotifier == NULL) return;
+	flushClientOutput(int(clientNotifier->socket()));
+}
+
+void ControlServer::flushClientOutput(int clientSocket) {
+	if (!clients.contains(clientSocket)) return;
+	Client &client = clients[clientSocket];
+	while (!client.output.isEmpty()) {
+		ssize_t bytesSent = send(clientSocket, client.output.constData(), size_t(client.output.size()), SEND_FLAGS);
+		if (bytesSent < 0) {
+			if (errno == EINTR) continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				// Resume once the client has read some of the data.
+				client.writeNotifier->setEnabled(true);
+				return;
+			}
+			closeClient(clientSocket);
+			return;
+		}
+		client.output.remove(0, int(bytesSent));
+	}
+	client.writeNotifier->setEnabled(false);
+	if (client.closing) closeClient(clientSocket);
+}
+
+void ControlServer::closeClient(int clientSocket) {
+	if (!clients.contains(clientSocket)) return;
+	Client client = clients.take(clientSocket);
+	client.readNotifier->setEnabled(false);
+	client.readNotifier->deleteLater();
+	client.writeNotifier->setEnabled(false);
+	client.writeNotifier->deleteLater();
+	close(clientSocket);
+}
+
+void ControlServer::processCommand(int clientSocket, const QString &commandLine) {
+	int separatorIx = commandLine.indexOf(' ');
+	QString command = commandLine.left(separatorIx);
+	QString parameter = separatorIx == -1 ? QString() : commandLine.mid(separatorIx + 1).trimmed();
+	if (QString::compare(command, "list", Qt::CaseInsensitive) == 0) {
+		listSynthRoutes(clientSocket);
+	} else if (QString::compare(command, "connect_midi", Qt::CaseInsensitive) == 0) {
+		connectMidi(clientSocket, parameter);
+	} else if (QString::compare(command, "disconnect_midi", Qt::CaseInsensitive) == 0) {
+		disconnectMidi(clientSocket, parameter);
+	} else if (QString::compare(command, "reset", Qt::CaseInsensitive) == 0) {
+		resetSynthRoute(clientSocket, parameter);
+	} else if (QString::compare(command, "load", Qt::CaseInsensitive) == 0) {
+		showRenderLoad(clientSocket, parameter);
+	} else if (QString::compare(command, "help", Qt::CaseInsensitive) == 0) {
+		sendResponse(clientSocket, QString(HELP_TEXT) + "OK");
+	} else if (QString::compare(command, "quit", Qt::CaseInsensitive) == 0) {
+		sendResponse(clientSocket, "OK");
+		QCoreApplication::quit();
+	} else {
+		sendResponse(clientSocket, "ERROR Unknown command " + command);
+	}
+}
+
+void ControlServer::listSynthRoutes(int clientSocket) {
+	QString response;
+	const QList<SynthRoute *> &synthRoutes = master.getSynthRoutes();
+	for (int synthRouteIx = 0; synthRouteIx < synthRoutes.size(); synthRouteIx++) {
+		SynthRoute *synthRoute = synthRoutes.at(synthRouteIx);
+		QStringList portNames;
+		foreach (MidiSession *midiSession, synthRoute->getMidiSessions()) {
+			portNames += midiSession->getName();
+		}
+		response += QString().setNum(synthRouteIx) + " " + getSynthRouteStateName(synthRoute->getState()) + " " + portNames.join(", ") + "\n";
+	}
+	sendResponse(clientSocket, response + "OK");
+}
+
+void ControlServer::connectMidi(int clientSocket, const QString &portName) {
+	if (portName.isEmpty()) {
+		sendResponse(clientSocket, "ERROR The MIDI port name must be specified");
+		return;
+	}
+	if (!master.canCreateMidiPort()) {
+		sendResponse(clientSocket, "ERROR The MIDI driver does not support creation of MIDI ports");
+		return;
+	}
+	if (findMidiSession(master.getSynthRoutes(), portName) != NULL) {
+		sendResponse(clientSocket, "ERROR The MIDI port already exists");
+		return;
+	}
+	master.createMidiPort(-1, portName);
+	if (findMidiSession(master.getSynthRoutes(), portName) == NULL) {
+		sendResponse(clientSocket, "ERROR Failed to create the MIDI port");
+		return;
+	}
+	sendResponse(clientSocket, "OK");
+}
+
+void ControlServer::disconnectMidi(int clientSocket, const QString &portName) {
+	MidiSession *midiSession = findMidiSession(master.getSynthRoutes(), portName);
+	if (midiSession == NULL) {
+		sendResponse(clientSocket, "ERROR The MIDI port not found");
+		return;
+	}
+	if (!master.canDeleteMidiPort(midiSession)) {
+		sendResponse(clientSocket, "ERROR The MIDI port cannot be deleted");
+		return;
+	}
+	master.deleteMidiPort(midiSession);
+	sendResponse(clientSocket, "OK");
+}
+
+void ControlServer::resetSynthRoute(int clientSocket, const QString &synthRouteIndex) {
+	bool ok;
+	int synthRouteIx = synthRouteIndex.toInt(&ok);
+	const QList<SynthRoute *> &synthRoutes = master.getSynthRoutes();
+	if (!ok || synthRouteIx < 0 || synthRoutes.size() <= synthRouteIx) {
+		sendResponse(clientSocket, "ERROR Invalid synth instance index");
+		return;
+	}
+	synthRoutes.at(synthRouteIx)->reset();
+	sendResponse(clientSocket, "OK");
+}
+
+void ControlServer::showRenderLoad(int clientSocket, const QString &synthRouteIndex) {
+	bool ok;
+	int synthRouteIx = synthRouteIndex.toInt(&ok);
+	const QList<SynthRoute *> &synthRoutes = master.getSynthRoutes();
+	if (!ok || synthRouteIx < 0 || synthRoutes.size() <= synthRouteIx) {
+		sendResponse(clientSocket, "ERROR Invalid synth instance index");
+		return;
+	}
+	RenderLoadStats stats;
+	synthRoutes.at(synthRouteIx)->getRenderLoadStats(stats);
+	QString response = RenderLoadMeter::getStatsSummary(stats) + "\n" + RenderLoadMeter::getStageBreakdown(stats) + "\n";
+	AudioTimingStats timingStats;
+	if (synthRoutes.at(synthRouteIx)->getAudioTimingStats(timingStats)) response += AudioStream::getTimingStatsSummary(timingStats) + "\n";
+	sendResponse(clientSocket, response + "OK");
+}
+
+void ControlServer::sendResponse(int clientSocket, const QString &response) {
+	if (!clients.contains(clientSocket)) return;
+	QByteArray &output = clients[clientSocket].output;
+	if (output.size() > MAX_PENDING_OUTPUT_SIZE) {
+		qWarning() << "ControlServer: Client does not read responses, disconnecting";
+		closeClient(clientSocket);
+		return;
+	}
+	output.append((response + "\n").toLocal8Bit());
+	flushClientOutput(clientSocket);
+}
@@ -0,0 +1,57 @@
+#ifndef CONTROL_SERVER_H
+#define CONTROL_SERVER_H
+
+#include <QtCore>
+
+class Master;
+
+/**
+ * Accepts connections on a local Unix domain socket and handles simple text commands, one per line,
+ * that allow for managing synth instances of a headless application. Each command is answered with
+ * a line starting with either "OK" or "ERROR", optionally preceded by lines of data.
+ * All the processing takes place in the application thread, driven by the event loop. The client sockets are
+ * non-blocking, the responses a client doesn't read promptly are queued until the socket becomes writable.
+ */
+class ControlServer : public QObject {
+	Q_OBJECT
+
+private:
+	struct Client {
+		QSocketNotifier *readNotifier;
+		QSocketNotifier *writeNotifier;
+		// Incomplete command line received so far.
+		QByteArray input;
+		// Responses not yet sent.
+		QByteArray output;
+		// When set, the client is closed once the pending output is sent.
+		bool closing;
+	};
+
+	Master &master;
+	QByteArray socketPathName;
+	int serverSocket;
+	QSocketNotifier *serverNotifier;
+	QMap<int, Client> clients;
+
+	void closeClient(int clientSocket);
+	void flushClientOutput(int clientSocket);
+	void processCommand(int clientSocket, const QString &commandLine);
+	void listSynthRoutes(int clientSocket);
+	void connectMidi(int clientSocket, const QString &portName);
+	void disconnectMidi(int clientSocket, const QString &portName);
+	void resetSynthRoute(int clientSocket, const QString &synthRouteIndex);
+	void showRenderLoad(int clientSocket, const QString &synthRouteIndex);
+	void sendResponse(int clientSocket, const QString &response);
+
+private slots:
+	void handleNewConnection();
+	void handleClientInput();
+	void handleClientOutput();
+
+public:
+	explicit ControlServer(Master &master);
+	~ControlServer();
+	bool listen(const QString &socketPath);
+};
+
+#endif
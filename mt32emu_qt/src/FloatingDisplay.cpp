@@ -94,6 +94,7 @@ void FloatingDisplay::setSynthRoute(SynthRoute *useSynthRoute) {
 	if (synthRoute != NULL) {
 		synthRoute->disconnectSynth(SIGNAL(stateChanged(SynthState)), this, SLOT(handleSynthStateChange(SynthState)));
 		synthRoute->disconnectReportHandler(SIGNAL(lcdStateChanged()), lcdWidget, SLOT(handleLCDUpdate()));
+		synthRoute->disconnectSynth(SIGNAL(audioBlockRendered()), lcdWidget, SLOT(handleAudioBlockRendered()));
 		synthRoute->disconnectReportHandler(SIGNAL(midiMessageLEDStateChanged(bool)), this, SLOT(handleMidiMessageLEDUpdate(bool)));
 	}
 	synthRoute = useSynthRoute;
@@ -101,6 +102,7 @@ void FloatingDisplay::setSynthRoute(SynthRoute *useSynthRoute) {
 	if (synthRoute != NULL) {
 		synthRoute->connectSynth(SIGNAL(stateChanged(SynthState)), this, SLOT(handleSynthStateChange(SynthState)));
 		synthRoute->connectReportHandler(SIGNAL(lcdStateChanged()), lcdWidget, SLOT(handleLCDUpdate()));
+		synthRoute->connectSynth(SIGNAL(audioBlockRendered()), lcdWidget, SLOT(handleAudioBlockRendered()));
 		synthRoute->connectReportHandler(SIGNAL(midiMessageLEDStateChanged(bool)), this, SLOT(handleMidiMessageLEDUpdate(bool)));
 	}
 	midiMessageLED->setState(lcdWidget->updateDisplayText());
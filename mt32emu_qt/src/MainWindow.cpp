@@ -98,6 +98,7 @@ MainWindow::MainWindow(Master *master) :
 	ui->actionNew_JACK_MIDI_port->setVisible(true);
 	ui->actionNew_exclusive_JACK_MIDI_port->setVisible(true);
 	ui->actionConnect_JACK_audio_automatically->setVisible(true);
+	ui->actionRender_JACK_audio_in_process_callback->setVisible(true);
 #endif
 
 	QActionGroup *floatingDisplayGroup = new QActionGroup(this);
@@ -349,6 +350,7 @@ void MainWindow::on_menuOptions_aboutToShow() {
 	QFileDialog::Options qFileDialogOptions = QFileDialog::Options(settings->value("Master/qFileDialogOptions", 0).toInt());
 	ui->actionShow_native_file_dialog->setChecked(!qFileDialogOptions.testFlag(QFileDialog::DontUseNativeDialog));
 	ui->actionConnect_JACK_audio_automatically->setChecked(settings->value("Master/autoconnectJACKAudio", true).toBool());
+	ui->actionRender_JACK_audio_in_process_callback->setChecked(settings->value("Master/renderJACKAudioInProcessCallback", false).toBool());
 }
 
 void MainWindow::on_actionStart_iconized_toggled(bool checked) {
@@ -381,6 +383,10 @@ void MainWindow::on_actionConnect_JACK_audio_automatically_toggled(bool checked)
 	master->getSettings()->setValue("Master/autoconnectJACKAudio", checked);
 }
 
+void MainWindow::on_actionRender_JACK_audio_in_process_callback_toggled(bool checked) {
+	master->getSettings()->setValue("Master/renderJACKAudioInProcessCallback", checked);
+}
+
 void MainWindow::on_menuFloating_Display_aboutToShow() {
 	switch (getFloatingDisplayVisibility()) {
 	case FloatingDisplayVisibility_ALWAYS_SHOWN:
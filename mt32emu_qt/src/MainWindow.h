@@ -72,6 +72,7 @@ private slots:
 	void on_actionShow_connection_balloons_toggled(bool checked);
 	void on_actionShow_native_file_dialog_toggled(bool checked);
 	void on_actionConnect_JACK_audio_automatically_toggled(bool checked);
+	void on_actionRender_JACK_audio_in_process_callback_toggled(bool checked);
 	void on_menuFloating_Display_aboutToShow();
 	void handleFloatingDisplayVisibilityChanged(QAction *triggeredAction);
 	void on_actionFloating_display_Bypass_window_manager_toggled(bool checked);
@@ -17,12 +17,17 @@
 #include <QSystemTrayIcon>
 #include <QDropEvent>
 #include <QMessageBox>
+#include <QTextDocumentFragment>
 
 #include "Master.h"
 #include "MasterClock.h"
 #include "MidiSession.h"
 #include "MidiPropertiesDialog.h"
 
+#ifdef WITH_CONTROL_SERVER
+#include "ControlServer.h"
+#endif
+
 #ifdef WITH_WINMM_AUDIO_DRIVER
 #include "audiodrv/WinMMAudioDriver.h"
 #endif
@@ -77,14 +82,14 @@ static void migrateSettings(QSettings &settings, const int fromVersion) {
 		break;
 	default:
 		qDebug() << "Migration failed";
-		QMessageBox::warning(NULL, "Unsupported settings version",
+		Master::showWarning("Unsupported settings version",
 			"Unable to load application settings of unsupported version " + QString().setNum(fromVersion) + ".\n"
 			"Please, check the settings!");
 		break;
 	}
 }
 
-Master::Master() {
+Master::Master(bool useHeadless) : headless(useHeadless), commandLineFailed(false) {
 	if (instance != NULL) {
 		qFatal("Master already instantiated!");
 		// Do nothing if ignored
@@ -114,7 +119,9 @@ Master::Master() {
 	lastAudioDeviceScan = -4 * MasterClock::NANOS_PER_SECOND;
 	getAudioDevices();
 	pinnedSynthRoute = NULL;
-	audioFileWriterSynth = NULL;
+#ifdef WITH_CONTROL_SERVER
+	controlServer = NULL;
+#endif
 
 	qRegisterMetaType<MidiDriver *>("MidiDriver*");
 	qRegisterMetaType<MidiSession *>("MidiSession*");
@@ -218,9 +225,19 @@ Master *Master::getInstance() {
 	return instance;
 }
 
+void Master::showWarning(const QString &title, const QString &text, bool critical) {
+	if (instance != NULL && instance->headless) {
+		qWarning() << title + ":" << text;
+	} else if (critical) {
+		QMessageBox::critical(NULL, title, text);
+	} else {
+		QMessageBox::warning(NULL, title, text);
+	}
+}
+
 void Master::showCommandLineHelp() {
 	QString appName = QFileInfo(QCoreApplication::arguments().at(0)).fileName();
-	QMessageBox::information(NULL, "Information",
+	QString helpText =
 		"<h3>Command line format:</h3>"
 		"<pre><code>" + appName + " [option...] [&lt;command&gt; [parameters...]]</code></pre>"
 		"<h3>Options:</h3>"
@@ -228,6 +245,14 @@ void Master::showCommandLineHelp() {
 		"<p>override default synth profile with specified profile during this run only.</p>"
 		"<p><code>-max_sessions &lt;number of sessions&gt;</code></p>"
 		"<p>exit after this number of MIDI sessions are finished.</p>"
+		"<p><code>-headless</code></p>"
+		"<p>run without GUI. Each MIDI port is connected to a dedicated synth instance with its own audio output,"
+		" while the synth instances share the ROM images loaded. Commands play and convert are unavailable.</p>"
+#ifdef WITH_CONTROL_SERVER
+		"<p><code>-control_socket &lt;socket path name&gt;</code></p>"
+		"<p>accept commands that manage synth instances and MIDI ports via a local Unix domain socket."
+		" Send command <code>help</code> to the socket for the list of supported commands.</p>"
+#endif
 #ifdef WITH_JACK_MIDI_DRIVER
 		"<p><code>-jack_midi_clients &lt;number of MIDI ports&gt;</code></p>"
 		"<p>create the specified number of JACK MIDI ports that may be connected to any synth.</p>"
@@ -250,8 +275,12 @@ void Master::showCommandLineHelp() {
 		"</ul>"
 		"<p><code>connect_midi &lt;MIDI port name...&gt;</code></p>"
 		"<p>attempts to create one or more MIDI ports with the specified name(s) using the system MIDI driver. On Windows,"
-		" opens available MIDI input devices with names that contain (case-insensitively) one of the specified port names.</p>"
-	);
+		" opens available MIDI input devices with names that contain (case-insensitively) one of the specified port names.</p>";
+	if (instance != NULL && instance->headless) {
+		qWarning().nospace() << QTextDocumentFragment::fromHtml(helpText).toPlainText();
+	} else {
+		QMessageBox::information(NULL, "Information", helpText);
+	}
 }
 
 bool Master::processCommandLine(QStringList args) {
@@ -262,6 +291,12 @@ bool Master::processCommandLine(QStringList args) {
 			handleCLIOptionProfile(args, argIx);
 		} else if (QString::compare(command, "-max_sessions", Qt::CaseInsensitive) == 0) {
 			handleCLIOptionMaxSessions(args, argIx);
+		} else if (QString::compare(command, "-headless", Qt::CaseInsensitive) == 0) {
+			// Already taken into account on startup.
+#ifdef WITH_CONTROL_SERVER
+		} else if (QString::compare(command, "-control_socket", Qt::CaseInsensitive) == 0) {
+			handleCLIOptionControlSocket(args, argIx);
+#endif
 #ifdef WITH_JACK_MIDI_DRIVER
 		} else if (QString::compare(command, "-jack_midi_clients", Qt::CaseInsensitive) == 0) {
 			handleCLIOptionJackMidiClients(args, argIx);
@@ -269,22 +304,22 @@ bool Master::processCommandLine(QStringList args) {
 			handleCLIOptionJackSyncClients(args, argIx);
 #endif
 		} else {
-			QMessageBox::warning(NULL, "Error", "Illegal command line option " + command + " specified.");
+			showWarning("Error", "Illegal command line option " + command + " specified.");
 			showCommandLineHelp();
 		}
 		if (args.count() == argIx) return true;
 		command = args.at(argIx++);
 	}
 	if (QString::compare(command, "play", Qt::CaseInsensitive) == 0) {
-		handleCLICommandPlay(args, argIx);
+		return handleCLICommandPlay(args, argIx);
 	} else if (QString::compare(command, "convert", Qt::CaseInsensitive) == 0) {
-		handleCLICommandConvert(args, argIx);
+		return handleCLICommandConvert(args, argIx);
 	} else if (QString::compare(command, "reset", Qt::CaseInsensitive) == 0) {
 		return handleCLICommandReset(args, argIx);
 	} else if (QString::compare(command, "connect_midi", Qt::CaseInsensitive) == 0) {
 		handleCLIConnectMidi(args, argIx);
 	} else {
-		QMessageBox::warning(NULL, "Error", "Illegal command " + command + " specified in command line.");
+		showWarning("Error", "Illegal command " + command + " specified in command line.");
 		showCommandLineHelp();
 	}
 	return true;
@@ -292,7 +327,7 @@ bool Master::processCommandLine(QStringList args) {
 
 void Master::handleCLIOptionProfile(const QStringList &args, int &argIx) {
 	if (args.count() == argIx) {
-		QMessageBox::warning(NULL, "Error", "The profile name must be specified in command line with \"-profile\" option.");
+		showWarning("Error", "The profile name must be specified in command line with \"-profile\" option.");
 		showCommandLineHelp();
 		return;
 	}
@@ -300,39 +335,59 @@ void Master::handleCLIOptionProfile(const QStringList &args, int &argIx) {
 	if (enumSynthProfiles().contains(profile, Qt::CaseInsensitive)) {
 		synthProfileName = profile;
 	} else {
-		QMessageBox::warning(NULL, "Error", "The profile name specified in command line is invalid.\nOption \"-profile\" ignored.");
+		showWarning("Error", "The profile name specified in command line is invalid.\nOption \"-profile\" ignored.");
 	}
 }
 
 void Master::handleCLIOptionMaxSessions(const QStringList &args, int &argIx) {
 	if (args.count() == argIx) {
-		QMessageBox::warning(NULL, "Error", "The maximum number of sessions must be specified in command line\n"
+		showWarning("Error", "The maximum number of sessions must be specified in command line\n"
 			"with \"-max_sessions\" option.");
 		showCommandLineHelp();
 		return;
 	}
 	maxSessions = args.at(argIx++).toUInt();
-	if (maxSessions == 0) QMessageBox::warning(NULL, "Error", "The maximum number of sessions specified in command line is invalid.\n"
+	if (maxSessions == 0) showWarning("Error", "The maximum number of sessions specified in command line is invalid.\n"
 		"Option \"-max_sessions\" ignored.");
 }
 
+#ifdef WITH_CONTROL_SERVER
+
+void Master::handleCLIOptionControlSocket(const QStringList &args, int &argIx) {
+	if (args.count() == argIx) {
+		showWarning("Error", "The socket path name must be specified in command line with \"-control_socket\" option.");
+		showCommandLineHelp();
+		return;
+	}
+	QString socketPath = args.at(argIx++);
+	if (controlServer != NULL) return;
+	controlServer = new ControlServer(*this);
+	if (!controlServer->listen(socketPath)) {
+		delete controlServer;
+		controlServer = NULL;
+		showWarning("Error", "Failed to listen on control socket " + socketPath + ".\nOption \"-control_socket\" ignored.");
+	}
+}
+
+#endif
+
 #ifdef WITH_JACK_MIDI_DRIVER
 
 void Master::handleCLIOptionJackMidiClients(const QStringList &args, int &argIx) {
 	if (args.count() == argIx) {
-		QMessageBox::warning(NULL, "Error", "The number of JACK MIDI clients must be specified in command line\n"
+		showWarning("Error", "The number of JACK MIDI clients must be specified in command line\n"
 			"with \"-jack_midi_clients\" option.");
 		showCommandLineHelp();
 		return;
 	}
 	int ports = args.at(argIx++).toInt();
 	if (ports <= 0) {
-		QMessageBox::warning(NULL, "Error", "The number of JACK MIDI clients specified in command line is invalid.\n"
+		showWarning("Error", "The number of JACK MIDI clients specified in command line is invalid.\n"
 			"Option \"-jack_midi_clients\" ignored.");
 		return;
 	}
 	if (ports > 99) {
-		QMessageBox::warning(NULL, "Error", "The number of JACK MIDI clients specified in command line is too big.\n"
+		showWarning("Error", "The number of JACK MIDI clients specified in command line is too big.\n"
 			"Option \"-jack_midi_clients\" ignored.");
 		return;
 	}
@@ -342,19 +397,19 @@ void Master::handleCLIOptionJackMidiClients(const QStringList &args, int &argIx)
 
 void Master::handleCLIOptionJackSyncClients(const QStringList &args, int &argIx) {
 	if (args.count() == argIx) {
-		QMessageBox::warning(NULL, "Error", "The number of JACK sync clients must be specified in command line\n"
+		showWarning("Error", "The number of JACK sync clients must be specified in command line\n"
 			"with \"-jack_sync_clients\" option.");
 		showCommandLineHelp();
 		return;
 	}
 	int ports = args.at(argIx++).toInt();
 	if (ports <= 0) {
-		QMessageBox::warning(NULL, "Error", "The number of JACK sync clients specified in command line is invalid.\n"
+		showWarning("Error", "The number of JACK sync clients specified in command line is invalid.\n"
 			"Option \"-jack_sync_clients\" ignored.");
 		return;
 	}
 	if (ports > 99) {
-		QMessageBox::warning(NULL, "Error", "The number of JACK sync clients specified in command line is too big.\n"
+		showWarning("Error", "The number of JACK sync clients specified in command line is too big.\n"
 			"Option \"-jack_sync_clients\" ignored.");
 		return;
 	}
@@ -363,27 +418,44 @@ void Master::handleCLIOptionJackSyncClients(const QStringList &args, int &argIx)
 
 #endif
 
-void Master::handleCLICommandPlay(const QStringList &args, int &argIx) {
+bool Master::isCommandLineFailed() const {
+	return commandLineFailed;
+}
+
+bool Master::handleCLICommandPlay(const QStringList &args, int &argIx) {
+	if (headless) {
+		// The MIDI player and the converter are parts of the main window.
+		showWarning("Error", "The play command is unavailable when running headless.");
+		commandLineFailed = true;
+		return false;
+	}
 	if (args.count() == argIx) {
-		QMessageBox::warning(NULL, "Error", "The file list must be specified in command line with play command.");
+		showWarning("Error", "The file list must be specified in command line with play command.");
 		showCommandLineHelp();
-		return;
+		return true;
 	}
 	emit playMidiFiles(args.mid(argIx));
+	return true;
 }
 
-void Master::handleCLICommandConvert(const QStringList &args, int &argIx) {
+bool Master::handleCLICommandConvert(const QStringList &args, int &argIx) {
+	if (headless) {
+		showWarning("Error", "The convert command is unavailable when running headless.");
+		commandLineFailed = true;
+		return false;
+	}
 	if (args.count() > (argIx + 1)) {
 		emit convertMidiFiles(args.mid(argIx));
-		return;
+		return true;
 	}
-	QMessageBox::warning(NULL, "Error", "The file list must be specified in command line with convert command.");
+	showWarning("Error", "The file list must be specified in command line with convert command.");
 	showCommandLineHelp();
+	return true;
 }
 
 bool Master::handleCLICommandReset(const QStringList &args, int &argIx) {
 	if (args.count() != (argIx + 1)) {
-		QMessageBox::warning(NULL, "Error", "The settings scope must be specified in command line with reset command.");
+		showWarning("Error", "The settings scope must be specified in command line with reset command.");
 		showCommandLineHelp();
 		return true;
 	}
@@ -405,24 +477,28 @@ bool Master::handleCLICommandReset(const QStringList &args, int &argIx) {
 		settings->remove("Audio");
 		qDebug() << "Audio devices settings reset";
 	} else {
-		QMessageBox::warning(NULL, "Error", "The settings scope specified in command line is invalid.\n"
+		showWarning("Error", "The settings scope specified in command line is invalid.\n"
 			"Command reset ignored.");
 		showCommandLineHelp();
 		return true;
 	}
-	QMessageBox::information(NULL, "Information", "Requested settings reset completed.\n"
-		"Please, restart the application.");
+	if (headless) {
+		qDebug() << "Requested settings reset completed";
+	} else {
+		QMessageBox::information(NULL, "Information", "Requested settings reset completed.\n"
+			"Please, restart the application.");
+	}
 	return false;
 }
 
 void Master::handleCLIConnectMidi(const QStringList &args, int &argIx) {
 	if (args.count() == argIx) {
-		QMessageBox::warning(NULL, "Error", "The MIDI port list must be specified in command line with connect_midi command.");
+		showWarning("Error", "The MIDI port list must be specified in command line with connect_midi command.");
 		showCommandLineHelp();
 		return;
 	}
 	if (!midiDriver->canCreatePort()) {
-		QMessageBox::warning(NULL, "Error", "The MIDI driver does not support creation of MIDI ports.");
+		showWarning("Error", "The MIDI driver does not support creation of MIDI ports.");
 		return;
 	}
 
@@ -493,6 +569,14 @@ const AudioDevice *Master::findAudioDevice(QString driverId, QString name) const
 	return audioDevices.first();
 }
 
+bool Master::isHeadless() const {
+	return headless;
+}
+
+const QList<SynthRoute *> &Master::getSynthRoutes() const {
+	return synthRoutes;
+}
+
 QSettings *Master::getSettings() const {
 	return settings;
 }
@@ -525,11 +609,12 @@ const QByteArray Master::getROMPathNameLocal(const QDir &romDir, const QString r
 void Master::findROMImages(const SynthProfile &synthProfile, const MT32Emu::ROMImage *&controlROMImage, const MT32Emu::ROMImage *&pcmROMImage) const {
 	const MT32Emu::ROMImage *synthControlROMImage = NULL;
 	const MT32Emu::ROMImage *synthPCMROMImage = NULL;
-	for (int synthRouteIx = -1; synthRouteIx < synthRoutes.size(); synthRouteIx++) {
+	// Negative indices refer to the synths used in the SMF converter.
+	for (int synthRouteIx = -audioFileWriterSynths.size(); synthRouteIx < synthRoutes.size(); synthRouteIx++) {
 		if (controlROMImage != NULL && pcmROMImage != NULL) return;
 		SynthProfile profile;
-		if (synthRouteIx == -1) {
-			if (audioFileWriterSynth == NULL) continue;
+		if (synthRouteIx < 0) {
+			const QSynth *audioFileWriterSynth = audioFileWriterSynths.at(-synthRouteIx - 1);
 			audioFileWriterSynth->getSynthProfile(profile);
 			audioFileWriterSynth->getROMImages(synthControlROMImage, synthPCMROMImage);
 		} else {
@@ -549,10 +634,10 @@ void Master::freeROMImages(const MT32Emu::ROMImage *&controlROMImage, const MT32
 	bool pcmROMInUse = false;
 	const MT32Emu::ROMImage *synthControlROMImage = NULL;
 	const MT32Emu::ROMImage *synthPCMROMImage = NULL;
-	if (audioFileWriterSynth != NULL) {
+	foreach (const QSynth *audioFileWriterSynth, audioFileWriterSynths) {
 		audioFileWriterSynth->getROMImages(synthControlROMImage, synthPCMROMImage);
-		controlROMInUse = synthControlROMImage == controlROMImage;
-		pcmROMInUse = synthPCMROMImage == pcmROMImage;
+		controlROMInUse = controlROMInUse || (synthControlROMImage == controlROMImage);
+		pcmROMInUse = pcmROMInUse || (synthPCMROMImage == pcmROMImage);
 		if (controlROMInUse && pcmROMInUse) return;
 	}
 	foreach (SynthRoute *synthRoute, synthRoutes) {
@@ -679,6 +764,8 @@ void Master::setPinned(SynthRoute *synthRoute) {
 }
 
 void Master::startPinnedSynthRoute() {
+	// When headless, each MIDI port is connected to a dedicated synth.
+	if (headless) return;
 	if (settings->value("Master/startPinnedSynthRoute", false).toBool()) {
 		setPinned(startSynthRoute());
 	}
@@ -810,9 +897,14 @@ void Master::reconnectMidiPort(MidiPropertiesDialog &mpd, MidiSession *midiSessi
 }
 
 // A quick hack to prevent ROMImages used in SMF converter from being freed
-// when closing another synth which uses the same ROMImages
-void Master::setAudioFileWriterSynth(const QSynth *qSynth) {
-	audioFileWriterSynth = qSynth;
+// when closing another synth which uses the same ROMImages. Like the SynthRoutes,
+// the synths are only registered and closed in the application thread.
+void Master::addAudioFileWriterSynth(const QSynth *qSynth) {
+	audioFileWriterSynths.append(qSynth);
+}
+
+void Master::removeAudioFileWriterSynth(const QSynth *qSynth) {
+	audioFileWriterSynths.removeOne(qSynth);
 }
 
 void Master::isSupportedDropEvent(QDropEvent *e) {
@@ -6,6 +6,7 @@
 #include "SynthRoute.h"
 
 class AudioDriver;
+class ControlServer;
 class MidiDriver;
 class MidiSession;
 
@@ -23,7 +24,7 @@ private:
 	QList<const AudioDevice *> audioDevices;
 	MidiDriver *midiDriver;
 	SynthRoute *pinnedSynthRoute;
-	const QSynth *audioFileWriterSynth;
+	QList<const QSynth *> audioFileWriterSynths;
 
 	QSettings *settings;
 	QString synthProfileName;
@@ -33,8 +34,12 @@ private:
 	qint64 lastAudioDeviceScan;
 
 	unsigned int maxSessions;
+	// When true, no GUI is shown, and messages to the user are logged instead.
+	const bool headless;
+	// Set when the command given in command line cannot be carried out, so that the application exits with an error.
+	bool commandLineFailed;
 
-	explicit Master();
+	explicit Master(bool headless = false);
 	explicit Master(Master &);
 	~Master();
 
@@ -50,6 +55,8 @@ public:
 	static QStringList parseMidiListFromPathName(const QString pathName);
 	static const QByteArray getROMPathNameLocal(const QDir &romDir, const QString romFileName);
 	static void showCommandLineHelp();
+	// Shows a message box or logs the message when running headless.
+	static void showWarning(const QString &title, const QString &text, bool critical = false);
 
 	// May only be called from the application thread
 	const QList<const AudioDevice *> getAudioDevices();
@@ -65,17 +72,21 @@ public:
 	bool handleROMSLoadFailed(QString usedSynthProfileName);
 	QSystemTrayIcon *getTrayIcon() const;
 	QSettings *getSettings() const;
+	bool isHeadless() const;
+	const QList<SynthRoute *> &getSynthRoutes() const;
 	bool isPinned(const SynthRoute *synthRoute) const;
 	void setPinned(SynthRoute *synthRoute);
 	void startPinnedSynthRoute();
 	void startMidiProcessing();
 	bool processCommandLine(const QStringList args);
+	bool isCommandLineFailed() const;
 	void handleCLIOptionProfile(const QStringList &args, int &argIx);
 	void handleCLIOptionMaxSessions(const QStringList &args, int &argIx);
+	void handleCLIOptionControlSocket(const QStringList &args, int &argIx);
 	void handleCLIOptionJackMidiClients(const QStringList &args, int &argIx);
 	void handleCLIOptionJackSyncClients(const QStringList &args, int &argIx);
-	void handleCLICommandPlay(const QStringList &args, int &argIx);
-	void handleCLICommandConvert(const QStringList &args, int &argIx);
+	bool handleCLICommandPlay(const QStringList &args, int &argIx);
+	bool handleCLICommandConvert(const QStringList &args, int &argIx);
 	bool handleCLICommandReset(const QStringList &args, int &argIx);
 	void handleCLIConnectMidi(const QStringList &args, int &argIx);
 	bool canCreateMidiPort();
@@ -87,7 +98,8 @@ public:
 	void deleteMidiPort(MidiSession *midiSession);
 	void reconnectMidiPort(MidiPropertiesDialog &mpd, MidiSession *midiSession);
 	QString getDefaultROMSearchPath();
-	void setAudioFileWriterSynth(const QSynth *);
+	void addAudioFileWriterSynth(const QSynth *);
+	void removeAudioFileWriterSynth(const QSynth *);
 
 private slots:
 	void createMidiSession(MidiSession **returnVal, MidiDriver *midiDriver, QString name);
@@ -105,6 +117,11 @@ signals:
 	void mainWindowTitleUpdated(const QString &);
 	void maxSessionsFinished();
 
+#ifdef WITH_CONTROL_SERVER
+private:
+	ControlServer *controlServer;
+#endif
+
 #ifdef WITH_JACK_MIDI_DRIVER
 private:
 	MidiDriver *jackMidiDriver;
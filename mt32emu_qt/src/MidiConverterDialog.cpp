@@ -28,11 +28,13 @@ static inline bool isSmfFileName(const QString &fileName) {
 	return fileName.endsWith(".mid", Qt::CaseInsensitive) || fileName.endsWith(".smf", Qt::CaseInsensitive);
 }
 
-MidiConverterDialog::MidiConverterDialog(Master *master, QWidget *parent) : QDialog(parent), ui(new Ui::MidiConverterDialog), batchMode(false) {
+MidiConverterDialog::MidiConverterDialog(Master *master, QWidget *parent) :
+	QDialog(parent), ui(new Ui::MidiConverterDialog), conversionCount(0), finishedConversionCount(0), batchMode(false)
+{
 	ui->setupUi(this);
 	loadProfileCombo();
-	connect(&converter, SIGNAL(conversionFinished()), SLOT(handleConversionFinished()));
-	connect(&converter, SIGNAL(midiEventProcessed(int, int)), SLOT(updateConversionProgress(int, int)));
+	int parallelConversions = master->getSettings()->value("Master/midiConverterParallelConversions", QThread::idealThreadCount()).toInt();
+	ui->parallelConversionsSpinBox->setValue(qMax(1, parallelConversions));
 	connect(this, SIGNAL(conversionFinished(const QString &, const QString &)), master, SLOT(showBalloon(const QString &, const QString &)));
 #if (QT_VERSION >= QT_VERSION_CHECK(4, 6, 0))
 	ui->midiList->setDefaultDropAction(Qt::MoveAction);
@@ -41,6 +43,7 @@ MidiConverterDialog::MidiConverterDialog(Master *master, QWidget *parent) : QDia
 }
 
 MidiConverterDialog::~MidiConverterDialog() {
+	qDeleteAll(converters);
 	delete ui;
 }
 
@@ -135,7 +138,7 @@ void MidiConverterDialog::on_editPcmButton_clicked() {
 	QString pcmFileName = currentPcmItem->text();
 	QSettings *settings = Master::getInstance()->getSettings();
 	QFileDialog::Options qFileDialogOptions = QFileDialog::Options(settings->value("Master/qFileDialogOptions", 0).toInt());
-	QString newFileName = QFileDialog::getSaveFileName(this, NULL, pcmFileName, "*.wav *.raw;;*.wav;;*.raw;;*.*",
+	QString newFileName = QFileDialog::getSaveFileName(this, NULL, pcmFileName, "*.wav *.flac *.raw;;*.wav;;*.flac;;*.raw;;*.*",
 		NULL, qFileDialogOptions);
 	if (newFileName.isEmpty()) return;
 	QString newPcmFileDir = QDir(newFileName).absolutePath();
@@ -197,13 +200,49 @@ void MidiConverterDialog::on_startButton_clicked() {
 		return;
 	}
 	enableControls(false);
+	// The MIDI file list being edited is only stored in the output PCM file item when another item is selected.
+	if (ui->pcmList->currentItem() != NULL) ui->pcmList->currentItem()->setData(Qt::UserRole, getMidiFileNames());
 	ui->pcmList->setCurrentRow(0);
-	const QStringList midiFileNames = getMidiFileNames();
-	if (!converter.convertMIDIFiles(ui->pcmList->currentItem()->text(), midiFileNames, ui->profileComboBox->currentText())) enableControls(true);
+	pendingPcmItems.clear();
+	for (int i = 0; i < ui->pcmList->count(); i++) {
+		pendingPcmItems.append(ui->pcmList->item(i));
+	}
+	conversionCount = pendingPcmItems.size();
+	finishedConversionCount = 0;
+
+	int parallelConversions = ui->parallelConversionsSpinBox->value();
+	Master::getInstance()->getSettings()->setValue("Master/midiConverterParallelConversions", parallelConversions);
+	while (converters.size() < parallelConversions) {
+		AudioFileRenderer *converter = new AudioFileRenderer;
+		connect(converter, SIGNAL(conversionFinished()), SLOT(handleConversionFinished()));
+		connect(converter, SIGNAL(midiEventProcessed(int, int)), SLOT(updateConversionProgress(int, int)));
+		converters.append(converter);
+	}
+	for (int converterIx = 0; converterIx < parallelConversions && !pendingPcmItems.isEmpty(); converterIx++) {
+		startNextConversion(converters.at(converterIx));
+	}
+	if (activePcmItems.isEmpty()) enableControls(true);
+}
+
+void MidiConverterDialog::startNextConversion(AudioFileRenderer *converter) {
+	QListWidgetItem *pcmItem = pendingPcmItems.takeFirst();
+	const QStringList midiFileNames = pcmItem->data(Qt::UserRole).value<QStringList>();
+	if (!converter->convertMIDIFiles(pcmItem->text(), midiFileNames, ui->profileComboBox->currentText())) {
+		// Leave the rest intact, the conversions in progress are allowed to complete though.
+		pendingPcmItems.clear();
+		return;
+	}
+	activePcmItems.insert(converter, pcmItem);
+	activeConversionProgress.insert(converter, 0.0);
 }
 
 void MidiConverterDialog::on_stopButton_clicked() {
-	converter.stop();
+	pendingPcmItems.clear();
+	foreach (AudioFileRenderer *converter, activePcmItems.keys()) {
+		converter->stop();
+	}
+	activePcmItems.clear();
+	activeConversionProgress.clear();
 	enableControls(true);
 }
 
@@ -248,16 +287,35 @@ void MidiConverterDialog::on_pcmList_currentItemChanged(QListWidgetItem *current
 }
 
 void MidiConverterDialog::handleConversionFinished() {
+	AudioFileRenderer *converter = static_cast<AudioFileRenderer *>(sender());
+	// The conversion may have been stopped after it finished, yet before we've got here.
+	QListWidgetItem *pcmItem = activePcmItems.take(converter);
+	if (pcmItem == NULL) return;
+	activeConversionProgress.remove(converter);
+	finishedConversionCount++;
 	if (Master::getInstance()->getSettings()->value("Master/showConnectionBalloons", "1").toBool()) {
-		emit conversionFinished("MIDI file converted", ui->pcmList->currentItem()->text());
+		emit conversionFinished("MIDI file converted", pcmItem->text());
 	}
-	ui->midiList->clear();
-	delete ui->pcmList->takeItem(ui->pcmList->currentRow());
-	on_startButton_clicked();
+	if (pcmItem == ui->pcmList->currentItem()) ui->midiList->clear();
+	delete ui->pcmList->takeItem(ui->pcmList->row(pcmItem));
+	if (!pendingPcmItems.isEmpty()) startNextConversion(converter);
+	if (!activePcmItems.isEmpty()) return;
+	if (ui->pcmList->count() == 0 && batchMode) {
+		emit batchConversionFinished();
+		return;
+	}
+	enableControls(true);
 }
 
 void MidiConverterDialog::updateConversionProgress(int midiEventsProcessed, int midiEventsTotal) {
-	double percentage = (100.0 * midiEventsProcessed) / midiEventsTotal;
+	AudioFileRenderer *converter = static_cast<AudioFileRenderer *>(sender());
+	if (!activeConversionProgress.contains(converter)) return;
+	activeConversionProgress[converter] = double(midiEventsProcessed) / midiEventsTotal;
+	double progress = finishedConversionCount;
+	foreach (double conversionProgress, activeConversionProgress) {
+		progress += conversionProgress;
+	}
+	double percentage = (100.0 * progress) / conversionCount;
 	ui->progressBar->setValue((int)percentage);
 }
 
@@ -268,6 +326,7 @@ void MidiConverterDialog::enableControls(bool enable) {
 	ui->stopButton->setEnabled(!enable);
 	ui->startButton->setEnabled(enable && ui->pcmList->count() > 0);
 	ui->profileComboBox->setEnabled(enable);
+	ui->parallelConversionsSpinBox->setEnabled(enable);
 	ui->midiList->setEnabled(enable);
 	ui->pcmList->setEnabled(enable);
 	ui->newPcmButton->setEnabled(enable);
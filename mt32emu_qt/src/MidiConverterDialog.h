@@ -26,7 +26,13 @@ protected:
 
 private:
 	Ui::MidiConverterDialog *ui;
-	AudioFileRenderer converter;
+	// Each output PCM file is converted by a separate converter, the MIDI files it concatenates are processed serially.
+	QList<AudioFileRenderer *> converters;
+	QList<QListWidgetItem *> pendingPcmItems;
+	QHash<AudioFileRenderer *, QListWidgetItem *> activePcmItems;
+	QHash<AudioFileRenderer *, double> activeConversionProgress;
+	int conversionCount;
+	int finishedConversionCount;
 	bool batchMode;
 
 	void enableControls(bool enable);
@@ -35,6 +41,7 @@ private:
 	QStringList showAddMidiFilesDialog();
 	void newPcmFile(const QString &proposedPCMFileName);
 	void newPcmFileGroup(const QStringList &fileNames);
+	void startNextConversion(AudioFileRenderer *converter);
 
 private slots:
 	void on_newPcmButton_clicked();
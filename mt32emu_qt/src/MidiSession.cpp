@@ -43,6 +43,12 @@ QMidiBuffer *MidiSession::getQMidiBuffer() {
 	return qMidiBuffer;
 }
 
+QMidiBuffer *MidiSession::takeQMidiBuffer() {
+	QMidiBuffer *takenQMidiBuffer = qMidiBuffer;
+	qMidiBuffer = NULL;
+	return takenQMidiBuffer;
+}
+
 MidiTrackRecorder * MidiSession::getMidiTrackRecorder() {
 	return midiTrackRecorder;
 }
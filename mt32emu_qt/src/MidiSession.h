@@ -30,6 +30,8 @@ public:
 	SynthRoute *getSynthRoute() const;
 	QMidiStreamParser *getQMidiStreamParser();
 	QMidiBuffer *getQMidiBuffer();
+	// Transfers the ownership of the QMidiBuffer (if any) to the caller.
+	QMidiBuffer *takeQMidiBuffer();
 	MidiTrackRecorder *getMidiTrackRecorder();
 	MidiTrackRecorder *setMidiTrackRecorder(MidiTrackRecorder *midiTrackRecorder);
 };
@@ -82,6 +82,34 @@ static inline void storeRelease(QAtomicPointer<T> &atomicPointer, T *value) {
 #endif
 }
 
+// Helpers for publishing a value written by a single thread to any number of reader threads without locking.
+// The two snapshots are written in turn, so that while the change count stays intact, it is safe to read the snapshot
+// with the index equal to the last bit of the change count.
+
+template<class T>
+static inline void takeSnapshot(T &snapshot, const T snapshots[], const QAtomicInt &changeCount) {
+	quint32 myChangeCount;
+	do {
+		myChangeCount = loadAcquire(changeCount);
+		snapshot = snapshots[myChangeCount & 1];
+	} while (myChangeCount != loadRelaxed(changeCount));
+}
+
+static inline quint32 getSnapshotReadIx(const QAtomicInt &changeCount) {
+	return loadRelaxed(changeCount) & 1;
+}
+
+static inline quint32 getSnapshotWriteIx(const QAtomicInt &changeCount) {
+	return (loadRelaxed(changeCount) + 1) & 1;
+}
+
+static inline void publishSnapshot(QAtomicInt &changeCount) {
+	// Since QAtomicInt involves signed arithmetic, we do increment explicitly to avoid UB.
+	// This is safe being performed in the rendering thread only.
+	quint32 myChangeCount = loadRelaxed(changeCount);
+	storeRelease(changeCount, (myChangeCount + 1U) & 0x7fffffffU);
+}
+
 } // namespace QAtomicHelper
 
 #endif // QATOMIC_HELPER_H
@@ -28,6 +28,11 @@ typedef MidiEventLayout::SysexMessageHeader<quint64> SysexMessageHeader;
 static const quint32 BUFFER_SIZE = 32768;
 static const quint32 MESSAGE_DATA_ALIGNMENT = quint32(sizeof(quint32));
 
+static bool isSysexProcessed(quint32 serial, quint32 processedSysexCount) {
+	// Serial numbers wrap around.
+	return qint32(processedSysexCount - serial) > 0;
+}
+
 QMidiBuffer::QMidiBuffer() :
 	ringBuffer(BUFFER_SIZE),
 	writePointer(),
@@ -35,7 +40,12 @@ QMidiBuffer::QMidiBuffer() :
 	bytesToWrite(),
 	readPointer(),
 	bytesRead(),
-	bytesToRead()
+	bytesToRead(),
+	lastReferencedSysexSerial(),
+	referencedSysexRetained(),
+	releasePosition(),
+	releaseSysexSerial(),
+	releasePending()
 {}
 
 bool QMidiBuffer::pushShortMessage(quint64 timestamp, quint32 data) {
@@ -133,12 +143,38 @@ void QMidiBuffer::discardEvents() {
 
 void QMidiBuffer::popEvents() {
 	if (readPointer == NULL) return;
-	ringBuffer.advanceReadPointer(bytesRead);
+	ringBuffer.advanceReadPointerRetainingData(bytesRead);
 	readPointer = NULL;
 	bytesRead = 0;
 	bytesToRead = 0;
 }
 
+void QMidiBuffer::sysexReferenced(quint32 serial) {
+	lastReferencedSysexSerial = serial;
+	referencedSysexRetained = true;
+}
+
+void QMidiBuffer::releaseProcessedEvents(quint32 processedSysexCount) {
+	if (releasePending) {
+		if (!isSysexProcessed(releaseSysexSerial, processedSysexCount)) return;
+		ringBuffer.releaseRetainedData(releasePosition);
+		releasePending = false;
+	}
+	if (!referencedSysexRetained || isSysexProcessed(lastReferencedSysexSerial, processedSysexCount)) {
+		ringBuffer.releaseRetainedData();
+		referencedSysexRetained = false;
+		return;
+	}
+	// The events retained so far are to be released once the last SysEx message among them is processed.
+	releasePosition = ringBuffer.getRetainedDataEnd();
+	releaseSysexSerial = lastReferencedSysexSerial;
+	releasePending = true;
+}
+
+bool QMidiBuffer::hasReferencedSysex(quint32 processedSysexCount) const {
+	return referencedSysexRetained && !isSysexProcessed(lastReferencedSysexSerial, processedSysexCount);
+}
+
 bool QMidiBuffer::requestSpace(quint32 eventLength) {
 	if (writePointer == NULL) {
 		writePointer = ringBuffer.writePointer(bytesToWrite, freeSpaceContiguous);
@@ -25,6 +25,14 @@ public:
 	bool nextEvent();
 	void discardEvents();
 	void popEvents();
+	// The events popped are retained in the buffer until released, so that the SysEx data can be referenced meanwhile.
+	// Retained SysEx messages are identified by serial numbers, assigned by the consumer sequentially as it takes
+	// them by reference and processes in the same order.
+	void sysexReferenced(quint32 serial);
+	// Releases the retained events that no longer contain SysEx messages in use, given the number of messages processed.
+	// The release is done in steps, so that a steady flow of SysEx messages can't hold the whole buffer indefinitely.
+	void releaseProcessedEvents(quint32 processedSysexCount);
+	bool hasReferencedSysex(quint32 processedSysexCount) const;
 
 private:
 	Utility::QRingBuffer ringBuffer;
@@ -39,6 +47,13 @@ private:
 	void *readPointer;
 	quint32 bytesRead;
 	quint32 bytesToRead;
+	// Serial number of the last SysEx message referenced, valid if referencedSysexRetained is set.
+	quint32 lastReferencedSysexSerial;
+	bool referencedSysexRetained;
+	// The retained events before releasePosition are released as soon as the SysEx message releaseSysexSerial is processed.
+	quint32 releasePosition;
+	quint32 releaseSysexSerial;
+	bool releasePending;
 
 	bool requestSpace(quint32 length);
 };
@@ -20,7 +20,7 @@
 using namespace Utility;
 
 QRingBuffer::QRingBuffer(const quint32 byteSize) :
-	buffer(new uchar[byteSize]), bufferSize(byteSize)
+	buffer(new uchar[byteSize]), bufferSize(byteSize), consumerReadPosition()
 {}
 
 QRingBuffer::~QRingBuffer() {
@@ -55,18 +55,33 @@ void *QRingBuffer::readPointer(quint32 &bytesReady) const {
 	// Acquire barrier ensures that data is never read ahead of the indices, when the buffer
 	// space might not contain valid data yet. In practice however, this is barely possible,
 	// because all subsequent data reads depend on values of the indices, but shouldn't hurt anyway.
-	quint32 myReadPosition = QAtomicHelper::loadRelaxed(readPosition);
+	quint32 myReadPosition = consumerReadPosition;
 	quint32 myWritePosition = QAtomicHelper::loadAcquire(writePosition);
 	bytesReady = (myWritePosition < myReadPosition ? bufferSize : myWritePosition) - myReadPosition;
 	return buffer + myReadPosition;
 }
 
 void QRingBuffer::advanceReadPointer(quint32 bytesRead) {
-	quint32 myReadPosition = QAtomicHelper::loadRelaxed(readPosition);
-	myReadPosition += bytesRead;
-	if (bufferSize <= myReadPosition) {
-		myReadPosition -= bufferSize;
+	advanceReadPointerRetainingData(bytesRead);
+	releaseRetainedData();
+}
+
+void QRingBuffer::advanceReadPointerRetainingData(quint32 bytesRead) {
+	consumerReadPosition += bytesRead;
+	if (bufferSize <= consumerReadPosition) {
+		consumerReadPosition -= bufferSize;
 	}
+}
+
+void QRingBuffer::releaseRetainedData() {
+	releaseRetainedData(consumerReadPosition);
+}
+
+quint32 QRingBuffer::getRetainedDataEnd() const {
+	return consumerReadPosition;
+}
+
+void QRingBuffer::releaseRetainedData(quint32 retainedDataEnd) {
 	// Release barrier ensures that data is completely read prior to updating the index.
-	QAtomicHelper::storeRelease(readPosition, myReadPosition);
+	QAtomicHelper::storeRelease(readPosition, retainedDataEnd);
 }
@@ -21,13 +21,25 @@ public:
 
 	// Accessible from the consumer thread.
 	void *readPointer(quint32 &bytesUsed) const;
+	// Also releases the data retained previously.
 	void advanceReadPointer(quint32 bytesRead);
+	// Same as advanceReadPointer() but keeps the data read in the buffer until releaseRetainedData() is invoked,
+	// so that the consumer may still refer to it, while the producer can't overwrite it.
+	void advanceReadPointerRetainingData(quint32 bytesRead);
+	void releaseRetainedData();
+	// Returns the position where the data retained so far ends, for a later partial release.
+	quint32 getRetainedDataEnd() const;
+	// Releases the retained data up to a position returned by getRetainedDataEnd() before.
+	void releaseRetainedData(quint32 retainedDataEnd);
 
 private:
 	uchar * const buffer;
 	const quint32 bufferSize;
+	// Position of the data retained by the consumer, the space before it is free for the producer.
 	QAtomicInt readPosition;
 	QAtomicInt writePosition;
+	// Accessed from the consumer thread only.
+	quint32 consumerReadPosition;
 };
 
 }
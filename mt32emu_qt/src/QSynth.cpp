@@ -16,11 +16,12 @@
 
 #include <cstring>
 #include <QtGlobal>
-#include <QMessageBox>
 
 #include "QSynth.h"
 #include "AudioFileWriter.h"
 #include "Master.h"
+#include "QAtomicHelper.h"
+#include "QRingBuffer.h"
 #include "RealtimeLocker.h"
 
 using namespace MT32Emu;
@@ -34,6 +35,10 @@ const int PART_COUNT = VOICE_PART_COUNT + 1;
 const int SOUND_GROUP_NAME_LENGTH = 9; // 0-terminated
 const int TIMBRE_NAME_LENGTH = 11; // 0-terminated
 const int NO_UPDATE_VALUE = -1;
+// The maximum number of synth control commands pending application in the rendering thread.
+const quint32 SYNTH_CONTROL_COMMAND_BUFFER_CAPACITY = 256;
+// How long to wait for the rendering thread to run a synth task in the realtime mode before giving up.
+const int SYNTH_TASK_TIMEOUT_MILLIS = 1000;
 
 static const ROMImage *makeROMImage(const QDir &romDir, QString romFileName, QString romFileName2) {
 	if (romFileName2.isEmpty()) {
@@ -112,6 +117,132 @@ static int getMasterVolume(Synth *synth, bool &overridden) {
 	return masterVolume;
 }
 
+// An operation that needs exclusive access to the synth. In the realtime mode, the rendering thread never locks synthMutex,
+// so such operations are handed over to it and run at the beginning of the next rendering pass instead.
+class SynthTask {
+public:
+	virtual ~SynthTask() {}
+	virtual void run(Synth &synth) = 0;
+};
+
+class FlushMIDIQueueTask : public SynthTask {
+public:
+	void run(Synth &synth) {
+		synth.flushMIDIQueue();
+	}
+};
+
+class PlayMIDIShortMessageNowTask : public SynthTask {
+	const Bit32u msg;
+
+public:
+	explicit PlayMIDIShortMessageNowTask(Bit32u useMsg) : msg(useMsg) {}
+
+	void run(Synth &synth) {
+		synth.playMsgNow(msg);
+	}
+};
+
+class PlayMIDISysexNowTask : public SynthTask {
+	const Bit8u * const sysex;
+	const Bit32u sysexLen;
+
+public:
+	PlayMIDISysexNowTask(const Bit8u *useSysex, Bit32u useSysexLen) : sysex(useSysex), sysexLen(useSysexLen) {}
+
+	void run(Synth &synth) {
+		synth.playSysexNow(sysex, sysexLen);
+	}
+};
+
+// Memory is never allocated in the rendering thread, so the caller repeats the task with a larger buffer when necessary.
+class DumpSysexBankTask : public SynthTask {
+	QByteArray &sysexBank;
+
+public:
+	Bit32u sysexBankSize;
+
+	explicit DumpSysexBankTask(QByteArray &useSysexBank) : sysexBank(useSysexBank), sysexBankSize() {}
+
+	void run(Synth &synth) {
+		sysexBankSize = synth.dumpSysexBank(reinterpret_cast<Bit8u *>(sysexBank.data()), Bit32u(sysexBank.size()));
+	}
+};
+
+class ApplySysexBankTask : public SynthTask {
+	const QByteArray &sysexBank;
+
+public:
+	explicit ApplySysexBankTask(const QByteArray &useSysexBank) : sysexBank(useSysexBank) {}
+
+	void run(Synth &synth) {
+		synth.applySysexBank(reinterpret_cast<const Bit8u *>(sysexBank.constData()), Bit32u(sysexBank.size()));
+	}
+};
+
+class SetReverbCompatibilityModeTask : public SynthTask {
+	const ReverbCompatibilityMode reverbCompatibilityMode;
+
+public:
+	explicit SetReverbCompatibilityModeTask(ReverbCompatibilityMode useReverbCompatibilityMode) :
+		reverbCompatibilityMode(useReverbCompatibilityMode)
+	{}
+
+	void run(Synth &synth) {
+		bool mt32CompatibleReverb;
+		if (reverbCompatibilityMode == ReverbCompatibilityMode_DEFAULT) {
+			mt32CompatibleReverb = synth.isDefaultReverbMT32Compatible();
+		} else {
+			mt32CompatibleReverb = reverbCompatibilityMode == ReverbCompatibilityMode_MT32;
+		}
+		synth.setReverbCompatibilityMode(mt32CompatibleReverb);
+	}
+};
+
+class GetPatchNameTask : public SynthTask {
+	const int partNum;
+
+public:
+	char patchName[TIMBRE_NAME_LENGTH];
+
+	explicit GetPatchNameTask(int usePartNum) : partNum(usePartNum), patchName() {}
+
+	void run(Synth &synth) {
+		const char *name = synth.getPatchName(partNum);
+		if (name != NULL) strncpy(patchName, name, TIMBRE_NAME_LENGTH - 1);
+	}
+};
+
+class IsActiveTask : public SynthTask {
+public:
+	bool active;
+
+	IsActiveTask() : active() {}
+
+	void run(Synth &synth) {
+		active = synth.isActive();
+	}
+};
+
+class GetDisplayStateTask : public SynthTask {
+	char * const targetBuffer;
+
+public:
+	bool midiMessageLEDState;
+
+	explicit GetDisplayStateTask(char *useTargetBuffer) : targetBuffer(useTargetBuffer), midiMessageLEDState() {}
+
+	void run(Synth &synth) {
+		midiMessageLEDState = synth.getDisplayState(targetBuffer);
+	}
+};
+
+static void clearMeasurements(RenderPassMeasurements *measurements) {
+	if (measurements == NULL) return;
+	measurements->sampleRateConversionNanos = 0;
+	measurements->statisticsAvailable = false;
+}
+
 class RealtimeHelper : public QThread {
 private:
 	enum SynthControlEvent {
@@ -135,10 +266,47 @@ private:
 		DISPLAY_COMPATIBILITY_MODE_CHANGED
 	};
 
+	// A change to be applied to the synth at the beginning of a rendering pass. Carries a copy of the new setting value,
+	// so that the rendering thread never needs to access the settings guarded by settingsMutex.
+	struct SynthControlCommand {
+		SynthControlEvent event;
+		union {
+			struct {
+				int volume;
+				bool overridden;
+			} masterVolume;
+			float gain;
+			bool enabled;
+			struct {
+				int mode;
+				int time;
+				int level;
+			} reverbSettings;
+			struct {
+				uint partNumber;
+				Bit8u volume;
+			} partVolumeOverride;
+			struct {
+				uint partNumber;
+				Bit8u group;
+				Bit8u number;
+			} partTimbre;
+			DACInputMode emuDACInputMode;
+			MIDIDelayMode midiDelayMode;
+			DisplayCompatibilityMode displayCompatibilityMode;
+		} params;
+	};
+
 	QSynth &qsynth;
 	bool stopProcessing;
 
-	QQueue<SynthControlEvent> synthControlEvents;
+	// Transfers synth control commands to the rendering thread lock-free. Written with settingsMutex held,
+	// so that commands from different threads are serialised. The buffer size is a multiple of the command size,
+	// therefore each command is always stored contiguously.
+	Utility::QRingBuffer synthControlCommandBuffer;
+	// Commands that didn't fit in synthControlCommandBuffer, guarded by settingsMutex. They are flushed to the buffer
+	// before the next command is written and after each rendering pass, so that no setting change is ever lost.
+	QQueue<SynthControlCommand> pendingSynthControlCommands;
 
 	// Synth settings, guarded by settingsMutex.
 	int masterVolume;
@@ -147,20 +315,12 @@ private:
 	float reverbOutputGain;
 	bool reverbEnabled;
 	bool reverbOverridden;
-	int partVolumeOverride[PART_COUNT];
-	struct {
-		quint8 changed : 1;
-		quint8 group : 2;
-		quint8 number : 6;
-	} partTimbres[VOICE_PART_COUNT];
 	bool reversedStereoEnabled;
 	bool niceAmpRampEnabled;
 	bool nicePanningEnabled;
 	bool nicePartialMixingEnabled;
 	DACInputMode emuDACInputMode;
 	MIDIDelayMode midiDelayMode;
-	bool midiChannelsAssignmentChannel1Engaged;
-	DisplayCompatibilityMode displayCompatibilityMode;
 
 	// Temp synth state collected while rendering, only accessed from the rendering thread.
 	// On backpressure, the latest values are kept.
@@ -184,9 +344,9 @@ private:
 	} tempState;
 
 	// Synth state snapshot, guarded by stateSnapshotMutex.
+	// Partial states, playing notes and LCD state are published by the synth itself and retrieved lock-free.
 	struct {
 		char lcdMessage[LCD_MESSAGE_LENGTH];
-		char lcdState[LCD_MESSAGE_LENGTH];
 		bool lcdStateUpdated;
 		bool midiMessageLEDState;
 		bool midiMessageLEDStateUpdated;
@@ -201,14 +361,10 @@ private:
 			bool programChanged;
 			char soundGroupName[SOUND_GROUP_NAME_LENGTH];
 			char timbreName[TIMBRE_NAME_LENGTH];
-			Bit32u playingNotesCount;
-			Bit8u keysOfPlayingNotes[MAX_PARTIAL_COUNT];
-			Bit8u velocitiesOfPlayingNotes[MAX_PARTIAL_COUNT];
 		} partStates[PART_COUNT];
-		PartialState partialStates[MAX_PARTIAL_COUNT];
 	} stateSnapshot;
 
-	/** Ensures atomicity of collecting changes to be applied to the synth settings. */
+	/** Ensures atomicity of collecting changes to be applied to the synth settings. Never locked in the rendering thread. */
 	QMutex settingsMutex;
 	/** Ensures atomicity of handling the output signals of the synth and capturing its internal state. */
 	QMutex stateSnapshotMutex;
@@ -217,81 +373,106 @@ private:
 
 	QVector<SoundGroup> soundGroupCache;
 
-	void applyChangesRealtime() {
-		RealtimeLocker settingsLocker(settingsMutex);
-		if (!settingsLocker.isLocked()) return;
+	/** Serialises the synth tasks submitted by other threads. Never locked in the rendering thread. */
+	QMutex synthTaskMutex;
+	/** The synth task awaiting to be run by the rendering thread or NULL. */
+	QAtomicPointer<SynthTask> pendingSynthTask;
+	/** Released by the rendering thread each time a synth task completes. */
+	QSemaphore synthTaskCompletions;
+
+	void runPendingSynthTask() {
+		if (QAtomicHelper::loadRelaxed(pendingSynthTask) == NULL) return;
+		SynthTask *synthTask = pendingSynthTask.fetchAndStoreAcquire(NULL);
+		if (synthTask == NULL) return;
+		synthTask->run(*qsynth.synth);
+		synthTaskCompletions.release();
+	}
+
+	// Invoked at the beginning of each rendering pass. The synth is only closed once the audio stream is stopped,
+	// so the rendering thread needs no locking to access the synth. Returns false if the synth is closed.
+	bool beginRenderingPass() {
+		if (!qsynth.isOpen()) return false;
+		runPendingSynthTask();
+		applyChangesRealtime();
+		return true;
+	}
+
+	void endRenderingPass() {
+		saveStateRealtime();
+		renderCompleteCondition.wakeOne();
+	}
+
+	void applySynthControlCommand(const SynthControlCommand &command) {
 		Synth *synth = qsynth.synth;
-		while (!synthControlEvents.isEmpty()) {
-			switch (synthControlEvents.dequeue()) {
-			case SYNTH_RESET:
-				writeSystemResetSysex(synth);
-				break;
-			case MASTER_VOLUME_CHANGED:
-				applyMasterVolume(synth, masterVolume, masterVolumeOverridden);
-				break;
-			case OUTPUT_GAIN_CHANGED:
-				synth->setOutputGain(outputGain);
-				break;
-			case REVERB_OUTPUT_GAIN_CHANGED:
-				synth->setReverbOutputGain(reverbOutputGain);
-				break;
-			case REVERB_ENABLED_CHANGED:
-				synth->setReverbEnabled(reverbEnabled);
-				break;
-			case REVERB_OVERRIDDEN_CHANGED:
-				synth->setReverbOverridden(reverbOverridden);
-				break;
-			case REVERB_SETTINGS_CHANGED:
-				overrideReverbSettings(synth, qsynth.reverbMode, qsynth.reverbTime, qsynth.reverbLevel);
-				break;
-			case PART_VOLUME_OVERRIDE_CHANGED:
-				for (int i = 0; i < PART_COUNT; i++) {
-					if (NO_UPDATE_VALUE != partVolumeOverride[i]) {
-						synth->setPartVolumeOverride(i, partVolumeOverride[i]);
-						partVolumeOverride[i] = NO_UPDATE_VALUE;
-					}
-				}
-				break;
-			case PART_TIMBRE_CHANGED:
-				for (int i = 0; i < VOICE_PART_COUNT; i++) {
-					if (partTimbres[i].changed) {
-						partTimbres[i].changed = 0;
-						writeTimbreSelectionOnPartSysex(synth, i, partTimbres[i].group, partTimbres[i].number);
-					}
-				}
-				break;
-			case REVERSED_STEREO_ENABLED_CHANGED:
-				synth->setReversedStereoEnabled(reversedStereoEnabled);
-				break;
-			case NICE_AMP_RAMP_ENABLED_CHANGED:
-				synth->setNiceAmpRampEnabled(niceAmpRampEnabled);
-				break;
-			case NICE_PANNING_ENABLED_CHANGED:
-				synth->setNicePanningEnabled(nicePanningEnabled);
-				break;
-			case NICE_PARTIAL_MIXING_ENABLED_CHANGED:
-				synth->setNicePartialMixingEnabled(nicePartialMixingEnabled);
-				break;
-			case EMU_DAC_INPUT_MODE_CHANGED:
-				synth->setDACInputMode(emuDACInputMode);
-				break;
-			case MIDI_DELAY_MODE_CHANGED:
-				synth->setMIDIDelayMode(midiDelayMode);
-				break;
-			case MIDI_CHANNELS_ASSIGNMENT_RESET:
-				writeMIDIChannelsAssignmentResetSysex(synth, midiChannelsAssignmentChannel1Engaged);
-				break;
-			case DISPLAY_RESET:
-				synth->setMainDisplayMode();
-				break;
-			case DISPLAY_COMPATIBILITY_MODE_CHANGED:
-				if (DisplayCompatibilityMode_DEFAULT == displayCompatibilityMode) {
-					synth->setDisplayCompatibility(synth->isDefaultDisplayOldMT32Compatible());
-				} else {
-					synth->setDisplayCompatibility(DisplayCompatibilityMode_OLD_MT32 == displayCompatibilityMode);
-				}
-				break;
+		switch (command.event) {
+		case SYNTH_RESET:
+			writeSystemResetSysex(synth);
+			break;
+		case MASTER_VOLUME_CHANGED:
+			applyMasterVolume(synth, command.params.masterVolume.volume, command.params.masterVolume.overridden);
+			break;
+		case OUTPUT_GAIN_CHANGED:
+			synth->setOutputGain(command.params.gain);
+			break;
+		case REVERB_OUTPUT_GAIN_CHANGED:
+			synth->setReverbOutputGain(command.params.gain);
+			break;
+		case REVERB_ENABLED_CHANGED:
+			synth->setReverbEnabled(command.params.enabled);
+			break;
+		case REVERB_OVERRIDDEN_CHANGED:
+			synth->setReverbOverridden(command.params.enabled);
+			break;
+		case REVERB_SETTINGS_CHANGED:
+			overrideReverbSettings(synth, command.params.reverbSettings.mode, command.params.reverbSettings.time, command.params.reverbSettings.level);
+			break;
+		case PART_VOLUME_OVERRIDE_CHANGED:
+			synth->setPartVolumeOverride(command.params.partVolumeOverride.partNumber, command.params.partVolumeOverride.volume);
+			break;
+		case PART_TIMBRE_CHANGED:
+			writeTimbreSelectionOnPartSysex(synth, command.params.partTimbre.partNumber, command.params.partTimbre.group, command.params.partTimbre.number);
+			break;
+		case REVERSED_STEREO_ENABLED_CHANGED:
+			synth->setReversedStereoEnabled(command.params.enabled);
+			break;
+		case NICE_AMP_RAMP_ENABLED_CHANGED:
+			synth->setNiceAmpRampEnabled(command.params.enabled);
+			break;
+		case NICE_PANNING_ENABLED_CHANGED:
+			synth->setNicePanningEnabled(command.params.enabled);
+			break;
+		case NICE_PARTIAL_MIXING_ENABLED_CHANGED:
+			synth->setNicePartialMixingEnabled(command.params.enabled);
+			break;
+		case EMU_DAC_INPUT_MODE_CHANGED:
+			synth->setDACInputMode(command.params.emuDACInputMode);
+			break;
+		case MIDI_DELAY_MODE_CHANGED:
+			synth->setMIDIDelayMode(command.params.midiDelayMode);
+			break;
+		case MIDI_CHANNELS_ASSIGNMENT_RESET:
+			writeMIDIChannelsAssignmentResetSysex(synth, command.params.enabled);
+			break;
+		case DISPLAY_RESET:
+			synth->setMainDisplayMode();
+			break;
+		case DISPLAY_COMPATIBILITY_MODE_CHANGED:
+			if (DisplayCompatibilityMode_DEFAULT == command.params.displayCompatibilityMode) {
+				synth->setDisplayCompatibility(synth->isDefaultDisplayOldMT32Compatible());
+			} else {
+				synth->setDisplayCompatibility(DisplayCompatibilityMode_OLD_MT32 == command.params.displayCompatibilityMode);
 			}
+			break;
+		}
+	}
+
+	void applyChangesRealtime() {
+		for (;;) {
+			quint32 bytesReady;
+			const SynthControlCommand *command = static_cast<const SynthControlCommand *>(synthControlCommandBuffer.readPointer(bytesReady));
+			if (bytesReady < sizeof(SynthControlCommand)) break;
+			applySynthControlCommand(*command);
+			synthControlCommandBuffer.advanceReadPointer(sizeof(SynthControlCommand));
 		}
 	}
 
@@ -320,13 +501,8 @@ private:
 			stateSnapshot.midiMessageLEDState = tempState.midiMessageLEDState;
 		}
 
-		Synth *synth = qsynth.synth;
-
 		stateSnapshot.lcdStateUpdated = tempState.lcdStateUpdated;
-		if (tempState.lcdStateUpdated) {
-			tempState.lcdStateUpdated = false;
-			synth->getDisplayState(stateSnapshot.lcdState);
-		}
+		tempState.lcdStateUpdated = false;
 
 		stateSnapshot.noteOnIgnored = tempState.noteOnIgnored;
 		tempState.noteOnIgnored = false;
@@ -343,24 +519,51 @@ private:
 			}
 
 			stateSnapshot.partStates[partIx].polyStateChanged = tempState.partStates[partIx].polyStateChanged;
-			if (tempState.partStates[partIx].polyStateChanged) {
-				tempState.partStates[partIx].polyStateChanged = false;
-				stateSnapshot.partStates[partIx].playingNotesCount = synth->getPlayingNotes(partIx, stateSnapshot.partStates[partIx].keysOfPlayingNotes, stateSnapshot.partStates[partIx].velocitiesOfPlayingNotes);
-			}
+			tempState.partStates[partIx].polyStateChanged = false;
+		}
+	}
+
+	// Only invoked with settingsMutex locked.
+	bool writeSynthControlCommand(const SynthControlCommand &command) {
+		quint32 bytesFree;
+		bool freeSpaceContiguous;
+		void *writePointer = synthControlCommandBuffer.writePointer(bytesFree, freeSpaceContiguous);
+		if (bytesFree < sizeof(SynthControlCommand)) return false;
+		*static_cast<SynthControlCommand *>(writePointer) = command;
+		synthControlCommandBuffer.advanceWritePointer(sizeof(SynthControlCommand));
+		return true;
+	}
+
+	// Only invoked with settingsMutex locked.
+	void flushPendingSynthControlCommands() {
+		while (!pendingSynthControlCommands.isEmpty() && writeSynthControlCommand(pendingSynthControlCommands.head())) {
+			pendingSynthControlCommands.dequeue();
 		}
+	}
 
-		synth->getPartialStates(stateSnapshot.partialStates);
+	// Only invoked with settingsMutex locked.
+	void pushSynthControlCommand(const SynthControlCommand &command) {
+		flushPendingSynthControlCommands();
+		// Keep the commands in order in case the buffer is full.
+		if (!pendingSynthControlCommands.isEmpty() || !writeSynthControlCommand(command)) {
+			pendingSynthControlCommands.enqueue(command);
+		}
 	}
 
-	void enqueueSynthControlEvent(SynthControlEvent value) {
-		synthControlEvents.removeOne(value);
-		synthControlEvents.enqueue(value);
+	void pushSynthControlCommand(SynthControlEvent event) {
+		SynthControlCommand command = { event };
+		pushSynthControlCommand(command);
 	}
 
 	void run() {
 		QMutexLocker stateSnapshotLocker(&stateSnapshotMutex);
 		QReportHandler &reportHandler = qsynth.reportHandler;
 		while (renderCompleteCondition.wait(&stateSnapshotMutex) && !stopProcessing) {
+			{
+				QMutexLocker settingsLocker(&settingsMutex);
+				flushPendingSynthControlCommands();
+			}
+
 			if (stateSnapshot.lcdMessage[0]) {
 				reportHandler.doShowLCDMessage(stateSnapshot.lcdMessage);
 				stateSnapshot.lcdMessage[0] = 0;
@@ -426,6 +629,7 @@ public:
 	RealtimeHelper(QSynth &useQSynth) :
 		qsynth(useQSynth),
 		stopProcessing(),
+		synthControlCommandBuffer(SYNTH_CONTROL_COMMAND_BUFFER_CAPACITY * sizeof(SynthControlCommand)),
 		outputGain(qsynth.synth->getOutputGain()),
 		reverbOutputGain(qsynth.synth->getReverbOutputGain()),
 		reverbEnabled(!qsynth.synth->isReverbOverridden() || qsynth.synth->isReverbEnabled()),
@@ -437,20 +641,16 @@ public:
 		emuDACInputMode(qsynth.synth->getDACInputMode()),
 		midiDelayMode(qsynth.synth->getMIDIDelayMode()),
 		tempState(),
-		stateSnapshot()
+		stateSnapshot(),
+		pendingSynthTask()
 	{
 		masterVolume = getMasterVolume(qsynth.synth, masterVolumeOverridden);
 		tempState.masterVolumeUpdate = NO_UPDATE_VALUE;
 		tempState.reverbMode = NO_UPDATE_VALUE;
 		tempState.reverbTime = NO_UPDATE_VALUE;
 		tempState.reverbLevel = NO_UPDATE_VALUE;
-		stateSnapshot.midiMessageLEDState = qsynth.synth->getDisplayState(stateSnapshot.lcdState);
-		for (int i = 0; i < PART_COUNT; i++) {
-			partVolumeOverride[i] = NO_UPDATE_VALUE;
-		}
-		for (int i = 0; i < VOICE_PART_COUNT; i++) {
-			partTimbres[i].changed = 0;
-		}
+		char lcdState[LCD_MESSAGE_LENGTH];
+		stateSnapshot.midiMessageLEDState = qsynth.synth->getDisplayState(lcdState);
 		{
 			makeSoundGroups(*qsynth.synth, soundGroupCache);
 			char memoryGroupName[SOUND_GROUP_NAME_LENGTH];
@@ -498,31 +698,42 @@ public:
 		QMutexLocker settingsLocker(&settingsMutex);
 		masterVolume = useMasterVolume;
 		masterVolumeOverridden = overridden;
-		enqueueSynthControlEvent(MASTER_VOLUME_CHANGED);
+		SynthControlCommand command = { MASTER_VOLUME_CHANGED };
+		command.params.masterVolume.volume = masterVolume;
+		command.params.masterVolume.overridden = masterVolumeOverridden;
+		pushSynthControlCommand(command);
 	}
 
 	void setOutputGain(float useOutputGain) {
 		QMutexLocker settingsLocker(&settingsMutex);
 		outputGain = useOutputGain;
-		enqueueSynthControlEvent(OUTPUT_GAIN_CHANGED);
+		SynthControlCommand command = { OUTPUT_GAIN_CHANGED };
+		command.params.gain = outputGain;
+		pushSynthControlCommand(command);
 	}
 
 	void setReverbOutputGain(float useReverbOutputGain) {
 		QMutexLocker settingsLocker(&settingsMutex);
 		reverbOutputGain = useReverbOutputGain;
-		enqueueSynthControlEvent(REVERB_OUTPUT_GAIN_CHANGED);
+		SynthControlCommand command = { REVERB_OUTPUT_GAIN_CHANGED };
+		command.params.gain = reverbOutputGain;
+		pushSynthControlCommand(command);
 	}
 
 	void setReverbEnabled(bool useReverbEnabled) {
 		QMutexLocker settingsLocker(&settingsMutex);
 		reverbEnabled = useReverbEnabled;
-		enqueueSynthControlEvent(REVERB_ENABLED_CHANGED);
+		SynthControlCommand command = { REVERB_ENABLED_CHANGED };
+		command.params.enabled = reverbEnabled;
+		pushSynthControlCommand(command);
 	}
 
 	void setReverbOverridden(bool useReverbOverridden) {
 		QMutexLocker settingsLocker(&settingsMutex);
 		reverbOverridden = useReverbOverridden;
-		enqueueSynthControlEvent(REVERB_OVERRIDDEN_CHANGED);
+		SynthControlCommand command = { REVERB_OVERRIDDEN_CHANGED };
+		command.params.enabled = reverbOverridden;
+		pushSynthControlCommand(command);
 	}
 
 	void setReverbSettings(int useReverbMode, int useReverbTime, int useReverbLevel) {
@@ -530,79 +741,100 @@ public:
 		qsynth.reverbMode = useReverbMode;
 		qsynth.reverbTime = useReverbTime;
 		qsynth.reverbLevel = useReverbLevel;
-		enqueueSynthControlEvent(REVERB_SETTINGS_CHANGED);
+		SynthControlCommand command = { REVERB_SETTINGS_CHANGED };
+		command.params.reverbSettings.mode = useReverbMode;
+		command.params.reverbSettings.time = useReverbTime;
+		command.params.reverbSettings.level = useReverbLevel;
+		pushSynthControlCommand(command);
 	}
 
 	void setPartVolumeOverride(uint partNumber, Bit8u volumeOverride) {
 		QMutexLocker settingsLocker(&settingsMutex);
-		partVolumeOverride[partNumber] = volumeOverride;
-		enqueueSynthControlEvent(PART_VOLUME_OVERRIDE_CHANGED);
+		SynthControlCommand command = { PART_VOLUME_OVERRIDE_CHANGED };
+		command.params.partVolumeOverride.partNumber = partNumber;
+		command.params.partVolumeOverride.volume = volumeOverride;
+		pushSynthControlCommand(command);
 	}
 
 	void setPartTimbre(uint partNumber, Bit8u timbreGroup, Bit8u timbreNumber) {
 		QMutexLocker settingsLocker(&settingsMutex);
-		partTimbres[partNumber].changed = 1;
-		partTimbres[partNumber].group = timbreGroup;
-		partTimbres[partNumber].number = timbreNumber;
-		enqueueSynthControlEvent(PART_TIMBRE_CHANGED);
+		SynthControlCommand command = { PART_TIMBRE_CHANGED };
+		command.params.partTimbre.partNumber = partNumber;
+		command.params.partTimbre.group = timbreGroup;
+		command.params.partTimbre.number = timbreNumber;
+		pushSynthControlCommand(command);
 	}
 
 	void setReversedStereoEnabled(bool useReversedStereoEnabled) {
 		QMutexLocker settingsLocker(&settingsMutex);
 		reversedStereoEnabled = useReversedStereoEnabled;
-		enqueueSynthControlEvent(REVERSED_STEREO_ENABLED_CHANGED);
+		SynthControlCommand command = { REVERSED_STEREO_ENABLED_CHANGED };
+		command.params.enabled = reversedStereoEnabled;
+		pushSynthControlCommand(command);
 	}
 
 	void setNiceAmpRampEnabled(bool useNiceAmpRampEnabled) {
 		QMutexLocker settingsLocker(&settingsMutex);
 		niceAmpRampEnabled = useNiceAmpRampEnabled;
-		enqueueSynthControlEvent(NICE_AMP_RAMP_ENABLED_CHANGED);
+		SynthControlCommand command = { NICE_AMP_RAMP_ENABLED_CHANGED };
+		command.params.enabled = niceAmpRampEnabled;
+		pushSynthControlCommand(command);
 	}
 
 	void setNicePanningEnabled(bool useNicePanningEnabled) {
 		QMutexLocker settingsLocker(&settingsMutex);
 		nicePanningEnabled = useNicePanningEnabled;
-		enqueueSynthControlEvent(NICE_PANNING_ENABLED_CHANGED);
+		SynthControlCommand command = { NICE_PANNING_ENABLED_CHANGED };
+		command.params.enabled = nicePanningEnabled;
+		pushSynthControlCommand(command);
 	}
 
 	void setNicePartialMixingEnabled(bool useNicePartialMixingEnabled) {
 		QMutexLocker settingsLocker(&settingsMutex);
 		nicePartialMixingEnabled = useNicePartialMixingEnabled;
-		enqueueSynthControlEvent(NICE_PARTIAL_MIXING_ENABLED_CHANGED);
+		SynthControlCommand command = { NICE_PARTIAL_MIXING_ENABLED_CHANGED };
+		command.params.enabled = nicePartialMixingEnabled;
+		pushSynthControlCommand(command);
 	}
 
 	void setDACInputMode(DACInputMode useEmuDACInputMode) {
 		QMutexLocker settingsLocker(&settingsMutex);
 		emuDACInputMode = useEmuDACInputMode;
-		enqueueSynthControlEvent(EMU_DAC_INPUT_MODE_CHANGED);
+		SynthControlCommand command = { EMU_DAC_INPUT_MODE_CHANGED };
+		command.params.emuDACInputMode = emuDACInputMode;
+		pushSynthControlCommand(command);
 	}
 
 	void setMIDIDelayMode(MIDIDelayMode useMIDIDelayMode) {
 		QMutexLocker settingsLocker(&settingsMutex);
 		midiDelayMode = useMIDIDelayMode;
-		enqueueSynthControlEvent(MIDI_DELAY_MODE_CHANGED);
+		SynthControlCommand command = { MIDI_DELAY_MODE_CHANGED };
+		command.params.midiDelayMode = midiDelayMode;
+		pushSynthControlCommand(command);
 	}
 
 	void resetMidiChannelsAssignment(bool useMidiChannelsAssignmentChannel1Engaged) {
 		QMutexLocker settingsLocker(&settingsMutex);
-		midiChannelsAssignmentChannel1Engaged = useMidiChannelsAssignmentChannel1Engaged;
-		enqueueSynthControlEvent(MIDI_CHANNELS_ASSIGNMENT_RESET);
+		SynthControlCommand command = { MIDI_CHANNELS_ASSIGNMENT_RESET };
+		command.params.enabled = useMidiChannelsAssignmentChannel1Engaged;
+		pushSynthControlCommand(command);
 	}
 
 	void setMainDisplayMode() {
 		QMutexLocker settingsLocker(&settingsMutex);
-		enqueueSynthControlEvent(DISPLAY_RESET);
+		pushSynthControlCommand(DISPLAY_RESET);
 	}
 
 	void setDisplayCompatibilityMode(DisplayCompatibilityMode useDisplayCompatibilityMode) {
 		QMutexLocker settingsLocker(&settingsMutex);
-		displayCompatibilityMode = useDisplayCompatibilityMode;
-		enqueueSynthControlEvent(DISPLAY_COMPATIBILITY_MODE_CHANGED);
+		SynthControlCommand command = { DISPLAY_COMPATIBILITY_MODE_CHANGED };
+		command.params.displayCompatibilityMode = useDisplayCompatibilityMode;
+		pushSynthControlCommand(command);
 	}
 
 	void resetSynth() {
 		QMutexLocker settingsLocker(&settingsMutex);
-		enqueueSynthControlEvent(SYNTH_RESET);
+		pushSynthControlCommand(SYNTH_RESET);
 	}
 
 	bool playMIDIShortMessageRealtime(Bit32u msg, quint64 timestamp) const {
@@ -615,37 +847,53 @@ public:
 		return midiLocker.isLocked() && qsynth.isOpen() && qsynth.synth->playSysex(sysex, sysexLen, qsynth.convertOutputToSynthTimestamp(timestamp));
 	}
 
-	void renderRealtime(float *buffer, uint length) {
-		RealtimeLocker synthLocker(*qsynth.synthMutex);
-		if (synthLocker.isLocked() && qsynth.isOpen()) {
-			applyChangesRealtime();
+	bool playMIDIReferencedSysexRealtime(const Bit8u *sysex, Bit32u sysexLen, quint64 timestamp) const {
+		RealtimeLocker midiLocker(*qsynth.midiMutex);
+		return midiLocker.isLocked() && qsynth.isOpen() && qsynth.synth->playReferencedSysex(sysex, sysexLen, qsynth.convertOutputToSynthTimestamp(timestamp));
+	}
+
+	bool getPendingReferencedSysexCountRealtime(quint32 &count) const {
+		RealtimeLocker midiLocker(*qsynth.midiMutex);
+		if (!midiLocker.isLocked()) return false;
+		count = qsynth.isOpen() ? qsynth.synth->getPendingReferencedSysexCount() : 0;
+		return true;
+	}
+
+	void renderRealtime(float *buffer, uint length, RenderPassMeasurements *measurements) {
+		if (beginRenderingPass()) {
+			MasterClockNanos sampleRateConversionStartNanos = MasterClock::getClockNanos();
 			qsynth.sampleRateConverter->getOutputSamples(buffer, length);
-			saveStateRealtime();
-			renderCompleteCondition.wakeOne();
+			qsynth.measureRenderPass(sampleRateConversionStartNanos, measurements);
+			endRenderingPass();
 		} else {
-			Synth::muteSampleBuffer(buffer, length);
+			Synth::muteSampleBuffer(buffer, 2 * length);
+			clearMeasurements(measurements);
 		}
 	}
 
-	void getPartialStates(PartialState *partialStates) {
-		QMutexLocker stateSnapshotLocker(&stateSnapshotMutex);
-		if (!qsynth.isOpen()) return;
-		memcpy(partialStates, stateSnapshot.partialStates, qsynth.synth->getPartialCount() * sizeof(PartialState));
-	}
-
-	uint getPlayingNotes(uint partNumber, Bit8u *keys, Bit8u *velocities) {
-		QMutexLocker stateSnapshotLocker(&stateSnapshotMutex);
-		if (!qsynth.isOpen()) return 0;
-		Bit32u playingNotesCount = stateSnapshot.partStates[partNumber].playingNotesCount;
-		memcpy(keys, stateSnapshot.partStates[partNumber].keysOfPlayingNotes, playingNotesCount * sizeof(Bit8u));
-		memcpy(velocities, stateSnapshot.partStates[partNumber].velocitiesOfPlayingNotes, playingNotesCount * sizeof(Bit8u));
-		return playingNotesCount;
+	void renderRealtime(float *leftBuffer, float *rightBuffer, uint length, RenderPassMeasurements *measurements) {
+		if (beginRenderingPass()) {
+			MasterClockNanos sampleRateConversionStartNanos = MasterClock::getClockNanos();
+			qsynth.sampleRateConverter->getOutputSamples(leftBuffer, rightBuffer, length);
+			qsynth.measureRenderPass(sampleRateConversionStartNanos, measurements);
+			endRenderingPass();
+		} else {
+			Synth::muteSampleBuffer(leftBuffer, length);
+			Synth::muteSampleBuffer(rightBuffer, length);
+			clearMeasurements(measurements);
+		}
 	}
 
-	bool getDisplayState(char *targetBuffer) {
-		QMutexLocker stateSnapshotLocker(&stateSnapshotMutex);
-		memcpy(targetBuffer, stateSnapshot.lcdState, LCD_MESSAGE_LENGTH);
-		return stateSnapshot.midiMessageLEDState;
+	// Runs the task in the rendering thread and waits for it to complete. Returns false if the task could not be run
+	// because the rendering thread didn't pick it up in time, e.g. when the audio stream is stalled.
+	bool runSynthTask(SynthTask &synthTask) {
+		QMutexLocker synthTaskLocker(&synthTaskMutex);
+		QAtomicHelper::storeRelease(pendingSynthTask, &synthTask);
+		if (synthTaskCompletions.tryAcquire(1, SYNTH_TASK_TIMEOUT_MILLIS)) return true;
+		if (pendingSynthTask.testAndSetOrdered(&synthTask, NULL)) return false;
+		// The rendering thread has just picked the task up, it won't take long.
+		synthTaskCompletions.acquire();
+		return true;
 	}
 
 	const QVector<SoundGroup> &getSoundGroupCache() const {
@@ -722,11 +970,11 @@ void QReportHandler::showLCDMessage(const char *message) {
 }
 
 void QReportHandler::onErrorControlROM() {
-	QMessageBox::critical(NULL, "Cannot open Synth", "Control ROM file cannot be opened.");
+	Master::showWarning("Cannot open Synth", "Control ROM file cannot be opened.", true);
 }
 
 void QReportHandler::onErrorPCMROM() {
-	QMessageBox::critical(NULL, "Cannot open Synth", "PCM ROM file cannot be opened.");
+	Master::showWarning("Cannot open Synth", "PCM ROM file cannot be opened.", true);
 }
 
 void QReportHandler::onDeviceReconfig() {
@@ -837,7 +1085,7 @@ void QReportHandler::doShowLCDMessage(const char *message) {
 }
 
 QSynth::QSynth(QObject *parent) :
-	QObject(parent), state(SynthState_CLOSED), midiMutex(new QMutex), synthMutex(new QMutex),
+	QObject(parent), state(SynthState_CLOSED), midiMutex(new QMutex), synthMutex(new QMutex), synthLifecycleLock(new QReadWriteLock),
 	controlROMImage(), pcmROMImage(), synth(), reportHandler(this), sampleRateConverter(),
 	audioRecorder(), realtimeHelper()
 {
@@ -850,6 +1098,7 @@ QSynth::~QSynth() {
 	delete audioRecorder;
 	delete sampleRateConverter;
 	delete synth;
+	delete synthLifecycleLock;
 	delete synthMutex;
 	delete midiMutex;
 }
@@ -858,26 +1107,58 @@ void QSynth::createSynth() {
 	delete synth;
 	synth = new Synth;
 	synth->setReportHandler3(&reportHandler);
+	synth->setStateSnapshotsEnabled(true);
 }
 
 bool QSynth::isOpen() const {
 	return state == SynthState_OPEN;
 }
 
+bool QSynth::runSynthTask(SynthTask &synthTask) const {
+	if (isRealtime() && isOpen()) return realtimeHelper->runSynthTask(synthTask);
+	QMutexLocker synthLocker(synthMutex);
+	if (!isOpen()) return false;
+	synthTask.run(*synth);
+	return true;
+}
+
 void QSynth::flushMIDIQueue() const {
+	FlushMIDIQueueTask task;
+	if (isRealtime()) {
+		// The rendering thread merges MIDI streams without blocking, so holding midiMutex would only make it drop messages.
+		runSynthTask(task);
+		return;
+	}
 	QMutexLocker midiLocker(midiMutex);
-	QMutexLocker synthLocker(synthMutex);
-	synth->flushMIDIQueue();
+	runSynthTask(task);
 }
 
 void QSynth::playMIDIShortMessageNow(Bit32u msg) const {
-	QMutexLocker synthLocker(synthMutex);
-	if (isOpen()) synth->playMsgNow(msg);
+	PlayMIDIShortMessageNowTask task(msg);
+	runSynthTask(task);
 }
 
 void QSynth::playMIDISysexNow(const Bit8u *sysex, Bit32u sysexLen) const {
-	QMutexLocker synthLocker(synthMutex);
-	if (isOpen()) synth->playSysexNow(sysex, sysexLen);
+	PlayMIDISysexNowTask task(sysex, sysexLen);
+	runSynthTask(task);
+}
+
+const QByteArray QSynth::dumpSysexBank() const {
+	QByteArray sysexBank;
+	forever {
+		DumpSysexBankTask task(sysexBank);
+		if (!runSynthTask(task)) return QByteArray();
+		if (task.sysexBankSize <= Bit32u(sysexBank.size())) {
+			sysexBank.truncate(int(task.sysexBankSize));
+			return sysexBank;
+		}
+		sysexBank.resize(int(task.sysexBankSize));
+	}
+}
+
+void QSynth::applySysexBank(const QByteArray &sysexBank) const {
+	ApplySysexBankTask task(sysexBank);
+	runSynthTask(task);
 }
 
 bool QSynth::playMIDIShortMessage(Bit32u msg, quint64 timestamp) const {
@@ -898,21 +1179,81 @@ bool QSynth::playMIDISysex(const Bit8u *sysex, Bit32u sysexLen, quint64 timestam
 	}
 }
 
+bool QSynth::playMIDIReferencedSysex(const Bit8u *sysex, Bit32u sysexLen, quint64 timestamp) const {
+	if (isRealtime()) {
+		return realtimeHelper->playMIDIReferencedSysexRealtime(sysex, sysexLen, timestamp);
+	} else {
+		QMutexLocker midiLocker(midiMutex);
+		return isOpen() && synth->playReferencedSysex(sysex, sysexLen, convertOutputToSynthTimestamp(timestamp));
+	}
+}
+
+bool QSynth::getPendingReferencedSysexCount(quint32 &count) const {
+	if (isRealtime()) {
+		return realtimeHelper->getPendingReferencedSysexCountRealtime(count);
+	} else {
+		QMutexLocker midiLocker(midiMutex);
+		count = isOpen() ? synth->getPendingReferencedSysexCount() : 0;
+		return true;
+	}
+}
+
 Bit32u QSynth::convertOutputToSynthTimestamp(quint64 timestamp) const {
 	return Bit32u(sampleRateConverter->convertOutputToSynthTimestamp(timestamp));
 }
 
-void QSynth::render(Bit16s *buffer, uint length) {
+// AudioFileWriter stores 16-bit integer samples only, as this is the resolution of the DAC in the real devices.
+// When the synth renders float samples, these are converted the same way as the synth does for integer output.
+static bool writeFloatSamples(AudioFileWriter &audioFileWriter, const float *buffer, uint length) {
+	qint16 convertedBuffer[2 * MAX_SAMPLES_PER_RUN];
+	while (length > 0) {
+		uint framesToWrite = qMin(length, uint(MAX_SAMPLES_PER_RUN));
+		for (uint i = 0; i < 2 * framesToWrite; i++) {
+			convertedBuffer[i] = Synth::convertSample(buffer[i]);
+		}
+		if (!audioFileWriter.write(convertedBuffer, framesToWrite)) return false;
+		buffer += 2 * framesToWrite;
+		length -= framesToWrite;
+	}
+	return true;
+}
+
+static bool writeFloatSamples(AudioFileWriter &audioFileWriter, const float *leftBuffer, const float *rightBuffer, uint length) {
+	qint16 convertedBuffer[2 * MAX_SAMPLES_PER_RUN];
+	while (length > 0) {
+		uint framesToWrite = qMin(length, uint(MAX_SAMPLES_PER_RUN));
+		for (uint i = 0; i < framesToWrite; i++) {
+			convertedBuffer[2 * i] = Synth::convertSample(leftBuffer[i]);
+			convertedBuffer[2 * i + 1] = Synth::convertSample(rightBuffer[i]);
+		}
+		if (!audioFileWriter.write(convertedBuffer, framesToWrite)) return false;
+		leftBuffer += framesToWrite;
+		rightBuffer += framesToWrite;
+		length -= framesToWrite;
+	}
+	return true;
+}
+
+void QSynth::measureRenderPass(MasterClockNanos sampleRateConversionStartNanos, RenderPassMeasurements *measurements) const {
+	if (measurements == NULL) return;
+	measurements->sampleRateConversionNanos = MasterClock::getClockNanos() - sampleRateConversionStartNanos;
+	measurements->statisticsAvailable = synth->getStatistics(measurements->statistics);
+}
+
+void QSynth::render(Bit16s *buffer, uint length, RenderPassMeasurements *measurements) {
 	QMutexLocker synthLocker(synthMutex);
 	if (!isOpen()) {
 		synthLocker.unlock();
 
 		// Synth is closed, simply erase buffer content
 		Synth::muteSampleBuffer(buffer, 2 * length);
+		clearMeasurements(measurements);
 		emit audioBlockRendered();
 		return;
 	}
+	MasterClockNanos sampleRateConversionStartNanos = MasterClock::getClockNanos();
 	sampleRateConverter->getOutputSamples(buffer, length);
+	measureRenderPass(sampleRateConversionStartNanos, measurements);
 	if (isRecordingAudio()) {
 		if (!audioRecorder->write(buffer, length)) stopRecordingAudio();
 	}
@@ -920,9 +1261,9 @@ void QSynth::render(Bit16s *buffer, uint length) {
 	emit audioBlockRendered();
 }
 
-void QSynth::render(float *buffer, uint length) {
+void QSynth::render(float *buffer, uint length, RenderPassMeasurements *measurements) {
 	if (isRealtime()) {
-		realtimeHelper->renderRealtime(buffer, length);
+		realtimeHelper->renderRealtime(buffer, length, measurements);
 		return;
 	}
 	QMutexLocker synthLocker(synthMutex);
@@ -931,12 +1272,43 @@ void QSynth::render(float *buffer, uint length) {
 
 		// Synth is closed, simply erase buffer content
 		Synth::muteSampleBuffer(buffer, 2 * length);
+		clearMeasurements(measurements);
 		emit audioBlockRendered();
 		return;
 	}
+	MasterClockNanos sampleRateConversionStartNanos = MasterClock::getClockNanos();
 	sampleRateConverter->getOutputSamples(buffer, length);
+	measureRenderPass(sampleRateConversionStartNanos, measurements);
+	if (isRecordingAudio()) {
+		if (!writeFloatSamples(*audioRecorder, buffer, length)) stopRecordingAudio();
+	}
+	synthLocker.unlock();
+	emit audioBlockRendered();
+}
+
+void QSynth::render(float *leftBuffer, float *rightBuffer, uint length, RenderPassMeasurements *measurements) {
+	if (isRealtime()) {
+		realtimeHelper->renderRealtime(leftBuffer, rightBuffer, length, measurements);
+		return;
+	}
+	QMutexLocker synthLocker(synthMutex);
+	if (!isOpen()) {
+		synthLocker.unlock();
+
+		// Synth is closed, simply erase buffer content
+		Synth::muteSampleBuffer(leftBuffer, length);
+		Synth::muteSampleBuffer(rightBuffer, length);
+		clearMeasurements(measurements);
+		emit audioBlockRendered();
+		return;
+	}
+	MasterClockNanos sampleRateConversionStartNanos = MasterClock::getClockNanos();
+	sampleRateConverter->getOutputSamples(leftBuffer, rightBuffer, length);
+	measureRenderPass(sampleRateConversionStartNanos, measurements);
+	if (isRecordingAudio()) {
+		if (!writeFloatSamples(*audioRecorder, leftBuffer, rightBuffer, length)) stopRecordingAudio();
+	}
 	synthLocker.unlock();
-	// TODO: Add support for recording to float WAVs
 	emit audioBlockRendered();
 }
 
@@ -1109,15 +1481,8 @@ void QSynth::setInitialMIDIChannelsAssignment(bool engageChannel1) {
 
 void QSynth::setReverbCompatibilityMode(ReverbCompatibilityMode useReverbCompatibilityMode) {
 	reverbCompatibilityMode = useReverbCompatibilityMode;
-	QMutexLocker synthLocker(synthMutex);
-	if (!isOpen()) return;
-	bool mt32CompatibleReverb;
-	if (useReverbCompatibilityMode == ReverbCompatibilityMode_DEFAULT) {
-		mt32CompatibleReverb = synth->isDefaultReverbMT32Compatible();
-	} else {
-		mt32CompatibleReverb = useReverbCompatibilityMode == ReverbCompatibilityMode_MT32;
-	}
-	synth->setReverbCompatibilityMode(mt32CompatibleReverb);
+	SetReverbCompatibilityModeTask task(useReverbCompatibilityMode);
+	runSynthTask(task);
 }
 
 void QSynth::setMIDIDelayMode(MIDIDelayMode midiDelayMode) {
@@ -1151,9 +1516,8 @@ void QSynth::setPartialCount(int newPartialCount) {
 }
 
 const QString QSynth::getPatchName(int partNum) const {
-	QMutexLocker synthLocker(synthMutex);
-	QString name = isOpen() ? QString().fromLocal8Bit(synth->getPatchName(partNum)) : QString("Channel %1").arg(partNum + 1);
-	return name;
+	GetPatchNameTask task(partNum);
+	return runSynthTask(task) ? QString().fromLocal8Bit(task.patchName) : QString("Channel %1").arg(partNum + 1);
 }
 
 void QSynth::setTimbreOnPart(uint partNumber, uint timbreGroup, uint timbreNumber) {
@@ -1174,44 +1538,46 @@ void QSynth::getSoundGroups(QVector<SoundGroup> &groups) const {
 	makeSoundGroups(*synth, groups);
 }
 
-void QSynth::getPartialStates(PartialState *partialStates) const {
-	if (isRealtime()) {
-		realtimeHelper->getPartialStates(partialStates);
-	} else {
-		QMutexLocker synthLocker(synthMutex);
-		if (!isOpen()) return;
-		synth->getPartialStates(partialStates);
-	}
-}
-
-uint QSynth::getPlayingNotes(uint partNumber, Bit8u *keys, Bit8u *velocities) const {
-	if (isRealtime()) {
-		return realtimeHelper->getPlayingNotes(partNumber, keys, velocities);
-	} else {
-		QMutexLocker synthLocker(synthMutex);
-		return synth->getPlayingNotes(partNumber, keys, velocities);
-	}
+// The state snapshots are published by the synth at the end of each rendering pass and can be read without locking synthMutex,
+// so that monitoring the synth state never blocks the rendering thread. Only closing the synth is excluded meanwhile.
+bool QSynth::getStateSnapshot(StateSnapshot &snapshot, PartialState *partialStates, Bit8u *keys, Bit8u *velocities) const {
+	snapshot.partialStates = partialStates;
+	snapshot.packedPartialStates = NULL;
+	snapshot.keys = keys;
+	snapshot.velocities = velocities;
+	QReadLocker synthLifecycleLocker(synthLifecycleLock);
+	return isOpen() && synth->getStateSnapshot(snapshot);
 }
 
 uint QSynth::getPartialCount() const {
 	return synth->getPartialCount();
 }
 
+RendererType QSynth::getRendererType() const {
+	return synth->getSelectedRendererType();
+}
+
 uint QSynth::getSynthSampleRate() const {
 	return synth->getStereoOutputSampleRate();
 }
 
 bool QSynth::isActive() const {
-	QMutexLocker synthLocker(synthMutex);
-	return isOpen() && synth->isActive();
+	IsActiveTask task;
+	return runSynthTask(task) && task.active;
 }
 
 bool QSynth::getDisplayState(char *targetBuffer) const {
-	if (isRealtime()) {
-		return realtimeHelper->getDisplayState(targetBuffer);
-	}
-	QMutexLocker synthLocker(synthMutex);
-	return synth->getDisplayState(targetBuffer);
+	StateSnapshot snapshot;
+	if (getStateSnapshot(snapshot, NULL, NULL, NULL)) {
+		memcpy(targetBuffer, snapshot.lcdState, LCD_MESSAGE_LENGTH);
+		return snapshot.midiMessageLEDState;
+	}
+	GetDisplayStateTask task(targetBuffer);
+	if (runSynthTask(task)) return task.midiMessageLEDState;
+	// Blank display, same as the synth shows when closed.
+	memset(targetBuffer, ' ', LCD_MESSAGE_LENGTH - 1);
+	targetBuffer[LCD_MESSAGE_LENGTH - 1] = 0;
+	return false;
 }
 
 void QSynth::setMainDisplayMode() {
@@ -1272,6 +1638,7 @@ void QSynth::close() {
 	{
 		QMutexLocker midiLocker(midiMutex);
 		QMutexLocker synthLocker(synthMutex);
+		QWriteLocker synthLifecycleLocker(synthLifecycleLock);
 		synth->close();
 		// This effectively resets rendered frame counter, audioStream is also going down
 		createSynth();
@@ -1354,6 +1721,12 @@ void QSynth::getROMImages(const ROMImage *&cri, const ROMImage *&pri) const {
 	pri = pcmROMImage;
 }
 
+bool QSynth::openSynthWithROMImages(Synth &otherSynth) const {
+	// The ROM images are only freed after closing, which can't happen while the lock is held.
+	QReadLocker synthLifecycleLocker(synthLifecycleLock);
+	return isOpen() && otherSynth.open(*controlROMImage, *pcmROMImage, AnalogOutputMode_DIGITAL_ONLY);
+}
+
 void QSynth::freeROMImages() {
 	// Ensure our ROM images get freed even if the synth is still in use
 	const ROMImage *cri = controlROMImage;
@@ -4,6 +4,8 @@
 #include <QtCore>
 #include <mt32emu/mt32emu.h>
 
+#include "MasterClock.h"
+
 #if !MT32EMU_IS_COMPATIBLE(2, 8)
 #error Incompatible mt32emu library version
 #endif
@@ -11,6 +13,7 @@
 class AudioFileWriter;
 class RealtimeHelper;
 class QSynth;
+class SynthTask;
 
 enum SynthState {
 	SynthState_CLOSED,
@@ -71,6 +74,15 @@ struct SoundGroup {
 
 Q_DECLARE_METATYPE(SoundGroup::Item)
 
+// Measurements of a rendering pass taken by QSynth::render() while the synth cannot be closed.
+struct RenderPassMeasurements {
+	// Time spent in the sample rate converter, including the synth rendering it invoked.
+	MasterClockNanos sampleRateConversionNanos;
+	// Synth usage statistics sampled right after rendering, valid if statisticsAvailable is true.
+	bool statisticsAvailable;
+	MT32Emu::Statistics statistics;
+};
+
 class QReportHandler : public QObject, public MT32Emu::ReportHandler3 {
 	Q_OBJECT
 
@@ -130,6 +142,8 @@ private:
 
 	QMutex * const midiMutex;
 	QMutex * const synthMutex;
+	// Held for writing while the synth is closed, so that its state can be read without locking synthMutex.
+	QReadWriteLock * const synthLifecycleLock;
 
 	QDir romDir;
 	QString controlROMFileName;
@@ -159,6 +173,10 @@ private:
 	void setState(SynthState newState);
 	void freeROMImages();
 	MT32Emu::Bit32u convertOutputToSynthTimestamp(quint64 timestamp) const;
+	// Runs the task with exclusive access to the synth, provided the synth is open. Returns false if the task wasn't run.
+	bool runSynthTask(SynthTask &synthTask) const;
+	// Only invoked from the rendering thread after rendering, while the synth cannot be closed.
+	void measureRenderPass(MasterClockNanos sampleRateConversionStartNanos, RenderPassMeasurements *measurements) const;
 
 public:
 	explicit QSynth(QObject *parent = NULL);
@@ -174,10 +192,19 @@ public:
 	void flushMIDIQueue() const;
 	void playMIDIShortMessageNow(MT32Emu::Bit32u msg) const;
 	void playMIDISysexNow(const MT32Emu::Bit8u *sysex, MT32Emu::Bit32u sysexLen) const;
+	const QByteArray dumpSysexBank() const;
+	void applySysexBank(const QByteArray &sysexBank) const;
 	bool playMIDIShortMessage(MT32Emu::Bit32u msg, quint64 timestamp) const;
 	bool playMIDISysex(const MT32Emu::Bit8u *sysex, MT32Emu::Bit32u sysexLen, quint64 timestamp) const;
-	void render(MT32Emu::Bit16s *buffer, uint length);
-	void render(float *buffer, uint length);
+	// The SysEx data isn't copied and must stay intact until the message is processed.
+	bool playMIDIReferencedSysex(const MT32Emu::Bit8u *sysex, MT32Emu::Bit32u sysexLen, quint64 timestamp) const;
+	// Retrieves the number of SysEx messages played by reference and not yet processed, in the order played.
+	// Returns false if the count is unknown at the moment, meaning that the referenced data may still be in use.
+	bool getPendingReferencedSysexCount(quint32 &count) const;
+	// When measurements are provided, they are filled in for the rendered pass.
+	void render(MT32Emu::Bit16s *buffer, uint length, RenderPassMeasurements *measurements = NULL);
+	void render(float *buffer, uint length, RenderPassMeasurements *measurements = NULL);
+	void render(float *leftBuffer, float *rightBuffer, uint length, RenderPassMeasurements *measurements = NULL);
 
 	const QReportHandler *getReportHandler() const;
 
@@ -185,6 +212,8 @@ public:
 	void setSynthProfile(const SynthProfile &synthProfile, QString useSynthProfileName);
 
 	void getROMImages(const MT32Emu::ROMImage *&controlROMImage, const MT32Emu::ROMImage *&pcmROMImage) const;
+	// Opens another synth with the ROM images in use, which are protected from being freed meanwhile. Fails unless open.
+	bool openSynthWithROMImages(MT32Emu::Synth &otherSynth) const;
 
 	void setMasterVolume(int masterVolume, bool overridden);
 	void setOutputGain(float outputGain);
@@ -208,9 +237,11 @@ public:
 	const QString getPatchName(int partNum) const;
 	void setTimbreOnPart(uint partNumber, uint timbreGroup, uint timbreNumber);
 	void getSoundGroups(QVector<SoundGroup> &) const;
-	void getPartialStates(MT32Emu::PartialState *partialStates) const;
-	uint getPlayingNotes(uint partNumber, MT32Emu::Bit8u *keys, MT32Emu::Bit8u *velocities) const;
+	// Retrieves the synth state published at the end of the latest rendering pass. Any of the arrays may be NULL,
+	// otherwise they must have at least getPartialCount() entries. Returns false if the synth isn't open.
+	bool getStateSnapshot(MT32Emu::StateSnapshot &snapshot, MT32Emu::PartialState *partialStates, MT32Emu::Bit8u *keys, MT32Emu::Bit8u *velocities) const;
 	uint getPartialCount() const;
+	MT32Emu::RendererType getRendererType() const;
 	uint getSynthSampleRate() const;
 	bool isActive() const;
 	bool getDisplayState(char *targetBuffer) const;
@@ -224,7 +224,8 @@ ROMSelectionDialog::ROMSelectionDialog(SynthProfile &useSynthProfile, QWidget *p
 	QDialog(parent),
 	ui(new Ui::ROMSelectionDialog),
 	synthProfile(useSynthProfile),
-	romInfoTableCellChangedGuard()
+	romInfoTableCellChangedGuard(),
+	romIndex(new ROMIndex)
 {
 	ui->setupUi(this);
 
@@ -236,6 +237,7 @@ ROMSelectionDialog::ROMSelectionDialog(SynthProfile &useSynthProfile, QWidget *p
 }
 
 ROMSelectionDialog::~ROMSelectionDialog() {
+	delete romIndex;
 	delete ui;
 }
 
@@ -264,8 +266,10 @@ void ROMSelectionDialog::refreshROMInfos() {
 	int row = 0;
 	for (int dirEntryIx = 0; dirEntryIx < dirEntries.size(); dirEntryIx++) {
 		const QString &fileName = dirEntries.at(dirEntryIx);
-		FileStream file;
-		if (!file.open(Master::getROMPathNameLocal(synthProfile.romDir, fileName))) continue;
+		const QByteArray pathName = Master::getROMPathNameLocal(synthProfile.romDir, fileName);
+		MappedFile file;
+		if (!file.open(pathName)) continue;
+		romIndex->indexFile(file, pathName);
 		const ROMInfo *romInfoPtr = ROMInfo::getROMInfo(&file, romInfos);
 		if (romInfoPtr == NULL) continue;
 		const ROMInfo &romInfo = *romInfoPtr;
@@ -9,6 +9,10 @@ namespace Ui {
 	class ROMSelectionDialog;
 }
 
+namespace MT32Emu {
+	class ROMIndex;
+}
+
 struct SynthProfile;
 
 class ROMSelectionDialog : public QDialog
@@ -25,6 +29,8 @@ private:
 
 	SynthProfile &synthProfile;
 	bool romInfoTableCellChangedGuard;
+	// Remembers digests of the ROM files seen, so that refreshing the table doesn't hash unchanged files again.
+	MT32Emu::ROMIndex *romIndex;
 
 	void refreshROMInfos();
 
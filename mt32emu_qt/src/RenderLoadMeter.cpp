@@ -0,0 +1,152 @@
+/* Copyright (C) 2011-2026 Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "RenderLoadMeter.h"
+#include "QAtomicHelper.h"
+
+static const double LOAD_AVERAGING_FACTOR = 0.05;
+
+static MasterClockNanos secondsToNanos(double seconds) {
+	return MasterClockNanos(seconds * MasterClock::NANOS_PER_SECOND);
+}
+
+// Returns the increase of a synth duration since the previous period. The durations drop when the synth statistics are reset.
+static double getDurationDelta(double duration, double lastDuration) {
+	return duration < lastDuration ? duration : duration - lastDuration;
+}
+
+const char *RenderLoadMeter::getStageName(RenderStage stage) {
+	switch (stage) {
+	case RenderStage_MIDI_MERGE:
+		return "MIDI merge";
+	case RenderStage_MIDI_PROCESSING:
+		return "MIDI processing";
+	case RenderStage_PARTIALS:
+		return "Partials";
+	case RenderStage_REVERB:
+		return "Reverb";
+	case RenderStage_ANALOG:
+		return "Analog";
+	case RenderStage_SRC:
+		return "SRC";
+	default:
+		return "None";
+	}
+}
+
+QString RenderLoadMeter::getStatsSummary(const RenderLoadStats &stats) {
+	QString summary = QString("DSP load: %1% avg, %2% peak; render time: %3 ms last, %4 ms max; xruns: %5")
+		.arg(100.0 * stats.averageLoad, 0, 'f', 1)
+		.arg(100.0 * stats.peakLoad, 0, 'f', 1)
+		.arg(double(stats.lastPeriodNanos) / MasterClock::NANOS_PER_MILLISECOND, 0, 'f', 2)
+		.arg(double(stats.maxPeriodNanos) / MasterClock::NANOS_PER_MILLISECOND, 0, 'f', 2)
+		.arg(stats.xrunCount);
+	if (stats.lastXrunStage != RenderStage_COUNT) {
+		summary += QString(", the last one after a period mostly spent in %1 at %2% load").arg(getStageName(stats.lastXrunStage)).arg(100.0 * stats.lastXrunLoad, 0, 'f', 1);
+	}
+	return summary;
+}
+
+QString RenderLoadMeter::getStageBreakdown(const RenderLoadStats &stats) {
+	MasterClockNanos totalNanos = 0;
+	for (int stageIx = 0; stageIx < RenderStage_COUNT; stageIx++) {
+		totalNanos += stats.totalStageNanos[stageIx];
+	}
+	QStringList stageShares;
+	for (int stageIx = 0; stageIx < RenderStage_COUNT; stageIx++) {
+		double share = totalNanos > 0 ? 100.0 * stats.totalStageNanos[stageIx] / totalNanos : 0.0;
+		stageShares += QString("%1: %2%").arg(getStageName(RenderStage(stageIx))).arg(share, 0, 'f', 1);
+	}
+	return "Rendering time share: " + stageShares.join(", ");
+}
+
+RenderLoadMeter::RenderLoadMeter() : publishedStatsChangeCount(0) {
+	reset(0);
+}
+
+void RenderLoadMeter::reset(uint useSampleRate) {
+	sampleRate = useSampleRate;
+	memset(&currentStats, 0, sizeof currentStats);
+	currentStats.lastXrunStage = RenderStage_COUNT;
+	memset(&lastSynthDurations, 0, sizeof lastSynthDurations);
+	memset(lastPeriodStageNanos, 0, sizeof lastPeriodStageNanos);
+	publishedStats[0] = currentStats;
+	publishedStats[1] = currentStats;
+}
+
+void RenderLoadMeter::periodRendered(uint frameCount, MasterClockNanos periodStartNanos, MasterClockNanos synthRenderStartNanos, const RenderPassMeasurements &measurements) {
+	MasterClockNanos periodNanos = MasterClock::getClockNanos() - periodStartNanos;
+
+	memset(lastPeriodStageNanos, 0, sizeof lastPeriodStageNanos);
+	lastPeriodStageNanos[RenderStage_MIDI_MERGE] = synthRenderStartNanos - periodStartNanos;
+	if (measurements.statisticsAvailable) {
+		const MT32Emu::Statistics *synthStatistics = &measurements.statistics;
+		SynthDurations synthDurations;
+		synthDurations.midiProcessing = synthStatistics->totalMidiProcessingDuration;
+		synthDurations.partials = synthStatistics->totalPartialRenderingDuration;
+		synthDurations.reverb = synthStatistics->totalReverbDuration;
+		synthDurations.analog = synthStatistics->totalAnalogDuration;
+		synthDurations.total = synthStatistics->totalRenderPassDuration;
+		lastPeriodStageNanos[RenderStage_MIDI_PROCESSING] = secondsToNanos(getDurationDelta(synthDurations.midiProcessing, lastSynthDurations.midiProcessing));
+		lastPeriodStageNanos[RenderStage_PARTIALS] = secondsToNanos(getDurationDelta(synthDurations.partials, lastSynthDurations.partials));
+		lastPeriodStageNanos[RenderStage_REVERB] = secondsToNanos(getDurationDelta(synthDurations.reverb, lastSynthDurations.reverb));
+		lastPeriodStageNanos[RenderStage_ANALOG] = secondsToNanos(getDurationDelta(synthDurations.analog, lastSynthDurations.analog));
+		// The sample rate converter invokes the synth rendering, the rest of its time is spent in the conversion itself.
+		MasterClockNanos synthRenderPassNanos = secondsToNanos(getDurationDelta(synthDurations.total, lastSynthDurations.total));
+		lastPeriodStageNanos[RenderStage_SRC] = qMax(MasterClockNanos(0), measurements.sampleRateConversionNanos - synthRenderPassNanos);
+		lastSynthDurations = synthDurations;
+	} else {
+		lastPeriodStageNanos[RenderStage_PARTIALS] = measurements.sampleRateConversionNanos;
+	}
+	for (int stageIx = 0; stageIx < RenderStage_COUNT; stageIx++) {
+		currentStats.totalStageNanos[stageIx] += lastPeriodStageNanos[stageIx];
+	}
+
+	double load = (sampleRate == 0 || frameCount == 0) ? 0.0 : double(periodNanos) * sampleRate / (double(frameCount) * MasterClock::NANOS_PER_SECOND);
+	currentStats.averageLoad = currentStats.periodCount == 0 ? load : currentStats.averageLoad + (load - currentStats.averageLoad) * LOAD_AVERAGING_FACTOR;
+	currentStats.periodCount++;
+	currentStats.lastPeriodNanos = periodNanos;
+	currentStats.maxPeriodNanos = qMax(currentStats.maxPeriodNanos, periodNanos);
+	currentStats.lastLoad = load;
+	currentStats.peakLoad = qMax(currentStats.peakLoad, load);
+	publishStats();
+}
+
+void RenderLoadMeter::xrunDetected() {
+	RenderStage dominantStage = RenderStage_COUNT;
+	MasterClockNanos dominantStageNanos = 0;
+	for (int stageIx = 0; stageIx < RenderStage_COUNT; stageIx++) {
+		if (dominantStageNanos < lastPeriodStageNanos[stageIx]) {
+			dominantStage = RenderStage(stageIx);
+			dominantStageNanos = lastPeriodStageNanos[stageIx];
+		}
+	}
+	currentStats.xrunCount++;
+	currentStats.lastXrunStage = dominantStage;
+	currentStats.lastXrunLoad = currentStats.lastLoad;
+	publishStats();
+}
+
+void RenderLoadMeter::publishStats() {
+	publishedStats[QAtomicHelper::getSnapshotWriteIx(publishedStatsChangeCount)] = currentStats;
+	QAtomicHelper::publishSnapshot(publishedStatsChangeCount);
+}
+
+void RenderLoadMeter::getStats(RenderLoadStats &stats) const {
+	QAtomicHelper::takeSnapshot(stats, publishedStats, publishedStatsChangeCount);
+}
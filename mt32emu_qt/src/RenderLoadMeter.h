@@ -0,0 +1,87 @@
+#ifndef RENDER_LOAD_METER_H
+#define RENDER_LOAD_METER_H
+
+#include <QtCore>
+
+#include "MasterClock.h"
+#include "QSynth.h"
+
+enum RenderStage {
+	RenderStage_MIDI_MERGE,
+	RenderStage_MIDI_PROCESSING,
+	RenderStage_PARTIALS,
+	RenderStage_REVERB,
+	RenderStage_ANALOG,
+	RenderStage_SRC,
+	RenderStage_COUNT
+};
+
+struct RenderLoadStats {
+	// Number of periods rendered since the synth route was opened.
+	quint32 periodCount;
+	// Time taken to render the last period and the maximum of that.
+	MasterClockNanos lastPeriodNanos;
+	MasterClockNanos maxPeriodNanos;
+	// Ratios of the rendering time to the duration of the rendered period, also known as DSP load: for the last period,
+	// averaged over recent periods and the maximum.
+	double lastLoad;
+	double averageLoad;
+	double peakLoad;
+	// Number of buffer underruns reported by the audio driver or detected as discontinuities of the play position.
+	quint32 xrunCount;
+	// The stage that took the most time in the period rendered last before the most recent xrun, along with the load
+	// of that period. RenderStage_COUNT if there were no xruns.
+	RenderStage lastXrunStage;
+	double lastXrunLoad;
+	// Total time spent in each rendering stage. Waiting for the synth lock and recording audio are not attributed to any stage.
+	MasterClockNanos totalStageNanos[RenderStage_COUNT];
+};
+
+/**
+ * Measures the time the rendering thread takes to produce each period of audio output and attributes it to the stages
+ * of rendering. The measurements are published for monitoring in the same lock-free manner as the timing in AudioStream.
+ */
+class RenderLoadMeter {
+public:
+	static const char *getStageName(RenderStage stage);
+	// Return human-readable descriptions of the DSP load and xruns, and of the shares of the rendering stages respectively.
+	static QString getStatsSummary(const RenderLoadStats &stats);
+	static QString getStageBreakdown(const RenderLoadStats &stats);
+
+	RenderLoadMeter();
+
+	// Must not be called while rendering is in progress.
+	void reset(uint sampleRate);
+
+	// Only called from the rendering thread. When the synth statistics are unavailable, the whole time spent
+	// in the sample rate converter is accounted for the partials.
+	void periodRendered(uint frameCount, MasterClockNanos periodStartNanos, MasterClockNanos synthRenderStartNanos, const RenderPassMeasurements &measurements);
+	void xrunDetected();
+
+	// May be called from any thread.
+	void getStats(RenderLoadStats &stats) const;
+
+private:
+	// Synth rendering durations, in seconds, that were sampled after the previous period.
+	struct SynthDurations {
+		double midiProcessing;
+		double partials;
+		double reverb;
+		double analog;
+		double total;
+	};
+
+	uint sampleRate;
+
+	// Only accessed in the rendering thread.
+	RenderLoadStats currentStats;
+	SynthDurations lastSynthDurations;
+	MasterClockNanos lastPeriodStageNanos[RenderStage_COUNT];
+
+	RenderLoadStats publishedStats[2];
+	QAtomicInt publishedStatsChangeCount;
+
+	void publishStats();
+};
+
+#endif
@@ -0,0 +1,139 @@
+/* Copyright (C) 2011-2026 Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "SMFCheckpoints.h"
+
+static const MasterClockNanos CHECKPOINT_INTERVAL = 5 * MasterClock::NANOS_PER_SECOND;
+
+// Controllers that affect the state of a part but aren't reflected in the synth memory, hence not captured in a SysEx bank.
+static const int TRACKED_CONTROLLER_COUNT = 4;
+
+static int getTrackedControllerIx(quint32 msg) {
+	switch (msg & 0xF0) {
+	case 0xE0:
+		// Pitch bend
+		return 0;
+	case 0xB0:
+		switch ((msg >> 8) & 0x7F) {
+		case 1:
+			// Modulation
+			return 1;
+		case 11:
+			// Expression
+			return 2;
+		case 64:
+			// Hold pedal
+			return 3;
+		}
+		break;
+	}
+	return -1;
+}
+
+SMFCheckpoints::SMFCheckpoints() : stopRequested(false)
+{}
+
+void SMFCheckpoints::clear() {
+	QMutexLocker locker(&mutex);
+	checkpoints.clear();
+	stopRequested = false;
+}
+
+void SMFCheckpoints::stop() {
+	stopRequested = true;
+}
+
+bool SMFCheckpoints::compute(MT32Emu::Synth &drySynth, const MidiStreamSource &midiStreamSource) {
+	const QMidiEventList &midiEvents = midiStreamSource.getMIDIEvents();
+	QByteArray lastSysexBank;
+	quint32 controllerMessages[16][TRACKED_CONTROLLER_COUNT] = {};
+	uint tempo = 0;
+	MasterClockNanos tick = midiStreamSource.getMidiTick();
+	MasterClockNanos eventNanos = 0;
+	MasterClockNanos nextCheckpointNanos = 0;
+	for (int eventIx = 0; eventIx < midiEvents.count(); eventIx++) {
+		if (stopRequested) return false;
+		const QMidiEvent &e = midiEvents.at(eventIx);
+		eventNanos += e.getTimestamp() * tick;
+		if (nextCheckpointNanos <= eventNanos) {
+			SMFCheckpoint checkpoint;
+			checkpoint.eventIx = eventIx;
+			checkpoint.eventNanos = eventNanos;
+			checkpoint.tempo = tempo;
+			checkpoint.sysexBank = QByteArray(int(drySynth.dumpSysexBank(NULL, 0)), 0);
+			drySynth.dumpSysexBank(reinterpret_cast<MT32Emu::Bit8u *>(checkpoint.sysexBank.data()), MT32Emu::Bit32u(checkpoint.sysexBank.size()));
+			// Share the data with the previous checkpoint when the memory hasn't changed, as is typically the case.
+			if (checkpoint.sysexBank == lastSysexBank) checkpoint.sysexBank = lastSysexBank;
+			lastSysexBank = checkpoint.sysexBank;
+			for (int channel = 0; channel < 16; channel++) {
+				for (int controllerIx = 0; controllerIx < TRACKED_CONTROLLER_COUNT; controllerIx++) {
+					quint32 msg = controllerMessages[channel][controllerIx];
+					if (msg != 0) checkpoint.controllerMessages.append(msg);
+				}
+			}
+			append(checkpoint);
+			nextCheckpointNanos = eventNanos + CHECKPOINT_INTERVAL;
+		}
+		switch (e.getType()) {
+			case SHORT_MESSAGE: {
+				quint32 msg = e.getShortMessage();
+				if ((msg & 0xE0) == 0x80) break;
+				drySynth.playMsgNow(msg);
+				int controllerIx = getTrackedControllerIx(msg);
+				if (controllerIx > -1) {
+					controllerMessages[msg & 0x0F][controllerIx] = msg;
+				} else if ((msg & 0x7FF0) == 0x79B0) {
+					// Reset all controllers
+					memset(controllerMessages[msg & 0x0F], 0, sizeof controllerMessages[0]);
+				}
+				break;
+			}
+			case SYSEX:
+				drySynth.playSysexNow(e.getSysexData(), e.getSysexLen());
+				break;
+			case SET_TEMPO:
+				tempo = e.getShortMessage();
+				tick = midiStreamSource.getMidiTick(tempo);
+				break;
+			default:
+				break;
+		}
+	}
+	return true;
+}
+
+void SMFCheckpoints::append(const SMFCheckpoint &checkpoint) {
+	QMutexLocker locker(&mutex);
+	checkpoints.append(checkpoint);
+}
+
+bool SMFCheckpoints::findCheckpoint(const MasterClockNanos seekNanos, SMFCheckpoint &checkpoint) const {
+	QMutexLocker locker(&mutex);
+	for (int i = checkpoints.size() - 1; i >= 0; i--) {
+		if (checkpoints.at(i).eventNanos <= seekNanos) {
+			checkpoint = checkpoints.at(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+int SMFCheckpoints::getCount() const {
+	QMutexLocker locker(&mutex);
+	return checkpoints.size();
+}
@@ -0,0 +1,50 @@
+#ifndef SMF_CHECKPOINTS_H
+#define SMF_CHECKPOINTS_H
+
+#include <QtCore>
+#include <mt32emu/mt32emu.h>
+
+#include "MasterClock.h"
+#include "QMidiEvent.h"
+
+// Captures the state of the synth memory and the MIDI controllers that are not stored in there at a certain event,
+// so that seeking can start from the nearest checkpoint rather than replay the stream from the beginning.
+struct SMFCheckpoint {
+	int eventIx;
+	// Time of the event since the start of playback, at the tempo defined in the MIDI file.
+	MasterClockNanos eventNanos;
+	// Zero means the default tempo.
+	uint tempo;
+	QByteArray sysexBank;
+	QVector<quint32> controllerMessages;
+};
+
+/**
+ * Computes checkpoints for a MIDI stream by a dry pass through the MIDI events using a private synth that is never rendered.
+ * The checkpoints computed so far can be looked up from another thread while the computation is in progress, so that it can
+ * run in background while the stream is being played.
+ */
+class SMFCheckpoints {
+public:
+	SMFCheckpoints();
+
+	// Discards the checkpoints and prepares for a new computation.
+	void clear();
+	// Makes an ongoing computation finish early, the checkpoints computed so far remain usable.
+	void stop();
+	// The synth must be open and in the same state as the one the stream is played to. The notes are skipped, like when seeking,
+	// so the pass is very fast. Returns false if stopped before reaching the end of the stream.
+	bool compute(MT32Emu::Synth &drySynth, const MidiStreamSource &midiStreamSource);
+	// Retrieves the latest checkpoint at or before the time specified since the start of playback.
+	bool findCheckpoint(const MasterClockNanos seekNanos, SMFCheckpoint &checkpoint) const;
+	int getCount() const;
+
+private:
+	mutable QMutex mutex;
+	QVector<SMFCheckpoint> checkpoints;
+	volatile bool stopRequested;
+
+	void append(const SMFCheckpoint &checkpoint);
+};
+
+#endif
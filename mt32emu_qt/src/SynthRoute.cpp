@@ -24,6 +24,7 @@
  * - Merging MIDI streams coming from several MIDI sessions
  */
 
+#include <algorithm>
 #include <limits>
 
 #include "SynthRoute.h"
@@ -34,10 +35,29 @@
 
 using namespace MT32Emu;
 
+namespace {
+
+// Entry of the min-heap used to merge MIDI streams. Among streams with equal next event timestamps,
+// the one of the earlier added MIDI session goes first.
+struct MidiStreamHeapEntry {
+	quint64 nextEventTimestamp;
+	int sessionIx;
+	QMidiBuffer *midiBuffer;
+
+	// std heap functions build a max-heap, so the order is reversed.
+	bool operator<(const MidiStreamHeapEntry &other) const {
+		if (nextEventTimestamp != other.nextEventTimestamp) return nextEventTimestamp > other.nextEventTimestamp;
+		return sessionIx > other.sessionIx;
+	}
+};
+
+} // namespace
+
 SynthRoute::SynthRoute(QObject *parent) :
 	QObject(parent),
 	state(SynthRouteState_CLOSED),
 	qSynth(this),
+	referencedSysexCount(),
 	exclusiveMidiMode(),
 	multiMidiMode(),
 	audioDevice(NULL),
@@ -49,6 +69,7 @@ SynthRoute::SynthRoute(QObject *parent) :
 
 SynthRoute::~SynthRoute() {
 	deleteAudioStream();
+	qDeleteAll(retiredMidiBuffers);
 }
 
 void SynthRoute::setAudioDevice(const AudioDevice *newAudioDevice) {
@@ -83,6 +104,7 @@ bool SynthRoute::open(AudioStreamFactory audioStreamFactory) {
 			debugDeltaLowerLimit = qint64(floor(debugDeltaMean - debugDeltaLimit));
 			debugDeltaUpperLimit = qint64(ceil(debugDeltaMean + debugDeltaLimit));
 			qDebug() << "Using sample rate:" << sampleRate;
+			renderLoadMeter.reset(sampleRate);
 
 			AudioStream *newAudioStream = exclusiveMidiMode && audioStreamFactory != NULL
 				? audioStreamFactory(audioDevice, *this, sampleRate, midiSessions.first())
@@ -160,6 +182,7 @@ void SynthRoute::addMidiSession(MidiSession *midiSession) {
 	if (exclusiveMidiMode) return;
 	if (hasMIDISessions() && !multiMidiMode) enableMultiMidiMode();
 	QMutexLocker midiSessionsLocker(&midiSessionsMutex);
+	deleteRetiredMidiBuffers();
 	midiSessions.append(midiSession);
 	if (midiRecorder.isRecording()) midiSession->setMidiTrackRecorder(midiRecorder.addTrack());
 	emit midiSessionAdded(midiSession);
@@ -168,6 +191,16 @@ void SynthRoute::addMidiSession(MidiSession *midiSession) {
 void SynthRoute::removeMidiSession(MidiSession *midiSession) {
 	QMutexLocker midiSessionsLocker(&midiSessionsMutex);
 	midiSessions.removeOne(midiSession);
+	deleteRetiredMidiBuffers();
+	if (multiMidiMode) {
+		// The synth may still reference SysEx data in the MIDI buffer of the session, which is about to go away.
+		// Rather than disrupting playback of the other sessions, let the buffer live until the synth is done with it.
+		quint32 processedSysexCount;
+		QMidiBuffer *midiBuffer = midiSession->getQMidiBuffer();
+		if (!getProcessedReferencedSysexCount(processedSysexCount) || midiBuffer->hasReferencedSysex(processedSysexCount)) {
+			retiredMidiBuffers.append(midiSession->takeQMidiBuffer());
+		}
+	}
 	emit midiSessionRemoved(midiSession);
 	if (!hasMIDISessions() && multiMidiMode) {
 		multiMidiMode = false;
@@ -184,6 +217,10 @@ bool SynthRoute::hasMIDISessions() const {
 	return !midiSessions.isEmpty();
 }
 
+const QList<MidiSession *> SynthRoute::getMidiSessions() const {
+	return midiSessions;
+}
+
 void SynthRoute::handleQSynthState(SynthState synthState) {
 	// Should really only stopAudio on CLOSED, and startAudio() on OPEN after init or CLOSED.
 	// For CLOSING, it should suspend, and for OPEN after CLOSING, it should resume
@@ -294,6 +331,8 @@ void SynthRoute::discardMidiBuffers() {
 		}
 	}
 	qSynth.flushMIDIQueue();
+	QMutexLocker midiSessionsLocker(&midiSessionsMutex);
+	deleteRetiredMidiBuffers();
 }
 
 void SynthRoute::flushMIDIQueue() {
@@ -314,45 +353,65 @@ void SynthRoute::mergeMidiStreams(uint renderingPassFrameLength) {
 	}
 
 	QMutexLocker midiSessionsLocker(&midiSessionsMutex);
-	QVarLengthArray<QMidiBuffer *, 16> streamBuffers;
+	// SysEx data is passed to the synth by reference, so the events merged previously are only released from each buffer
+	// once the synth has processed the SysEx messages taken from it.
+	quint32 processedSysexCount;
+	const bool releaseMergedEvents = getProcessedReferencedSysexCount(processedSysexCount);
+	// The streams that have events due in this rendering pass are kept in a min-heap ordered by the next event timestamp,
+	// so that picking the next event costs O(log(sessions)) rather than O(sessions).
+	QVarLengthArray<MidiStreamHeapEntry, 16> streamHeap;
 	for (int i = 0; i < midiSessions.size(); i++) {
 		QMidiBuffer *midiBuffer = midiSessions[i]->getQMidiBuffer();
-		if (midiBuffer->retrieveEvents() && midiBuffer->getEventTimestamp() < renderingPassEndTimestamp) {
-			streamBuffers.append(midiBuffer);
+		if (releaseMergedEvents) midiBuffer->releaseProcessedEvents(processedSysexCount);
+		if (midiBuffer->retrieveEvents()) {
+			MidiStreamHeapEntry entry = { midiBuffer->getEventTimestamp(), i, midiBuffer };
+			if (entry.nextEventTimestamp < renderingPassEndTimestamp) streamHeap.append(entry);
 		}
 	}
-
-	while (!streamBuffers.isEmpty()) {
-		int nextEventBufferIx = 0;
-		quint64 nextEventTimestamp = streamBuffers[nextEventBufferIx]->getEventTimestamp();
-		for (int i = 1; i < streamBuffers.size(); i++) {
-			quint64 eventTimestamp = streamBuffers[i]->getEventTimestamp();
-			if (eventTimestamp < nextEventTimestamp) {
-				nextEventBufferIx = i;
-				nextEventTimestamp = eventTimestamp;
-			}
-		}
-		QMidiBuffer * const midiBuffer = streamBuffers[nextEventBufferIx];
+	MidiStreamHeapEntry * const heapBegin = streamHeap.data();
+	MidiStreamHeapEntry *heapEnd = heapBegin + streamHeap.size();
+	std::make_heap(heapBegin, heapEnd);
+
+	while (heapBegin < heapEnd) {
+		std::pop_heap(heapBegin, heapEnd);
+		MidiStreamHeapEntry &entry = heapEnd[-1];
+		QMidiBuffer * const midiBuffer = entry.midiBuffer;
+		const quint64 eventTimestamp = entry.nextEventTimestamp;
+		// Play all the events of this stream that share the timestamp at once, as before.
+		bool hasMoreEvents;
 		do {
 			const uchar *sysexData;
 			quint32 eventData = midiBuffer->getEventData(sysexData);
 			if (sysexData == NULL) {
-				qSynth.playMIDIShortMessage(eventData, nextEventTimestamp);
-			} else {
-				qSynth.playMIDISysex(sysexData, eventData, nextEventTimestamp);
-			}
-			if (!(midiBuffer->nextEvent() && midiBuffer->getEventTimestamp() < renderingPassEndTimestamp)) {
-#if QT_VERSION < QT_VERSION_CHECK(4, 7, 0)
-				if (nextEventBufferIx < streamBuffers.count() - 1) {
-					streamBuffers[nextEventBufferIx] = streamBuffers[streamBuffers.count() - 1];
-				}
-				streamBuffers.removeLast();
-#else
-				streamBuffers.remove(nextEventBufferIx);
-#endif
-				break;
+				qSynth.playMIDIShortMessage(eventData, eventTimestamp);
+			} else if (qSynth.playMIDIReferencedSysex(sysexData, eventData, eventTimestamp)) {
+				midiBuffer->sysexReferenced(referencedSysexCount++);
 			}
-		} while (midiBuffer->getEventTimestamp() <= nextEventTimestamp);
+			hasMoreEvents = midiBuffer->nextEvent();
+			if (hasMoreEvents) entry.nextEventTimestamp = midiBuffer->getEventTimestamp();
+		} while (hasMoreEvents && entry.nextEventTimestamp <= eventTimestamp);
+		if (hasMoreEvents && entry.nextEventTimestamp < renderingPassEndTimestamp) {
+			std::push_heap(heapBegin, heapEnd);
+		} else {
+			heapEnd--;
+		}
+	}
+}
+
+bool SynthRoute::getProcessedReferencedSysexCount(quint32 &processedSysexCount) const {
+	quint32 pendingSysexCount;
+	if (!qSynth.getPendingReferencedSysexCount(pendingSysexCount)) return false;
+	processedSysexCount = referencedSysexCount - pendingSysexCount;
+	return true;
+}
+
+// Only invoked in the application thread with midiSessionsMutex locked.
+void SynthRoute::deleteRetiredMidiBuffers() {
+	if (retiredMidiBuffers.isEmpty()) return;
+	quint32 processedSysexCount;
+	if (!getProcessedReferencedSysexCount(processedSysexCount)) return;
+	for (int i = retiredMidiBuffers.size() - 1; i >= 0; i--) {
+		if (!retiredMidiBuffers[i]->hasReferencedSysex(processedSysexCount)) delete retiredMidiBuffers.takeAt(i);
 	}
 }
 
@@ -363,19 +422,51 @@ void SynthRoute::deleteAudioStream() {
 }
 
 void SynthRoute::render(MT32Emu::Bit16s *buffer, uint length) {
+	MasterClockNanos periodStartNanos = MasterClock::getClockNanos();
 	if (multiMidiMode) mergeMidiStreams(length);
-	qSynth.render(buffer, length);
+	MasterClockNanos synthRenderStartNanos = MasterClock::getClockNanos();
+	RenderPassMeasurements measurements;
+	qSynth.render(buffer, length, &measurements);
+	renderLoadMeter.periodRendered(length, periodStartNanos, synthRenderStartNanos, measurements);
 }
 
 void SynthRoute::render(float *buffer, uint length) {
+	MasterClockNanos periodStartNanos = MasterClock::getClockNanos();
+	if (multiMidiMode) mergeMidiStreams(length);
+	MasterClockNanos synthRenderStartNanos = MasterClock::getClockNanos();
+	RenderPassMeasurements measurements;
+	qSynth.render(buffer, length, &measurements);
+	renderLoadMeter.periodRendered(length, periodStartNanos, synthRenderStartNanos, measurements);
+}
+
+void SynthRoute::render(float *leftBuffer, float *rightBuffer, uint length) {
+	MasterClockNanos periodStartNanos = MasterClock::getClockNanos();
 	if (multiMidiMode) mergeMidiStreams(length);
-	qSynth.render(buffer, length);
+	MasterClockNanos synthRenderStartNanos = MasterClock::getClockNanos();
+	RenderPassMeasurements measurements;
+	qSynth.render(leftBuffer, rightBuffer, length, &measurements);
+	renderLoadMeter.periodRendered(length, periodStartNanos, synthRenderStartNanos, measurements);
 }
 
 void SynthRoute::audioStreamFailed() {
 	qSynth.close();
 }
 
+void SynthRoute::audioStreamXrunDetected() {
+	renderLoadMeter.xrunDetected();
+}
+
+void SynthRoute::getRenderLoadStats(RenderLoadStats &stats) const {
+	renderLoadMeter.getStats(stats);
+}
+
+bool SynthRoute::getAudioTimingStats(AudioTimingStats &timingStats) {
+	QReadLocker audioStreamLocker(&audioStreamLock);
+	if (audioStream == NULL) return false;
+	audioStream->getTimingStats(timingStats);
+	return true;
+}
+
 // QSynth delegation
 
 void SynthRoute::enableRealtimeMode() {
@@ -390,6 +481,14 @@ void SynthRoute::playMIDISysexNow(const Bit8u *sysex, Bit32u sysexLen) {
 	qSynth.playMIDISysexNow(sysex, sysexLen);
 }
 
+const QByteArray SynthRoute::dumpSysexBank() const {
+	return qSynth.dumpSysexBank();
+}
+
+void SynthRoute::applySysexBank(const QByteArray &sysexBank) {
+	qSynth.applySysexBank(sysexBank);
+}
+
 void SynthRoute::reset() {
 	qSynth.reset();
 }
@@ -486,10 +585,18 @@ void SynthRoute::getROMImages(const MT32Emu::ROMImage *&controlROMImage, const M
 	qSynth.getROMImages(controlROMImage, pcmROMImage);
 }
 
+bool SynthRoute::openSynthWithROMImages(MT32Emu::Synth &synth) const {
+	return qSynth.openSynthWithROMImages(synth);
+}
+
 uint SynthRoute::getPartialCount() const {
 	return qSynth.getPartialCount();
 }
 
+RendererType SynthRoute::getRendererType() const {
+	return qSynth.getRendererType();
+}
+
 const QString SynthRoute::getPatchName(int partNum) const {
 	return qSynth.getPatchName(partNum);
 }
@@ -502,12 +609,8 @@ void SynthRoute::getSoundGroups(QVector<SoundGroup> &groups) const {
 	qSynth.getSoundGroups(groups);
 }
 
-void SynthRoute::getPartialStates(PartialState *partialStates) const {
-	qSynth.getPartialStates(partialStates);
-}
-
-uint SynthRoute::getPlayingNotes(unsigned int partNumber, MT32Emu::Bit8u *keys, MT32Emu::Bit8u *velocities) const {
-	return qSynth.getPlayingNotes(partNumber, keys, velocities);
+bool SynthRoute::getStateSnapshot(StateSnapshot &snapshot, PartialState *partialStates, Bit8u *keys, Bit8u *velocities) const {
+	return qSynth.getStateSnapshot(snapshot, partialStates, keys, velocities);
 }
 
 bool SynthRoute::getDisplayState(char *targetBuffer) const {
@@ -7,10 +7,13 @@
 #include "QSynth.h"
 #include "MasterClock.h"
 #include "MidiRecorder.h"
+#include "RenderLoadMeter.h"
 
 class MidiSession;
+class QMidiBuffer;
 class AudioStream;
 class AudioDevice;
+struct AudioTimingStats;
 
 enum SynthRouteState {
 	SynthRouteState_CLOSED,
@@ -28,7 +31,12 @@ private:
 	QSynth qSynth;
 	QList<MidiSession *> midiSessions;
 	QMutex midiSessionsMutex;
+	// Number of SysEx messages played by reference from the MIDI session buffers, which also serves to number them.
+	quint32 referencedSysexCount;
+	// MIDI buffers of removed MIDI sessions, which contain SysEx data still referenced by the synth.
+	QList<QMidiBuffer *> retiredMidiBuffers;
 	MidiRecorder midiRecorder;
+	RenderLoadMeter renderLoadMeter;
 	bool exclusiveMidiMode;
 	volatile bool multiMidiMode;
 
@@ -44,6 +52,8 @@ private:
 	void setState(SynthRouteState newState);
 	void disableExclusiveMidiMode();
 	void mergeMidiStreams(uint renderingPassFrameLength);
+	bool getProcessedReferencedSysexCount(quint32 &processedSysexCount) const;
+	void deleteRetiredMidiBuffers();
 	void deleteAudioStream();
 
 public:
@@ -59,15 +69,17 @@ public:
 	const QString getPatchName(int partNum) const;
 	void setTimbreOnPart(uint partNumber, uint timbreGroup, uint timbreNumber);
 	void getSoundGroups(QVector<SoundGroup> &) const;
-	void getPartialStates(MT32Emu::PartialState *partialStates) const;
-	uint getPlayingNotes(unsigned int partNumber, MT32Emu::Bit8u *keys, MT32Emu::Bit8u *velocities) const;
+	bool getStateSnapshot(MT32Emu::StateSnapshot &snapshot, MT32Emu::PartialState *partialStates, MT32Emu::Bit8u *keys, MT32Emu::Bit8u *velocities) const;
 	uint getPartialCount() const;
+	MT32Emu::RendererType getRendererType() const;
 	bool getDisplayState(char *targetBuffer) const;
 	void setMainDisplayMode();
 
 	void flushMIDIQueue();
 	void playMIDIShortMessageNow(MT32Emu::Bit32u msg);
 	void playMIDISysexNow(const MT32Emu::Bit8u *sysex, MT32Emu::Bit32u sysexLen);
+	const QByteArray dumpSysexBank() const;
+	void applySysexBank(const QByteArray &sysexBank);
 	bool playMIDIShortMessage(MidiSession &midiSession, MT32Emu::Bit32u msg, quint64 timestamp);
 	bool playMIDISysex(MidiSession &midiSession, const MT32Emu::Bit8u *sysex, MT32Emu::Bit32u sysexLen, quint64 timestamp);
 	bool pushMIDIShortMessage(MidiSession &midiSession, MT32Emu::Bit32u msg, MasterClockNanos midiNanos);
@@ -75,7 +87,13 @@ public:
 	void discardMidiBuffers();
 	void render(MT32Emu::Bit16s *buffer, uint length);
 	void render(float *buffer, uint length);
+	void render(float *leftBuffer, float *rightBuffer, uint length);
 	void audioStreamFailed();
+	// Only called from the rendering thread when an xrun is reported by the audio driver or detected by the timing estimation.
+	void audioStreamXrunDetected();
+	void getRenderLoadStats(RenderLoadStats &stats) const;
+	// Returns false if there is no active audio stream.
+	bool getAudioTimingStats(AudioTimingStats &timingStats);
 
 	void enableRealtimeMode();
 	void setMasterVolume(int masterVolume, bool overridden);
@@ -112,11 +130,15 @@ public:
 	void removeMidiSession(MidiSession *midiSession);
 	void setMidiSessionName(MidiSession *midiSession, QString name);
 	bool hasMIDISessions() const;
+	// May only be called from the application thread.
+	const QList<MidiSession *> getMidiSessions() const;
 	SynthRouteState getState() const;
 	void setAudioDevice(const AudioDevice *newAudioDevice);
 	void getSynthProfile(SynthProfile &synthProfile) const;
 	void setSynthProfile(const SynthProfile &synthProfile, QString useSynthProfileName);
 	void getROMImages(const MT32Emu::ROMImage *&controlROMImage, const MT32Emu::ROMImage *&pcmROMImage) const;
+	// Opens a private synth with the same ROM images. May be called from any thread.
+	bool openSynthWithROMImages(MT32Emu::Synth &synth) const;
 	bool connectSynth(const char *signal, const QObject *receiver, const char *slot) const;
 	bool disconnectSynth(const char *signal, const QObject *receiver, const char *slot) const;
 	bool connectReportHandler(const char *signal, const QObject *receiver, const char *slot) const;
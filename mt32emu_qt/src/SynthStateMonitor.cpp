@@ -23,6 +23,7 @@
 #include "SynthStateMonitor.h"
 
 #include "SynthRoute.h"
+#include "audiodrv/AudioDriver.h"
 #include "ui_SynthWidget.h"
 #include "font_6x8.h"
 
@@ -45,6 +46,7 @@ static const uint LCD_COLUMN_SIZE_WITH_SPACING = 6 * LCD_PIXEL_SIZE_WITH_SPACING
 static const QPoint LCD_CONTENT_INSETS(8, 10);
 
 static const MasterClockNanos INSUFFICIENT_PARTIALS_WARNING_SHOWN_NANOS = 250 * MasterClock::NANOS_PER_MILLISECOND;
+static const MasterClockNanos RENDER_LOAD_UPDATE_INTERVAL_NANOS = 500 * MasterClock::NANOS_PER_MILLISECOND;
 
 using namespace MT32Emu;
 
@@ -53,7 +55,8 @@ SynthStateMonitor::SynthStateMonitor(Ui::SynthWidget *ui, SynthRoute *useSynthRo
 	ui(ui),
 	lcdWidget(ui->synthFrame),
 	midiMessageLED(ui->midiMessageFrame),
-	partialUsageLED(ui->partialUsageFrame)
+	partialUsageLED(ui->partialUsageFrame),
+	renderLoadLabel(ui->synthFrame)
 {
 	partialCount = useSynthRoute->getPartialCount();
 	allocatePartialsData();
@@ -64,7 +67,11 @@ SynthStateMonitor::SynthStateMonitor(Ui::SynthWidget *ui, SynthRoute *useSynthRo
 	ui->midiMessageLayout->addWidget(&midiMessageLED, 0, Qt::AlignHCenter);
 	partialUsageLED.setMinimumSize(10, 2);
 	ui->partialUsageLayout->addWidget(&partialUsageLED, 0, Qt::AlignHCenter);
+	ui->synthFrameLayout->insertWidget(3, &renderLoadLabel);
+	lastRenderLoadUpdateNanos = 0;
 	lastState = PartialUsageLEDWidget::STATE_OFF;
+	pendingPartStateUpdates = 0;
+	clearPlayingNotes();
 	lastInsufficientPartialsWarningNanos = MasterClock::getClockNanos() - INSUFFICIENT_PARTIALS_WARNING_SHOWN_NANOS;
 
 	for (int i = 0; i < 9; i++) {
@@ -102,22 +109,27 @@ void SynthStateMonitor::enableMonitor(bool enabled) {
 	if (enabled) {
 		synthRoute->connectReportHandler(SIGNAL(lcdStateChanged()), &lcdWidget, SLOT(handleLCDUpdate()));
 		synthRoute->connectReportHandler(SIGNAL(midiMessageLEDStateChanged(bool)), this, SLOT(handleMidiMessageLEDUpdate(bool)));
+		synthRoute->connectSynth(SIGNAL(audioBlockRendered()), &lcdWidget, SLOT(handleAudioBlockRendered()));
 		synthRoute->connectSynth(SIGNAL(audioBlockRendered()), this, SLOT(handleAudioBlockRendered()));
 		midiMessageLED.setState(lcdWidget.updateDisplayText());
 		handleAudioBlockRendered();
 	} else {
 		synthRoute->disconnectReportHandler(SIGNAL(lcdStateChanged()), &lcdWidget, SLOT(handleLCDUpdate()));
 		synthRoute->disconnectReportHandler(SIGNAL(midiMessageLEDStateChanged(bool)), this, SLOT(handleMidiMessageLEDUpdate(bool)));
+		synthRoute->disconnectSynth(SIGNAL(audioBlockRendered()), &lcdWidget, SLOT(handleAudioBlockRendered()));
 		synthRoute->disconnectSynth(SIGNAL(audioBlockRendered()), this, SLOT(handleAudioBlockRendered()));
 	}
 }
 
 void SynthStateMonitor::handleSynthStateChange(SynthState state) {
+	clearPlayingNotes();
 	enableMonitor(state == SynthState_OPEN);
 	if (state != SynthState_OPEN) {
 		lcdWidget.update();
 		midiMessageLED.setState(false);
 		partialUsageLED.setState(PartialUsageLEDWidget::STATE_OFF);
+		renderLoadLabel.clear();
+		renderLoadLabel.setToolTip(QString());
 	}
 
 	uint newPartialCount = synthRoute->getPartialCount();
@@ -139,8 +151,9 @@ void SynthStateMonitor::handleSynthStateChange(SynthState state) {
 	}
 }
 
+// The synth state snapshot is only published at the end of the rendering pass, so we defer repainting till then.
 void SynthStateMonitor::handlePolyStateChanged(int partNum) {
-	partStateWidget[partNum]->update();
+	pendingPartStateUpdates |= 1 << partNum;
 }
 
 void SynthStateMonitor::handleProgramChanged(int partNum, QString, QString patchName) {
@@ -153,9 +166,22 @@ void SynthStateMonitor::handleMidiMessageLEDUpdate(bool midiMessageOn) {
 	midiMessageLED.setState(midiMessageOn);
 }
 
+// Reads the state snapshot once per rendering pass, the part state widgets only paint the slices retrieved here.
 void SynthStateMonitor::handleAudioBlockRendered() {
 	if (synthRoute->getState() != SynthRouteState_OPEN) return;
-	synthRoute->getPartialStates(partialStates);
+	// The arrays are reallocated upon the synth state change that follows opening with a different partial count.
+	if (synthRoute->getPartialCount() != partialCount) return;
+	StateSnapshot snapshot;
+	if (!synthRoute->getStateSnapshot(snapshot, partialStates, keysOfPlayingNotes, velocitiesOfPlayingNotes)) return;
+	uint noteOffset = 0;
+	for (int i = 0; i < 9; i++) {
+		playingNoteOffsets[i] = noteOffset;
+		playingNoteCounts[i] = snapshot.playingNoteCounts[i];
+		noteOffset += playingNoteCounts[i];
+	}
+	for (int i = 0; pendingPartStateUpdates != 0; i++, pendingPartStateUpdates >>= 1) {
+		if (pendingPartStateUpdates & 1) partStateWidget[i]->update();
+	}
 	bool playing = false;
 	for (unsigned int partialNum = 0; partialNum < partialCount; partialNum++) {
 		partialStateLED[partialNum]->setState(partialStates[partialNum]);
@@ -165,6 +191,18 @@ void SynthStateMonitor::handleAudioBlockRendered() {
 		lastState = playing ? PartialUsageLEDWidget::STATE_OK : PartialUsageLEDWidget::STATE_OFF;
 		partialUsageLED.setState(lastState);
 	}
+	if (lastRenderLoadUpdateNanos + RENDER_LOAD_UPDATE_INTERVAL_NANOS <= MasterClock::getClockNanos()) updateRenderLoad();
+}
+
+void SynthStateMonitor::updateRenderLoad() {
+	RenderLoadStats stats;
+	synthRoute->getRenderLoadStats(stats);
+	renderLoadLabel.setText(RenderLoadMeter::getStatsSummary(stats));
+	QString toolTip = RenderLoadMeter::getStageBreakdown(stats);
+	AudioTimingStats timingStats;
+	if (synthRoute->getAudioTimingStats(timingStats)) toolTip += "\n" + AudioStream::getTimingStatsSummary(timingStats);
+	renderLoadLabel.setToolTip(toolTip);
+	lastRenderLoadUpdateNanos = MasterClock::getClockNanos();
 }
 
 void SynthStateMonitor::handleNoteOnIgnored() {
@@ -197,6 +235,13 @@ void SynthStateMonitor::allocatePartialsData() {
 	}
 }
 
+void SynthStateMonitor::clearPlayingNotes() {
+	for (int i = 0; i < 9; i++) {
+		playingNoteOffsets[i] = 0;
+		playingNoteCounts[i] = 0;
+	}
+}
+
 void SynthStateMonitor::freePartialsData() {
 	if (partialStateLED != NULL) {
 		for (unsigned int i = 0; i < partialCount; i++) delete partialStateLED[i];
@@ -255,12 +300,14 @@ void PartStateWidget::paintEvent(QPaintEvent *) {
 	QPainter painter(this);
 	painter.fillRect(rect(), COLOR_GRAY);
 	if (monitor.synthRoute->getState() != SynthRouteState_OPEN) return;
-	uint playingNotes = monitor.synthRoute->getPlayingNotes(partNum, monitor.keysOfPlayingNotes, monitor.velocitiesOfPlayingNotes);
+	const Bit8u *keys = monitor.keysOfPlayingNotes + monitor.playingNoteOffsets[partNum];
+	const Bit8u *velocities = monitor.velocitiesOfPlayingNotes + monitor.playingNoteOffsets[partNum];
+	uint playingNotes = monitor.playingNoteCounts[partNum];
 	while (playingNotes-- > 0) {
-		uint velocity = monitor.velocitiesOfPlayingNotes[playingNotes];
+		uint velocity = velocities[playingNotes];
 		if (velocity == 0) continue;
 		QColor color(2 * velocity, 255 - 2 * velocity, 0);
-		uint x = 5 * (monitor.keysOfPlayingNotes[playingNotes] - 12);
+		uint x = 5 * (keys[playingNotes] - 12);
 		painter.fillRect(x, 0, 5, 16, color);
 	}
 }
@@ -269,7 +316,8 @@ LCDWidget::LCDWidget(QWidget *parent) :
 	QWidget(parent),
 	synthRoute(),
 	lcdOffBackground(":/images/LCDOff.gif"),
-	lcdOnBackground(":/images/LCDOn.gif")
+	lcdOnBackground(":/images/LCDOn.gif"),
+	lcdUpdatePending()
 {
 	QSizePolicy sizePolicy(QSizePolicy::Expanding, QSizePolicy::Ignored);
 	sizePolicy.setHeightForWidth(true);
@@ -355,7 +403,14 @@ void LCDWidget::mousePressEvent(QMouseEvent *event) {
 	event->accept();
 }
 
+// The synth state snapshot is only published at the end of the rendering pass, so we defer retrieving the LCD state till then.
 void LCDWidget::handleLCDUpdate() {
+	lcdUpdatePending = true;
+}
+
+void LCDWidget::handleAudioBlockRendered() {
+	if (!lcdUpdatePending) return;
+	lcdUpdatePending = false;
 	updateDisplayText();
 }
 
@@ -3,6 +3,7 @@
 
 #include <QtGui>
 #include <QAbstractButton>
+#include <QLabel>
 #include <QWidget>
 
 #include <mt32emu/mt32emu.h>
@@ -101,9 +102,11 @@ private:
 	const QPixmap lcdOffBackground;
 	const QPixmap lcdOnBackground;
 	char lcdText[21];
+	bool lcdUpdatePending;
 
 private slots:
 	void handleLCDUpdate();
+	void handleAudioBlockRendered();
 };
 
 class PartVolumeButton : public QAbstractButton {
@@ -170,6 +173,7 @@ private:
 	LCDWidget lcdWidget;
 	MidiMessageLEDWidget midiMessageLED;
 	PartialUsageLEDWidget partialUsageLED;
+	QLabel renderLoadLabel;
 	PartialStateLEDWidget **partialStateLED;
 	PartVolumeButton *partVolumeButton[9];
 	PatchNameButton *patchNameButton[9];
@@ -178,14 +182,23 @@ private:
 	MT32Emu::PartialState *partialStates;
 	MT32Emu::Bit8u *keysOfPlayingNotes;
 	MT32Emu::Bit8u *velocitiesOfPlayingNotes;
+	// Slices of keysOfPlayingNotes and velocitiesOfPlayingNotes that belong to each part, retrieved from the same
+	// state snapshot, so that all the parts are shown consistently.
+	uint playingNoteOffsets[9];
+	uint playingNoteCounts[9];
 
 	PartialUsageLEDWidget::State lastState;
 	MasterClockNanos lastInsufficientPartialsWarningNanos;
+	MasterClockNanos lastRenderLoadUpdateNanos;
 
 	uint partialCount;
+	// Bit set of parts which state widgets are to be repainted once the current rendering pass completes.
+	uint pendingPartStateUpdates;
 
 	void allocatePartialsData();
 	void freePartialsData();
+	void clearPlayingNotes();
+	void updateRenderLoad();
 
 private slots:
 	void handleSynthStateChange(SynthState);
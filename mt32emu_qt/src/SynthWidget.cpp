@@ -274,7 +274,7 @@ void SynthWidget::on_audioRecord_clicked() {
 	} else {
 		static QString currentDir = NULL;
 		QFileDialog::Options qFileDialogOptions = QFileDialog::Options(Master::getInstance()->getSettings()->value("Master/qFileDialogOptions", 0).toInt());
-		QString fileName = QFileDialog::getSaveFileName(this, NULL, currentDir, "*.wav *.raw;;*.wav;;*.raw;;*.*",
+		QString fileName = QFileDialog::getSaveFileName(this, NULL, currentDir, "*.wav *.flac *.raw;;*.wav;;*.flac;;*.raw;;*.*",
 			NULL, qFileDialogOptions);
 		if (!fileName.isEmpty()) {
 			currentDir = QDir(fileName).absolutePath();
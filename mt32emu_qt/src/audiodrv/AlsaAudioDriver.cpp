@@ -14,6 +14,7 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <cerrno>
 #include <pthread.h>
 
 #include "AlsaAudioDriver.h"
@@ -23,7 +24,6 @@
 
 using namespace MT32Emu;
 
-static const unsigned int FRAME_SIZE = 4; // Stereo, 16-bit
 static const unsigned int DEFAULT_CHUNK_MS = 16;
 static const unsigned int DEFAULT_AUDIO_LATENCY = 64;
 static const unsigned int DEFAULT_MIDI_LATENCY = 32;
@@ -32,7 +32,7 @@ AlsaAudioStream::AlsaAudioStream(const AudioDriverSettings &useSettings, SynthRo
   AudioStream(useSettings, useSynthRoute, useSampleRate), stream(NULL), processingThreadID(0), stopProcessing(false)
 {
 	bufferSize = settings.chunkLen * sampleRate / MasterClock::MILLIS_PER_SECOND;
-	buffer = new Bit16s[/* channels */ 2 * bufferSize];
+	buffer = new float[/* channels */ 2 * bufferSize];
 }
 
 AlsaAudioStream::~AlsaAudioStream() {
@@ -63,6 +63,7 @@ void *AlsaAudioStream::processingThread(void *userData) {
 		error = snd_pcm_writei(audioStream.stream, audioStream.buffer, audioStream.bufferSize);
 		if (error < 0) {
 			qDebug() << "snd_pcm_writei failed:" << snd_strerror(error) << "-> recovering...";
+			if (error == -EPIPE) audioStream.xrunDetected();
 			error = snd_pcm_recover(audioStream.stream, error, 0);
 			if (error != 0) {
 				qDebug() << "snd_pcm_recover failed:" << snd_strerror(error) << "-> closing...";
@@ -89,7 +90,6 @@ void *AlsaAudioStream::processingThread(void *userData) {
 bool AlsaAudioStream::start(const char *deviceID) {
 	int error;
 	if (buffer == NULL) return false;
-	memset(buffer, 0, FRAME_SIZE * bufferSize);
 	if (stream != NULL) close();
 
 	qDebug() << "Using ALSA audio device:" << deviceID;
@@ -102,9 +102,21 @@ bool AlsaAudioStream::start(const char *deviceID) {
 		return false;
 	}
 
-	// Set Sample format to use
-	error = snd_pcm_set_params(stream, SND_PCM_FORMAT_S16, SND_PCM_ACCESS_RW_INTERLEAVED, /* channels */ 2,
-	  sampleRate, /* allow resampling */ 1, settings.audioLatency * MasterClock::MICROS_PER_MILLISECOND);
+	// Set Sample format to use, prefer float samples when the synth renders them natively
+	sampleFormat = getNativeSampleFormat();
+	const uint latencyMicros = settings.audioLatency * MasterClock::MICROS_PER_MILLISECOND;
+	if (sampleFormat == AudioSampleFormat_FLOAT) {
+		error = snd_pcm_set_params(stream, SND_PCM_FORMAT_FLOAT, SND_PCM_ACCESS_RW_INTERLEAVED, /* channels */ 2,
+		  sampleRate, /* allow resampling */ 1, latencyMicros);
+		if (error < 0) {
+			qDebug() << "ALSA audio: Float samples unsupported:" << snd_strerror(error) << "-> falling back to 16-bit integer samples";
+			sampleFormat = AudioSampleFormat_S16;
+		}
+	}
+	if (sampleFormat == AudioSampleFormat_S16) {
+		error = snd_pcm_set_params(stream, SND_PCM_FORMAT_S16, SND_PCM_ACCESS_RW_INTERLEAVED, /* channels */ 2,
+		  sampleRate, /* allow resampling */ 1, latencyMicros);
+	}
 	if (error < 0) {
 		qDebug() << "snd_pcm_set_params failed:" << snd_strerror(error);
 		snd_pcm_close(stream);
@@ -112,6 +124,7 @@ bool AlsaAudioStream::start(const char *deviceID) {
 		return false;
 	}
 
+	memset(buffer, 0, getFrameSize() * bufferSize);
 	audioLatencyFrames = snd_pcm_avail(stream);
 
 	if (audioLatencyFrames <= bufferSize) {
@@ -15,7 +15,8 @@ class AlsaAudioDriver;
 
 class AlsaAudioStream : public AudioStream {
 private:
-	MT32Emu::Bit16s *buffer;
+	// Large enough to hold a chunk in either sample format.
+	float *buffer;
 	snd_pcm_t *stream;
 	uint bufferSize;
 	pthread_t processingThreadID;
@@ -14,38 +14,48 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <limits>
+
 #include "AudioDriver.h"
 #include <QSettings>
 #include "../Master.h"
 #include "../QAtomicHelper.h"
+#include "../SynthRoute.h"
 
-template<class T>
-static inline void takeSnapshot(T &snapshot, const T snapshots[], const QAtomicInt &changeCount) {
-	quint32 myChangeCount;
-	do {
-		myChangeCount = QAtomicHelper::loadAcquire(changeCount);
-		snapshot = snapshots[myChangeCount & 1];
-	} while (myChangeCount != QAtomicHelper::loadRelaxed(changeCount));
-}
+// Bandwidth of the delay-locked loop that tracks the play position, in Hz. Lower values reject jitter of audio callbacks better
+// while taking longer to lock onto the actual sample rate.
+static const double DLL_BANDWIDTH = 0.1;
+static const double JITTER_AVERAGING_FACTOR = 0.05;
+static const double PI = 3.14159265358979323846;
+static const double SQRT2 = 1.41421356237309504880;
 
-static inline quint32 getSnapshotReadIx(const QAtomicInt &changeCount) {
-	return QAtomicHelper::loadRelaxed(changeCount) & 1;
-}
+// In auto-latency mode, the minimum delay of incoming MIDI events is evaluated over this period of time
+// to figure out whether the adaptive MIDI latency can be reduced.
+static const MasterClockNanos LATENCY_ADAPTATION_PERIOD_NANOS = 2 * MasterClock::NANOS_PER_SECOND;
+// The minimum delay of MIDI events to keep when reducing the adaptive MIDI latency.
+static const quint32 LATENCY_SAFETY_MARGIN_MILLIS = 2;
+// Reducing the latency shifts the subsequent events earlier in time, so do it in small steps to keep that inaudible.
+static const quint32 MAX_LATENCY_REDUCTION_STEP_MILLIS = 1;
 
-static inline quint32 getSnapshotWriteIx(const QAtomicInt &changeCount) {
-	return (QAtomicHelper::loadRelaxed(changeCount) + 1) & 1;
+static inline void storeMin(QAtomicInt &atomicInt, int value) {
+	int currentValue;
+	do {
+		currentValue = int(QAtomicHelper::loadRelaxed(atomicInt));
+		if (currentValue <= value) return;
+	} while (!atomicInt.testAndSetRelaxed(currentValue, value));
 }
 
-static inline void publishSnapshot(QAtomicInt &changeCount) {
-	// Since QAtomicInt involves signed arithmetic, we do increment explicitly to avoid UB.
-	// This is safe being performed in the rendering thread only.
-	quint32 myChangeCount = QAtomicHelper::loadRelaxed(changeCount);
-	QAtomicHelper::storeRelease(changeCount, (myChangeCount + 1U) & 0x7fffffffU);
+static inline void storeMax(QAtomicInt &atomicInt, int value) {
+	int currentValue;
+	do {
+		currentValue = int(QAtomicHelper::loadRelaxed(atomicInt));
+		if (currentValue >= value) return;
+	} while (!atomicInt.testAndSetRelaxed(currentValue, value));
 }
 
 AudioStream::AudioStream(const AudioDriverSettings &useSettings, SynthRoute &useSynthRoute, const quint32 useSampleRate) :
-	synthRoute(useSynthRoute), sampleRate(useSampleRate), settings(useSettings), lastEstimatedPlayedFramesCount(0),
-	resetScheduled(true)
+	synthRoute(useSynthRoute), sampleRate(useSampleRate), settings(useSettings), sampleFormat(AudioSampleFormat_S16),
+	adaptiveLatencyFrames(0), minMIDIDelayFrames(std::numeric_limits<int>::max()), dllPlayedFrames(0), resetScheduled(true)
 {
 	audioLatencyFrames = settings.audioLatency * sampleRate / MasterClock::MILLIS_PER_SECOND;
 	midiLatencyFrames = settings.midiLatency * sampleRate / MasterClock::MILLIS_PER_SECOND;
@@ -54,25 +64,35 @@ AudioStream::AudioStream(const AudioDriverSettings &useSettings, SynthRoute &use
 	timeInfos[0].lastPlayedNanos = MasterClock::getClockNanos();
 	timeInfos[0].lastPlayedFramesCount = 0;
 	timeInfos[0].actualSampleRate = sampleRate;
+	timeInfos[0].lastPositionError = 0;
+	timeInfos[0].averageJitter = 0;
 	timeInfos[1] = timeInfos[0];
+	latencyAdaptationStartNanos = timeInfos[0].lastPlayedNanos;
 }
 
 // Intended to be called from MIDI receiving threads.
 quint64 AudioStream::estimateMIDITimestamp(const MasterClockNanos midiNanos) {
 	TimeInfo timeInfo;
-	takeSnapshot(timeInfo, timeInfos, timeInfoChangeCount);
+	QAtomicHelper::takeSnapshot(timeInfo, timeInfos, timeInfoChangeCount);
 	quint64 renderedFramesCount;
-	takeSnapshot(renderedFramesCount, renderedFramesCounts, renderedFramesChangeCount);
+	QAtomicHelper::takeSnapshot(renderedFramesCount, renderedFramesCounts, renderedFramesChangeCount);
 
+	const quint32 adaptiveLatency = QAtomicHelper::loadRelaxed(adaptiveLatencyFrames);
 	qint64 refFrameOffset = qint64(((midiNanos - timeInfo.lastPlayedNanos) * timeInfo.actualSampleRate) / MasterClock::NANOS_PER_SECOND);
-	qint64 timestamp = qint64(timeInfo.lastPlayedFramesCount) + refFrameOffset + qint64(midiLatencyFrames);
+	qint64 timestamp = qint64(timeInfo.lastPlayedFramesCount) + refFrameOffset + qint64(midiLatencyFrames + adaptiveLatency);
 	qint64 delay = timestamp - qint64(renderedFramesCount);
-	if (delay < 0) {
-		// Negative delay means our timing is broken. We want to absorb all the jitter while keeping the latency at the minimum.
-		if (isAutoLatencyMode()) {
-			midiLatencyFrames -= delay;
+	if (isAutoLatencyMode()) {
+		// We want to absorb all the jitter while keeping the latency at the minimum. The rendering thread reduces the latency
+		// when the minimum delay of incoming events shows excessive headroom.
+		storeMin(minMIDIDelayFrames, int(qBound(qint64(std::numeric_limits<int>::min()), delay, qint64(std::numeric_limits<int>::max()))));
+		if (delay < 0) {
+			// Events received concurrently may all appear late by about the same amount, so don't accumulate their delays.
+			storeMax(adaptiveLatencyFrames, int(adaptiveLatency - delay));
 		}
-		qDebug() << "L" << renderedFramesCount << timestamp << delay << midiLatencyFrames;
+	}
+	if (delay < 0) {
+		// Negative delay means our timing is broken.
+		qDebug() << "L" << renderedFramesCount << timestamp << delay << getMIDILatencyFrames();
 	}
 	return timestamp < 0 ? 0 : quint64(timestamp);
 }
@@ -83,24 +103,31 @@ quint64 AudioStream::computeMIDITimestamp(uint relativeFrameTime) const {
 }
 
 // Only called from the rendering thread.
-void AudioStream::renderAndUpdateState(MT32Emu::Bit16s *buffer, const quint32 frameCount, const MasterClockNanos measuredNanos, const quint32 framesInAudioBuffer) {
+void AudioStream::renderAndUpdateState(void *buffer, const quint32 frameCount, const MasterClockNanos measuredNanos, const quint32 framesInAudioBuffer) {
 	updateTimeInfo(measuredNanos, framesInAudioBuffer);
-	synthRoute.render(buffer, frameCount);
+	if (sampleFormat == AudioSampleFormat_FLOAT) {
+		synthRoute.render(static_cast<float *>(buffer), frameCount);
+	} else {
+		synthRoute.render(static_cast<MT32Emu::Bit16s *>(buffer), frameCount);
+	}
 	framesRendered(frameCount);
 }
 
 // Only called from the rendering thread.
 void AudioStream::updateTimeInfo(const MasterClockNanos measuredNanos, const quint32 framesInAudioBuffer) {
-	const TimeInfo &timeInfo = timeInfos[getSnapshotReadIx(timeInfoChangeCount)];
-	TimeInfo &nextTimeInfo = timeInfos[getSnapshotWriteIx(timeInfoChangeCount)];
-	quint64 renderedFramesCount = renderedFramesCounts[getSnapshotReadIx(renderedFramesChangeCount)];
+	const TimeInfo &timeInfo = timeInfos[QAtomicHelper::getSnapshotReadIx(timeInfoChangeCount)];
+	TimeInfo &nextTimeInfo = timeInfos[QAtomicHelper::getSnapshotWriteIx(timeInfoChangeCount)];
+	quint64 renderedFramesCount = renderedFramesCounts[QAtomicHelper::getSnapshotReadIx(renderedFramesChangeCount)];
+
+	adaptMIDILatency(measuredNanos);
+	const quint32 midiLatency = getMIDILatencyFrames();
 
 #if 0
 	qDebug() << "R" << renderedFramesCount - timeInfo.lastPlayedFramesCount
 	<< (measuredNanos - timeInfo.lastPlayedNanos) * 1e-6;
 #endif
 
-	if (((measuredNanos - timeInfo.lastPlayedNanos) * sampleRate) < (midiLatencyFrames * MasterClock::NANOS_PER_SECOND)) {
+	if (((measuredNanos - timeInfo.lastPlayedNanos) * sampleRate) < (midiLatency * MasterClock::NANOS_PER_SECOND)) {
 		// If callbacks are coming too quickly, we cannot benefit from that, it just makes our timing estimation worse.
 		// This is because some audio systems may pull more data than the our specified audio latency in no time.
 		// Moreover, we should be able to adjust lastPlayedFramesCount increasing speed as it counts in samples.
@@ -113,29 +140,39 @@ void AudioStream::updateTimeInfo(const MasterClockNanos measuredNanos, const qui
 	quint64 estimatedNewPlayedFramesCount = settings.advancedTiming ? quint64(renderedFramesCount - framesInAudioBuffer) : renderedFramesCount;
 	double secondsElapsed = double(measuredNanos - timeInfo.lastPlayedNanos) / MasterClock::NANOS_PER_SECOND;
 
-	// Ensure lastPlayedFramesCount is monotonically increasing and has no jumps
-	quint64 newPlayedFramesCount = timeInfo.lastPlayedFramesCount + quint64(timeInfo.actualSampleRate * secondsElapsed + 0.5);
-
-	qint64 absError = qint64(estimatedNewPlayedFramesCount - newPlayedFramesCount);
+	// The play position we expect at this point given the current sample rate estimation.
+	const double predictedPlayedFrames = dllPlayedFrames + timeInfo.actualSampleRate * secondsElapsed;
+	const double positionError = double(estimatedNewPlayedFramesCount) - predictedPlayedFrames;
 
 	// If the estimation goes too far - do reset
-	if (resetScheduled || qAbs(absError) > qint64(midiLatencyFrames)) {
+	if (resetScheduled || qAbs(positionError) > midiLatency) {
 		if (resetScheduled) {
 			resetScheduled = false;
 		} else {
-			qDebug() << "AudioStream: Estimated play position is way off:" << absError << "-> resetting...";
+			qDebug() << "AudioStream: Estimated play position is way off:" << positionError << "-> resetting...";
+			synthRoute.audioStreamXrunDetected();
 		}
-		lastEstimatedPlayedFramesCount = estimatedNewPlayedFramesCount;
+		dllPlayedFrames = double(estimatedNewPlayedFramesCount);
 		nextTimeInfo.lastPlayedNanos = measuredNanos;
 		nextTimeInfo.lastPlayedFramesCount = estimatedNewPlayedFramesCount;
 		nextTimeInfo.actualSampleRate = sampleRate;
-		publishSnapshot(timeInfoChangeCount);
+		nextTimeInfo.lastPositionError = 0;
+		nextTimeInfo.averageJitter = 0;
+		QAtomicHelper::publishSnapshot(timeInfoChangeCount);
 		return;
 	}
 
-	const double estimatedNewActualSampleRate = (estimatedNewPlayedFramesCount - lastEstimatedPlayedFramesCount + absError) / secondsElapsed;
-	const double prevActualSampleRate = timeInfo.actualSampleRate;
-	const double filteredNewActualSampleRate = prevActualSampleRate + (estimatedNewActualSampleRate - prevActualSampleRate) * 0.1;
+	// The measured play position is fed to a second-order delay-locked loop, as described in the paper
+	// "Using a DLL to filter time" by F. Adriaensen. The loop follows the drift of the actual sample rate
+	// while rejecting the jitter of audio callbacks, so that neither accumulates in the play position.
+	// The coefficients are computed for the actual update interval since callbacks may come irregularly.
+	const double omega = qMin(2.0 * PI * DLL_BANDWIDTH * secondsElapsed, 0.5);
+	const double b = SQRT2 * omega;
+	const double c = omega * omega;
+
+	// Ensure lastPlayedFramesCount is monotonically increasing and has no jumps
+	dllPlayedFrames = qMax(dllPlayedFrames, predictedPlayedFrames + b * positionError);
+	const double filteredNewActualSampleRate = timeInfo.actualSampleRate + c * positionError / secondsElapsed;
 
 	// Now fixup sample rate estimation. It shouldn't go too far from expected.
 	// Assume the actual sample rate differs from nominal one within 1% range.
@@ -148,30 +185,88 @@ void AudioStream::updateTimeInfo(const MasterClockNanos measuredNanos, const qui
 	double newActualSampleRate = qBound(0.995 * sampleRate, filteredNewActualSampleRate, 1.005 * sampleRate) ;
 
 #if 0
-	qDebug() << "S" << newActualSampleRate << absError;
+	qDebug() << "S" << newActualSampleRate << positionError;
 #endif
 
-	lastEstimatedPlayedFramesCount = estimatedNewPlayedFramesCount;
 	nextTimeInfo.lastPlayedNanos = measuredNanos;
-	nextTimeInfo.lastPlayedFramesCount = newPlayedFramesCount;
+	nextTimeInfo.lastPlayedFramesCount = quint64(dllPlayedFrames);
 	nextTimeInfo.actualSampleRate = newActualSampleRate;
-	publishSnapshot(timeInfoChangeCount);
+	nextTimeInfo.lastPositionError = positionError;
+	nextTimeInfo.averageJitter = timeInfo.averageJitter + (qAbs(positionError) - timeInfo.averageJitter) * JITTER_AVERAGING_FACTOR;
+	QAtomicHelper::publishSnapshot(timeInfoChangeCount);
+}
+
+void AudioStream::xrunDetected() {
+	synthRoute.audioStreamXrunDetected();
+	// The play position has just jumped, so let the timing estimation start over rather than count the same xrun again.
+	resetScheduled = true;
+}
+
+// Only called from the rendering thread.
+void AudioStream::adaptMIDILatency(const MasterClockNanos measuredNanos) {
+	if (!isAutoLatencyMode() || (measuredNanos - latencyAdaptationStartNanos) < LATENCY_ADAPTATION_PERIOD_NANOS) return;
+	latencyAdaptationStartNanos = measuredNanos;
+	const int minDelay = minMIDIDelayFrames.fetchAndStoreRelaxed(std::numeric_limits<int>::max());
+	// Without incoming events, there is nothing to learn from.
+	if (minDelay == std::numeric_limits<int>::max()) return;
+	const quint32 adaptiveLatency = QAtomicHelper::loadRelaxed(adaptiveLatencyFrames);
+	const int safetyMargin = int(LATENCY_SAFETY_MARGIN_MILLIS * sampleRate / MasterClock::MILLIS_PER_SECOND);
+	if (adaptiveLatency == 0 || minDelay <= safetyMargin) return;
+	// Only the rendering thread reduces the adaptive latency, so it cannot go below zero.
+	const quint32 maxStep = MAX_LATENCY_REDUCTION_STEP_MILLIS * sampleRate / MasterClock::MILLIS_PER_SECOND;
+	const quint32 reduction = qMin(adaptiveLatency, qMin(quint32(minDelay - safetyMargin) / 2, maxStep));
+	if (reduction == 0) return;
+	adaptiveLatencyFrames.fetchAndAddRelaxed(-int(reduction));
+	qDebug() << "AudioStream: Reduced MIDI latency by" << reduction << "frames, minimum event delay:" << minDelay;
 }
 
 bool AudioStream::isAutoLatencyMode() const {
 	return settings.midiLatency == 0;
 }
 
+quint32 AudioStream::getMIDILatencyFrames() const {
+	return midiLatencyFrames + QAtomicHelper::loadRelaxed(adaptiveLatencyFrames);
+}
+
+QString AudioStream::getTimingStatsSummary(const AudioTimingStats &timingStats) {
+	double framesPerMilli = double(timingStats.sampleRate) / MasterClock::MILLIS_PER_SECOND;
+	return QString("Audio output: %1 Hz actual rate; play position jitter: %2 ms avg, %3 ms last; MIDI latency: %4 ms, %5 ms adaptive")
+		.arg(timingStats.actualSampleRate, 0, 'f', 1)
+		.arg(timingStats.averageJitter / framesPerMilli, 0, 'f', 2)
+		.arg(timingStats.lastPositionError / framesPerMilli, 0, 'f', 2)
+		.arg(timingStats.midiLatencyFrames / framesPerMilli, 0, 'f', 1)
+		.arg(timingStats.adaptiveLatencyFrames / framesPerMilli, 0, 'f', 1);
+}
+
+void AudioStream::getTimingStats(AudioTimingStats &timingStats) const {
+	TimeInfo timeInfo;
+	QAtomicHelper::takeSnapshot(timeInfo, timeInfos, timeInfoChangeCount);
+	timingStats.sampleRate = sampleRate;
+	timingStats.actualSampleRate = timeInfo.actualSampleRate;
+	timingStats.lastPositionError = timeInfo.lastPositionError;
+	timingStats.averageJitter = timeInfo.averageJitter;
+	timingStats.adaptiveLatencyFrames = QAtomicHelper::loadRelaxed(adaptiveLatencyFrames);
+	timingStats.midiLatencyFrames = midiLatencyFrames + timingStats.adaptiveLatencyFrames;
+}
+
 // Only called from the rendering thread.
 void AudioStream::framesRendered(quint32 frameCount) {
-	quint64 &renderedFramesCount = renderedFramesCounts[getSnapshotReadIx(renderedFramesChangeCount)];
-	renderedFramesCounts[getSnapshotWriteIx(renderedFramesChangeCount)] = renderedFramesCount + frameCount;
-	publishSnapshot(renderedFramesChangeCount);
+	quint64 &renderedFramesCount = renderedFramesCounts[QAtomicHelper::getSnapshotReadIx(renderedFramesChangeCount)];
+	renderedFramesCounts[QAtomicHelper::getSnapshotWriteIx(renderedFramesChangeCount)] = renderedFramesCount + frameCount;
+	QAtomicHelper::publishSnapshot(renderedFramesChangeCount);
 }
 
 // Only called from the rendering thread.
 quint64 AudioStream::getRenderedFramesCount() const {
-	return renderedFramesCounts[getSnapshotReadIx(renderedFramesChangeCount)];
+	return renderedFramesCounts[QAtomicHelper::getSnapshotReadIx(renderedFramesChangeCount)];
+}
+
+quint32 AudioStream::getFrameSize() const {
+	return sampleFormat == AudioSampleFormat_FLOAT ? quint32(2 * sizeof(float)) : quint32(2 * sizeof(MT32Emu::Bit16s));
+}
+
+AudioSampleFormat AudioStream::getNativeSampleFormat() const {
+	return synthRoute.getRendererType() == MT32Emu::RendererType_FLOAT ? AudioSampleFormat_FLOAT : AudioSampleFormat_S16;
 }
 
 AudioDevice::AudioDevice(AudioDriver &useDriver, QString useName) : driver(useDriver), name(useName) {}
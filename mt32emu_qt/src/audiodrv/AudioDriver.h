@@ -14,15 +14,47 @@ class AudioDriver;
 class SynthRoute;
 struct AudioDriverSettings;
 
+enum AudioSampleFormat {
+	AudioSampleFormat_S16,
+	AudioSampleFormat_FLOAT
+};
+
+// Current estimates of the timing engine of an AudioStream, for monitoring purposes.
+struct AudioTimingStats {
+	// Sample rate of the audio output as configured and as estimated from the play position.
+	quint32 sampleRate;
+	double actualSampleRate;
+	// Difference between the measured and the predicted play position at the last update, in frames.
+	double lastPositionError;
+	// Exponentially averaged magnitude of the play position error, in frames.
+	double averageJitter;
+	// Total MIDI latency in effect, in frames.
+	quint32 midiLatencyFrames;
+	// Part of midiLatencyFrames added in auto-latency mode to absorb the observed jitter.
+	quint32 adaptiveLatencyFrames;
+};
+
 class AudioStream {
 protected:
 	SynthRoute &synthRoute;
 	const quint32 sampleRate;
 	const AudioDriverSettings &settings;
+	// Format of samples in the buffers passed to renderAndUpdateState(), AudioSampleFormat_S16 by default.
+	AudioSampleFormat sampleFormat;
 	quint32 audioLatencyFrames;
+	// The base MIDI latency, configured by the driver on start.
 	quint32 midiLatencyFrames;
 
-	quint64 lastEstimatedPlayedFramesCount;
+	// In auto-latency mode, the extra MIDI latency that absorbs the observed jitter of MIDI event timestamps.
+	// It is increased by the MIDI receiving threads whenever an event appears late, and gradually decreased
+	// by the rendering thread when the minimum delay of incoming events shows there is excessive headroom.
+	QAtomicInt adaptiveLatencyFrames;
+	// The minimum delay of MIDI events received since the start of the current latency adaptation period.
+	QAtomicInt minMIDIDelayFrames;
+	MasterClockNanos latencyAdaptationStartNanos;
+
+	// State of the delay-locked loop that tracks the play position, only accessed in the rendering thread.
+	double dllPlayedFrames;
 	bool resetScheduled;
 
 	// Note, renderedFramesCount and timeInfo are read from several MIDI receiving threads,
@@ -37,20 +69,40 @@ protected:
 		MasterClockNanos lastPlayedNanos;
 		quint64 lastPlayedFramesCount;
 		double actualSampleRate;
+		// The following are only used for monitoring.
+		double lastPositionError;
+		double averageJitter;
 	} timeInfos[2];
 	QAtomicInt timeInfoChangeCount;
 
-	void renderAndUpdateState(MT32Emu::Bit16s *buffer, const quint32 frameCount, const MasterClockNanos measuredNanos, const quint32 framesInAudioBuffer);
+	// Renders frameCount stereo frames to the buffer in the current sample format.
+	void renderAndUpdateState(void *buffer, const quint32 frameCount, const MasterClockNanos measuredNanos, const quint32 framesInAudioBuffer);
 	void updateTimeInfo(const MasterClockNanos measuredNanos, const quint32 framesInAudioBuffer);
 	bool isAutoLatencyMode() const;
+	// Returns the total MIDI latency in effect, including the adaptive part.
+	quint32 getMIDILatencyFrames() const;
+	void adaptMIDILatency(const MasterClockNanos measuredNanos);
 	void framesRendered(quint32 frameCount);
+	// Only called from the rendering thread when the audio driver reports a buffer underrun.
+	void xrunDetected();
 	quint64 getRenderedFramesCount() const;
+	// Returns the size of a stereo frame in bytes in the current sample format.
+	quint32 getFrameSize() const;
+	// Returns the sample format that matches the renderer type of the synth, so that the samples need no conversion.
+	// Drivers capable of float output should try this format first, and revert to AudioSampleFormat_S16 if the device
+	// doesn't support it.
+	AudioSampleFormat getNativeSampleFormat() const;
 
 public:
+	// Returns a human-readable description of the timing estimates.
+	static QString getTimingStatsSummary(const AudioTimingStats &timingStats);
+
 	AudioStream(const AudioDriverSettings &settings, SynthRoute &synthRoute, const quint32 sampleRate);
 	virtual ~AudioStream() {}
 	virtual quint64 estimateMIDITimestamp(const MasterClockNanos refNanos);
 	quint64 computeMIDITimestamp(uint relativeFrameTime) const;
+	// Safe to call from any thread.
+	void getTimingStats(AudioTimingStats &timingStats) const;
 };
 
 class AudioDevice {
@@ -31,7 +31,7 @@ AudioFileWriterStream::AudioFileWriterStream(const AudioDriverSettings &useSetti
 bool AudioFileWriterStream::start() {
 	static QString currentDir = NULL;
 	QFileDialog::Options qFileDialogOptions = QFileDialog::Options(Master::getInstance()->getSettings()->value("Master/qFileDialogOptions", 0).toInt());
-	QString fileName = QFileDialog::getSaveFileName(NULL, NULL, currentDir, "*.wav *.raw;;*.wav;;*.raw;;*.*",
+	QString fileName = QFileDialog::getSaveFileName(NULL, NULL, currentDir, "*.wav *.flac *.raw;;*.wav;;*.flac;;*.raw;;*.*",
 		NULL, qFileDialogOptions);
 	if (fileName.isEmpty()) return false;
 	currentDir = QDir(fileName).absolutePath();
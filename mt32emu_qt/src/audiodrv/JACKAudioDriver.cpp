@@ -14,8 +14,6 @@
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <QMessageBox>
-
 #include "JACKAudioDriver.h"
 
 #include "../Master.h"
@@ -127,7 +125,6 @@ public:
 JACKAudioStream::JACKAudioStream(const AudioDriverSettings &useSettings, SynthRoute &useSynthRoute, const quint32 useSampleRate) :
 	AudioStream(useSettings, useSynthRoute, useSampleRate),
 	jackClient(new JACKClient),
-	buffer(),
 	processor(),
 	configuredAudioLatencyFrames(audioLatencyFrames)
 {}
@@ -135,7 +132,6 @@ JACKAudioStream::JACKAudioStream(const AudioDriverSettings &useSettings, SynthRo
 JACKAudioStream::~JACKAudioStream() {
 	stop();
 	delete jackClient;
-	delete[] buffer;
 	delete processor;
 }
 
@@ -143,7 +139,7 @@ bool JACKAudioStream::start(MidiSession *midiSession) {
 	JACKClientState state = jackClient->open(midiSession, this);
 	if (JACKClientState_OPENING != state) {
 		if (JACKClientState_UNAVAILABLE == state) {
-			QMessageBox::warning(NULL, "Error", "The JACK library not found");
+			Master::showWarning("Error", "The JACK library not found");
 		}
 		qDebug() << "JACKAudioDriver: Failed to open JACK client connection";
 		return false;
@@ -152,7 +148,17 @@ bool JACKAudioStream::start(MidiSession *midiSession) {
 	const quint32 jackBufferSizeFrames = jackClient->getBufferSize();
 	qDebug() << "JACKAudioDriver: JACK reported initial audio buffer size (frames / s):"
 		<< jackBufferSizeFrames << "/" << double(jackBufferSizeFrames) / sampleRate;
-	if (midiSession == NULL && jackClient->isRealtimeProcessing()) {
+	const bool renderInProcessCallback = midiSession == NULL && jackClient->isRealtimeProcessing()
+		&& Master::getInstance()->getSettings()->value("Master/renderJACKAudioInProcessCallback", false).toBool();
+	if (renderInProcessCallback) {
+		// Render directly in the realtime thread. The synth is switched to the realtime mode, so that rendering never locks
+		// and other threads access the synth via the rendering thread. MIDI input doesn't block either, at the cost of
+		// dropping a MIDI message should a lock be contended.
+		// Like with synchronous rendering, zero additional latency introduced.
+		audioLatencyFrames = 0;
+		synthRoute.enableRealtimeMode();
+		qDebug() << "JACKAudioDriver: Configured rendering in JACK process callback";
+	} else if (midiSession == NULL && jackClient->isRealtimeProcessing()) {
 		// Use prerendering to prevent the realtime thread from locking, yet to retain complete functionality.
 		// Additional latency of at least the JACK buffer length is introduced.
 		if (audioLatencyFrames < jackBufferSizeFrames) audioLatencyFrames = jackBufferSizeFrames;
@@ -164,7 +170,6 @@ bool JACKAudioStream::start(MidiSession *midiSession) {
 	} else {
 		// Rendering is synchronous, zero additional latency introduced.
 		audioLatencyFrames = 0;
-		buffer = new float[CHANNEL_COUNT * MT32Emu::MAX_SAMPLES_PER_RUN];
 	}
 
 	if (midiSession == NULL) {
@@ -204,7 +209,7 @@ bool JACKAudioStream::checkSampleRate(quint32 jackSampleRate) const {
 	if (jackSampleRate == sampleRate) return true;
 	qDebug() << "JACKAudioDriver: Sample rate mismatch: configured rate / JACK system rate:" << sampleRate
 		<< "/" << jackSampleRate;
-	QMessageBox::warning(NULL, "Error", "Sample rate configured for the synth doesn't match the JACK system sample rate");
+	Master::showWarning("Error", "Sample rate configured for the synth doesn't match the JACK system sample rate");
 	return false;
 }
 
@@ -235,29 +240,27 @@ void JACKAudioStream::renderStreams(const quint32 totalFrameCount, JACKAudioSamp
 		}
 		updateTimeInfo(MasterClock::getClockNanos(), framesInAudioBuffer);
 	}
+	if (processor == NULL) {
+		// The synth renders straight into the port buffers, no intermediate buffer needed.
+		synthRoute.render(leftOutBuffer, rightOutBuffer, totalFrameCount);
+		framesRendered(totalFrameCount);
+		return;
+	}
 	for (quint32 framesLeft = totalFrameCount; framesLeft > 0;) {
-		float *bufferPtr;
-		uint framesToRender;
-		if (processor != NULL) {
-			framesToRender = framesLeft;
-			bufferPtr = processor->getAvailableChunk(framesToRender);
-			if (framesToRender == 0) {
-				for (JACKAudioSample *leftOutBufferEnd = leftOutBuffer + framesLeft; leftOutBuffer < leftOutBufferEnd;) {
-					*(leftOutBuffer++) = 0;
-					*(rightOutBuffer++) = 0;
-				}
-				return;
+		uint framesToRender = framesLeft;
+		const float *bufferPtr = processor->getAvailableChunk(framesToRender);
+		if (framesToRender == 0) {
+			for (JACKAudioSample *leftOutBufferEnd = leftOutBuffer + framesLeft; leftOutBuffer < leftOutBufferEnd;) {
+				*(leftOutBuffer++) = 0;
+				*(rightOutBuffer++) = 0;
 			}
-		} else {
-			bufferPtr = buffer;
-			framesToRender = qMin(framesLeft, MT32Emu::MAX_SAMPLES_PER_RUN);
-			synthRoute.render(buffer, framesToRender);
+			return;
 		}
 		for (JACKAudioSample *leftOutBufferEnd = leftOutBuffer + framesToRender; leftOutBuffer < leftOutBufferEnd;) {
 			*(leftOutBuffer++) = JACKAudioSample(*(bufferPtr++));
 			*(rightOutBuffer++) = JACKAudioSample(*(bufferPtr++));
 		}
-		if (processor != NULL) processor->markChunkProcessed(framesToRender);
+		processor->markChunkProcessed(framesToRender);
 		framesLeft -= framesToRender;
 	}
 	framesRendered(totalFrameCount);
@@ -27,7 +27,6 @@ public:
 
 private:
 	JACKClient * const jackClient;
-	float *buffer;
 	JACKAudioProcessor *processor;
 	const quint32 configuredAudioLatencyFrames;
 };
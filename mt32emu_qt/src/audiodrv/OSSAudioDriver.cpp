@@ -28,7 +28,6 @@
 using namespace MT32Emu;
 
 static const unsigned int NUM_OF_FRAGMENTS = 2;
-static const unsigned int FRAME_SIZE = 4; // Stereo, 16-bit
 static const unsigned int DEFAULT_CHUNK_MS = 16;
 static const unsigned int DEFAULT_AUDIO_LATENCY = 32;
 static const unsigned int DEFAULT_MIDI_LATENCY = 16;
@@ -60,13 +59,14 @@ void *OSSAudioStream::processingThread(void *userData) {
 				isErrorOccurred = true;
 				break;
 			}
-			framesInAudioBuffer = quint32(delay / FRAME_SIZE);
+			framesInAudioBuffer = quint32(delay / audioStream.getFrameSize());
 		} else {
 			framesInAudioBuffer = 0;
 		}
 		audioStream.renderAndUpdateState(audioStream.buffer, audioStream.bufferSize, nanosNow, framesInAudioBuffer);
-		error = write(audioStream.stream, audioStream.buffer, FRAME_SIZE * audioStream.bufferSize);
-		if (error != int(FRAME_SIZE * audioStream.bufferSize)) {
+		const int bytesToWrite = int(audioStream.getFrameSize() * audioStream.bufferSize);
+		error = write(audioStream.stream, audioStream.buffer, bytesToWrite);
+		if (error != bytesToWrite) {
 			if (error == -1) {
 				qDebug() << "OSS audio: write failed:" << errno;
 			} else {
@@ -92,6 +92,11 @@ bool OSSAudioStream::start() {
 
 	qDebug() << "Using OSS default audio device";
 
+	// Prefer float samples when the synth renders them natively
+#ifdef AFMT_FLOAT
+	sampleFormat = getNativeSampleFormat();
+#endif
+
 	// Open audio device
 	stream = open(deviceName, O_WRONLY, 0);
 	if (stream == -1) {
@@ -100,8 +105,38 @@ bool OSSAudioStream::start() {
 		return false;
 	}
 
-	int tmp = 0;
-	uint fragSize = (FRAME_SIZE * audioLatencyFrames) / NUM_OF_FRAGMENTS;
+	// Set the sample format
+	int tmp;
+#ifdef AFMT_FLOAT
+	if (sampleFormat == AudioSampleFormat_FLOAT) {
+		tmp = AFMT_FLOAT;
+		if (ioctl(stream, SNDCTL_DSP_SETFMT, &tmp) == -1 || tmp != AFMT_FLOAT) {
+			qDebug() << "OSS audio: The device doesn't support the float sample format -> falling back to 16-bit integer samples";
+			sampleFormat = AudioSampleFormat_S16;
+		}
+	}
+#endif
+	if (sampleFormat == AudioSampleFormat_S16) {
+		tmp = AFMT_S16_NE;/* Native 16 bits */
+		if (ioctl(stream, SNDCTL_DSP_SETFMT, &tmp) == -1) {
+			qDebug() << "OSS audio: SNDCTL_DSP_SETFMT failed:" << errno;
+			close(stream);
+			stream = 0;
+			return false;
+		}
+
+		if (tmp != AFMT_S16_NE) {
+			qDebug() << "OSS audio: The device doesn't support the 16 bit sample format";
+			close(stream);
+			stream = 0;
+			return false;
+		}
+	}
+
+	// The fragment size depends on the frame size of the negotiated sample format. The fragments can be set up
+	// at any point before the first write, although it is best done as early as possible.
+	tmp = 0;
+	uint fragSize = (getFrameSize() * audioLatencyFrames) / NUM_OF_FRAGMENTS;
 	while (fragSize > 1) {
 		tmp++;
 		fragSize >>= 1;
@@ -115,22 +150,6 @@ bool OSSAudioStream::start() {
 	}
 	qDebug() << "OSS audio: Set number of fragments:"  << (tmp >> 16) << "Fragment size:" << (tmp & 0xFFFF);
 
-	// Set the sample format
-	tmp = AFMT_S16_NE;/* Native 16 bits */
-	if (ioctl(stream, SNDCTL_DSP_SETFMT, &tmp) == -1) {
-		qDebug() << "OSS audio: SNDCTL_DSP_SETFMT failed:" << errno;
-		close(stream);
-		stream = 0;
-		return false;
-	}
-
-	if (tmp != AFMT_S16_NE) {
-		qDebug() << "OSS audio: The device doesn't support the 16 bit sample format";
-		close(stream);
-		stream = 0;
-		return false;
-	}
-
 	// Set the number of channels
 	tmp = 2; // Stereo
 	if (ioctl(stream, SNDCTL_DSP_CHANNELS, &tmp) == -1) {
@@ -171,16 +190,17 @@ bool OSSAudioStream::start() {
 		stream = 0;
 		return false;
 	}
-	audioLatencyFrames = bi.bytes / FRAME_SIZE;
-	bufferSize = bi.fragsize / FRAME_SIZE;
-	buffer = new Bit16s[/* number of channels */ 2 * bufferSize];
+	const uint frameSize = getFrameSize();
+	audioLatencyFrames = bi.bytes / frameSize;
+	bufferSize = bi.fragsize / frameSize;
+	buffer = new float[/* number of channels */ 2 * bufferSize];
 	if (buffer == NULL) {
 		qDebug() << "OSS audio setup: Memory allocation error, driver died";
 		close(stream);
 		stream = 0;
 		return false;
 	}
-	memset(buffer, 0, FRAME_SIZE * bufferSize);
+	memset(buffer, 0, frameSize * bufferSize);
 	qDebug() << "OSS audio setup: Number of fragments:" << bi.fragments << "Audio buffer size:" << bi.bytes << "bytes ("<< audioLatencyFrames << ") frames";
 	qDebug() << "fragsize:" << bi.fragsize << "bufferSize:" << bufferSize;
 
@@ -190,8 +210,8 @@ bool OSSAudioStream::start() {
 	// Start playing to fill audio buffers
 	int initFrames = audioLatencyFrames;
 	while (initFrames > 0) {
-		tmp = write(stream, buffer, FRAME_SIZE * bufferSize);
-		if (tmp != int(FRAME_SIZE * bufferSize)) {
+		tmp = write(stream, buffer, frameSize * bufferSize);
+		if (tmp != int(frameSize * bufferSize)) {
 			if (tmp == -1) {
 				qDebug() << "OSS audio: write failed:" << errno;
 			} else {
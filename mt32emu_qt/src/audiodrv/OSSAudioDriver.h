@@ -13,7 +13,8 @@ class OSSAudioDriver;
 
 class OSSAudioStream : public AudioStream {
 private:
-	MT32Emu::Bit16s *buffer;
+	// Large enough to hold a chunk in either sample format.
+	float *buffer;
 	int stream;
 	uint bufferSize;
 	pthread_t processingThreadID;
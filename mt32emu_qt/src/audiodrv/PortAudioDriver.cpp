@@ -103,6 +103,16 @@ bool PortAudioStream::start(PaDeviceIndex deviceIndex) {
 		audioLatency = deviceInfo->defaultHighOutputLatency * MasterClock::NANOS_PER_SECOND;
 	}
 	PaStreamParameters outStreamParameters = {deviceIndex, 2, paInt16, (double)audioLatency / MasterClock::NANOS_PER_SECOND, NULL};
+	// Prefer float samples when the synth renders them natively
+	sampleFormat = getNativeSampleFormat();
+	if (sampleFormat == AudioSampleFormat_FLOAT) {
+		outStreamParameters.sampleFormat = paFloat32;
+		if (Pa_IsFormatSupported(NULL, &outStreamParameters, sampleRate) != paFormatIsSupported) {
+			qDebug() << "PortAudio: Float samples unsupported -> falling back to 16-bit integer samples";
+			outStreamParameters.sampleFormat = paInt16;
+			sampleFormat = AudioSampleFormat_S16;
+		}
+	}
 	PaError err =  Pa_OpenStream(&stream, NULL, &outStreamParameters, sampleRate, paFramesPerBufferUnspecified, paNoFlag, paCallback, this);
 	if(err != paNoError) {
 		qDebug() << "Pa_OpenStream() returned PaError" << err << "-" << Pa_GetErrorText(err);
@@ -131,9 +141,9 @@ bool PortAudioStream::start(PaDeviceIndex deviceIndex) {
 
 int PortAudioStream::paCallback(const void *inputBuffer, void *outputBuffer, unsigned long frameCount, const PaStreamCallbackTimeInfo *timeInfo, PaStreamCallbackFlags statusFlags, void *userData) {
 	Q_UNUSED(inputBuffer);
-	Q_UNUSED(statusFlags);
 
 	PortAudioStream *stream = (PortAudioStream *)userData;
+	if (statusFlags & paOutputUnderflow) stream->xrunDetected();
 	MasterClockNanos nanosNow = MasterClock::getClockNanos();
 	quint32 framesInAudioBuffer;
 	if (stream->settings.advancedTiming) {
@@ -143,7 +153,7 @@ int PortAudioStream::paCallback(const void *inputBuffer, void *outputBuffer, uns
 	} else {
 		framesInAudioBuffer = 0;
 	}
-	stream->renderAndUpdateState((Bit16s *)outputBuffer, quint32(frameCount), nanosNow, framesInAudioBuffer);
+	stream->renderAndUpdateState(outputBuffer, quint32(frameCount), nanosNow, framesInAudioBuffer);
 
 	return paContinue;
 }
@@ -28,7 +28,6 @@
 
 using namespace MT32Emu;
 
-static const int FRAME_SIZE = 4; // Stereo, 16-bit
 static const unsigned int DEFAULT_CHUNK_MS = 10;
 static const unsigned int DEFAULT_AUDIO_LATENCY = 40;
 static const unsigned int DEFAULT_MIDI_LATENCY = 20;
@@ -131,7 +130,7 @@ PulseAudioStream::PulseAudioStream(const AudioDriverSettings &useSettings, Synth
 	AudioStream(useSettings, useSynthRoute, useSampleRate), stream(NULL), processingThreadID(0), stopProcessing(false)
 {
 	bufferSize = settings.chunkLen * sampleRate / MasterClock::MILLIS_PER_SECOND;
-	buffer = new Bit16s[/* channels */ 2 * bufferSize];
+	buffer = new float[/* channels */ 2 * bufferSize];
 }
 
 PulseAudioStream::~PulseAudioStream() {
@@ -152,7 +151,7 @@ void *PulseAudioStream::processingThread(void *userData) {
 			framesInAudioBuffer = 0;
 		}
 		audioStream.renderAndUpdateState(audioStream.buffer, audioStream.bufferSize, nanosNow, framesInAudioBuffer);
-		if (_pa_simple_write(audioStream.stream, audioStream.buffer, audioStream.bufferSize * FRAME_SIZE, &error) < 0) {
+		if (_pa_simple_write(audioStream.stream, audioStream.buffer, audioStream.bufferSize * audioStream.getFrameSize(), &error) < 0) {
 			qDebug() << "pa_simple_write() failed:" << _pa_strerror(error);
 			_pa_simple_free(audioStream.stream);
 			audioStream.stream = NULL;
@@ -167,37 +166,52 @@ void *PulseAudioStream::processingThread(void *userData) {
 	return NULL;
 }
 
-bool PulseAudioStream::start() {
-	int error;
-	if (buffer == NULL) return false;
-	memset(buffer, 0, FRAME_SIZE * bufferSize);
-	if (stream != NULL) close();
-
-	qDebug() << "Using PulseAudio default device";
-
+pa_simple *PulseAudioStream::createStream(int &error) const {
 	// The Sample format to use
-	static const pa_sample_spec ss = {
-		PA_SAMPLE_S16NE, // format
+	const pa_sample_spec ss = {
+		sampleFormat == AudioSampleFormat_FLOAT ? PA_SAMPLE_FLOAT32NE : PA_SAMPLE_S16NE, // format
 		sampleRate,
 		2 // channels
 	};
 
 	// Configuring desired audio latency
-	qDebug() << "Using audio latency:" << settings.audioLatency;
-	static const pa_buffer_attr ba = {
-		audioLatencyFrames * FRAME_SIZE, // uint32_t maxlength;
-		audioLatencyFrames * FRAME_SIZE, // uint32_t tlength;
+	const quint32 frameSize = getFrameSize();
+	const pa_buffer_attr ba = {
+		audioLatencyFrames * frameSize, // uint32_t maxlength;
+		audioLatencyFrames * frameSize, // uint32_t tlength;
 		(uint32_t)-1, // uint32_t prebuf;
 		(uint32_t)-1, // uint32_t minreq;
 		(uint32_t)-1 // uint32_t fragsize;
 	};
 
-	// Create a new playback stream
-	stream = _pa_simple_new(NULL, "mt32emu-qt", PA_STREAM_PLAYBACK, NULL, "playback", &ss, NULL, &ba, &error);
+	return _pa_simple_new(NULL, "mt32emu-qt", PA_STREAM_PLAYBACK, NULL, "playback", &ss, NULL, &ba, &error);
+}
+
+bool PulseAudioStream::start() {
+	int error;
+	if (buffer == NULL) return false;
+	if (stream != NULL) close();
+
+	qDebug() << "Using PulseAudio default device";
+	qDebug() << "Using audio latency:" << settings.audioLatency;
+
+	// Create a new playback stream, prefer float samples when the synth renders them natively
+	sampleFormat = getNativeSampleFormat();
+	if (sampleFormat == AudioSampleFormat_FLOAT) {
+		stream = createStream(error);
+		if (stream == NULL) {
+			qDebug() << "PulseAudio: Float samples unsupported:" << _pa_strerror(error) << "-> falling back to 16-bit integer samples";
+			sampleFormat = AudioSampleFormat_S16;
+		}
+	}
+	if (sampleFormat == AudioSampleFormat_S16) {
+		stream = createStream(error);
+	}
 	if (stream == NULL) {
 		qDebug() << "pa_simple_new() failed:" << _pa_strerror(error);
 		return false;
 	}
+	memset(buffer, 0, getFrameSize() * bufferSize);
 
 	// Setup initial MIDI latency
 	if (isAutoLatencyMode()) midiLatencyFrames = audioLatencyFrames + ((DEFAULT_MIDI_LATENCY * sampleRate) / MasterClock::MILLIS_PER_SECOND);
@@ -205,7 +219,7 @@ bool PulseAudioStream::start() {
 	// Start playing to fill audio buffers
 	int initFrames = audioLatencyFrames;
 	while (initFrames > 0) {
-		if (_pa_simple_write(stream, buffer, FRAME_SIZE * bufferSize, &error) < 0) {
+		if (_pa_simple_write(stream, buffer, getFrameSize() * bufferSize, &error) < 0) {
 			qDebug() << "pa_simple_write() failed:" << _pa_strerror(error);
 			_pa_simple_free(stream);
 			stream = NULL;
@@ -15,7 +15,8 @@ class PulseAudioDriver;
 
 class PulseAudioStream : public AudioStream {
 private:
-	MT32Emu::Bit16s *buffer;
+	// Large enough to hold a chunk in either sample format.
+	float *buffer;
 	pa_simple *stream;
 	uint bufferSize;
 	pthread_t processingThreadID;
@@ -23,6 +24,8 @@ private:
 
 	static void *processingThread(void *);
 
+	pa_simple *createStream(int &error) const;
+
 public:
 	PulseAudioStream(const AudioDriverSettings &settings, SynthRoute &synthRoute, const quint32 sampleRate);
 	~PulseAudioStream();
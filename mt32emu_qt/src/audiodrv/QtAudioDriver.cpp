@@ -17,11 +17,15 @@
 #include "QtAudioDriver.h"
 
 #ifdef USE_QT_MULTIMEDIAKIT
+#include <QtMultimediaKit/QAudioDeviceInfo>
 #include <QtMultimediaKit/QAudioOutput>
 #elif (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
+#include <QtMultimedia/QAudioDeviceInfo>
 #include <QtMultimedia/QAudioOutput>
 #else
+#include <QtMultimedia/QAudioDevice>
 #include <QtMultimedia/QAudioSink>
+#include <QtMultimedia/QMediaDevices>
 #endif
 
 #include <mt32emu/mt32emu.h>
@@ -42,7 +46,8 @@ public:
 	}
 
 	qint64 readData(char *data, qint64 len) {
-		if (len == (stream.audioLatencyFrames << 2)) {
+		const quint32 frameSize = stream.getFrameSize();
+		if (len == qint64(stream.audioLatencyFrames) * frameSize) {
 			// Fill empty buffer to keep correct timing at startup / x-run recovery
 			memset(data, 0, len);
 			return len;
@@ -50,12 +55,12 @@ public:
 		MasterClockNanos nanosNow = MasterClock::getClockNanos();
 		quint32 framesInAudioBuffer;
 		if (stream.settings.advancedTiming) {
-			framesInAudioBuffer = (stream.audioOutput->bufferSize() - stream.audioOutput->bytesFree()) >> 2;
+			framesInAudioBuffer = quint32(stream.audioOutput->bufferSize() - stream.audioOutput->bytesFree()) / frameSize;
 		} else {
 			framesInAudioBuffer = 0;
 		}
-		uint framesToRender = uint(len >> 2);
-		stream.renderAndUpdateState((Bit16s *)data, framesToRender, nanosNow, framesInAudioBuffer);
+		uint framesToRender = uint(len / frameSize);
+		stream.renderAndUpdateState(data, framesToRender, nanosNow, framesInAudioBuffer);
 		return len;
 	}
 
@@ -70,7 +75,7 @@ public:
 	}
 
 	qint64 bytesAvailable() const {
-		return stream.audioLatencyFrames << 2;
+		return qint64(stream.audioLatencyFrames) * stream.getFrameSize();
 	}
 };
 
@@ -112,28 +117,43 @@ void QtAudioStream::start() {
 	QAudioFormat format;
 	format.setSampleRate(sampleRate);
 	format.setChannelCount(2);
+	// Prefer float samples when the synth renders them natively
+	sampleFormat = getNativeSampleFormat();
 #if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
-	format.setSampleSize(16);
 	format.setCodec("audio/pcm");
 	// libmt32emu produces samples in native byte order which is the default byte order used in QAudioFormat
-	format.setSampleType(QAudioFormat::SignedInt);
+	if (sampleFormat == AudioSampleFormat_FLOAT) {
+		format.setSampleSize(32);
+		format.setSampleType(QAudioFormat::Float);
+		if (!QAudioDeviceInfo::defaultOutputDevice().isFormatSupported(format)) sampleFormat = AudioSampleFormat_S16;
+	}
+	if (sampleFormat == AudioSampleFormat_S16) {
+		format.setSampleSize(16);
+		format.setSampleType(QAudioFormat::SignedInt);
+	}
 	audioOutput = new QAudioOutput(format);
 #else
-	format.setSampleFormat(QAudioFormat::Int16);
+	if (sampleFormat == AudioSampleFormat_FLOAT) {
+		format.setSampleFormat(QAudioFormat::Float);
+		if (!QMediaDevices::defaultAudioOutput().isFormatSupported(format)) sampleFormat = AudioSampleFormat_S16;
+	}
+	if (sampleFormat == AudioSampleFormat_S16) format.setSampleFormat(QAudioFormat::Int16);
 	audioOutput = new QAudioSink(format);
 #endif
+	qDebug() << "QAudioDriver: Using" << (sampleFormat == AudioSampleFormat_FLOAT ? "float" : "16-bit integer") << "samples";
+	const quint32 frameSize = getFrameSize();
 	waveGenerator = new WaveGenerator(*this);
 	if (settings.audioLatency != 0) {
-		audioOutput->setBufferSize((sampleRate * settings.audioLatency << 2) / MasterClock::MILLIS_PER_SECOND);
+		audioOutput->setBufferSize((sampleRate * settings.audioLatency * frameSize) / MasterClock::MILLIS_PER_SECOND);
 	}
 	audioOutput->start(waveGenerator);
-	MasterClockNanos audioLatency = MasterClock::NANOS_PER_SECOND * audioOutput->bufferSize() / (sampleRate << 2);
+	MasterClockNanos audioLatency = MasterClock::NANOS_PER_SECOND * audioOutput->bufferSize() / (sampleRate * frameSize);
 #if (QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
-	MasterClockNanos chunkSize = MasterClock::NANOS_PER_SECOND * audioOutput->periodSize() / (sampleRate << 2);
+	MasterClockNanos chunkSize = MasterClock::NANOS_PER_SECOND * audioOutput->periodSize() / (sampleRate * frameSize);
 #else
 	MasterClockNanos chunkSize = audioLatency / 5;
 #endif
-	audioLatencyFrames = quint32(audioOutput->bufferSize() >> 2);
+	audioLatencyFrames = quint32(audioOutput->bufferSize()) / frameSize;
 	qDebug() << "QAudioDriver: Latency set to:" << (double)audioLatency / MasterClock::NANOS_PER_SECOND << "sec." << "Chunk size:" << (double)chunkSize / MasterClock::NANOS_PER_SECOND;
 
 	// Setup initial MIDI latency
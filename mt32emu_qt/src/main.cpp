@@ -20,36 +20,58 @@
 #include "MainWindow.h"
 #include "Master.h"
 
+// Options precede the command, if any. As the command parameters may start with '-' as well, we stop at the first non-option.
+static bool isHeadlessModeRequested(int argv, char **args) {
+	for (int argIx = 1; argIx < argv && args[argIx][0] == '-'; argIx++) {
+		if (qstricmp(args[argIx], "-headless") == 0) return true;
+	}
+	return false;
+}
+
 int main(int argv, char **args) {
+	const bool headless = isHeadlessModeRequested(argv, args);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+	// Allow running on a machine without a display server, unless the user chose a platform plugin explicitly.
+	if (headless && qgetenv("QT_QPA_PLATFORM").isEmpty()) qputenv("QT_QPA_PLATFORM", "offscreen");
+#endif
 #if (QT_VERSION_CHECK(5, 6, 0) <= QT_VERSION && QT_VERSION < QT_VERSION_CHECK(6, 0, 0))
 	QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 #endif
 	QApplication app(argv, args);
 	app.setApplicationName("Munt mt32emu-qt");
 	app.setQuitOnLastWindowClosed(false);
+	int exitCode = 0;
 	{
 		setlocale(LC_ALL, "");
-		Master master;
+		Master master(headless);
 		QSystemTrayIcon *trayIcon = NULL;
-		if (QSystemTrayIcon::isSystemTrayAvailable()) {
-			trayIcon = new QSystemTrayIcon(QIcon(":/images/Icon.gif"));
-			trayIcon->setToolTip("Munt: MT-32 Emulator");
-			trayIcon->show();
-			master.setTrayIcon(trayIcon);
-		}
-		MainWindow mainWindow(&master);
-		if (trayIcon == NULL || !master.getSettings()->value("Master/startIconized", false).toBool()) {
-			mainWindow.show();
+		MainWindow *mainWindow = NULL;
+		if (headless) {
+			QObject::connect(&master, SIGNAL(maxSessionsFinished()), &app, SLOT(quit()));
 		} else {
-			mainWindow.updateFloatingDisplayVisibility();
+			if (QSystemTrayIcon::isSystemTrayAvailable()) {
+				trayIcon = new QSystemTrayIcon(QIcon(":/images/Icon.gif"));
+				trayIcon->setToolTip("Munt: MT-32 Emulator");
+				trayIcon->show();
+				master.setTrayIcon(trayIcon);
+			}
+			mainWindow = new MainWindow(&master);
+			if (trayIcon == NULL || !master.getSettings()->value("Master/startIconized", false).toBool()) {
+				mainWindow->show();
+			} else {
+				mainWindow->updateFloatingDisplayVisibility();
+			}
 		}
 		if (argv < 2 || master.processCommandLine(app.arguments())) {
 			master.startPinnedSynthRoute();
 			master.startMidiProcessing();
 			app.exec();
+		} else if (master.isCommandLineFailed()) {
+			exitCode = 1;
 		}
 		master.setTrayIcon(NULL);
 		delete trayIcon;
+		delete mainWindow;
 	}
-	return 0;
+	return exitCode;
 }
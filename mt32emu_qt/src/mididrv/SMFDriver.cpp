@@ -24,6 +24,12 @@
 
 static const MasterClockNanos MAX_SLEEP_TIME = 200 * MasterClock::NANOS_PER_MILLISECOND;
 
+// The synth used to compute checkpoints doesn't need to report anything.
+class SilentReportHandler : public MT32Emu::ReportHandler {
+	void printDebug(const char *, va_list) {}
+	void showLCDMessage(const char *) {}
+};
+
 static void sendAllSoundOff(SynthRoute *synthRoute, bool resetAllControllers, bool discardMidiBuffers) {
 	if (synthRoute->getState() != SynthRouteState_OPEN) return;
 	if (discardMidiBuffers) {
@@ -43,7 +49,34 @@ static void sendAllSoundOff(SynthRoute *synthRoute, bool resetAllControllers, bo
 	}
 }
 
-SMFProcessor::SMFProcessor(SMFDriver *useSMFDriver) : driver(useSMFDriver), midiStreamSource()
+SMFCheckpointBuilder::SMFCheckpointBuilder(SMFCheckpoints &useCheckpoints) :
+	checkpoints(useCheckpoints), synthRoute(), midiStreamSource()
+{}
+
+void SMFCheckpointBuilder::start(SynthRoute *useSynthRoute, const MidiStreamSource *useMidiStreamSource) {
+	synthRoute = useSynthRoute;
+	midiStreamSource = useMidiStreamSource;
+	checkpoints.clear();
+	// The private synth has to start in the same state as the one we play to, which is about to change once playback starts.
+	initialSysexBank = synthRoute->dumpSysexBank();
+	QThread::start(QThread::LowPriority);
+}
+
+void SMFCheckpointBuilder::stop() {
+	checkpoints.stop();
+	wait();
+}
+
+void SMFCheckpointBuilder::run() {
+	SilentReportHandler reportHandler;
+	MT32Emu::Synth drySynth(&reportHandler);
+	if (initialSysexBank.isEmpty() || !synthRoute->openSynthWithROMImages(drySynth)) return;
+	drySynth.applySysexBank(reinterpret_cast<const MT32Emu::Bit8u *>(initialSysexBank.constData()), MT32Emu::Bit32u(initialSysexBank.size()));
+	checkpoints.compute(drySynth, *midiStreamSource);
+	drySynth.close();
+}
+
+SMFProcessor::SMFProcessor(SMFDriver *useSMFDriver) : driver(useSMFDriver), midiStreamSource(), checkpointBuilder(checkpoints)
 {}
 
 void SMFProcessor::start(const MidiStreamSource *useMidiStreamSource) {
@@ -62,6 +95,8 @@ void SMFProcessor::run() {
 	bool paused = false;
 	const QMidiEventList &midiEvents = midiStreamSource->getMIDIEvents();
 	midiTick = midiStreamSource->getMidiTick();
+	checkpointBuilder.start(synthRoute, midiStreamSource);
+	bool tempoOverridden = false;
 	quint32 totalSeconds = estimateRemainingTime(midiEvents, 0);
 	MasterClockNanos startNanos = MasterClock::getClockNanos();
 	MasterClockNanos currentNanos = startNanos;
@@ -70,6 +105,7 @@ void SMFProcessor::run() {
 		while (!driver->stopProcessing && synthRoute->getState() == SynthRouteState_OPEN) {
 			uint bpmUpdate = uint(driver->bpmUpdate.fetchAndStoreRelaxed(0));
 			if (bpmUpdate > 0) {
+				tempoOverridden = true;
 				midiTick = midiStreamSource->getMidiTick(MidiParser::MICROSECONDS_PER_MINUTE / bpmUpdate);
 				totalSeconds = (currentNanos - startNanos) / MasterClock::NANOS_PER_SECOND + estimateRemainingTime(midiEvents, currentEventIx + 1);
 			}
@@ -91,17 +127,27 @@ void SMFProcessor::run() {
 				MasterClockNanos seekNanosSinceStart = totalSeconds * seekPosition * MasterClock::NANOS_PER_MILLISECOND;
 				MasterClockNanos currentNanosSinceStart = currentNanos - startNanos;
 				MasterClockNanos lastEventNanosSinceStart = currentNanosSinceStart - midiEvents.at(currentEventIx).getTimestamp() * midiTick;
-				bool rewind;
-				if (seekNanosSinceStart < lastEventNanosSinceStart || seekNanosSinceStart == 0) {
-					midiTick = midiStreamSource->getMidiTick();
-					emit driver->tempoUpdated(0);
-					currentEventIx = 0;
-					currentNanosSinceStart = midiEvents.at(currentEventIx).getTimestamp() * midiTick;
-					rewind = true;
+				bool rewind = seekNanosSinceStart < lastEventNanosSinceStart || seekNanosSinceStart == 0;
+				// The checkpoints are timed at the tempo of the file, so they are unusable for seeking forward with the tempo overridden.
+				// Those not computed yet are simply unavailable.
+				SMFCheckpoint checkpoint;
+				bool checkpointFound = (rewind || !tempoOverridden) && checkpoints.findCheckpoint(seekNanosSinceStart, checkpoint);
+				if (checkpointFound && (rewind || currentEventIx < checkpoint.eventIx)) {
+					sendAllSoundOff(synthRoute, true, true);
+					restoreCheckpoint(synthRoute, checkpoint);
+					currentEventIx = checkpoint.eventIx;
+					currentNanosSinceStart = checkpoint.eventNanos;
+					tempoOverridden = false;
 				} else {
-					rewind = false;
+					if (rewind) {
+						midiTick = midiStreamSource->getMidiTick();
+						emit driver->tempoUpdated(0);
+						currentEventIx = 0;
+						currentNanosSinceStart = midiEvents.at(currentEventIx).getTimestamp() * midiTick;
+						tempoOverridden = false;
+					}
+					sendAllSoundOff(synthRoute, rewind, rewind);
 				}
-				sendAllSoundOff(synthRoute, rewind, rewind);
 				seek(synthRoute, midiEvents, currentEventIx, currentNanosSinceStart, seekNanosSinceStart);
 				nanosNow = MasterClock::getClockNanos();
 				startNanos = nanosNow - seekNanosSinceStart;
@@ -138,6 +184,8 @@ void SMFProcessor::run() {
 				break;
 		}
 	}
+	// The synth route may go away along with the session.
+	checkpointBuilder.stop();
 	sendAllSoundOff(synthRoute, true, false);
 	emit driver->playbackTimeChanged(0, 0);
 	qDebug() << "SMFDriver: processor thread stopped";
@@ -156,6 +204,21 @@ quint32 SMFProcessor::estimateRemainingTime(const QMidiEventList &midiEvents, in
 	return quint32(totalNanos / MasterClock::NANOS_PER_SECOND);
 }
 
+void SMFProcessor::restoreCheckpoint(SynthRoute *synthRoute, const SMFCheckpoint &checkpoint) {
+	// The SysEx bank starts with a reset, hence all the controllers are reset as well.
+	synthRoute->applySysexBank(checkpoint.sysexBank);
+	foreach (quint32 msg, checkpoint.controllerMessages) {
+		synthRoute->playMIDIShortMessageNow(msg);
+	}
+	if (checkpoint.tempo == 0) {
+		midiTick = midiStreamSource->getMidiTick();
+		emit driver->tempoUpdated(0);
+	} else {
+		midiTick = midiStreamSource->getMidiTick(checkpoint.tempo);
+		emit driver->tempoUpdated(MidiParser::MICROSECONDS_PER_MINUTE / checkpoint.tempo);
+	}
+}
+
 void SMFProcessor::seek(SynthRoute *synthRoute, const QMidiEventList &midiEvents, int &currentEventIx, MasterClockNanos &currentEventNanos, const MasterClockNanos seekNanos) {
 	while (!driver->stopProcessing && synthRoute->getState() == SynthRouteState_OPEN && currentEventNanos < seekNanos) {
 		const QMidiEvent &e = midiEvents.at(currentEventIx);
@@ -7,9 +7,26 @@
 #include "../Master.h"
 #include "../MidiParser.h"
 #include "../MasterClock.h"
+#include "../SMFCheckpoints.h"
 
 class SMFDriver;
 
+// Computes the checkpoints in background, so that the playback starts without delay.
+class SMFCheckpointBuilder : public QThread {
+public:
+	SMFCheckpointBuilder(SMFCheckpoints &useCheckpoints);
+	void start(SynthRoute *synthRoute, const MidiStreamSource *midiStreamSource);
+	void stop();
+
+private:
+	SMFCheckpoints &checkpoints;
+	SynthRoute *synthRoute;
+	const MidiStreamSource *midiStreamSource;
+	QByteArray initialSysexBank;
+
+	void run();
+};
+
 class SMFProcessor : public QThread {
 	Q_OBJECT
 
@@ -21,9 +38,12 @@ private:
 	SMFDriver *driver;
 	const MidiStreamSource *midiStreamSource;
 	MasterClockNanos midiTick;
+	SMFCheckpoints checkpoints;
+	SMFCheckpointBuilder checkpointBuilder;
 
 	void run();
 	quint32 estimateRemainingTime(const QMidiEventList &midiEvents, int currentEventIx);
+	void restoreCheckpoint(SynthRoute *synthRoute, const SMFCheckpoint &checkpoint);
 	void seek(SynthRoute *synthRoute, const QMidiEventList &midiEvents, int &currentEventIx, MasterClockNanos &currentEventNanos, const MasterClockNanos seekNanos);
 };
 
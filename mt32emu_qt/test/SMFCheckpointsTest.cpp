@@ -0,0 +1,222 @@
+/* Copyright (C) 2011-2026 Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Checks the seek checkpoints computed by a dry pass through a synthetic MIDI stream. Real ROMs aren't needed, the synth
+// is opened with blank ROM images that carry the expected SHA1 digests, as only the synth memory matters here.
+
+#include <cstring>
+
+#include <doctest/doctest.h>
+
+#include "../src/SMFCheckpoints.h"
+
+using namespace MT32Emu;
+
+// Offset of the table in the control ROM that limits the values of the system area, SysEx writes are clamped to zero otherwise.
+static const uint CONTROL_ROM_SYSTEM_MAX_TABLE = 0x48B6;
+static const uint SYSTEM_AREA_SIZE = 23;
+static const Bit32u MASTER_VOLUME_ADDRESS = 0x40016;
+
+// Ticks per beat, so that a tick lasts exactly 1 ms at the default tempo.
+static const uint DIVISION = 500;
+
+static const Bit32u PITCH_BEND_MSG = 0x005000E0;
+static const Bit32u MODULATION_MSG = 0x004001B1;
+static const Bit32u RESET_ALL_CONTROLLERS_MSG = 0x000079B1;
+static const Bit8u MASTER_VOLUME_SYSEX[] = { 0xF0, 0x41, 0x10, 0x16, 0x12, 0x10, 0x00, 0x16, 0x17, 0x43, 0xF7 };
+static const Bit8u MASTER_VOLUME = 0x17;
+
+class TestStreamSource : public MidiStreamSource {
+public:
+	QMidiEventList midiEvents;
+
+	const QString getStreamName() const {
+		return "Test";
+	}
+
+	const QMidiEventList &getMIDIEvents() const {
+		return midiEvents;
+	}
+
+	MasterClockNanos getMidiTick(uint tempo) const {
+		return MasterClockNanos(tempo) * MasterClock::NANOS_PER_MICROSECOND / DIVISION;
+	}
+
+	void addShortMessage(SynthTimestamp deltaTicks, Bit32u msg) {
+		midiEvents.newMidiEvent().assignShortMessage(deltaTicks, msg);
+	}
+
+	void addSysex(SynthTimestamp deltaTicks, const Bit8u *sysex, Bit32u sysexLen) {
+		midiEvents.newMidiEvent().assignSysex(deltaTicks, sysex, sysexLen);
+	}
+
+	void addSetTempo(SynthTimestamp deltaTicks, uint tempo) {
+		midiEvents.newMidiEvent().assignSetTempoMessage(deltaTicks, tempo);
+	}
+};
+
+static const ROMImage *makeBlankROMImage(const char *shortName) {
+	for (const ROMInfo * const *romInfos = ROMInfo::getAllROMInfos(); *romInfos != NULL; romInfos++) {
+		const ROMInfo *romInfo = *romInfos;
+		if (strcmp(romInfo->shortName, shortName) != 0) continue;
+		// The data is never freed, like the ROM images.
+		Bit8u *data = new Bit8u[romInfo->fileSize];
+		memset(data, 0, romInfo->fileSize);
+		if (romInfo->type == ROMInfo::Control) memset(data + CONTROL_ROM_SYSTEM_MAX_TABLE, 0x7F, SYSTEM_AREA_SIZE);
+		return ROMImage::makeROMImage(new ArrayFile(data, romInfo->fileSize, romInfo->sha1Digest));
+	}
+	return NULL;
+}
+
+static bool openSynth(Synth &synth) {
+	static const ROMImage *controlROMImage = makeBlankROMImage("ctrl_mt32_2_04");
+	static const ROMImage *pcmROMImage = makeBlankROMImage("pcm_mt32");
+	return controlROMImage != NULL && pcmROMImage != NULL && synth.open(*controlROMImage, *pcmROMImage, AnalogOutputMode_DIGITAL_ONLY);
+}
+
+static Bit8u getMasterVolume(const QByteArray &sysexBank) {
+	Synth synth;
+	if (!openSynth(synth)) return 0;
+	synth.applySysexBank(reinterpret_cast<const Bit8u *>(sysexBank.constData()), Bit32u(sysexBank.size()));
+	Bit8u masterVolume = 0;
+	synth.readMemory(MASTER_VOLUME_ADDRESS, 1, &masterVolume);
+	synth.close();
+	return masterVolume;
+}
+
+// The timestamps of the events are deltas in ticks, the comments give the absolute event time.
+static void makeTestStream(TestStreamSource &stream) {
+	// 0 s
+	stream.addShortMessage(0, 0x000001C0);
+	// 3 s
+	stream.addShortMessage(3000, PITCH_BEND_MSG);
+	// 6 s, twice the default tempo from here on
+	stream.addSetTempo(3000, MidiStreamSource::DEFAULT_TEMPO / 2);
+	// 8 s
+	stream.addShortMessage(4000, MODULATION_MSG);
+	// 11 s
+	stream.addSysex(6000, MASTER_VOLUME_SYSEX, sizeof MASTER_VOLUME_SYSEX);
+	// 12 s, notes aren't played during the dry pass
+	stream.addShortMessage(2000, 0x007F3C90);
+	// 13 s
+	stream.addShortMessage(2000, RESET_ALL_CONTROLLERS_MSG);
+	// 15 s
+	stream.addShortMessage(4000, 0x00003C80);
+	// 16 s
+	stream.addShortMessage(2000, 0x00500BB2);
+}
+
+static void computeCheckpoints(SMFCheckpoints &checkpoints, const TestStreamSource &stream) {
+	Synth drySynth;
+	REQUIRE(openSynth(drySynth));
+	CHECK(checkpoints.compute(drySynth, stream));
+	drySynth.close();
+}
+
+TEST_CASE("SMFCheckpoints should be placed at events at least 5 s apart") {
+	TestStreamSource stream;
+	makeTestStream(stream);
+	SMFCheckpoints checkpoints;
+	computeCheckpoints(checkpoints, stream);
+	REQUIRE(checkpoints.getCount() == 4);
+
+	SMFCheckpoint checkpoint[4];
+	for (int i = 0; i < 4; i++) {
+		REQUIRE(checkpoints.findCheckpoint(MasterClockNanos(5 * i + 1) * MasterClock::NANOS_PER_SECOND, checkpoint[i]));
+	}
+
+	SUBCASE("Position") {
+		// The first event and then the first event at least 5 s past the previous checkpoint.
+		CHECK(checkpoint[0].eventIx == 0);
+		CHECK(checkpoint[0].eventNanos == 0);
+		CHECK(checkpoint[1].eventIx == 2);
+		CHECK(checkpoint[1].eventNanos == 6 * MasterClock::NANOS_PER_SECOND);
+		CHECK(checkpoint[2].eventIx == 4);
+		CHECK(checkpoint[2].eventNanos == 11 * MasterClock::NANOS_PER_SECOND);
+		CHECK(checkpoint[3].eventIx == 8);
+		CHECK(checkpoint[3].eventNanos == 16 * MasterClock::NANOS_PER_SECOND);
+	}
+
+	SUBCASE("Tempo") {
+		// The tempo event at a checkpoint is yet to be played.
+		CHECK(checkpoint[0].tempo == 0);
+		CHECK(checkpoint[1].tempo == 0);
+		CHECK(checkpoint[2].tempo == MidiStreamSource::DEFAULT_TEMPO / 2);
+		CHECK(checkpoint[3].tempo == MidiStreamSource::DEFAULT_TEMPO / 2);
+	}
+
+	SUBCASE("Controller messages") {
+		CHECK(checkpoint[0].controllerMessages.isEmpty());
+		REQUIRE(checkpoint[1].controllerMessages.size() == 1);
+		CHECK(checkpoint[1].controllerMessages.at(0) == PITCH_BEND_MSG);
+		REQUIRE(checkpoint[2].controllerMessages.size() == 2);
+		CHECK(checkpoint[2].controllerMessages.at(0) == PITCH_BEND_MSG);
+		CHECK(checkpoint[2].controllerMessages.at(1) == MODULATION_MSG);
+		// The modulation is reset on channel 2 only.
+		REQUIRE(checkpoint[3].controllerMessages.size() == 1);
+		CHECK(checkpoint[3].controllerMessages.at(0) == PITCH_BEND_MSG);
+	}
+
+	SUBCASE("SysEx bank") {
+		// The SysEx bank data is shared until the synth memory changes.
+		CHECK_FALSE(checkpoint[0].sysexBank.isEmpty());
+		CHECK(checkpoint[1].sysexBank.constData() == checkpoint[0].sysexBank.constData());
+		CHECK(checkpoint[2].sysexBank.constData() == checkpoint[0].sysexBank.constData());
+		CHECK(checkpoint[3].sysexBank != checkpoint[2].sysexBank);
+		CHECK(getMasterVolume(checkpoint[2].sysexBank) != MASTER_VOLUME);
+		CHECK(getMasterVolume(checkpoint[3].sysexBank) == MASTER_VOLUME);
+	}
+}
+
+TEST_CASE("SMFCheckpoints should find the latest checkpoint at or before the position") {
+	TestStreamSource stream;
+	makeTestStream(stream);
+	SMFCheckpoints checkpoints;
+	SMFCheckpoint checkpoint;
+	CHECK_FALSE(checkpoints.findCheckpoint(0, checkpoint));
+
+	computeCheckpoints(checkpoints, stream);
+
+	CHECK_FALSE(checkpoints.findCheckpoint(-1, checkpoint));
+	REQUIRE(checkpoints.findCheckpoint(0, checkpoint));
+	CHECK(checkpoint.eventIx == 0);
+	REQUIRE(checkpoints.findCheckpoint(6 * MasterClock::NANOS_PER_SECOND - 1, checkpoint));
+	CHECK(checkpoint.eventIx == 0);
+	REQUIRE(checkpoints.findCheckpoint(6 * MasterClock::NANOS_PER_SECOND, checkpoint));
+	CHECK(checkpoint.eventIx == 2);
+	REQUIRE(checkpoints.findCheckpoint(100 * MasterClock::NANOS_PER_SECOND, checkpoint));
+	CHECK(checkpoint.eventIx == 8);
+
+	checkpoints.clear();
+	CHECK(checkpoints.getCount() == 0);
+	CHECK_FALSE(checkpoints.findCheckpoint(100 * MasterClock::NANOS_PER_SECOND, checkpoint));
+}
+
+TEST_CASE("SMFCheckpoints should not be computed once stopped until cleared") {
+	TestStreamSource stream;
+	makeTestStream(stream);
+	SMFCheckpoints checkpoints;
+	Synth drySynth;
+	REQUIRE(openSynth(drySynth));
+	checkpoints.stop();
+	CHECK_FALSE(checkpoints.compute(drySynth, stream));
+	CHECK(checkpoints.getCount() == 0);
+
+	checkpoints.clear();
+	CHECK(checkpoints.compute(drySynth, stream));
+	CHECK(checkpoints.getCount() == 4);
+	drySynth.close();
+}
@@ -25,6 +25,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <limits>
 
 #include <glib.h>
 
@@ -35,7 +36,7 @@
 #error Incompatible glib2 library version
 #endif
 
-#if !MT32EMU_IS_COMPATIBLE(2, 7)
+#if !MT32EMU_IS_COMPATIBLE(2, 8)
 #error Incompatible mt32emu library version
 #endif
 
@@ -45,10 +46,18 @@
 
 #include "smf.h"
 
+#include "FLACEncoder.h"
+
 static const int DEFAULT_BUFFER_SIZE = 128 * 1024;
 
-// Maximum number of frames to render in each pass while waiting for reverb to become inactive.
-static const unsigned int MAX_REVERB_END_FRAMES = 8192;
+// Size in bytes of the block of encoded samples accumulated before it is written to the output file.
+static const unsigned int OUTPUT_BUFFER_SIZE = 64 * 1024;
+
+// Number of samples checked for silence at once, so that the compiler can vectorise the check.
+static const unsigned int SILENCE_CHECK_BLOCK_SIZE = 16;
+
+// Number of output buffer blocks that may be queued for the FLAC encoder thread.
+static const unsigned int FLAC_QUEUE_LENGTH = 16;
 
 static const int HEADEROFFS_RIFFLEN = 4;
 static const int HEADEROFFS_FORMAT_TAG = 20;
@@ -92,11 +101,15 @@ static const MT32Emu::SamplerateConversionQuality SRC_QUALITIES[] = {
 struct Options {
 	gchar **inputFilenames;
 	gchar *outputFilename;
+	bool flacOutput;
 	gboolean force;
 	gboolean quiet;
+	gboolean dryRun;
 
 	gchar *romDir;
 	gchar *machineID;
+	gboolean romSHA1Sidecars;
+	gchar *romIndexFilename;
 	unsigned int bufferFrameCount;
 	gint sampleRate;
 	OUTPUT_SAMPLE_FORMAT outputSampleFormat;
@@ -122,6 +135,70 @@ struct Options {
 	gboolean nicePartialMixing;
 };
 
+// Passes the filled blocks of the output buffer to the FLAC encoder thread via a single-producer single-consumer
+// queue. The blocks contain interleaved 16-bit samples in native byte order. Only the queue state is guarded
+// by the mutex, the blocks themselves are accessed without locking.
+struct FLACOutput {
+	FLACEncoder *encoder;
+	FILE *outputFile;
+	GThread *thread;
+	unsigned int frameSize;
+	MT32Emu::Bit16s *blocks[FLAC_QUEUE_LENGTH];
+	unsigned int blockByteCounts[FLAC_QUEUE_LENGTH];
+	GMutex mutex;
+	// Signalled whenever a block is queued or consumed, or the state of the encoding changes otherwise.
+	GCond queueChanged;
+	unsigned int writeIx;
+	unsigned int queuedBlockCount;
+	bool finishRequested;
+	bool failed;
+};
+
+// Counts the notes that the emulator failed to play due to insufficient partials during a dry run.
+class DryRunReportHandler : public MT32Emu::IReportHandlerV2 {
+public:
+	unsigned int ignoredNoteOnCount;
+	unsigned int silencedPolyCount;
+	// Suppresses the debug and LCD messages.
+	bool quiet;
+
+	DryRunReportHandler() : ignoredNoteOnCount(0), silencedPolyCount(0), quiet(false) {}
+
+	void printDebug(const char *fmt, va_list list) {
+		if (quiet) return;
+		vprintf(fmt, list);
+		printf("\n");
+	}
+
+	void showLCDMessage(const char *message) {
+		if (quiet) return;
+		printf("WRITE-LCD: %s\n", message);
+	}
+
+	void onErrorControlROM() {}
+	void onErrorPCMROM() {}
+	void onMIDIMessagePlayed() {}
+	bool onMIDIQueueOverflow() { return false; }
+	void onMIDISystemRealtime(MT32Emu::Bit8u) {}
+	void onDeviceReset() {}
+	void onDeviceReconfig() {}
+	void onNewReverbMode(MT32Emu::Bit8u) {}
+	void onNewReverbTime(MT32Emu::Bit8u) {}
+	void onNewReverbLevel(MT32Emu::Bit8u) {}
+	void onPolyStateChanged(MT32Emu::Bit8u) {}
+	void onProgramChanged(MT32Emu::Bit8u, const char *, const char *) {}
+	void onLCDStateUpdated() {}
+	void onMidiMessageLEDStateUpdated(bool) {}
+
+	void onNoteOnIgnored(MT32Emu::Bit32u, MT32Emu::Bit32u) {
+		ignoredNoteOnCount++;
+	}
+
+	void onPlayingPolySilenced(MT32Emu::Bit32u, MT32Emu::Bit32u) {
+		silencedPolyCount++;
+	}
+};
+
 struct State {
 	void *stereoSampleBuffer;
 	void *rawSampleBuffer[6];
@@ -132,6 +209,9 @@ struct State {
 	unsigned long unwrittenSilentFrames;
 	unsigned long renderedFrames;
 	unsigned long writtenFrames;
+	unsigned char *outputBuffer;
+	unsigned int outputBufferUsed;
+	FLACOutput *flacOutput;
 };
 
 static void freeOptions(Options *options) {
@@ -143,6 +223,8 @@ static void freeOptions(Options *options) {
 	options->machineID = NULL;
 	g_free(options->romDir);
 	options->romDir = NULL;
+	g_free(options->romIndexFilename);
+	options->romIndexFilename = NULL;
 }
 
 static bool parseOptions(int argc, char *argv[], Options *options) {
@@ -159,11 +241,15 @@ static bool parseOptions(int argc, char *argv[], Options *options) {
 	gchar *deprecatedSysexFile = NULL;
 	options->inputFilenames = NULL;
 	options->outputFilename = NULL;
+	options->flacOutput = false;
 	options->force = false;
 	options->quiet = false;
+	options->dryRun = false;
 
 	options->romDir = NULL;
 	options->machineID = NULL;
+	options->romSHA1Sidecars = false;
+	options->romIndexFilename = NULL;
 
 	options->dacInputMode = DAC_INPUT_MODES[0];
 	options->analogOutputMode = ANALOG_OUTPUT_MODES[0];
@@ -184,9 +270,12 @@ static bool parseOptions(int argc, char *argv[], Options *options) {
 	options->nicePartialMixing = false;
 	// FIXME: Perhaps there's a nicer way to represent long argument descriptions...
 	GOptionEntry entries[] = {
-		{"output", 'o', 0, G_OPTION_ARG_FILENAME, &options->outputFilename, "Output file (default: last source file name with \".wav\" appended)", "<filename>"},
+		{"output", 'o', 0, G_OPTION_ARG_FILENAME, &options->outputFilename, "Output file (default: last source file name with \".wav\" appended)\n"
+		 "                The output is compressed to FLAC if the file name ends with \".flac\"", "<filename>"},
 		{"force", 'f', 0, G_OPTION_ARG_NONE, &options->force, "Overwrite the output file if it already exists", NULL},
 		{"quiet", 'q', 0, G_OPTION_ARG_NONE, &options->quiet, "Be quiet", NULL},
+		{"dry-run", 'n', 0, G_OPTION_ARG_NONE, &options->dryRun, "Play the files through the emulator as fast as possible without synthesising audio and writing an output file.\n"
+		 "                Reports the notes that would fail to play due to insufficient partials", NULL},
 
 		{"rom-dir", 'm', 0, G_OPTION_ARG_STRING, &options->romDir, "Directory in which ROMs are stored", "<directory>"},
 		{"machine-id", 'i', 0, G_OPTION_ARG_STRING, &options->machineID, "ID of machine configuration to search ROMs for (default: any)\n"
@@ -205,6 +294,10 @@ static bool parseOptions(int argc, char *argv[], Options *options) {
 		 "                 cm32l_1_00: CM-32L / LAPC-I with control ROM version 1.00\n"
 		 "                 cm32l_1_02: CM-32L / LAPC-I with control ROM version 1.02\n"
 		 "                 cm32ln_1_00: CM-32LN / CM-500 / LAPC-N with control ROM version 1.00", "<machine_id>"},
+		{"rom-sha1-sidecars", 0, 0, G_OPTION_ARG_NONE, &options->romSHA1Sidecars, "Trust SHA1 digests of ROM files stored in <rom_file>.sha1 sidecar files\n"
+		 "                rather than computing them when identifying ROMs", NULL},
+		{"rom-index", 0, 0, G_OPTION_ARG_FILENAME, &options->romIndexFilename, "File to cache SHA1 digests of ROM files in, so that only new or changed ROM files\n"
+		 "                are hashed when identifying ROMs. The file is created if it doesn't exist", "<filename>"},
 		// buffer-size determines the maximum number of frames to be rendered by the emulator in one pass.
 		// This can have a big impact on performance (Generally more at a time=better).
 		{"buffer-size", 'b', 0, G_OPTION_ARG_INT, &bufferFrameCount, "Buffer size in frames (minimum: 1)", "<frame_count>"},  // FIXME: Show default
@@ -292,6 +385,11 @@ static bool parseOptions(int argc, char *argv[], Options *options) {
 		fprintf(stderr, "output-sample-format must be either 0 or 1\n");
 		parseSuccess = false;
 	}
+	options->flacOutput = options->outputFilename != NULL && g_str_has_suffix(options->outputFilename, ".flac");
+	if (options->flacOutput && outputSampleFormat != OUTPUT_SAMPLE_FORMAT_SINT16) {
+		fprintf(stderr, "FLAC output requires output-sample-format 0\n");
+		parseSuccess = false;
+	}
 	if (srcQualityIx < 0 || srcQualityIx > 3) {
 		fprintf(stderr, "src-quality must be between 0 and 3\n");
 		parseSuccess = false;
@@ -359,6 +457,11 @@ static bool parseOptions(int argc, char *argv[], Options *options) {
 	options->outputSampleFormat = static_cast<OUTPUT_SAMPLE_FORMAT>(outputSampleFormat);
 	options->srcQuality = SRC_QUALITIES[srcQualityIx];
 	g_strfreev(rawStreams);
+	if (options->dryRun) {
+		// Fast-forwarding proceeds at the native sample rate.
+		options->analogOutputMode = MT32Emu::AnalogOutputMode_DIGITAL_ONLY;
+		options->sampleRate = 0;
+	}
 	if (options->rawChannelCount > 0) {
 		options->dacInputMode = MT32Emu::DACInputMode_PURE;
 		options->analogOutputMode = MT32Emu::AnalogOutputMode_DIGITAL_ONLY;
@@ -487,6 +590,151 @@ enum Occasion {
 	LA32_INACTIVE
 };
 
+enum RenderMode {
+	// Render exactly the requested number of frames.
+	RENDER_ALL,
+	// Stop right after the frame where the last active partial has ended.
+	RENDER_WHILE_PARTIALS_ACTIVE,
+	// Stop once the synth becomes inactive, i.e. the reverb tail has decayed as well.
+	RENDER_WHILE_ACTIVE
+};
+
+static bool writeFLACEncoderOutput(FLACOutput &flacOutput) {
+	const unsigned int outputSize = flacOutput.encoder->getOutputSize();
+	if (outputSize > 0 && fwrite(flacOutput.encoder->getOutput(), 1, outputSize, flacOutput.outputFile) != outputSize) {
+		g_mutex_lock(&flacOutput.mutex);
+		flacOutput.failed = true;
+		g_cond_signal(&flacOutput.queueChanged);
+		g_mutex_unlock(&flacOutput.mutex);
+		return false;
+	}
+	flacOutput.encoder->clearOutput();
+	return true;
+}
+
+static gpointer runFLACEncoder(gpointer data) {
+	FLACOutput &flacOutput = *static_cast<FLACOutput *>(data);
+	unsigned int readIx = 0;
+	for (;;) {
+		g_mutex_lock(&flacOutput.mutex);
+		while (flacOutput.queuedBlockCount == 0 && !flacOutput.finishRequested) {
+			g_cond_wait(&flacOutput.queueChanged, &flacOutput.mutex);
+		}
+		// All the blocks are queued before the finish request, so the queue is drained first.
+		bool finished = flacOutput.queuedBlockCount == 0;
+		g_mutex_unlock(&flacOutput.mutex);
+		if (finished) break;
+
+		flacOutput.encoder->addFrames(flacOutput.blocks[readIx], flacOutput.blockByteCounts[readIx] / flacOutput.frameSize);
+		readIx = (readIx + 1) % FLAC_QUEUE_LENGTH;
+		g_mutex_lock(&flacOutput.mutex);
+		flacOutput.queuedBlockCount--;
+		g_cond_signal(&flacOutput.queueChanged);
+		g_mutex_unlock(&flacOutput.mutex);
+		if (!writeFLACEncoderOutput(flacOutput)) return NULL;
+	}
+	flacOutput.encoder->finish();
+	writeFLACEncoderOutput(flacOutput);
+	return NULL;
+}
+
+static FLACOutput *startFLACOutput(FILE *outputFile, const Options &options) {
+	const unsigned int channelCount = options.rawChannelCount > 0 ? options.rawChannelCount : 2;
+	FLACOutput *flacOutput = new FLACOutput;
+	flacOutput->encoder = new FLACEncoder(options.sampleRate, channelCount);
+	unsigned char streamHeader[FLACEncoder::STREAM_HEADER_SIZE];
+	flacOutput->encoder->makeStreamHeader(streamHeader);
+	if (fwrite(streamHeader, 1, sizeof(streamHeader), outputFile) != sizeof(streamHeader)) {
+		delete flacOutput->encoder;
+		delete flacOutput;
+		return NULL;
+	}
+	flacOutput->outputFile = outputFile;
+	flacOutput->frameSize = channelCount * sizeof(MT32Emu::Bit16s);
+	for (unsigned int blockIx = 0; blockIx < FLAC_QUEUE_LENGTH; blockIx++) {
+		flacOutput->blocks[blockIx] = new MT32Emu::Bit16s[OUTPUT_BUFFER_SIZE / sizeof(MT32Emu::Bit16s)];
+	}
+	g_mutex_init(&flacOutput->mutex);
+	g_cond_init(&flacOutput->queueChanged);
+	flacOutput->writeIx = 0;
+	flacOutput->queuedBlockCount = 0;
+	flacOutput->finishRequested = false;
+	flacOutput->failed = false;
+	flacOutput->thread = g_thread_new("FLAC encoder", runFLACEncoder, flacOutput);
+	return flacOutput;
+}
+
+// Waits for the encoder thread to process the queued blocks, then rewrites the stream header that is now complete.
+static bool finishFLACOutput(FLACOutput *flacOutput) {
+	g_mutex_lock(&flacOutput->mutex);
+	flacOutput->finishRequested = true;
+	g_cond_signal(&flacOutput->queueChanged);
+	g_mutex_unlock(&flacOutput->mutex);
+	g_thread_join(flacOutput->thread);
+	g_cond_clear(&flacOutput->queueChanged);
+	g_mutex_clear(&flacOutput->mutex);
+	bool success = !flacOutput->failed;
+	if (success) {
+		unsigned char streamHeader[FLACEncoder::STREAM_HEADER_SIZE];
+		flacOutput->encoder->makeStreamHeader(streamHeader);
+		success = fseek(flacOutput->outputFile, 0, SEEK_SET) == 0
+			&& fwrite(streamHeader, 1, sizeof(streamHeader), flacOutput->outputFile) == sizeof(streamHeader);
+	}
+	for (unsigned int blockIx = 0; blockIx < FLAC_QUEUE_LENGTH; blockIx++) {
+		delete[] flacOutput->blocks[blockIx];
+	}
+	delete flacOutput->encoder;
+	delete flacOutput;
+	return success;
+}
+
+// Queues the filled block for the FLAC encoder thread and continues with the next free one.
+static void queueFLACBlock(State &state) {
+	FLACOutput &flacOutput = *state.flacOutput;
+	flacOutput.blockByteCounts[flacOutput.writeIx] = state.outputBufferUsed;
+	flacOutput.writeIx = (flacOutput.writeIx + 1) % FLAC_QUEUE_LENGTH;
+	g_mutex_lock(&flacOutput.mutex);
+	flacOutput.queuedBlockCount++;
+	g_cond_signal(&flacOutput.queueChanged);
+	// Once the encoder thread failed, the blocks are no longer in use.
+	while (flacOutput.queuedBlockCount == FLAC_QUEUE_LENGTH && !flacOutput.failed) {
+		g_cond_wait(&flacOutput.queueChanged, &flacOutput.mutex);
+	}
+	g_mutex_unlock(&flacOutput.mutex);
+	state.outputBuffer = reinterpret_cast<unsigned char *>(flacOutput.blocks[flacOutput.writeIx]);
+}
+
+static void flushOutputBuffer(State &state) {
+	if (state.outputBufferUsed > 0) {
+		if (state.flacOutput != NULL) {
+			queueFLACBlock(state);
+		} else {
+			fwrite(state.outputBuffer, 1, state.outputBufferUsed, state.outputFile);
+		}
+		state.outputBufferUsed = 0;
+	}
+}
+
+// Returns a pointer to byteCount bytes of free space in the output buffer, flushing the buffer beforehand if necessary.
+static inline unsigned char *reserveOutputBuffer(State &state, const unsigned int byteCount) {
+	if (state.outputBufferUsed + byteCount > OUTPUT_BUFFER_SIZE) {
+		flushOutputBuffer(state);
+	}
+	unsigned char *data = state.outputBuffer + state.outputBufferUsed;
+	state.outputBufferUsed += byteCount;
+	return data;
+}
+
+// Writes the frames in chunks of whole frames, so that each flushed block of the output buffer contains complete frames.
+static void writeZeros(State &state, unsigned long frameCount, const unsigned int frameSize) {
+	const unsigned int maxChunkFrames = OUTPUT_BUFFER_SIZE / frameSize;
+	while (frameCount > 0) {
+		unsigned int chunkFrames = frameCount < maxChunkFrames ? static_cast<unsigned int>(frameCount) : maxChunkFrames;
+		memset(reserveOutputBuffer(state, chunkFrames * frameSize), 0, chunkFrames * frameSize);
+		frameCount -= chunkFrames;
+	}
+}
+
 static void flushSilence(Occasion occasion, const Options &options, State &state) {
 	unsigned int channelCount = options.rawChannelCount > 0 ? options.rawChannelCount : 2;
 	int writtenFrames = state.unwrittenSilentFrames;
@@ -508,21 +756,36 @@ static void flushSilence(Occasion occasion, const Options &options, State &state
 		break;
 	}
 	const int sampleSize = options.outputSampleFormat == OUTPUT_SAMPLE_FORMAT_IEEE_FLOAT32 ? 4 : 2;
-	for (unsigned long i = 0; i < writtenFrames * sampleSize * channelCount; i++) {
-		fputc(0, state.outputFile);
-	}
+	writeZeros(state, writtenFrames, sampleSize * channelCount);
 	state.writtenFrames += writtenFrames;
 }
 
-static inline void renderStereo(MT32Emu::Service &service, void *stereoSampleBuffer, const unsigned int frameCount, const OUTPUT_SAMPLE_FORMAT outputSampleFormat) {
+static inline unsigned int renderStereo(MT32Emu::Service &service, void *stereoSampleBuffer, const unsigned int frameCount, const OUTPUT_SAMPLE_FORMAT outputSampleFormat, const RenderMode renderMode) {
 	if (outputSampleFormat == OUTPUT_SAMPLE_FORMAT_IEEE_FLOAT32) {
-		service.renderFloat(static_cast<float *>(stereoSampleBuffer), frameCount);
-	} else {
-		service.renderBit16s(static_cast<MT32Emu::Bit16s *>(stereoSampleBuffer), frameCount);
+		float *stream = static_cast<float *>(stereoSampleBuffer);
+		switch (renderMode) {
+		case RENDER_WHILE_PARTIALS_ACTIVE:
+			return service.renderFloatWhilePartialsActive(stream, frameCount);
+		case RENDER_WHILE_ACTIVE:
+			return service.renderFloatWhileActive(stream, frameCount);
+		default:
+			service.renderFloat(stream, frameCount);
+			return frameCount;
+		}
+	}
+	MT32Emu::Bit16s *stream = static_cast<MT32Emu::Bit16s *>(stereoSampleBuffer);
+	switch (renderMode) {
+	case RENDER_WHILE_PARTIALS_ACTIVE:
+		return service.renderBit16sWhilePartialsActive(stream, frameCount);
+	case RENDER_WHILE_ACTIVE:
+		return service.renderBit16sWhileActive(stream, frameCount);
+	default:
+		service.renderBit16s(stream, frameCount);
+		return frameCount;
 	}
 }
 
-static inline void renderRaw(MT32Emu::Service &service, void *rawSampleBuffer[], const unsigned int frameCount, const OUTPUT_SAMPLE_FORMAT outputSampleFormat) {
+static inline unsigned int renderRaw(MT32Emu::Service &service, void *rawSampleBuffer[], const unsigned int frameCount, const OUTPUT_SAMPLE_FORMAT outputSampleFormat, const RenderMode renderMode) {
 	if (outputSampleFormat == OUTPUT_SAMPLE_FORMAT_IEEE_FLOAT32) {
 		mt32emu_dac_output_float_streams streams = {
 			static_cast<float *>(rawSampleBuffer[0]),
@@ -532,7 +795,15 @@ static inline void renderRaw(MT32Emu::Service &service, void *rawSampleBuffer[],
 			static_cast<float *>(rawSampleBuffer[4]),
 			static_cast<float *>(rawSampleBuffer[5])
 		};
-		service.renderFloatStreams(&streams, frameCount);
+		switch (renderMode) {
+		case RENDER_WHILE_PARTIALS_ACTIVE:
+			return service.renderFloatStreamsWhilePartialsActive(&streams, frameCount);
+		case RENDER_WHILE_ACTIVE:
+			return service.renderFloatStreamsWhileActive(&streams, frameCount);
+		default:
+			service.renderFloatStreams(&streams, frameCount);
+			return frameCount;
+		}
 	} else {
 		mt32emu_dac_output_bit16s_streams streams = {
 			static_cast<MT32Emu::Bit16s *>(rawSampleBuffer[0]),
@@ -542,19 +813,44 @@ static inline void renderRaw(MT32Emu::Service &service, void *rawSampleBuffer[],
 			static_cast<MT32Emu::Bit16s *>(rawSampleBuffer[4]),
 			static_cast<MT32Emu::Bit16s *>(rawSampleBuffer[5])
 		};
-		service.renderBit16sStreams(&streams, frameCount);
+		switch (renderMode) {
+		case RENDER_WHILE_PARTIALS_ACTIVE:
+			return service.renderBit16sStreamsWhilePartialsActive(&streams, frameCount);
+		case RENDER_WHILE_ACTIVE:
+			return service.renderBit16sStreamsWhileActive(&streams, frameCount);
+		default:
+			service.renderBit16sStreams(&streams, frameCount);
+			return frameCount;
+		}
 	}
 }
 
-static inline bool isSilence(void * const sampleBuffer, const int sampleIx, const OUTPUT_SAMPLE_FORMAT outputSampleFormat) {
-	if (outputSampleFormat == OUTPUT_SAMPLE_FORMAT_IEEE_FLOAT32) {
-		return static_cast<float *>(sampleBuffer)[sampleIx] == 0;
-	} else {
-		return static_cast<MT32Emu::Bit16s *>(sampleBuffer)[sampleIx] == 0;
+// Returns the number of leading samples in the buffer that are exactly zero.
+template <class Sample>
+static unsigned int countSilentSamples(const Sample *samples, const unsigned int sampleCount) {
+	unsigned int sampleIx = 0;
+	while (sampleIx + SILENCE_CHECK_BLOCK_SIZE <= sampleCount) {
+		bool silent = true;
+		for (unsigned int i = 0; i < SILENCE_CHECK_BLOCK_SIZE; i++) {
+			silent &= samples[sampleIx + i] == 0;
+		}
+		if (!silent) break;
+		sampleIx += SILENCE_CHECK_BLOCK_SIZE;
+	}
+	while (sampleIx < sampleCount && samples[sampleIx] == 0) {
+		sampleIx++;
 	}
+	return sampleIx;
 }
 
 static inline MT32Emu::Bit32u makeIeeeFloat(float sample) {
+	if (std::numeric_limits<float>::is_iec559) {
+		MT32Emu::Bit32u floatBits;
+		memcpy(&floatBits, &sample, sizeof floatBits);
+		// In this context, all the denormals, INFs and NaNs are treated as silence. This also turns -0 into +0.
+		MT32Emu::Bit32u exp = (floatBits >> 23) & 0xFF;
+		return (exp == 0 || exp == 0xFF) ? 0 : floatBits;
+	}
 	MT32Emu::Bit32u floatBits = 0;
 	// In this context, all the denormals, INFs and NaNs are treated as silence.
 	if (sample == sample && sample != 0 && fabs(sample) <= FLT_MAX) {
@@ -572,96 +868,212 @@ static inline MT32Emu::Bit32u makeIeeeFloat(float sample) {
 	return floatBits;
 }
 
-static inline void putSampleLE(void * const sampleBuffer, const int sampleIx, FILE *outputFile, const OUTPUT_SAMPLE_FORMAT outputSampleFormat) {
-	if (outputSampleFormat == OUTPUT_SAMPLE_FORMAT_IEEE_FLOAT32) {
-		MT32Emu::Bit32u sample = makeIeeeFloat(static_cast<float *>(sampleBuffer)[sampleIx]);
-		fputc(sample & 0xFF, outputFile);
-		fputc((sample >> 8) & 0xFF, outputFile);
-		fputc((sample >> 16) & 0xFF, outputFile);
-		fputc((sample >> 24) & 0xFF, outputFile);
-	} else {
-		MT32Emu::Bit16s sample = static_cast<MT32Emu::Bit16s *>(sampleBuffer)[sampleIx];
-		fputc(sample & 0xFF, outputFile);
-		fputc((sample >> 8) & 0xFF, outputFile);
+static inline MT32Emu::Bit32u getSampleBits(const MT32Emu::Bit16s sample) {
+	return MT32Emu::Bit16u(sample);
+}
+
+static inline MT32Emu::Bit32u getSampleBits(const float sample) {
+	return makeIeeeFloat(sample);
+}
+
+template <class Sample>
+static inline unsigned char *putSampleLE(unsigned char *out, const Sample sample) {
+	MT32Emu::Bit32u sampleBits = getSampleBits(sample);
+	for (unsigned int i = 0; i < sizeof(Sample); i++) {
+		out[i] = sampleBits & 0xFF;
+		sampleBits >>= 8;
 	}
+	return out + sizeof(Sample);
 }
 
-static inline void putSampleBE(void * const sampleBuffer, const int sampleIx, FILE *outputFile, const OUTPUT_SAMPLE_FORMAT outputSampleFormat) {
-	if (outputSampleFormat == OUTPUT_SAMPLE_FORMAT_IEEE_FLOAT32) {
-		MT32Emu::Bit32u sample = makeIeeeFloat(static_cast<float *>(sampleBuffer)[sampleIx]);
-		fputc((sample >> 24) & 0xFF, outputFile);
-		fputc((sample >> 16) & 0xFF, outputFile);
-		fputc((sample >> 8) & 0xFF, outputFile);
-		fputc(sample & 0xFF, outputFile);
-	} else {
-		MT32Emu::Bit16s sample = static_cast<MT32Emu::Bit16s *>(sampleBuffer)[sampleIx];
-		fputc((sample >> 8) & 0xFF, outputFile);
-		fputc(sample & 0xFF, outputFile);
+template <class Sample>
+static inline unsigned char *putSampleBE(unsigned char *out, const Sample sample) {
+	MT32Emu::Bit32u sampleBits = getSampleBits(sample);
+	for (unsigned int i = sizeof(Sample); i > 0; i--) {
+		out[i - 1] = sampleBits & 0xFF;
+		sampleBits >>= 8;
 	}
+	return out + sizeof(Sample);
 }
 
-static void renderStereo(unsigned int frameCount, const Options &options, State &state) {
-	state.renderedFrames += frameCount;
-	while (frameCount > 0) {
-		unsigned int renderedFramesThisPass = MIN(frameCount, options.bufferFrameCount);
-		renderStereo(state.service, state.stereoSampleBuffer, renderedFramesThisPass, options.outputSampleFormat);
-		for (unsigned int i = 0; i < renderedFramesThisPass; i++) {
-			unsigned int leftIx = i * 2;
-			unsigned int rightIx = leftIx + 1;
-			bool silent = isSilence(state.stereoSampleBuffer, leftIx, options.outputSampleFormat)
-				&& isSilence(state.stereoSampleBuffer, rightIx, options.outputSampleFormat);
-			if (silent) {
-				state.unwrittenSilentFrames++;
-				continue;
+// Encodes a run of stereo frames in bulk, filling the output buffer in as large blocks as possible.
+template <class Sample>
+static void writeStereoFrames(const Sample *frames, const unsigned int frameCount, State &state) {
+	const unsigned int frameSize = 2 * sizeof(Sample);
+	unsigned int frameIx = 0;
+	while (frameIx < frameCount) {
+		unsigned int framesThisPass = MIN(frameCount - frameIx, OUTPUT_BUFFER_SIZE / frameSize);
+		unsigned char *out = reserveOutputBuffer(state, framesThisPass * frameSize);
+		const Sample *samples = frames + 2 * frameIx;
+		if (state.flacOutput != NULL) {
+			// The FLAC encoder consumes samples in native byte order.
+			memcpy(out, samples, framesThisPass * frameSize);
+		} else {
+			for (unsigned int sampleIx = 0; sampleIx < 2 * framesThisPass; sampleIx++) {
+				out = putSampleLE(out, samples[sampleIx]);
 			}
-			flushSilence(NOISE_DETECTED, options, state);
-			putSampleLE(state.stereoSampleBuffer, leftIx, state.outputFile, options.outputSampleFormat);
-			putSampleLE(state.stereoSampleBuffer, rightIx, state.outputFile, options.outputSampleFormat);
-			state.writtenFrames++;
 		}
-		frameCount -= renderedFramesThisPass;
+		frameIx += framesThisPass;
 	}
 }
 
-static void renderRaw(unsigned int frameCount, const Options &options, State &state) {
-	state.renderedFrames += frameCount;
-	while (frameCount > 0) {
-		unsigned int renderedFramesThisPass = MIN(frameCount, options.bufferFrameCount);
-		renderRaw(state.service, state.rawSampleBuffer, renderedFramesThisPass, options.outputSampleFormat);
-		for (unsigned int i = 0; i < renderedFramesThisPass; i++) {
-			bool allSilent = true;
-			for (int chanMapIx = 0; chanMapIx < options.rawChannelCount; chanMapIx++) {
-				if (options.rawChannelMap[chanMapIx] >= 0 && !isSilence(state.rawSampleBuffer[options.rawChannelMap[chanMapIx]], i, options.outputSampleFormat)) {
-					allSilent = false;
-					break;
+template <class Sample>
+static void writeStereo(const Sample *buffer, const unsigned int frameCount, const Options &options, State &state) {
+	unsigned int frameIx = 0;
+	while (frameIx < frameCount) {
+		// A frame is only silent when both the samples are zero, so an odd count means the last frame isn't.
+		unsigned int silentFrameCount = countSilentSamples(buffer + 2 * frameIx, 2 * (frameCount - frameIx)) >> 1;
+		state.unwrittenSilentFrames += silentFrameCount;
+		frameIx += silentFrameCount;
+		if (frameIx == frameCount) break;
+		unsigned int noiseEndIx = frameIx + 1;
+		while (noiseEndIx < frameCount && (buffer[2 * noiseEndIx] != 0 || buffer[2 * noiseEndIx + 1] != 0)) {
+			noiseEndIx++;
+		}
+		flushSilence(NOISE_DETECTED, options, state);
+		writeStereoFrames(buffer + 2 * frameIx, noiseEndIx - frameIx, state);
+		state.writtenFrames += noiseEndIx - frameIx;
+		frameIx = noiseEndIx;
+	}
+}
+
+static inline bool isNativeByteOrderBE() {
+	const MT32Emu::Bit16u probe = 0x0100;
+	return *reinterpret_cast<const unsigned char *>(&probe) != 0;
+}
+
+// Samples can be copied verbatim into the raw output when the native byte order is big-endian. This doesn't apply to floats
+// since they need to be sanitised anyway.
+static inline bool canCopySamplesBE(const MT32Emu::Bit16s *) {
+	return isNativeByteOrderBE();
+}
+
+static inline bool canCopySamplesBE(const float *) {
+	return false;
+}
+
+// Interleaves a run of frames from the mapped channels into the output buffer, filling it in as large blocks as possible.
+template <class Sample>
+static void writeRawFrames(const Sample * const channels[], const int channelCount, const unsigned int startFrameIx, const unsigned int frameCount, State &state) {
+	const unsigned int frameSize = channelCount * sizeof(Sample);
+	const bool copySamples = state.flacOutput != NULL || canCopySamplesBE(channels[0]);
+	unsigned int frameIx = 0;
+	while (frameIx < frameCount) {
+		unsigned int framesThisPass = MIN(frameCount - frameIx, OUTPUT_BUFFER_SIZE / frameSize);
+		unsigned char *out = reserveOutputBuffer(state, framesThisPass * frameSize);
+		for (int chanMapIx = 0; chanMapIx < channelCount; chanMapIx++) {
+			unsigned char *channelOut = out + chanMapIx * sizeof(Sample);
+			const Sample *samples = channels[chanMapIx];
+			if (samples == NULL) {
+				for (unsigned int i = 0; i < framesThisPass; i++, channelOut += frameSize) {
+					memset(channelOut, 0, sizeof(Sample));
 				}
-			}
-			if (allSilent) {
-				state.unwrittenSilentFrames++;
 				continue;
 			}
-			flushSilence(NOISE_DETECTED, options, state);
-			for (int chanMapIx = 0; chanMapIx < options.rawChannelCount; chanMapIx++) {
-				if (options.rawChannelMap[chanMapIx] < 0) {
-					const int sampleSize = options.outputSampleFormat == OUTPUT_SAMPLE_FORMAT_IEEE_FLOAT32 ? 4 : 2;
-					for (int sampleIx = 0; sampleIx < sampleSize; sampleIx++) {
-						fputc(0, state.outputFile);
-					}
+			samples += startFrameIx + frameIx;
+			if (copySamples) {
+				// The FLAC encoder consumes samples in native byte order.
+				if (channelCount == 1) {
+					memcpy(channelOut, samples, framesThisPass * sizeof(Sample));
 				} else {
-					putSampleBE(state.rawSampleBuffer[options.rawChannelMap[chanMapIx]], i, state.outputFile, options.outputSampleFormat);
+					for (unsigned int i = 0; i < framesThisPass; i++, channelOut += frameSize) {
+						memcpy(channelOut, samples + i, sizeof(Sample));
+					}
+				}
+			} else {
+				for (unsigned int i = 0; i < framesThisPass; i++, channelOut += frameSize) {
+					putSampleBE(channelOut, samples[i]);
 				}
 			}
-			state.writtenFrames++;
 		}
+		frameIx += framesThisPass;
+	}
+}
+
+template <class Sample>
+static void writeRaw(const unsigned int frameCount, const Options &options, State &state) {
+	// Unmapped channels are represented by NULL and written as silence.
+	const Sample *channels[8];
+	const Sample *mappedChannels[8];
+	int mappedChannelCount = 0;
+	for (int chanMapIx = 0; chanMapIx < options.rawChannelCount; chanMapIx++) {
+		int streamIx = options.rawChannelMap[chanMapIx];
+		channels[chanMapIx] = streamIx < 0 ? NULL : static_cast<const Sample *>(state.rawSampleBuffer[streamIx]);
+		if (channels[chanMapIx] != NULL) mappedChannels[mappedChannelCount++] = channels[chanMapIx];
+	}
+	unsigned int frameIx = 0;
+	while (frameIx < frameCount) {
+		// A frame is only silent when the samples of all the mapped channels are zero.
+		unsigned int silentFrameCount = frameCount - frameIx;
+		for (int i = 0; i < mappedChannelCount && silentFrameCount > 0; i++) {
+			silentFrameCount = countSilentSamples(mappedChannels[i] + frameIx, silentFrameCount);
+		}
+		state.unwrittenSilentFrames += silentFrameCount;
+		frameIx += silentFrameCount;
+		if (frameIx == frameCount) break;
+		unsigned int noiseEndIx = frameIx + 1;
+		while (noiseEndIx < frameCount) {
+			bool silent = true;
+			for (int i = 0; i < mappedChannelCount; i++) {
+				silent &= mappedChannels[i][noiseEndIx] == 0;
+			}
+			if (silent) break;
+			noiseEndIx++;
+		}
+		flushSilence(NOISE_DETECTED, options, state);
+		writeRawFrames(channels, options.rawChannelCount, frameIx, noiseEndIx - frameIx, state);
+		state.writtenFrames += noiseEndIx - frameIx;
+		frameIx = noiseEndIx;
+	}
+}
+
+static void renderStereo(unsigned int frameCount, const Options &options, State &state, const RenderMode renderMode) {
+	while (frameCount > 0) {
+		unsigned int framesToRender = MIN(frameCount, options.bufferFrameCount);
+		unsigned int renderedFramesThisPass = renderStereo(state.service, state.stereoSampleBuffer, framesToRender, options.outputSampleFormat, renderMode);
+		state.renderedFrames += renderedFramesThisPass;
+		if (options.outputSampleFormat == OUTPUT_SAMPLE_FORMAT_IEEE_FLOAT32) {
+			writeStereo(static_cast<const float *>(state.stereoSampleBuffer), renderedFramesThisPass, options, state);
+		} else {
+			writeStereo(static_cast<const MT32Emu::Bit16s *>(state.stereoSampleBuffer), renderedFramesThisPass, options, state);
+		}
+		if (renderedFramesThisPass < framesToRender) break;
+		frameCount -= renderedFramesThisPass;
+	}
+}
+
+static void renderRaw(unsigned int frameCount, const Options &options, State &state, const RenderMode renderMode) {
+	while (frameCount > 0) {
+		unsigned int framesToRender = MIN(frameCount, options.bufferFrameCount);
+		unsigned int renderedFramesThisPass = renderRaw(state.service, state.rawSampleBuffer, framesToRender, options.outputSampleFormat, renderMode);
+		state.renderedFrames += renderedFramesThisPass;
+		if (options.outputSampleFormat == OUTPUT_SAMPLE_FORMAT_IEEE_FLOAT32) {
+			writeRaw<float>(renderedFramesThisPass, options, state);
+		} else {
+			writeRaw<MT32Emu::Bit16s>(renderedFramesThisPass, options, state);
+		}
+		if (renderedFramesThisPass < framesToRender) break;
 		frameCount -= renderedFramesThisPass;
 	}
 }
 
-static void render(unsigned int frameCount, const Options &options, State &state) {
-	if (options.rawChannelCount > 0) {
-		renderRaw(frameCount, options, state);
+static void fastForward(unsigned int frameCount, const Options &options, State &state) {
+	while (frameCount > 0) {
+		unsigned int framesThisPass = MIN(frameCount, options.bufferFrameCount);
+		state.service.fastForward(framesThisPass);
+		state.renderedFrames += framesThisPass;
+		frameCount -= framesThisPass;
+	}
+}
+
+static void render(unsigned int frameCount, const Options &options, State &state, const RenderMode renderMode = RENDER_ALL) {
+	if (options.dryRun) {
+		// Nothing can happen after the MIDI stream has ended that would be of interest without the audio output.
+		if (renderMode == RENDER_ALL) fastForward(frameCount, options, state);
+	} else if (options.rawChannelCount > 0) {
+		renderRaw(frameCount, options, state, renderMode);
 	} else {
-		renderStereo(frameCount, options, state);
+		renderStereo(frameCount, options, state, renderMode);
 	}
 }
 
@@ -767,26 +1179,14 @@ static void playSMF(smf_t *smf, const Options &options, State &state) {
 		render(options.renderMinFrames - state.renderedFrames, options, state);
 	}
 	if (options.waitForLA32) {
-		while (state.renderedFrames < options.renderMaxFrames && state.service.hasActivePartials()) {
-			// FIXME: Rendering one sample at a time is very inefficient, but it's important for
-			// some tests to be able to see the precise frame when partials become inactive.
-			// Perhaps we should add a renderWhilePartialsActive() to Synth
-			// or add a getter for "the minimum number of frames remaining with active partials if
-			// no further MIDI is sent". Which would make quite a function name.
-			render(1, options, state);
+		// The synth stops rendering at the precise frame when partials become inactive, which is important for some tests.
+		if (state.renderedFrames < options.renderMaxFrames) {
+			render(options.renderMaxFrames - state.renderedFrames, options, state, RENDER_WHILE_PARTIALS_ACTIVE);
 		}
 		flushSilence(LA32_INACTIVE, options, state);
-		if (options.waitForReverb) {
-			unsigned int reverbEndFrames = MIN(MAX_REVERB_END_FRAMES, options.bufferFrameCount);
-			while (state.renderedFrames < options.renderMaxFrames && state.service.isActive()) {
-				// Render a healthy number of frames while waiting for reverb to become inactive.
-				// Note that once we've detected inactivity, silent samples will not be written.
-				unsigned int renderLength = reverbEndFrames;
-				if (state.renderedFrames + renderLength > options.renderMaxFrames) {
-					renderLength = options.renderMaxFrames - state.renderedFrames;
-				}
-				render(renderLength, options, state);
-			}
+		if (options.waitForReverb && state.renderedFrames < options.renderMaxFrames) {
+			// Note that once we've detected inactivity, silent samples will not be written.
+			render(options.renderMaxFrames - state.renderedFrames, options, state, RENDER_WHILE_ACTIVE);
 		}
 	}
 	if (!state.service.isActive()) {
@@ -820,6 +1220,27 @@ static bool playFile(const gchar *inputFilename, const gchar *displayInputFilena
 	return false;
 }
 
+static void playFilesDry(MT32Emu::Service &service, const Options &options, DryRunReportHandler &reportHandler) {
+	State state = {NULL, {NULL, NULL, NULL, NULL, NULL, NULL}, service, NULL, false, false, 0, 0, 0, NULL, 0, NULL};
+	clock_t startTime = clock();
+	gchar **inputFilename = options.inputFilenames;
+	while (*inputFilename != NULL) {
+		char *inputFilenameUtf8 = g_filename_to_utf8(*inputFilename, strlen(*inputFilename), NULL, NULL, NULL);
+		char *inputFilenameLocale = g_locale_from_utf8(inputFilenameUtf8, strlen(inputFilenameUtf8), NULL, NULL, NULL);
+		state.lastInputFile = *(inputFilename + 1) == NULL;
+		reportHandler.ignoredNoteOnCount = 0;
+		reportHandler.silencedPolyCount = 0;
+		if (playFile(*inputFilename, inputFilenameLocale, options, state)) {
+			printf("%s: %u note(s) ignored, %u playing note(s) silenced due to insufficient partials\n", inputFilenameLocale,
+				reportHandler.ignoredNoteOnCount, reportHandler.silencedPolyCount);
+		}
+		inputFilename++;
+		g_free(inputFilenameLocale);
+		g_free(inputFilenameUtf8);
+	}
+	printf("Elapsed time: %f sec\n", float(clock() - startTime) / CLOCKS_PER_SEC);
+}
+
 static size_t matchMachineIDs(const char **&matchedMachineIDs, MT32Emu::Service &service, const char * const machineID) {
 	bool anyMachine = NULL == machineID || strcmp(machineID, "any") == 0;
 
@@ -882,7 +1303,8 @@ static void identifyControlROMs(MT32Emu::Service &service, const char *romDirNam
 		char *pathName = g_build_filename(romDirName, fileName, NULL);
 		char *pathNameUtf8 = g_filename_to_utf8(pathName, strlen(pathName), NULL, NULL, NULL);
 		char *pathNameLocale = g_locale_from_utf8(pathNameUtf8, strlen(pathNameUtf8), NULL, NULL, NULL);
-		if (MT32EMU_RC_OK == service.identifyROMFile(&rom_info, pathNameLocale, NULL) && rom_info.control_rom_id != NULL) {
+		// Makes use of the ROM index and SHA1 sidecars, if enabled.
+		if (MT32EMU_RC_OK == service.identifyROMFileUsingIndex(&rom_info, pathNameLocale, NULL) && rom_info.control_rom_id != NULL) {
 			g_hash_table_add(seenControlROMIDs, gpointer(rom_info.control_rom_id));
 		}
 		g_free(pathNameLocale);
@@ -926,6 +1348,11 @@ static bool loadROMs(MT32Emu::Service &service, const Options &options) {
 		return false;
 	}
 
+	service.setROMSHA1SidecarsEnabled(options.romSHA1Sidecars);
+	if (options.romIndexFilename != NULL && MT32EMU_RC_OK != service.loadROMIndex(options.romIndexFilename) && !options.quiet) {
+		printf("ROM index not loaded, it will be rebuilt.\n");
+	}
+
 	bool res;
 	const char **machineIDs;
 	const size_t machineIDCount = matchMachineIDs(machineIDs, service, options.machineID);
@@ -936,6 +1363,9 @@ static bool loadROMs(MT32Emu::Service &service, const Options &options) {
 		if (!res) fprintf(stderr, "ROMs not found for machine configuration.\n");
 		delete[] machineIDs;
 	}
+	if (options.romIndexFilename != NULL && MT32EMU_RC_OK != service.saveROMIndex()) {
+		fprintf(stderr, "Error writing ROM index.\n");
+	}
 
 	g_dir_close(romDir);
 	g_free(romDirName);
@@ -945,6 +1375,7 @@ static bool loadROMs(MT32Emu::Service &service, const Options &options) {
 int main(int argc, char *argv[]) {
 	Options options;
 	MT32Emu::Service service;
+	DryRunReportHandler dryRunReportHandler;
 	setlocale(LC_ALL, "");
 #ifdef BUILD_MT32EMU_VERSION
 	const char *mt32emuVersion = BUILD_MT32EMU_VERSION;
@@ -971,7 +1402,12 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
-	service.createContext();
+	if (options.dryRun) {
+		dryRunReportHandler.quiet = options.quiet != FALSE;
+		service.createContext(dryRunReportHandler);
+	} else {
+		service.createContext();
+	}
 	if (!loadROMs(service, options)) {
 		service.freeContext();
 
@@ -986,7 +1422,13 @@ int main(int argc, char *argv[]) {
 	service.setPartialCount(options.partialCount);
 	service.setAnalogOutputMode(options.analogOutputMode);
 	service.selectRendererType(options.rendererType);
-	if (service.openSynth() == MT32EMU_RC_OK) {
+	if (options.dryRun) {
+		if (service.openSynth() == MT32EMU_RC_OK) {
+			playFilesDry(service, options, dryRunReportHandler);
+		} else {
+			fprintf(stderr, "Error opening MT32Emu synthesizer.\n");
+		}
+	} else if (service.openSynth() == MT32EMU_RC_OK) {
 		service.setDACInputMode(options.dacInputMode);
 		if (!options.niceAmpRamp) {
 			service.setNiceAmpRampEnabled(false);
@@ -1027,9 +1469,22 @@ int main(int argc, char *argv[]) {
 		clock_t startTime = clock();
 
 		if (outputFile != NULL) {
-			if (options.rawChannelCount > 0 || writeWAVEHeader(outputFile, options.sampleRate, options.outputSampleFormat)) {
-				State state = {NULL, {NULL, NULL, NULL, NULL, NULL, NULL}, service, outputFile, false, false, 0, 0, 0};
+			FLACOutput *flacOutput = NULL;
+			bool headerWritten;
+			if (options.flacOutput) {
+				flacOutput = startFLACOutput(outputFile, options);
+				headerWritten = flacOutput != NULL;
+			} else {
+				headerWritten = options.rawChannelCount > 0 || writeWAVEHeader(outputFile, options.sampleRate, options.outputSampleFormat);
+			}
+			if (headerWritten) {
+				State state = {NULL, {NULL, NULL, NULL, NULL, NULL, NULL}, service, outputFile, false, false, 0, 0, 0, NULL, 0, flacOutput};
 				state.outputFile = outputFile;
+				if (flacOutput != NULL) {
+					state.outputBuffer = reinterpret_cast<unsigned char *>(flacOutput->blocks[0]);
+				} else {
+					state.outputBuffer = new unsigned char[OUTPUT_BUFFER_SIZE];
+				}
 				if (options.rawChannelCount > 0) {
 					for (int i = 0; i < 6; i++) {
 						if (options.outputSampleFormat == OUTPUT_SAMPLE_FORMAT_IEEE_FLOAT32) {
@@ -1066,11 +1521,19 @@ int main(int argc, char *argv[]) {
 						delete[] static_cast<MT32Emu::Bit16s *>(state.rawSampleBuffer[i]);
 					}
 				}
-				if (options.rawChannelCount == 0 && !fillWAVESizes(outputFile, state.writtenFrames, options.outputSampleFormat)) {
-					fprintf(stderr, "Error writing final sizes to WAVE header\n");
+				flushOutputBuffer(state);
+				if (flacOutput != NULL) {
+					if (!finishFLACOutput(flacOutput)) {
+						fprintf(stderr, "Error writing FLAC stream to '%s'\n", outputFilenameLocale);
+					}
+				} else {
+					delete[] state.outputBuffer;
+					if (options.rawChannelCount == 0 && !fillWAVESizes(outputFile, state.writtenFrames, options.outputSampleFormat)) {
+						fprintf(stderr, "Error writing final sizes to WAVE header\n");
+					}
 				}
 			} else {
-				fprintf(stderr, "Error writing WAVE header to '%s'\n", outputFilenameLocale);
+				fprintf(stderr, "Error writing %s header to '%s'\n", options.flacOutput ? "FLAC" : "WAVE", outputFilenameLocale);
 			}
 			fclose(outputFile);
 			printf("Elapsed time: %f sec\n", float(clock() - startTime) / CLOCKS_PER_SEC);